@@ -43,6 +43,7 @@
 #include "magick/blob.h"
 #include "magick/blob-private.h"
 #include "magick/cache.h"
+#include "magick/cache-view.h"
 #include "magick/color.h"
 #include "magick/color-private.h"
 #include "magick/colormap.h"
@@ -79,32 +80,36 @@
 typedef struct _LZWCodeInfo
 {
   unsigned char
-    buffer[280];
+    buffer[256];
 
   size_t
     count,
-    bit;
+    offset;
+
+  MagickSizeType
+    datum;
+
+  size_t
+    bits;
 
   MagickBooleanType
     eof;
 } LZWCodeInfo;
 
-typedef struct _LZWStack
+typedef struct _LZWString
 {
-  size_t
-    *codes,
-    *index,
-    *top;
-} LZWStack;
+  unsigned short
+    prefix,
+    suffix,
+    first,
+    length;
+} LZWString;
 
 typedef struct _LZWInfo
 {
   Image
     *image;
 
-  LZWStack
-    *stack;
-
   MagickBooleanType
     genesis;
 
@@ -114,16 +119,44 @@ typedef struct _LZWInfo
     clear_code,
     end_code,
     bits,
-    first_code,
     last_code,
     maximum_code,
-    slot,
-    *table[2];
+    slot;
+
+  LZWString
+    *table;
+
+  unsigned short
+    *string;
+
+  size_t
+    offset,
+    length;
 
   LZWCodeInfo
     code_info;
 } LZWInfo;
-
+
+typedef struct _GIFFrameInfo
+{
+  Image
+    *image;
+
+  ssize_t
+    opacity;
+
+  MagickBooleanType
+    status;
+
+  size_t
+    bits_per_pixel,
+    extent,
+    length;
+
+  unsigned char
+    *raster;
+} GIFFrameInfo;
+
 /*
   Forward declarations.
 */
@@ -161,21 +194,27 @@ static ssize_t
 %
 */
 
+static inline size_t MagickMax(const size_t x,const size_t y)
+{
+  if (x > y)
+    return(x);
+  return(y);
+}
+
+static inline size_t MagickMin(const size_t x,const size_t y)
+{
+  if (x < y)
+    return(x);
+  return(y);
+}
+
 static LZWInfo *RelinquishLZWInfo(LZWInfo *lzw_info)
 {
-  if (lzw_info->table[0] != (size_t *) NULL)
-    lzw_info->table[0]=(size_t *) RelinquishMagickMemory(
-      lzw_info->table[0]);
-  if (lzw_info->table[1] != (size_t *) NULL)
-    lzw_info->table[1]=(size_t *) RelinquishMagickMemory(
-      lzw_info->table[1]);
-  if (lzw_info->stack != (LZWStack *) NULL)
-    {
-      if (lzw_info->stack->codes != (size_t *) NULL)
-        lzw_info->stack->codes=(size_t *) RelinquishMagickMemory(
-          lzw_info->stack->codes);
-      lzw_info->stack=(LZWStack *) RelinquishMagickMemory(lzw_info->stack);
-    }
+  if (lzw_info->table != (LZWString *) NULL)
+    lzw_info->table=(LZWString *) RelinquishMagickMemory(lzw_info->table);
+  if (lzw_info->string != (unsigned short *) NULL)
+    lzw_info->string=(unsigned short *) RelinquishMagickMemory(
+      lzw_info->string);
   lzw_info=(LZWInfo *) RelinquishMagickMemory(lzw_info);
   return((LZWInfo *) NULL);
 }
@@ -213,43 +252,35 @@ static LZWInfo *AcquireLZWInfo(Image *image,const size_t data_size)
   lzw_info->maximum_data_value=(one << data_size)-1;
   lzw_info->clear_code=lzw_info->maximum_data_value+1;
   lzw_info->end_code=lzw_info->maximum_data_value+2;
-  lzw_info->table[0]=(size_t *) AcquireQuantumMemory(MaximumLZWCode,
+  lzw_info->table=(LZWString *) AcquireQuantumMemory(MaximumLZWCode,
     sizeof(*lzw_info->table));
-  lzw_info->table[1]=(size_t *) AcquireQuantumMemory(MaximumLZWCode,
-    sizeof(*lzw_info->table));
-  if ((lzw_info->table[0] == (size_t *) NULL) ||
-      (lzw_info->table[1] == (size_t *) NULL))
+  lzw_info->string=(unsigned short *) AcquireQuantumMemory(MaximumLZWCode,
+    sizeof(*lzw_info->string));
+  if ((lzw_info->table == (LZWString *) NULL) ||
+      (lzw_info->string == (unsigned short *) NULL))
     {
       lzw_info=RelinquishLZWInfo(lzw_info);
       return((LZWInfo *) NULL);
     }
+  /*
+    Each root code is a string of length one; a zero length marks a code that
+    is not (yet) defined.
+  */
+  (void) ResetMagickMemory(lzw_info->table,0,MaximumLZWCode*
+    sizeof(*lzw_info->table));
   for (i=0; i <= (ssize_t) lzw_info->maximum_data_value; i++)
   {
-    lzw_info->table[0][i]=0;
-    lzw_info->table[1][i]=(size_t) i;
+    lzw_info->table[i].suffix=(unsigned short) i;
+    lzw_info->table[i].first=(unsigned short) i;
+    lzw_info->table[i].length=1;
   }
   ResetLZWInfo(lzw_info);
-  lzw_info->code_info.buffer[0]='\0';
-  lzw_info->code_info.buffer[1]='\0';
-  lzw_info->code_info.count=2;
-  lzw_info->code_info.bit=8*lzw_info->code_info.count;
+  lzw_info->code_info.count=0;
+  lzw_info->code_info.offset=0;
+  lzw_info->code_info.datum=0;
+  lzw_info->code_info.bits=0;
   lzw_info->code_info.eof=MagickFalse;
   lzw_info->genesis=MagickTrue;
-  lzw_info->stack=(LZWStack *) AcquireMagickMemory(sizeof(*lzw_info->stack));
-  if (lzw_info->stack == (LZWStack *) NULL)
-    {
-      lzw_info=RelinquishLZWInfo(lzw_info);
-      return((LZWInfo *) NULL);
-    }
-  lzw_info->stack->codes=(size_t *) AcquireQuantumMemory(2UL*
-    MaximumLZWCode,sizeof(*lzw_info->stack->codes));
-  if (lzw_info->stack->codes == (size_t *) NULL)
-    {
-      lzw_info=RelinquishLZWInfo(lzw_info);
-      return((LZWInfo *) NULL);
-    }
-  lzw_info->stack->index=lzw_info->stack->codes;
-  lzw_info->stack->top=lzw_info->stack->codes+2*MaximumLZWCode;
   return(lzw_info);
 }
 
@@ -258,121 +289,142 @@ static inline int GetNextLZWCode(LZWInfo *lzw_info,const size_t bits)
   int
     code;
 
-  register ssize_t
-    i;
+  register LZWCodeInfo
+    *code_info;
 
   size_t
     one;
 
-  while (((lzw_info->code_info.bit+bits) > (8*lzw_info->code_info.count)) &&
-         (lzw_info->code_info.eof == MagickFalse))
+  /*
+    Codes are packed LSB first; keep a 64-bit accumulator topped up from the
+    current data sub-block and only read the next sub-block when it runs dry.
+  */
+  code_info=(&lzw_info->code_info);
+  while (code_info->bits < bits)
   {
-    ssize_t
-      count;
-
-    lzw_info->code_info.buffer[0]=lzw_info->code_info.buffer[
-      lzw_info->code_info.count-2];
-    lzw_info->code_info.buffer[1]=lzw_info->code_info.buffer[
-      lzw_info->code_info.count-1];
-    lzw_info->code_info.bit-=8*(lzw_info->code_info.count-2);
-    lzw_info->code_info.count=2;
-    count=ReadBlobBlock(lzw_info->image,&lzw_info->code_info.buffer[
-      lzw_info->code_info.count]);
-    if (count > 0)
-      lzw_info->code_info.count+=count;
-    else
-      lzw_info->code_info.eof=MagickTrue;
+    if (code_info->offset >= code_info->count)
+      {
+        ssize_t
+          count;
+
+        if (code_info->eof != MagickFalse)
+          return(-1);
+        count=ReadBlobBlock(lzw_info->image,code_info->buffer);
+        if (count <= 0)
+          {
+            code_info->eof=MagickTrue;
+            return(-1);
+          }
+        code_info->count=(size_t) count;
+        code_info->offset=0;
+      }
+    while ((code_info->bits <= 56) && (code_info->offset < code_info->count))
+    {
+      code_info->datum|=(MagickSizeType) code_info->buffer[
+        code_info->offset++] << code_info->bits;
+      code_info->bits+=8;
+    }
   }
-  if ((lzw_info->code_info.bit+bits) > (8*lzw_info->code_info.count))
-    return(-1);
-  code=0;
   one=1;
-  for (i=0; i < (ssize_t) bits; i++)
-  {
-    code|=((lzw_info->code_info.buffer[lzw_info->code_info.bit/8] &
-      (one << (lzw_info->code_info.bit % 8))) != 0) << i;
-    lzw_info->code_info.bit++;
-  }
+  code=(int) (code_info->datum & ((one << bits)-1));
+  code_info->datum>>=bits;
+  code_info->bits-=bits;
   return(code);
 }
 
-static inline int PopLZWStack(LZWStack *stack_info)
-{
-  if (stack_info->index <= stack_info->codes)
-    return(-1);
-  stack_info->index--;
-  return((int) *stack_info->index);
-}
-
-static inline void PushLZWStack(LZWStack *stack_info,const size_t value)
-{
-  if (stack_info->index >= stack_info->top)
-    return;
-  *stack_info->index=value;
-  stack_info->index++;
-}
-
-static int ReadBlobLZWByte(LZWInfo *lzw_info)
+static MagickBooleanType ReadBlobLZWString(LZWInfo *lzw_info)
 {
   int
     code;
 
-  ssize_t
-    count;
+  register LZWString
+    *table;
+
+  register unsigned short
+    *q;
 
   size_t
-    one,
+    first,
+    length,
     value;
 
-  if (lzw_info->stack->index != lzw_info->stack->codes)
-    return(PopLZWStack(lzw_info->stack));
-  if (lzw_info->genesis != MagickFalse)
-    {
-      lzw_info->genesis=MagickFalse;
-      do
+  /*
+    Decode the next code and expand its string into the string buffer.
+  */
+  table=lzw_info->table;
+  for ( ; ; )
+  {
+    code=GetNextLZWCode(lzw_info,lzw_info->bits);
+    if (code < 0)
+      return(MagickFalse);
+    if ((size_t) code == lzw_info->clear_code)
       {
-        lzw_info->first_code=(size_t) GetNextLZWCode(lzw_info,
-          lzw_info->bits);
-        lzw_info->last_code=lzw_info->first_code;
-      } while (lzw_info->first_code == lzw_info->clear_code);
-      return((int) lzw_info->first_code);
-    }
-  code=GetNextLZWCode(lzw_info,lzw_info->bits);
-  if (code < 0)
-    return(code);
-  if ((size_t) code == lzw_info->clear_code)
-    {
-      ResetLZWInfo(lzw_info);
-      return(ReadBlobLZWByte(lzw_info));
-    }
+        ResetLZWInfo(lzw_info);
+        continue;
+      }
+    if (lzw_info->genesis != MagickFalse)
+      {
+        lzw_info->genesis=MagickFalse;
+        if ((size_t) code > lzw_info->maximum_data_value)
+          return(MagickFalse);
+        lzw_info->last_code=(size_t) code;
+        *lzw_info->string=(unsigned short) code;
+        lzw_info->offset=0;
+        lzw_info->length=1;
+        return(MagickTrue);
+      }
+    break;
+  }
   if ((size_t) code == lzw_info->end_code)
-    return(-1);
+    return(MagickFalse);
   if ((size_t) code < lzw_info->slot)
-    value=(size_t) code;
+    {
+      /*
+        Known code: walk the prefix chain from the tail of the string.
+      */
+      length=(size_t) table[code].length;
+      if (length == 0)
+        return(MagickFalse);
+      value=(size_t) code;
+      first=(size_t) table[code].first;
+      q=lzw_info->string+length-1;
+    }
   else
     {
-      PushLZWStack(lzw_info->stack,lzw_info->first_code);
+      /*
+        Code not yet in the table: it is the previous string plus its own
+        first character.
+      */
+      length=(size_t) table[lzw_info->last_code].length+1;
+      if ((length == 1) || (length > MaximumLZWCode))
+        return(MagickFalse);
       value=lzw_info->last_code;
+      first=(size_t) table[value].first;
+      lzw_info->string[length-1]=(unsigned short) first;
+      q=lzw_info->string+length-2;
     }
-  count=0;
-  while (value > lzw_info->maximum_data_value)
+  while (q > lzw_info->string)
   {
-    if ((size_t) count > MaximumLZWCode)
-      return(-1);
-    count++;
-    if ((size_t) value > MaximumLZWCode)
-      return(-1);
-    PushLZWStack(lzw_info->stack,lzw_info->table[1][value]);
-    value=lzw_info->table[0][value];
+    *q--=table[value].suffix;
+    value=(size_t) table[value].prefix;
   }
-  lzw_info->first_code=lzw_info->table[1][value];
-  PushLZWStack(lzw_info->stack,lzw_info->first_code);
-  one=1;
+  *q=(unsigned short) first;
   if (lzw_info->slot < MaximumLZWCode)
     {
-      lzw_info->table[0][lzw_info->slot]=lzw_info->last_code;
-      lzw_info->table[1][lzw_info->slot]=lzw_info->first_code;
+      register LZWString
+        *entry;
+
+      size_t
+        one;
+
+      entry=table+lzw_info->slot;
+      entry->prefix=(unsigned short) lzw_info->last_code;
+      entry->suffix=(unsigned short) first;
+      entry->first=table[lzw_info->last_code].first;
+      entry->length=(unsigned short) MagickMin((size_t)
+        table[lzw_info->last_code].length+1,MaximumLZWCode);
       lzw_info->slot++;
+      one=1;
       if ((lzw_info->slot >= lzw_info->maximum_code) &&
           (lzw_info->bits < MaximumLZWBits))
         {
@@ -381,7 +433,9 @@ static int ReadBlobLZWByte(LZWInfo *lzw_info)
         }
     }
   lzw_info->last_code=(size_t) code;
-  return(PopLZWStack(lzw_info->stack));
+  lzw_info->offset=0;
+  lzw_info->length=length;
+  return(MagickTrue);
 }
 
 static MagickBooleanType DecodeImage(Image *image,const ssize_t opacity)
@@ -392,9 +446,6 @@ static MagickBooleanType DecodeImage(Image *image,const ssize_t opacity)
   IndexPacket
     index;
 
-  int
-    c;
-
   ssize_t
     offset,
     y;
@@ -402,9 +453,18 @@ static MagickBooleanType DecodeImage(Image *image,const ssize_t opacity)
   LZWInfo
     *lzw_info;
 
+  PixelPacket
+    *colormap;
+
+  register ssize_t
+    i;
+
   unsigned char
     data_size;
 
+  unsigned short
+    *row;
+
   size_t
     pass;
 
@@ -422,6 +482,29 @@ static MagickBooleanType DecodeImage(Image *image,const ssize_t opacity)
   if (lzw_info == (LZWInfo *) NULL)
     ThrowBinaryException(ResourceLimitError,"MemoryAllocationFailed",
       image->filename);
+  row=(unsigned short *) AcquireQuantumMemory(image->columns,sizeof(*row));
+  colormap=(PixelPacket *) AcquireQuantumMemory(MagickMax(image->colors,1),
+    sizeof(*colormap));
+  if ((row == (unsigned short *) NULL) || (colormap == (PixelPacket *) NULL))
+    {
+      if (row != (unsigned short *) NULL)
+        row=(unsigned short *) RelinquishMagickMemory(row);
+      if (colormap != (PixelPacket *) NULL)
+        colormap=(PixelPacket *) RelinquishMagickMemory(colormap);
+      lzw_info=RelinquishLZWInfo(lzw_info);
+      ThrowBinaryException(ResourceLimitError,"MemoryAllocationFailed",
+        image->filename);
+    }
+  /*
+    A frame without a colormap maps every index to the background color.
+  */
+  colormap[0]=image->background_color;
+  for (i=0; i < (ssize_t) image->colors; i++)
+  {
+    colormap[i]=image->colormap[i];
+    SetPixelOpacity(colormap+i,i == opacity ? TransparentOpacity :
+      OpaqueOpacity);
+  }
   exception=(&image->exception);
   pass=0;
   offset=0;
@@ -436,25 +519,40 @@ static MagickBooleanType DecodeImage(Image *image,const ssize_t opacity)
     register PixelPacket
       *restrict q;
 
+    size_t
+      length;
+
+    /*
+      Copy whole decoded strings into the row, then map the row through the
+      colormap.
+    */
+    for (x=0; x < (ssize_t) image->columns; )
+    {
+      if (lzw_info->length == 0)
+        if (ReadBlobLZWString(lzw_info) == MagickFalse)
+          break;
+      length=MagickMin(lzw_info->length,image->columns-x);
+      (void) CopyMagickMemory(row+x,lzw_info->string+lzw_info->offset,
+        length*sizeof(*row));
+      lzw_info->offset+=length;
+      lzw_info->length-=length;
+      x+=(ssize_t) length;
+    }
+    if (x < (ssize_t) image->columns)
+      break;
     q=GetAuthenticPixels(image,0,offset,image->columns,1,exception);
     if (q == (PixelPacket *) NULL)
       break;
     indexes=GetAuthenticIndexQueue(image);
-    for (x=0; x < (ssize_t) image->columns; )
+    for (x=0; x < (ssize_t) image->columns; x++)
     {
-      c=ReadBlobLZWByte(lzw_info);
-      if (c < 0)
-        break;
-      index=ConstrainColormapIndex(image,(size_t) c);
+      index=(IndexPacket) row[x];
+      if ((size_t) row[x] >= image->colors)
+        index=image->colors == 0 ? (IndexPacket) 0 :
+          ConstrainColormapIndex(image,(size_t) row[x]);
       SetPixelIndex(indexes+x,index);
-      SetPixelRGBO(q,image->colormap+(ssize_t) index);
-      SetPixelOpacity(q,(ssize_t) index == opacity ?
-        TransparentOpacity : OpaqueOpacity);
-      x++;
-      q++;
+      *q++=colormap[(ssize_t) index];
     }
-    if (x < (ssize_t) image->columns)
-      break;
     if (image->interlace == NoInterlace)
       offset++;
     else
@@ -500,12 +598,14 @@ static MagickBooleanType DecodeImage(Image *image,const ssize_t opacity)
     if (SyncAuthenticPixels(image,exception) == MagickFalse)
       break;
   }
+  colormap=(PixelPacket *) RelinquishMagickMemory(colormap);
+  row=(unsigned short *) RelinquishMagickMemory(row);
   lzw_info=RelinquishLZWInfo(lzw_info);
   if (y < (ssize_t) image->rows)
     ThrowBinaryException(CorruptImageError,"CorruptImage",image->filename);
   return(MagickTrue);
 }
-
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -517,27 +617,55 @@ static MagickBooleanType DecodeImage(Image *image,const ssize_t opacity)
 %                                                                             %
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %
-%  EncodeImage compresses an image via GIF-coding.
+%  EncodeImage compresses the image of a GIF frame via GIF-coding and leaves
+%  the raster data in the frame as a series of GIF data sub-blocks (without
+%  the block terminator).  The image is only read and the raster grows as
+%  needed, so distinct frames may be encoded concurrently.  MagickFalse is
+%  returned if the raster could not be allocated.
 %
 %  The format of the EncodeImage method is:
 %
-%      MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
-%        const size_t data_size)
+%      MagickBooleanType EncodeImage(const ImageInfo *image_info,
+%        GIFFrameInfo *frame_info,const size_t data_size)
 %
 %  A description of each parameter follows:
 %
 %    o image_info: the image info.
 %
-%    o image: the address of a structure of type Image.
+%    o frame_info: the frame to encode.
 %
 %    o data_size:  The number of bits in the compressed packet.
 %
 */
-static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
-  const size_t data_size)
+
+static inline MagickBooleanType WriteLZWPacket(GIFFrameInfo *frame_info,
+  const unsigned char *packet,const size_t length)
+{
+  unsigned char
+    *datum;
+
+  if (frame_info->raster == (unsigned char *) NULL)
+    return(MagickFalse);
+  if ((frame_info->extent+length+1) > frame_info->length)
+    {
+      frame_info->length=2*frame_info->length+length+1;
+      frame_info->raster=(unsigned char *) ResizeQuantumMemory(
+        frame_info->raster,frame_info->length,sizeof(*frame_info->raster));
+      if (frame_info->raster == (unsigned char *) NULL)
+        return(MagickFalse);
+    }
+  datum=frame_info->raster+frame_info->extent;
+  *datum++=(unsigned char) length;
+  (void) CopyMagickMemory(datum,packet,length);
+  frame_info->extent+=length+1;
+  return(MagickTrue);
+}
+
+static MagickBooleanType EncodeImage(const ImageInfo *image_info,
+  GIFFrameInfo *frame_info,const size_t data_size)
 {
 #define MaxCode(number_bits)  ((one << (number_bits))-1)
-#define MaxHashTable  5003
+#define MaxHashTable  8192
 #define MaxGIFBits  12UL
 #define MaxGIFTable  (1UL << MaxGIFBits)
 #define GIFOutputCode(code) \
@@ -558,8 +686,8 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
     packet[length++]=(unsigned char) (datum & 0xff); \
     if (length >= 254) \
       { \
-        (void) WriteBlobByte(image,(unsigned char) length); \
-        (void) WriteBlob(image,length,packet); \
+        if (WriteLZWPacket(frame_info,packet,length) == MagickFalse) \
+          status=MagickFalse; \
         length=0; \
       } \
     datum>>=8; \
@@ -574,17 +702,16 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
         max_code=MaxCode(number_bits); \
     } \
 }
+#define LZWHash(key)  ((size_t) (((key)*2654435761U) >> 19) & (MaxHashTable-1))
 
-  IndexPacket
-    index;
+  CacheView
+    *image_view;
 
-  register ssize_t
-    i;
+  Image
+    *image;
 
-  short
-    *hash_code,
-    *hash_prefix,
-    waiting_code;
+  MagickBooleanType
+    status;
 
   size_t
     bits,
@@ -594,62 +721,80 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
     free_code,
     length,
     max_code,
-    next_pixel,
     number_bits,
     one,
-    pass;
+    pass,
+    waiting_code;
 
   ssize_t
-    displacement,
     offset,
-    k,
     y;
 
   unsigned char
     *packet,
-    *hash_suffix;
+    *pixels;
+
+  unsigned int
+    *hash_key;
+
+  unsigned short
+    *hash_code;
 
   /*
     Allocate encoder tables.
   */
+  assert(frame_info != (GIFFrameInfo *) NULL);
+  image=frame_info->image;
   assert(image != (Image *) NULL);
   one=1;
   packet=(unsigned char *) AcquireQuantumMemory(256,sizeof(*packet));
-  hash_code=(short *) AcquireQuantumMemory(MaxHashTable,sizeof(*hash_code));
-  hash_prefix=(short *) AcquireQuantumMemory(MaxHashTable,sizeof(*hash_prefix));
-  hash_suffix=(unsigned char *) AcquireQuantumMemory(MaxHashTable,
-    sizeof(*hash_suffix));
-  if ((packet == (unsigned char *) NULL) || (hash_code == (short *) NULL) ||
-      (hash_prefix == (short *) NULL) ||
-      (hash_suffix == (unsigned char *) NULL))
+  pixels=(unsigned char *) AcquireQuantumMemory(image->columns,
+    sizeof(*pixels));
+  hash_key=(unsigned int *) AcquireQuantumMemory(MaxHashTable,
+    sizeof(*hash_key));
+  hash_code=(unsigned short *) AcquireQuantumMemory(MaxHashTable,
+    sizeof(*hash_code));
+  if ((packet == (unsigned char *) NULL) ||
+      (pixels == (unsigned char *) NULL) ||
+      (hash_key == (unsigned int *) NULL) ||
+      (hash_code == (unsigned short *) NULL))
     {
       if (packet != (unsigned char *) NULL)
         packet=(unsigned char *) RelinquishMagickMemory(packet);
-      if (hash_code != (short *) NULL)
-        hash_code=(short *) RelinquishMagickMemory(hash_code);
-      if (hash_prefix != (short *) NULL)
-        hash_prefix=(short *) RelinquishMagickMemory(hash_prefix);
-      if (hash_suffix != (unsigned char *) NULL)
-        hash_suffix=(unsigned char *) RelinquishMagickMemory(hash_suffix);
+      if (pixels != (unsigned char *) NULL)
+        pixels=(unsigned char *) RelinquishMagickMemory(pixels);
+      if (hash_key != (unsigned int *) NULL)
+        hash_key=(unsigned int *) RelinquishMagickMemory(hash_key);
+      if (hash_code != (unsigned short *) NULL)
+        hash_code=(unsigned short *) RelinquishMagickMemory(hash_code);
       return(MagickFalse);
     }
+  /*
+    Start with room for a few rows; the raster doubles as codes are emitted.
+  */
+  frame_info->extent=0;
+  frame_info->length=4*(image->columns+255);
+  frame_info->raster=(unsigned char *) AcquireQuantumMemory(frame_info->length,
+    sizeof(*frame_info->raster));
+  status=frame_info->raster != (unsigned char *) NULL ? MagickTrue :
+    MagickFalse;
   /*
     Initialize GIF encoder.
   */
   number_bits=data_size;
   max_code=MaxCode(number_bits);
-  clear_code=((short) one << (data_size-1));
+  clear_code=((size_t) one << (data_size-1));
   end_of_information_code=clear_code+1;
   free_code=clear_code+2;
   length=0;
   datum=0;
   bits=0;
-  for (i=0; i < MaxHashTable; i++)
-    hash_code[i]=0;
+  (void) ResetMagickMemory(hash_key,0,MaxHashTable*sizeof(*hash_key));
   GIFOutputCode(clear_code);
   /*
     Encode pixels.
   */
+  image_view=AcquireCacheView(image);
   offset=0;
   pass=0;
   waiting_code=0;
@@ -664,66 +809,49 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
     register ssize_t
       x;
 
-    p=GetVirtualPixels(image,0,offset,image->columns,1,&image->exception);
+    if (status == MagickFalse)
+      break;
+    p=GetCacheViewVirtualPixels(image_view,0,offset,image->columns,1,
+      &image->exception);
     if (p == (const PixelPacket *) NULL)
       break;
-    indexes=GetVirtualIndexQueue(image);
+    indexes=GetCacheViewVirtualIndexQueue(image_view);
+    for (x=0; x < (ssize_t) image->columns; x++)
+      pixels[x]=(unsigned char) ((size_t) GetPixelIndex(indexes+x) & 0xff);
     if (y == 0)
-      waiting_code=(short) (*indexes);
+      waiting_code=(size_t) *pixels;
     for (x=(ssize_t) (y == 0 ? 1 : 0); x < (ssize_t) image->columns; x++)
     {
+      register size_t
+        k;
+
+      unsigned int
+        key;
+
       /*
-        Probe hash table.
+        Probe the dictionary for the current string extended by this index.
       */
-      index=(IndexPacket) ((size_t) GetPixelIndex(indexes+x) & 0xff);
-      p++;
-      k=(ssize_t) (((size_t) index << (MaxGIFBits-8))+waiting_code);
-      if (k >= MaxHashTable)
-        k-=MaxHashTable;
-      next_pixel=MagickFalse;
-      displacement=1;
-      if (hash_code[k] > 0)
+      key=(unsigned int) (((waiting_code << 8) | pixels[x])+1);
+      for (k=LZWHash(key); hash_key[k] != 0; k=(k+1) & (MaxHashTable-1))
+        if (hash_key[k] == key)
+          break;
+      if (hash_key[k] == key)
         {
-          if ((hash_prefix[k] == waiting_code) &&
-              (hash_suffix[k] == (unsigned char) index))
-            {
-              waiting_code=hash_code[k];
-              continue;
-            }
-          if (k != 0)
-            displacement=MaxHashTable-k;
-          for ( ; ; )
-          {
-            k-=displacement;
-            if (k < 0)
-              k+=MaxHashTable;
-            if (hash_code[k] == 0)
-              break;
-            if ((hash_prefix[k] == waiting_code) &&
-                (hash_suffix[k] == (unsigned char) index))
-              {
-                waiting_code=hash_code[k];
-                next_pixel=MagickTrue;
-                break;
-              }
-          }
-          if (next_pixel == MagickTrue)
-            continue;
+          waiting_code=(size_t) hash_code[k];
+          continue;
         }
-      GIFOutputCode((size_t) waiting_code);
+      GIFOutputCode(waiting_code);
       if (free_code < MaxGIFTable)
         {
-          hash_code[k]=(short) free_code++;
-          hash_prefix[k]=waiting_code;
-          hash_suffix[k]=(unsigned char) index;
+          hash_key[k]=key;
+          hash_code[k]=(unsigned short) free_code++;
         }
       else
         {
           /*
             Fill the hash table with empty entries.
           */
-          for (k=0; k < MaxHashTable; k++)
-            hash_code[k]=0;
+          (void) ResetMagickMemory(hash_key,0,MaxHashTable*sizeof(*hash_key));
           /*
             Reset compressor and issue a clear code.
           */
@@ -732,7 +860,7 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
           number_bits=data_size;
           max_code=MaxCode(number_bits);
         }
-      waiting_code=(short) index;
+      waiting_code=(size_t) pixels[x];
     }
     if (image_info->interlace == NoInterlace)
       offset++;
@@ -777,10 +905,11 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
         }
       }
   }
+  image_view=DestroyCacheView(image_view);
   /*
     Flush out the buffered code.
   */
-  GIFOutputCode((size_t) waiting_code);
+  GIFOutputCode(waiting_code);
   GIFOutputCode(end_of_information_code);
   if (bits > 0)
     {
@@ -790,8 +919,8 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
       packet[length++]=(unsigned char) (datum & 0xff);
       if (length >= 254)
         {
-          (void) WriteBlobByte(image,(unsigned char) length);
-          (void) WriteBlob(image,length,packet);
+          if (WriteLZWPacket(frame_info,packet,length) == MagickFalse)
+            status=MagickFalse;
           length=0;
         }
     }
@@ -799,20 +928,18 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
     Flush accumulated data.
   */
   if (length > 0)
-    {
-      (void) WriteBlobByte(image,(unsigned char) length);
-      (void) WriteBlob(image,length,packet);
-    }
+    if (WriteLZWPacket(frame_info,packet,length) == MagickFalse)
+      status=MagickFalse;
   /*
     Free encoder memory.
   */
-  hash_suffix=(unsigned char *) RelinquishMagickMemory(hash_suffix);
-  hash_prefix=(short *) RelinquishMagickMemory(hash_prefix);
-  hash_code=(short *) RelinquishMagickMemory(hash_code);
+  hash_code=(unsigned short *) RelinquishMagickMemory(hash_code);
+  hash_key=(unsigned int *) RelinquishMagickMemory(hash_key);
+  pixels=(unsigned char *) RelinquishMagickMemory(pixels);
   packet=(unsigned char *) RelinquishMagickMemory(packet);
-  return(MagickTrue);
+  return(status);
 }
-
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -918,20 +1045,6 @@ static ssize_t ReadBlobBlock(Image *image,unsigned char *data)
 %
 */
 
-static inline size_t MagickMax(const size_t x,const size_t y)
-{
-  if (x > y)
-    return(x);
-  return(y);
-}
-
-static inline size_t MagickMin(const size_t x,const size_t y)
-{
-  if (x < y)
-    return(x);
-  return(y);
-}
-
 static MagickBooleanType PingGIFImage(Image *image)
 {
   unsigned char
@@ -1037,6 +1150,8 @@ static Image *ReadGIFImage(const ImageInfo *image_info,ExceptionInfo *exception)
     MagickMax(global_colors,256),3UL*sizeof(*global_colormap));
   if (global_colormap == (unsigned char *) NULL)
     ThrowReaderException(ResourceLimitError,"MemoryAllocationFailed");
+  (void) ResetMagickMemory(global_colormap,0,(size_t) MagickMax(global_colors,
+    256)*3UL*sizeof(*global_colormap));
   if (BitSet((int) flag,0x80) != 0)
     count=ReadBlob(image,(size_t) (3*global_colors),global_colormap);
   delay=0;
@@ -1447,8 +1562,99 @@ ModuleExport void UnregisterGIFImage(void)
 %    o image:  The image.
 %
 */
+static GIFFrameInfo *DestroyGIFFrameInfo(GIFFrameInfo *frame_info,
+  const size_t number_frames)
+{
+  register ssize_t
+    i;
+
+  for (i=0; i < (ssize_t) number_frames; i++)
+    if (frame_info[i].raster != (unsigned char *) NULL)
+      frame_info[i].raster=(unsigned char *) RelinquishMagickMemory(
+        frame_info[i].raster);
+  frame_info=(GIFFrameInfo *) RelinquishMagickMemory(frame_info);
+  return((GIFFrameInfo *) NULL);
+}
+
+static MagickBooleanType SetGIFImagePalette(Image *image,ssize_t *transparent)
+{
+  register ssize_t
+    i;
+
+  ssize_t
+    opacity;
+
+  if (IsRGBColorspace(image->colorspace) == MagickFalse)
+    (void) TransformImageColorspace(image,RGBColorspace);
+  opacity=(-1);
+  if (IsOpaqueImage(image,&image->exception) != MagickFalse)
+    {
+      if ((image->storage_class == DirectClass) || (image->colors > 256))
+        (void) SetImageType(image,PaletteType);
+    }
+  else
+    {
+      MagickRealType
+        alpha,
+        beta;
+
+      /*
+        Identify transparent colormap index.
+      */
+      if ((image->storage_class == DirectClass) || (image->colors > 256))
+        (void) SetImageType(image,PaletteBilevelMatteType);
+      for (i=0; i < (ssize_t) image->colors; i++)
+        if (image->colormap[i].opacity != OpaqueOpacity)
+          {
+            if (opacity < 0)
+              {
+                opacity=i;
+                continue;
+              }
+            alpha=(MagickRealType) TransparentOpacity-(MagickRealType)
+              image->colormap[i].opacity;
+            beta=(MagickRealType) TransparentOpacity-(MagickRealType)
+              image->colormap[opacity].opacity;
+            if (alpha < beta)
+              opacity=i;
+          }
+      if (opacity == -1)
+        {
+          (void) SetImageType(image,PaletteBilevelMatteType);
+          for (i=0; i < (ssize_t) image->colors; i++)
+            if (image->colormap[i].opacity != OpaqueOpacity)
+              {
+                if (opacity < 0)
+                  {
+                    opacity=i;
+                    continue;
+                  }
+                alpha=(Quantum) TransparentOpacity-(MagickRealType)
+                  image->colormap[i].opacity;
+                beta=(Quantum) TransparentOpacity-(MagickRealType)
+                  image->colormap[opacity].opacity;
+                if (alpha < beta)
+                  opacity=i;
+              }
+        }
+      if (opacity >= 0)
+        {
+          image->colormap[opacity].red=image->transparent_color.red;
+          image->colormap[opacity].green=image->transparent_color.green;
+          image->colormap[opacity].blue=image->transparent_color.blue;
+        }
+    }
+  *transparent=opacity;
+  if ((image->storage_class == DirectClass) || (image->colors > 256))
+    return(MagickFalse);
+  return(MagickTrue);
+}
+
 static MagickBooleanType WriteGIFImage(const ImageInfo *image_info,Image *image)
 {
+  GIFFrameInfo
+    *frame_info;
+
   Image
     *next_image;
 
@@ -1480,6 +1686,7 @@ static MagickBooleanType WriteGIFImage(const ImageInfo *image_info,Image *image)
     bits_per_pixel,
     delay,
     length,
+    number_frames,
     one;
 
   ssize_t
@@ -1555,75 +1762,70 @@ static MagickBooleanType WriteGIFImage(const ImageInfo *image_info,Image *image)
   if ((write_info->adjoin != MagickFalse) &&
       (GetNextImageInList(image) != (Image *) NULL))
     interlace=NoInterlace;
-  scene=0;
+  /*
+    Reduce each frame to a colormapped image, then compress the frames.  Once
+    colormapped the frames are independent, so their rasters are encoded
+    concurrently and written in order below.  Each frame records its own
+    status; the OpenMP region raises no exceptions.
+  */
+  number_frames=1;
+  if (write_info->adjoin != MagickFalse)
+    for (next_image=GetNextImageInList(image); next_image != (Image *) NULL; )
+    {
+      number_frames++;
+      next_image=GetNextImageInList(next_image);
+    }
+  frame_info=(GIFFrameInfo *) AcquireQuantumMemory(number_frames,
+    sizeof(*frame_info));
+  if (frame_info == (GIFFrameInfo *) NULL)
+    {
+      global_colormap=(unsigned char *) RelinquishMagickMemory(
+        global_colormap);
+      colormap=(unsigned char *) RelinquishMagickMemory(colormap);
+      write_info=DestroyImageInfo(write_info);
+      ThrowWriterException(ResourceLimitError,"MemoryAllocationFailed");
+    }
+  (void) ResetMagickMemory(frame_info,0,number_frames*sizeof(*frame_info));
   one=1;
-  do
+  next_image=image;
+  for (i=0; i < (ssize_t) number_frames; i++)
   {
-    if (IsRGBColorspace(image->colorspace) == MagickFalse)
-      (void) TransformImageColorspace(image,RGBColorspace);
-    opacity=(-1);
-    if (IsOpaqueImage(image,&image->exception) != MagickFalse)
-      {
-        if ((image->storage_class == DirectClass) || (image->colors > 256))
-          (void) SetImageType(image,PaletteType);
-      }
-    else
-      {
-        MagickRealType
-          alpha,
-          beta;
-
-        /*
-          Identify transparent colormap index.
-        */
-        if ((image->storage_class == DirectClass) || (image->colors > 256))
-          (void) SetImageType(image,PaletteBilevelMatteType);
-        for (i=0; i < (ssize_t) image->colors; i++)
-          if (image->colormap[i].opacity != OpaqueOpacity)
-            {
-              if (opacity < 0)
-                {
-                  opacity=i;
-                  continue;
-                }
-              alpha=(MagickRealType) TransparentOpacity-(MagickRealType)
-                image->colormap[i].opacity;
-              beta=(MagickRealType) TransparentOpacity-(MagickRealType)
-                image->colormap[opacity].opacity;
-              if (alpha < beta)
-                opacity=i;
-            }
-        if (opacity == -1)
-          {
-            (void) SetImageType(image,PaletteBilevelMatteType);
-            for (i=0; i < (ssize_t) image->colors; i++)
-              if (image->colormap[i].opacity != OpaqueOpacity)
-                {
-                  if (opacity < 0)
-                    {
-                      opacity=i;
-                      continue;
-                    }
-                  alpha=(Quantum) TransparentOpacity-(MagickRealType)
-                    image->colormap[i].opacity;
-                  beta=(Quantum) TransparentOpacity-(MagickRealType)
-                    image->colormap[opacity].opacity;
-                  if (alpha < beta)
-                    opacity=i;
-                }
-          }
-        if (opacity >= 0)
-          {
-            image->colormap[opacity].red=image->transparent_color.red;
-            image->colormap[opacity].green=image->transparent_color.green;
-            image->colormap[opacity].blue=image->transparent_color.blue;
-          }
-      }
-    if ((image->storage_class == DirectClass) || (image->colors > 256))
-      ThrowWriterException(ResourceLimitError,"MemoryAllocationFailed");
+    frame_info[i].image=next_image;
+    if (SetGIFImagePalette(next_image,&frame_info[i].opacity) == MagickFalse)
+      break;
     for (bits_per_pixel=1; bits_per_pixel < 8; bits_per_pixel++)
-      if ((one << bits_per_pixel) >= image->colors)
+      if ((one << bits_per_pixel) >= next_image->colors)
         break;
+    frame_info[i].bits_per_pixel=bits_per_pixel;
+    next_image=GetNextImageInList(next_image);
+  }
+  status=i < (ssize_t) number_frames ? MagickFalse : MagickTrue;
+  if (status != MagickFalse)
+    {
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+      #pragma omp parallel for schedule(dynamic,1)
+#endif
+      for (i=0; i < (ssize_t) number_frames; i++)
+        frame_info[i].status=EncodeImage(write_info,frame_info+i,(size_t)
+          MagickMax(frame_info[i].bits_per_pixel,2)+1);
+      for (i=0; i < (ssize_t) number_frames; i++)
+        if (frame_info[i].status == MagickFalse)
+          status=MagickFalse;
+    }
+  if (status == MagickFalse)
+    {
+      frame_info=DestroyGIFFrameInfo(frame_info,number_frames);
+      global_colormap=(unsigned char *) RelinquishMagickMemory(
+        global_colormap);
+      colormap=(unsigned char *) RelinquishMagickMemory(colormap);
+      write_info=DestroyImageInfo(write_info);
+      ThrowWriterException(ResourceLimitError,"MemoryAllocationFailed");
+    }
+  scene=0;
+  do
+  {
+    opacity=frame_info[scene].opacity;
+    bits_per_pixel=frame_info[scene].bits_per_pixel;
     q=colormap;
     for (i=0; i < (ssize_t) image->colors; i++)
     {
@@ -1852,15 +2054,7 @@ static MagickBooleanType WriteGIFImage(const ImageInfo *image_info,Image *image)
     */
     c=(int) MagickMax(bits_per_pixel,2);
     (void) WriteBlobByte(image,(unsigned char) c);
-    status=EncodeImage(write_info,image,(size_t) MagickMax(bits_per_pixel,2)+1);
-    if (status == MagickFalse)
-      {
-        global_colormap=(unsigned char *) RelinquishMagickMemory(
-          global_colormap);
-        colormap=(unsigned char *) RelinquishMagickMemory(colormap);
-        write_info=DestroyImageInfo(write_info);
-        ThrowWriterException(ResourceLimitError,"MemoryAllocationFailed");
-      }
+    (void) WriteBlob(image,frame_info[scene].extent,frame_info[scene].raster);
     (void) WriteBlobByte(image,(unsigned char) 0x00);
     if (GetNextImageInList(image) == (Image *) NULL)
       break;
@@ -1872,6 +2066,7 @@ static MagickBooleanType WriteGIFImage(const ImageInfo *image_info,Image *image)
       break;
   } while (write_info->adjoin != MagickFalse);
   (void) WriteBlobByte(image,';'); /* terminator */
+  frame_info=DestroyGIFFrameInfo(frame_info,number_frames);
   global_colormap=(unsigned char *) RelinquishMagickMemory(global_colormap);
   colormap=(unsigned char *) RelinquishMagickMemory(colormap);
   write_info=DestroyImageInfo(write_info);
@@ -79,6 +79,7 @@
 #include "magick/statistic.h"
 #include "magick/string_.h"
 #include "magick/string-private.h"
+#include "magick/thread-private.h"
 #include "magick/transform.h"
 #include "magick/utility.h"
 #if defined(MAGICKCORE_PNG_DELEGATE)
@@ -673,9 +674,12 @@ static png_byte mng_pHYs[5]={112,  72,  89, 115, (png_byte) '\0'};
 static png_byte mng_sBIT[5]={115,  66,  73,  84, (png_byte) '\0'};
 static png_byte mng_sRGB[5]={115,  82,  71,  66, (png_byte) '\0'};
 static png_byte mng_tRNS[5]={116,  82,  78,  83, (png_byte) '\0'};
+static png_byte mng_IDAT[5]={ 73,  68,  65,  84, (png_byte) '\0'};
+static png_byte mng_iTXt[5]={105,  84,  88, 116, (png_byte) '\0'};
+static png_byte mng_tEXt[5]={116,  69,  88, 116, (png_byte) '\0'};
+static png_byte mng_zTXt[5]={122,  84,  88, 116, (png_byte) '\0'};
 
 #if defined(JNG_SUPPORTED)
-static png_byte mng_IDAT[5]={ 73,  68,  65,  84, (png_byte) '\0'};
 static png_byte mng_JDAT[5]={ 74,  68,  65,  84, (png_byte) '\0'};
 static png_byte mng_JDAA[5]={ 74,  68,  65,  65, (png_byte) '\0'};
 static png_byte mng_JdAA[5]={ 74, 100,  65,  65, (png_byte) '\0'};
@@ -687,12 +691,9 @@ static png_byte mng_oFFs[5]={111,  70,  70, 115, (png_byte) '\0'};
 Other known chunks that are not yet supported by ImageMagick:
 static png_byte mng_hIST[5]={104,  73,  83,  84, (png_byte) '\0'};
 static png_byte mng_iCCP[5]={105,  67,  67,  80, (png_byte) '\0'};
-static png_byte mng_iTXt[5]={105,  84,  88, 116, (png_byte) '\0'};
 static png_byte mng_sPLT[5]={115,  80,  76,  84, (png_byte) '\0'};
 static png_byte mng_sTER[5]={115,  84,  69,  82, (png_byte) '\0'};
-static png_byte mng_tEXt[5]={116,  69,  88, 116, (png_byte) '\0'};
 static png_byte mng_tIME[5]={116,  73,  77,  69, (png_byte) '\0'};
-static png_byte mng_zTXt[5]={122,  84,  88, 116, (png_byte) '\0'};
 */
 
 typedef struct _MngBox
@@ -833,6 +834,9 @@ typedef struct _MngInfo
   float
     global_gamma;
 
+  double
+    write_png_optimize_time;
+
   ChromaticityInfo
     global_chrm;
 
@@ -872,6 +876,8 @@ typedef struct _MngInfo
     write_png_compression_level,
     write_png_compression_strategy,
     write_png_compression_filter,
+    write_png_optimize,
+    write_png_parallel,
     write_png8,
     write_png24,
     write_png32;
@@ -2008,6 +2014,7 @@ static Image *ReadOnePNGImage(MngInfo *mng_info,
 
   MagickBooleanType
     logging,
+    ping_direct,
     status;
 
   png_bytep
@@ -2646,6 +2653,33 @@ static Image *ReadOnePNGImage(MngInfo *mng_info,
       if (!png_get_valid(ping,ping_info,PNG_INFO_sBIT))
         png_set_sBIT(ping,ping_info,&mng_info->global_sbit);
     }
+#endif
+  /*
+    Let libpng lay 8-bit RGB and RGBA rows out as pixel packets, and 8-bit
+    gray and indexed rows as colormap indexes, so they are decoded straight
+    into the pixel cache.
+  */
+  ping_direct=MagickFalse;
+#if (MAGICKCORE_QUANTUM_DEPTH == 8) && !defined(MAGICKCORE_HDRI_SUPPORT)
+  if (ping_bit_depth == 8)
+    {
+      if (((int) ping_color_type == PNG_COLOR_TYPE_RGB) ||
+          ((int) ping_color_type == PNG_COLOR_TYPE_RGB_ALPHA))
+        {
+#if defined(MAGICK_PIXEL_BGRA)
+          png_set_bgr(ping);
+#endif
+          if ((int) ping_color_type == PNG_COLOR_TYPE_RGB)
+            png_set_filler(ping,(png_uint_32) OpaqueOpacity,
+              PNG_FILLER_AFTER);
+          else
+            png_set_invert_alpha(ping);
+          ping_direct=MagickTrue;
+        }
+      if (((int) ping_color_type == PNG_COLOR_TYPE_GRAY) ||
+          ((int) ping_color_type == PNG_COLOR_TYPE_PALETTE))
+        ping_direct=MagickTrue;
+    }
 #endif
   num_passes=png_set_interlace_handling(ping);
 
@@ -2813,16 +2847,28 @@ static Image *ReadOnePNGImage(MngInfo *mng_info,
     (void) LogMagickEvent(CoderEvent,GetMagickModule(),
       "    Reading PNG IDAT chunk(s)");
 
-  if (num_passes > 1)
-    ping_pixels=(unsigned char *) AcquireQuantumMemory(image->rows,
-      ping_rowbytes*sizeof(*ping_pixels));
+  ping_pixels=(unsigned char *) NULL;
+
+  if (ping_direct != MagickFalse)
+    {
+      if (logging != MagickFalse)
+        (void) LogMagickEvent(CoderEvent,GetMagickModule(),
+          "    Decoding PNG rows directly into the pixel cache");
+    }
 
   else
-    ping_pixels=(unsigned char *) AcquireQuantumMemory(ping_rowbytes,
-      sizeof(*ping_pixels));
+    {
+      if (num_passes > 1)
+        ping_pixels=(unsigned char *) AcquireQuantumMemory(image->rows,
+          ping_rowbytes*sizeof(*ping_pixels));
 
-  if (ping_pixels == (unsigned char *) NULL)
-    ThrowReaderException(ResourceLimitError,"MemoryAllocationFailed");
+      else
+        ping_pixels=(unsigned char *) AcquireQuantumMemory(ping_rowbytes,
+          sizeof(*ping_pixels));
+
+      if (ping_pixels == (unsigned char *) NULL)
+        ThrowReaderException(ResourceLimitError,"MemoryAllocationFailed");
+    }
 
   if (logging != MagickFalse)
     (void) LogMagickEvent(CoderEvent,GetMagickModule(),
@@ -2890,37 +2936,57 @@ static Image *ReadOnePNGImage(MngInfo *mng_info,
 
         for (y=0; y < (ssize_t) image->rows; y++)
         {
-          if (num_passes > 1)
-            row_offset=ping_rowbytes*y;
+          if (ping_direct != MagickFalse)
+            {
+              /*
+                Later passes fill in the pixels left by earlier ones.
+              */
+              if (pass == 0)
+                q=QueueAuthenticPixels(image,0,y,image->columns,1,exception);
+              else
+                q=GetAuthenticPixels(image,0,y,image->columns,1,exception);
+
+              if (q == (PixelPacket *) NULL)
+                break;
+
+              png_read_row(ping,(png_bytep) q,NULL);
+            }
 
           else
-            row_offset=0;
+            {
+              if (num_passes > 1)
+                row_offset=ping_rowbytes*y;
 
-          png_read_row(ping,ping_pixels+row_offset,NULL);
-          q=QueueAuthenticPixels(image,0,y,image->columns,1,exception);
+              else
+                row_offset=0;
 
-          if (q == (PixelPacket *) NULL)
-            break;
+              png_read_row(ping,ping_pixels+row_offset,NULL);
+              q=QueueAuthenticPixels(image,0,y,image->columns,1,exception);
+
+              if (q == (PixelPacket *) NULL)
+                break;
 
-          if ((int) ping_color_type == PNG_COLOR_TYPE_GRAY)
-            (void) ImportQuantumPixels(image,(CacheView *) NULL,quantum_info,
-              GrayQuantum,ping_pixels+row_offset,exception);
+              if ((int) ping_color_type == PNG_COLOR_TYPE_GRAY)
+                (void) ImportQuantumPixels(image,(CacheView *) NULL,
+                  quantum_info,GrayQuantum,ping_pixels+row_offset,exception);
 
-          else if ((int) ping_color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
-            (void) ImportQuantumPixels(image,(CacheView *) NULL,quantum_info,
-              GrayAlphaQuantum,ping_pixels+row_offset,exception);
+              else if ((int) ping_color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+                (void) ImportQuantumPixels(image,(CacheView *) NULL,
+                  quantum_info,GrayAlphaQuantum,ping_pixels+row_offset,
+                  exception);
 
-          else if ((int) ping_color_type == PNG_COLOR_TYPE_RGB_ALPHA)
-            (void) ImportQuantumPixels(image,(CacheView *) NULL,quantum_info,
-              RGBAQuantum,ping_pixels+row_offset,exception);
+              else if ((int) ping_color_type == PNG_COLOR_TYPE_RGB_ALPHA)
+                (void) ImportQuantumPixels(image,(CacheView *) NULL,
+                  quantum_info,RGBAQuantum,ping_pixels+row_offset,exception);
 
-          else if ((int) ping_color_type == PNG_COLOR_TYPE_PALETTE)
-            (void) ImportQuantumPixels(image,(CacheView *) NULL,quantum_info,
-              IndexQuantum,ping_pixels+row_offset,exception);
+              else if ((int) ping_color_type == PNG_COLOR_TYPE_PALETTE)
+                (void) ImportQuantumPixels(image,(CacheView *) NULL,
+                  quantum_info,IndexQuantum,ping_pixels+row_offset,exception);
 
-          else /* ping_color_type == PNG_COLOR_TYPE_RGB */
-            (void) ImportQuantumPixels(image,(CacheView *) NULL,quantum_info,
-              RGBQuantum,ping_pixels+row_offset,exception);
+              else /* ping_color_type == PNG_COLOR_TYPE_RGB */
+                (void) ImportQuantumPixels(image,(CacheView *) NULL,
+                  quantum_info,RGBQuantum,ping_pixels+row_offset,exception);
+            }
 
           if (found_transparent_pixel == MagickFalse)
             {
@@ -2986,9 +3052,6 @@ static Image *ReadOnePNGImage(MngInfo *mng_info,
 
     for (pass=0; pass < num_passes; pass++)
     {
-      Quantum
-        *quantum_scanline;
-
       register Quantum
         *r;
 
@@ -3002,14 +3065,33 @@ static Image *ReadOnePNGImage(MngInfo *mng_info,
       image->matte=ping_color_type == PNG_COLOR_TYPE_GRAY_ALPHA ?
         MagickTrue : MagickFalse;
 
-      quantum_scanline=(Quantum *) AcquireQuantumMemory(image->columns,
-        (image->matte ?  2 : 1)*sizeof(*quantum_scanline));
-
-      if (quantum_scanline == (Quantum *) NULL)
-        ThrowReaderException(ResourceLimitError,"MemoryAllocationFailed");
-
       for (y=0; y < (ssize_t) image->rows; y++)
       {
+        if (ping_direct != MagickFalse)
+          {
+            q=GetAuthenticPixels(image,0,y,image->columns,1,exception);
+
+            if (q == (PixelPacket *) NULL)
+              break;
+
+            indexes=GetAuthenticIndexQueue(image);
+            png_read_row(ping,(png_bytep) indexes,NULL);
+
+            if (SyncAuthenticPixels(image,exception) == MagickFalse)
+              break;
+
+            if ((image->previous == (Image *) NULL) && (num_passes == 1))
+              {
+                status=SetImageProgress(image,LoadImageTag,
+                  (MagickOffsetType) y,image->rows);
+
+                if (status == MagickFalse)
+                  break;
+              }
+
+            continue;
+          }
+
         if (num_passes > 1)
           row_offset=ping_rowbytes*y;
 
@@ -3022,9 +3104,12 @@ static Image *ReadOnePNGImage(MngInfo *mng_info,
         if (q == (PixelPacket *) NULL)
           break;
 
+        /*
+          Unpack the samples straight into the colormap indexes.
+        */
         indexes=GetAuthenticIndexQueue(image);
         p=ping_pixels+row_offset;
-        r=quantum_scanline;
+        r=(Quantum *) indexes;
 
         switch (ping_bit_depth)
         {
@@ -3162,14 +3247,6 @@ static Image *ReadOnePNGImage(MngInfo *mng_info,
             break;
         }
 
-        /*
-          Transfer image scanline.
-        */
-        r=quantum_scanline;
-
-        for (x=0; x < (ssize_t) image->columns; x++)
-          SetPixelIndex(indexes+x,*r++);
-
         if (SyncAuthenticPixels(image,exception) == MagickFalse)
           break;
 
@@ -3190,8 +3267,6 @@ static Image *ReadOnePNGImage(MngInfo *mng_info,
           if (status == MagickFalse)
             break;
         }
-
-      quantum_scanline=(Quantum *) RelinquishMagickMemory(quantum_scanline);
     }
 
     image->matte=found_transparent_pixel;
@@ -7381,143 +7456,1269 @@ static MagickBooleanType Magick_png_write_chunk_from_profile(Image *image,
 }
 
 
-/* Write one PNG image */
-#ifdef PNG_USE_CLONE
-static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
-   const ImageInfo *IMimage_info,Image *IMimage)
-#else
-static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
-   const ImageInfo *image_info,Image *image)
-#endif
+/*
+  Parallel IDAT encoder, enabled with -define png:parallel=true.
+
+  Rows are collected into strips of about PNGStripExtent bytes, one strip per
+  thread.  Each strip is filtered and then deflated as an independent raw
+  deflate stream whose dictionary is primed with the last 32K of the
+  preceding strip (the pigz scheme), so the compression ratio stays close to
+  that of a single stream.  Every strip but the last ends on a sync flush;
+  the concatenated streams, with a zlib header and the combined Adler-32,
+  form one zlib datastream that is split across IDAT chunks.
+*/
+#define PNGChunkExtent  32768
+#define PNGStripExtent  131072
+#define PNGWindowExtent  32768
+
+typedef struct _PNGStripInfo
 {
-#ifdef PNG_USE_CLONE
   Image
     *image;
 
-  ImageInfo
-    *image_info;
-#endif
-
-  char
-    s[2];
-
-  const char
-    *name,
-    *property,
-    *value;
-
-  const StringInfo
-    *profile;
+  MagickBooleanType
+    logging;
 
   int
-    num_passes,
-    pass;
+    filter_mask,
+    level,
+    strategy;
 
-  png_byte
-     ping_trans_alpha[256];
-
-  png_color
-     palette[257];
-
-  png_color_16
-    ping_background,
-    ping_trans_color;
+  size_t
+    bit_depth,
+    bytes_per_pixel,
+    columns,
+    rows,
+    packed_rowbytes,
+    rows_per_strip,
+    number_strips,
+    rows_buffered,
+    rows_written,
+    window_length,
+    chunk_length;
 
-  png_info
-    *ping_info;
+  unsigned char
+    *pixels,
+    **filtered,
+    **compressed,
+    *window,
+    *chunk;
 
-  png_struct
-    *ping;
+  size_t
+    *filtered_length,
+    *compressed_length,
+    *compressed_extent;
 
-  png_uint_32
-    ping_height,
-    ping_width;
+  uLong
+    *checksum,
+    adler;
+} PNGStripInfo;
 
-  ssize_t
-    y;
+static PNGStripInfo *DestroyPNGStripInfo(PNGStripInfo *strip_info)
+{
+  register ssize_t
+    i;
 
-  MagickBooleanType
-    image_matte,
-    logging,
-    matte,
+  if (strip_info->filtered != (unsigned char **) NULL)
+    {
+      for (i=0; i < (ssize_t) strip_info->number_strips; i++)
+        if (strip_info->filtered[i] != (unsigned char *) NULL)
+          strip_info->filtered[i]=(unsigned char *) RelinquishMagickMemory(
+            strip_info->filtered[i]);
+      strip_info->filtered=(unsigned char **) RelinquishMagickMemory(
+        strip_info->filtered);
+    }
+  if (strip_info->compressed != (unsigned char **) NULL)
+    {
+      for (i=0; i < (ssize_t) strip_info->number_strips; i++)
+        if (strip_info->compressed[i] != (unsigned char *) NULL)
+          strip_info->compressed[i]=(unsigned char *) RelinquishMagickMemory(
+            strip_info->compressed[i]);
+      strip_info->compressed=(unsigned char **) RelinquishMagickMemory(
+        strip_info->compressed);
+    }
+  if (strip_info->filtered_length != (size_t *) NULL)
+    strip_info->filtered_length=(size_t *) RelinquishMagickMemory(
+      strip_info->filtered_length);
+  if (strip_info->compressed_length != (size_t *) NULL)
+    strip_info->compressed_length=(size_t *) RelinquishMagickMemory(
+      strip_info->compressed_length);
+  if (strip_info->compressed_extent != (size_t *) NULL)
+    strip_info->compressed_extent=(size_t *) RelinquishMagickMemory(
+      strip_info->compressed_extent);
+  if (strip_info->checksum != (uLong *) NULL)
+    strip_info->checksum=(uLong *) RelinquishMagickMemory(
+      strip_info->checksum);
+  if (strip_info->pixels != (unsigned char *) NULL)
+    strip_info->pixels=(unsigned char *) RelinquishMagickMemory(
+      strip_info->pixels);
+  if (strip_info->window != (unsigned char *) NULL)
+    strip_info->window=(unsigned char *) RelinquishMagickMemory(
+      strip_info->window);
+  if (strip_info->chunk != (unsigned char *) NULL)
+    strip_info->chunk=(unsigned char *) RelinquishMagickMemory(
+      strip_info->chunk);
+  strip_info=(PNGStripInfo *) RelinquishMagickMemory(strip_info);
+  return((PNGStripInfo *) NULL);
+}
 
-    ping_have_blob,
-    ping_have_cheap_transparency,
-    ping_have_color,
-    ping_have_non_bw,
-    ping_have_PLTE,
-    ping_have_bKGD,
-    ping_have_pHYs,
-    ping_have_tRNS,
+static inline size_t GetPNGChannels(const int color_type)
+{
+  switch (color_type)
+  {
+    case PNG_COLOR_TYPE_GRAY_ALPHA: return(2);
+    case PNG_COLOR_TYPE_RGB: return(3);
+    case PNG_COLOR_TYPE_RGBA: return(4);
+    default: break;
+  }
+  return(1);
+}
 
-    ping_exclude_bKGD,
-    ping_exclude_cHRM,
-    ping_exclude_date,
-    /* ping_exclude_EXIF, */
-    ping_exclude_gAMA,
-    ping_exclude_iCCP,
-    /* ping_exclude_iTXt, */
-    ping_exclude_oFFs,
-    ping_exclude_pHYs,
-    ping_exclude_sRGB,
-    ping_exclude_tEXt,
-    /* ping_exclude_tRNS, */
-    ping_exclude_vpAg,
-    ping_exclude_zCCP, /* hex-encoded iCCP */
-    ping_exclude_zTXt,
+static PNGStripInfo *AcquirePNGStripInfo(Image *image,const size_t columns,
+  const size_t rows,const int color_type,const int bit_depth,
+  const int filter_mask,const int level,const int strategy,
+  const MagickBooleanType logging)
+{
+  PNGStripInfo
+    *strip_info;
 
-    ping_preserve_colormap,
-    ping_need_colortype_warning,
+  register ssize_t
+    i;
 
-    status,
-    tried_332,
-    tried_333,
-    tried_444;
+  size_t
+    channels,
+    extent;
+
+  strip_info=(PNGStripInfo *) AcquireMagickMemory(sizeof(*strip_info));
+  if (strip_info == (PNGStripInfo *) NULL)
+    return((PNGStripInfo *) NULL);
+  (void) ResetMagickMemory(strip_info,0,sizeof(*strip_info));
+  channels=GetPNGChannels(color_type);
+  strip_info->image=image;
+  strip_info->logging=logging;
+  strip_info->filter_mask=filter_mask;
+  strip_info->level=level;
+  strip_info->strategy=strategy;
+  strip_info->bit_depth=(size_t) bit_depth;
+  strip_info->columns=columns;
+  strip_info->rows=rows;
+  strip_info->packed_rowbytes=(columns*channels*bit_depth+7)/8;
+  strip_info->bytes_per_pixel=(channels*bit_depth+7)/8;
+  strip_info->rows_per_strip=(PNGStripExtent+strip_info->packed_rowbytes)/
+    (strip_info->packed_rowbytes+1);
+  if (strip_info->rows_per_strip > rows)
+    strip_info->rows_per_strip=rows;
+  strip_info->number_strips=GetOpenMPMaximumThreads();
+  if ((strip_info->number_strips*strip_info->rows_per_strip) > rows)
+    strip_info->number_strips=(rows+strip_info->rows_per_strip-1)/
+      strip_info->rows_per_strip;
+  strip_info->adler=adler32(0L,Z_NULL,0);
+  /*
+    The pixel buffer holds one batch of rows preceded by the last row of the
+    previous batch, which the Up, Average, and Paeth filters refer to.
+  */
+  strip_info->pixels=(unsigned char *) AcquireQuantumMemory(
+    strip_info->number_strips*strip_info->rows_per_strip+1,
+    strip_info->packed_rowbytes*sizeof(*strip_info->pixels));
+  strip_info->window=(unsigned char *) AcquireQuantumMemory(PNGWindowExtent,
+    sizeof(*strip_info->window));
+  strip_info->chunk=(unsigned char *) AcquireQuantumMemory(PNGChunkExtent+4,
+    sizeof(*strip_info->chunk));
+  strip_info->filtered=(unsigned char **) AcquireQuantumMemory(
+    strip_info->number_strips,sizeof(*strip_info->filtered));
+  strip_info->compressed=(unsigned char **) AcquireQuantumMemory(
+    strip_info->number_strips,sizeof(*strip_info->compressed));
+  strip_info->filtered_length=(size_t *) AcquireQuantumMemory(
+    strip_info->number_strips,sizeof(*strip_info->filtered_length));
+  strip_info->compressed_length=(size_t *) AcquireQuantumMemory(
+    strip_info->number_strips,sizeof(*strip_info->compressed_length));
+  strip_info->compressed_extent=(size_t *) AcquireQuantumMemory(
+    strip_info->number_strips,sizeof(*strip_info->compressed_extent));
+  strip_info->checksum=(uLong *) AcquireQuantumMemory(
+    strip_info->number_strips,sizeof(*strip_info->checksum));
+  if ((strip_info->pixels == (unsigned char *) NULL) ||
+      (strip_info->window == (unsigned char *) NULL) ||
+      (strip_info->chunk == (unsigned char *) NULL) ||
+      (strip_info->filtered == (unsigned char **) NULL) ||
+      (strip_info->compressed == (unsigned char **) NULL) ||
+      (strip_info->filtered_length == (size_t *) NULL) ||
+      (strip_info->compressed_length == (size_t *) NULL) ||
+      (strip_info->compressed_extent == (size_t *) NULL) ||
+      (strip_info->checksum == (uLong *) NULL))
+    return(DestroyPNGStripInfo(strip_info));
+  (void) ResetMagickMemory(strip_info->pixels,0,
+    strip_info->packed_rowbytes*sizeof(*strip_info->pixels));
+  (void) ResetMagickMemory(strip_info->filtered,0,strip_info->number_strips*
+    sizeof(*strip_info->filtered));
+  (void) ResetMagickMemory(strip_info->compressed,0,strip_info->number_strips*
+    sizeof(*strip_info->compressed));
+  /*
+    Each filtered strip is followed by scratch space for the five candidate
+    filters of one row.
+  */
+  extent=(strip_info->rows_per_strip+5)*(strip_info->packed_rowbytes+1);
+  for (i=0; i < (ssize_t) strip_info->number_strips; i++)
+  {
+    strip_info->filtered[i]=(unsigned char *) AcquireQuantumMemory(extent,
+      sizeof(**strip_info->filtered));
+    if (strip_info->filtered[i] == (unsigned char *) NULL)
+      return(DestroyPNGStripInfo(strip_info));
+    strip_info->compressed_extent[i]=0;
+  }
+  PNGType(strip_info->chunk,mng_IDAT);
+  if (logging != MagickFalse)
+    (void) LogMagickEvent(CoderEvent,GetMagickModule(),
+      "    Parallel IDAT: %.20g rows per strip, %.20g strips per batch",
+      (double) strip_info->rows_per_strip,(double) strip_info->number_strips);
+  return(strip_info);
+}
 
-  QuantumInfo
-    *quantum_info;
+static inline unsigned char PaethPredictor(const unsigned char a,
+  const unsigned char b,const unsigned char c)
+{
+  ssize_t
+    pa,
+    pb,
+    pc;
+
+  pa=(ssize_t) b-c;
+  pb=(ssize_t) a-c;
+  pc=pa+pb;
+  if (pa < 0)
+    pa=(-pa);
+  if (pb < 0)
+    pb=(-pb);
+  if (pc < 0)
+    pc=(-pc);
+  if ((pa <= pb) && (pa <= pc))
+    return(a);
+  if (pb <= pc)
+    return(b);
+  return(c);
+}
 
+static size_t ApplyPNGFilter(const int filter,const unsigned char *prior,
+  const unsigned char *row,const size_t length,const size_t bpp,
+  unsigned char *q)
+{
   register ssize_t
-    i,
-    x;
+    i;
 
-  unsigned char
-    *ping_pixels;
+  size_t
+    cost;
 
-  volatile int
-    image_colors,
-    ping_bit_depth,
-    ping_color_type,
-    ping_interlace_method,
-    ping_compression_method,
-    ping_filter_method,
-    ping_num_trans;
+  /*
+    Filter one row; the cost is the sum of the absolute values of the
+    filtered bytes taken as signed, the heuristic libpng uses.
+  */
+  *q++=(unsigned char) filter;
+  for (i=0; i < (ssize_t) length; i++)
+  {
+    unsigned char
+      a,
+      b,
+      c;
+
+    a=(unsigned char) (i >= (ssize_t) bpp ? row[i-bpp] : 0);
+    b=prior[i];
+    c=(unsigned char) (i >= (ssize_t) bpp ? prior[i-bpp] : 0);
+    switch (filter)
+    {
+      case PNG_FILTER_VALUE_SUB: q[i]=(unsigned char) (row[i]-a); break;
+      case PNG_FILTER_VALUE_UP: q[i]=(unsigned char) (row[i]-b); break;
+      case PNG_FILTER_VALUE_AVG:
+      {
+        q[i]=(unsigned char) (row[i]-(((size_t) a+b) >> 1));
+        break;
+      }
+      case PNG_FILTER_VALUE_PAETH:
+      {
+        q[i]=(unsigned char) (row[i]-PaethPredictor(a,b,c));
+        break;
+      }
+      default: q[i]=row[i]; break;
+    }
+  }
+  cost=0;
+  for (i=0; i < (ssize_t) length; i++)
+    cost+=q[i] < 128 ? q[i] : 256-q[i];
+  return(cost);
+}
 
-  volatile size_t
-    image_depth,
-    old_bit_depth;
+static void FilterPNGRow(const int filter_mask,const unsigned char *prior,
+  const unsigned char *row,const size_t length,const size_t bpp,
+  unsigned char *filtered,unsigned char *scratch)
+{
+  int
+    best,
+    filter,
+    number_filters;
 
   size_t
-    quality,
-    rowbytes,
-    save_image_depth;
+    cost,
+    minimum_cost;
+
+  number_filters=0;
+  best=PNG_FILTER_VALUE_NONE;
+  for (filter=PNG_FILTER_VALUE_NONE; filter <= PNG_FILTER_VALUE_PAETH; filter++)
+    if ((filter_mask & (PNG_FILTER_NONE << filter)) != 0)
+      {
+        best=filter;
+        number_filters++;
+      }
+  if (number_filters <= 1)
+    {
+      (void) ApplyPNGFilter(best,prior,row,length,bpp,filtered);
+      return;
+    }
+  minimum_cost=(~0UL);
+  for (filter=PNG_FILTER_VALUE_NONE; filter <= PNG_FILTER_VALUE_PAETH; filter++)
+  {
+    if ((filter_mask & (PNG_FILTER_NONE << filter)) == 0)
+      continue;
+    cost=ApplyPNGFilter(filter,prior,row,length,bpp,scratch+filter*(length+1));
+    if (cost < minimum_cost)
+      {
+        minimum_cost=cost;
+        best=filter;
+      }
+  }
+  (void) CopyMagickMemory(filtered,scratch+best*(length+1),length+1);
+}
 
+static MagickBooleanType DeflatePNGStrip(PNGStripInfo *strip_info,
+  const ssize_t strip,const unsigned char *dictionary,const size_t length,
+  const int flush)
+{
   int
-    j,
-    number_colors,
-    number_opaque,
-    number_semitransparent,
-    number_transparent,
-    ping_pHYs_unit_type;
+    status;
 
-  png_uint_32
-    ping_pHYs_x_resolution,
-    ping_pHYs_y_resolution;
+  size_t
+    extent;
 
-  logging=LogMagickEvent(CoderEvent,GetMagickModule(),
-    "  Enter WriteOnePNGImage()");
+  z_stream
+    stream;
 
-#ifdef PNG_USE_CLONE
+  (void) ResetMagickMemory(&stream,0,sizeof(stream));
+  if (deflateInit2(&stream,strip_info->level,Z_DEFLATED,-MAX_WBITS,9,
+      strip_info->strategy) != Z_OK)
+    return(MagickFalse);
+  if (length != 0)
+    (void) deflateSetDictionary(&stream,dictionary,(uInt) length);
+  extent=(size_t) deflateBound(&stream,(uLong)
+    strip_info->filtered_length[strip])+64;
+  if (extent > strip_info->compressed_extent[strip])
+    {
+      strip_info->compressed[strip]=(unsigned char *) ResizeQuantumMemory(
+        strip_info->compressed[strip],extent,
+        sizeof(**strip_info->compressed));
+      if (strip_info->compressed[strip] == (unsigned char *) NULL)
+        {
+          strip_info->compressed_extent[strip]=0;
+          (void) deflateEnd(&stream);
+          return(MagickFalse);
+        }
+      strip_info->compressed_extent[strip]=extent;
+    }
+  stream.next_in=strip_info->filtered[strip];
+  stream.avail_in=(uInt) strip_info->filtered_length[strip];
+  stream.next_out=strip_info->compressed[strip];
+  stream.avail_out=(uInt) strip_info->compressed_extent[strip];
+  status=deflate(&stream,flush);
+  strip_info->compressed_length[strip]=(size_t) stream.total_out;
+  (void) deflateEnd(&stream);
+  if ((stream.avail_in != 0) || (stream.avail_out == 0) ||
+      ((flush == Z_FINISH) && (status != Z_STREAM_END)))
+    return(MagickFalse);
+  return(MagickTrue);
+}
+
+static void WritePNGChunk(Image *image,png_bytep chunk,const size_t length,
+  const MagickBooleanType logging)
+{
+  /*
+    The chunk buffer holds the chunk type followed by the chunk data.
+  */
+  (void) WriteBlobMSBULong(image,length);
+  LogPNGChunk(logging,chunk,length);
+  (void) WriteBlob(image,length+4,chunk);
+  (void) WriteBlobMSBULong(image,crc32(0,chunk,(uInt) length+4));
+}
+
+static void WritePNGIDAT(PNGStripInfo *strip_info,const unsigned char *data,
+  const size_t length)
+{
+  register ssize_t
+    i;
+
+  size_t
+    count;
+
+  for (i=0; i < (ssize_t) length; i+=(ssize_t) count)
+  {
+    count=PNGChunkExtent-strip_info->chunk_length;
+    if (count > (length-i))
+      count=length-i;
+    (void) CopyMagickMemory(strip_info->chunk+4+strip_info->chunk_length,
+      data+i,count);
+    strip_info->chunk_length+=count;
+    if (strip_info->chunk_length == PNGChunkExtent)
+      {
+        WritePNGChunk(strip_info->image,strip_info->chunk,
+          strip_info->chunk_length,strip_info->logging);
+        strip_info->chunk_length=0;
+      }
+  }
+}
+
+static MagickBooleanType FlushPNGStrips(PNGStripInfo *strip_info)
+{
+  MagickBooleanType
+    finish,
+    status;
+
+  register ssize_t
+    i;
+
+  size_t
+    number_strips,
+    rowbytes;
+
+  unsigned char
+    trailer[4];
+
+  if (strip_info->rows_buffered == 0)
+    return(MagickTrue);
+  rowbytes=strip_info->packed_rowbytes;
+  number_strips=(strip_info->rows_buffered+strip_info->rows_per_strip-1)/
+    strip_info->rows_per_strip;
+  finish=(strip_info->rows_written+strip_info->rows_buffered) >=
+    strip_info->rows ? MagickTrue : MagickFalse;
+  status=MagickTrue;
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for schedule(static,1) shared(status)
+#endif
+  for (i=0; i < (ssize_t) number_strips; i++)
+  {
+    register ssize_t
+      y;
+
+    register unsigned char
+      *q;
+
+    size_t
+      rows;
+
+    rows=strip_info->rows_per_strip;
+    if (((i+1)*rows) > strip_info->rows_buffered)
+      rows=strip_info->rows_buffered-i*rows;
+    q=strip_info->filtered[i];
+    for (y=0; y < (ssize_t) rows; y++)
+    {
+      const unsigned char
+        *p;
+
+      p=strip_info->pixels+(i*strip_info->rows_per_strip+y)*rowbytes;
+      FilterPNGRow(strip_info->filter_mask,p,p+rowbytes,rowbytes,
+        strip_info->bytes_per_pixel,q,strip_info->filtered[i]+
+        strip_info->rows_per_strip*(rowbytes+1));
+      q+=rowbytes+1;
+    }
+    strip_info->filtered_length[i]=rows*(rowbytes+1);
+    strip_info->checksum[i]=adler32(adler32(0L,Z_NULL,0),
+      strip_info->filtered[i],(uInt) strip_info->filtered_length[i]);
+  }
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for schedule(static,1) shared(status)
+#endif
+  for (i=0; i < (ssize_t) number_strips; i++)
+  {
+    const unsigned char
+      *dictionary;
+
+    int
+      flush;
+
+    size_t
+      length;
+
+    dictionary=strip_info->window;
+    length=strip_info->window_length;
+    if (i > 0)
+      {
+        length=MagickMin(strip_info->filtered_length[i-1],PNGWindowExtent);
+        dictionary=strip_info->filtered[i-1]+
+          strip_info->filtered_length[i-1]-length;
+      }
+    flush=Z_SYNC_FLUSH;
+    if ((finish != MagickFalse) && (i == (ssize_t) (number_strips-1)))
+      flush=Z_FINISH;
+    if (DeflatePNGStrip(strip_info,i,dictionary,length,flush) == MagickFalse)
+      status=MagickFalse;
+  }
+  if (status == MagickFalse)
+    return(MagickFalse);
+  if (strip_info->rows_written == 0)
+    {
+      unsigned char
+        header[2];
+
+      unsigned int
+        level,
+        value;
+
+      /*
+        zlib header: deflate with a 32K window and the compression level hint.
+      */
+      level=2;
+      if ((strip_info->strategy >= Z_HUFFMAN_ONLY) ||
+          ((strip_info->level >= 0) && (strip_info->level < 2)))
+        level=0;
+      else if ((strip_info->level >= 2) && (strip_info->level < 6))
+        level=1;
+      else if (strip_info->level > 6)
+        level=3;
+      value=(0x78 << 8) | (level << 6);
+      value+=31-(value % 31);
+      header[0]=(unsigned char) (value >> 8);
+      header[1]=(unsigned char) value;
+      WritePNGIDAT(strip_info,header,2);
+    }
+  for (i=0; i < (ssize_t) number_strips; i++)
+  {
+    WritePNGIDAT(strip_info,strip_info->compressed[i],
+      strip_info->compressed_length[i]);
+    strip_info->adler=adler32_combine(strip_info->adler,
+      strip_info->checksum[i],(z_off_t) strip_info->filtered_length[i]);
+  }
+  /*
+    Carry the dictionary window and the prior row into the next batch.
+  */
+  i=(ssize_t) number_strips-1;
+  strip_info->window_length=MagickMin(strip_info->filtered_length[i],
+    PNGWindowExtent);
+  (void) CopyMagickMemory(strip_info->window,strip_info->filtered[i]+
+    strip_info->filtered_length[i]-strip_info->window_length,
+    strip_info->window_length);
+  (void) CopyMagickMemory(strip_info->pixels,strip_info->pixels+
+    strip_info->rows_buffered*rowbytes,rowbytes);
+  strip_info->rows_written+=strip_info->rows_buffered;
+  strip_info->rows_buffered=0;
+  if (finish != MagickFalse)
+    {
+      PNGLong(trailer,(png_uint_32) strip_info->adler);
+      WritePNGIDAT(strip_info,trailer,4);
+      if (strip_info->chunk_length != 0)
+        WritePNGChunk(strip_info->image,strip_info->chunk,
+          strip_info->chunk_length,strip_info->logging);
+      strip_info->chunk_length=0;
+    }
+  return(MagickTrue);
+}
+
+static void PackPNGRow(const unsigned char *pixels,const size_t columns,
+  const size_t bit_depth,const size_t packed_rowbytes,unsigned char *q)
+{
+  register ssize_t
+    x;
+
+  size_t
+    mask,
+    shift;
+
+  if (bit_depth >= 8)
+    {
+      (void) CopyMagickMemory(q,pixels,packed_rowbytes);
+      return;
+    }
+  /*
+    Pack one sample per byte the way png_set_packing() does.
+  */
+  mask=(1UL << bit_depth)-1;
+  (void) ResetMagickMemory(q,0,packed_rowbytes);
+  shift=8-bit_depth;
+  for (x=0; x < (ssize_t) columns; x++)
+  {
+    size_t
+      value;
+
+    value=(size_t) pixels[x] & mask;
+    if ((bit_depth == 1) && (pixels[x] != 0))
+      value=1;
+    *q|=(unsigned char) (value << shift);
+    if (shift == 0)
+      {
+        q++;
+        shift=8;
+      }
+    shift-=bit_depth;
+  }
+}
+
+static MagickBooleanType WritePNGStripRow(PNGStripInfo *strip_info,
+  const unsigned char *pixels)
+{
+  PackPNGRow(pixels,strip_info->columns,strip_info->bit_depth,
+    strip_info->packed_rowbytes,strip_info->pixels+
+    (strip_info->rows_buffered+1)*strip_info->packed_rowbytes);
+  strip_info->rows_buffered++;
+  if ((strip_info->rows_buffered == (strip_info->number_strips*
+       strip_info->rows_per_strip)) ||
+      ((strip_info->rows_written+strip_info->rows_buffered) >=
+       strip_info->rows))
+    return(FlushPNGStrips(strip_info));
+  return(MagickTrue);
+}
+
+/*
+  Filter and compression search, enabled with -define png:optimize=true.
+
+  The first rows of a non-interlaced image, about PNGOptimizeExtent bytes of
+  filtered data, are buffered as they are produced and filtered and deflated
+  with each candidate filter, strategy, and level until the CPU time budget
+  is spent.  The settings that gave the smallest sample are then handed to
+  libpng before png_write_info(), the buffered rows are written, and the
+  remaining rows stream through as usual.
+*/
+#define PNGOptimizeExtent  262144
+
+typedef struct _PNGOptimizeInfo
+{
+  Image
+    *image;
+
+  png_info
+    *ping_info;
+
+  MagickBooleanType
+    exclude_vpAg,
+    logging;
+
+  int
+    filter_mask,
+    level,
+    strategy;
+
+  double
+    time_limit;
+
+  size_t
+    bit_depth,
+    bytes_per_pixel,
+    columns,
+    rows,
+    rowbytes,
+    packed_rowbytes,
+    rows_buffered,
+    sample_rows;
+
+  unsigned char
+    *pixels;
+} PNGOptimizeInfo;
+
+static PNGOptimizeInfo *DestroyPNGOptimizeInfo(PNGOptimizeInfo *optimize_info)
+{
+  if (optimize_info->pixels != (unsigned char *) NULL)
+    optimize_info->pixels=(unsigned char *) RelinquishMagickMemory(
+      optimize_info->pixels);
+  optimize_info=(PNGOptimizeInfo *) RelinquishMagickMemory(optimize_info);
+  return((PNGOptimizeInfo *) NULL);
+}
+
+static PNGOptimizeInfo *AcquirePNGOptimizeInfo(Image *image,
+  png_info *ping_info,const size_t columns,const size_t rows,
+  const size_t rowbytes,const int color_type,const int bit_depth,
+  const int filter_mask,const int level,const int strategy,
+  const double time_limit,const MagickBooleanType exclude_vpAg,
+  const MagickBooleanType logging)
+{
+  PNGOptimizeInfo
+    *optimize_info;
+
+  size_t
+    channels;
+
+  optimize_info=(PNGOptimizeInfo *) AcquireMagickMemory(
+    sizeof(*optimize_info));
+  if (optimize_info == (PNGOptimizeInfo *) NULL)
+    return((PNGOptimizeInfo *) NULL);
+  (void) ResetMagickMemory(optimize_info,0,sizeof(*optimize_info));
+  channels=GetPNGChannels(color_type);
+  optimize_info->image=image;
+  optimize_info->ping_info=ping_info;
+  optimize_info->exclude_vpAg=exclude_vpAg;
+  optimize_info->logging=logging;
+  optimize_info->filter_mask=filter_mask;
+  optimize_info->level=level;
+  optimize_info->strategy=strategy;
+  optimize_info->time_limit=time_limit;
+  optimize_info->bit_depth=(size_t) bit_depth;
+  optimize_info->bytes_per_pixel=(channels*bit_depth+7)/8;
+  optimize_info->columns=columns;
+  optimize_info->rows=rows;
+  optimize_info->rowbytes=rowbytes;
+  optimize_info->packed_rowbytes=(columns*channels*bit_depth+7)/8;
+  optimize_info->sample_rows=MagickMin(MagickMax(PNGOptimizeExtent/
+    (optimize_info->packed_rowbytes+1),1),rows);
+  optimize_info->pixels=(unsigned char *) AcquireQuantumMemory(
+    optimize_info->sample_rows,rowbytes*sizeof(*optimize_info->pixels));
+  if (optimize_info->pixels == (unsigned char *) NULL)
+    return(DestroyPNGOptimizeInfo(optimize_info));
+  return(optimize_info);
+}
+
+static size_t DeflatePNGSample(const unsigned char *sample,const size_t length,
+  const int level,const int strategy,unsigned char *compressed,
+  const size_t extent)
+{
+  z_stream
+    stream;
+
+  (void) ResetMagickMemory(&stream,0,sizeof(stream));
+  if (deflateInit2(&stream,level,Z_DEFLATED,MAX_WBITS,8,strategy) != Z_OK)
+    return(~0UL);
+  stream.next_in=(Bytef *) sample;
+  stream.avail_in=(uInt) length;
+  stream.next_out=compressed;
+  stream.avail_out=(uInt) extent;
+  if (deflate(&stream,Z_FINISH) != Z_STREAM_END)
+    {
+      (void) deflateEnd(&stream);
+      return(~0UL);
+    }
+  (void) deflateEnd(&stream);
+  return((size_t) stream.total_out);
+}
+
+static MagickBooleanType IsPNGOptimizeTimeExhausted(TimerInfo *timer,
+  const double time_limit)
+{
+  double
+    elapsed_time;
+
+  /*
+    GetUserTime() stops the timer, so restart it for the next candidate.
+  */
+  elapsed_time=GetUserTime(timer);
+  (void) ContinueTimer(timer);
+  return(elapsed_time >= time_limit ? MagickTrue : MagickFalse);
+}
+
+static MagickBooleanType OptimizePNGSettings(PNGOptimizeInfo *optimize_info)
+{
+  static const int
+    filters[] =
+    {
+      PNG_FILTER_NONE, PNG_FILTER_SUB, PNG_FILTER_UP, PNG_FILTER_AVG,
+      PNG_FILTER_PAETH, PNG_ALL_FILTERS
+    },
+    strategies[] =
+    {
+      Z_DEFAULT_STRATEGY, Z_FILTERED,
+#ifdef Z_RLE  /* Z_RLE was added to zlib-1.2.0 */
+      Z_RLE
+#else
+      Z_HUFFMAN_ONLY
+#endif
+    };
+
+  int
+    levels[2];
+
+  register ssize_t
+    i,
+    j,
+    k;
+
+  size_t
+    best,
+    extent,
+    length,
+    number_levels,
+    sample_rows,
+    size;
+
+  TimerInfo
+    *timer;
+
+  unsigned char
+    *compressed,
+    *packed,
+    *sample,
+    *scratch;
+
+  sample_rows=optimize_info->rows_buffered;
+  length=sample_rows*(optimize_info->packed_rowbytes+1);
+  packed=(unsigned char *) AcquireQuantumMemory(2*optimize_info->
+    packed_rowbytes+1,sizeof(*packed));
+  sample=(unsigned char *) AcquireQuantumMemory(length,sizeof(*sample));
+  scratch=(unsigned char *) AcquireQuantumMemory(5*(optimize_info->
+    packed_rowbytes+1),sizeof(*scratch));
+  extent=(size_t) compressBound((uLong) length)+64;
+  compressed=(unsigned char *) AcquireQuantumMemory(extent,
+    sizeof(*compressed));
+  if ((packed == (unsigned char *) NULL) ||
+      (sample == (unsigned char *) NULL) ||
+      (scratch == (unsigned char *) NULL) ||
+      (compressed == (unsigned char *) NULL))
+    {
+      if (packed != (unsigned char *) NULL)
+        packed=(unsigned char *) RelinquishMagickMemory(packed);
+      if (sample != (unsigned char *) NULL)
+        sample=(unsigned char *) RelinquishMagickMemory(sample);
+      if (scratch != (unsigned char *) NULL)
+        scratch=(unsigned char *) RelinquishMagickMemory(scratch);
+      if (compressed != (unsigned char *) NULL)
+        compressed=(unsigned char *) RelinquishMagickMemory(compressed);
+      return(MagickFalse);
+    }
+  levels[0]=optimize_info->level;
+  number_levels=1;
+  if (optimize_info->level != 9)
+    levels[number_levels++]=9;
+  timer=AcquireTimerInfo();
+  best=(~0UL);
+  /*
+    The current settings are tried first, so they are kept when the budget
+    is too small for anything else.
+  */
+  for (i=(-1); i < (ssize_t) (sizeof(filters)/sizeof(*filters)); i++)
+  {
+    int
+      filter_mask;
+
+    register unsigned char
+      *q;
+
+    if ((i >= 0) && (IsPNGOptimizeTimeExhausted(timer,
+         optimize_info->time_limit) != MagickFalse))
+      break;
+    filter_mask=i < 0 ? optimize_info->filter_mask : filters[i];
+    if ((i >= 0) && (filter_mask == optimize_info->filter_mask))
+      continue;
+    q=sample;
+    (void) ResetMagickMemory(packed,0,optimize_info->packed_rowbytes);
+    for (j=0; j < (ssize_t) sample_rows; j++)
+    {
+      unsigned char
+        *prior,
+        *row;
+
+      prior=packed+(j & 0x01)*optimize_info->packed_rowbytes;
+      row=packed+((j+1) & 0x01)*optimize_info->packed_rowbytes;
+      PackPNGRow(optimize_info->pixels+j*optimize_info->rowbytes,
+        optimize_info->columns,optimize_info->bit_depth,
+        optimize_info->packed_rowbytes,row);
+      FilterPNGRow(filter_mask,prior,row,optimize_info->packed_rowbytes,
+        optimize_info->bytes_per_pixel,q,scratch);
+      q+=optimize_info->packed_rowbytes+1;
+    }
+    for (j=(-1); j < (ssize_t) (sizeof(strategies)/sizeof(*strategies)); j++)
+    {
+      int
+        strategy;
+
+      strategy=j < 0 ? optimize_info->strategy : strategies[j];
+      if ((j >= 0) && (strategy == optimize_info->strategy))
+        continue;
+      for (k=0; k < (ssize_t) number_levels; k++)
+      {
+        if (((i >= 0) || (j >= 0) || (k > 0)) &&
+            (IsPNGOptimizeTimeExhausted(timer,optimize_info->time_limit) !=
+             MagickFalse))
+          break;
+        size=DeflatePNGSample(sample,length,levels[k],strategy,compressed,
+          extent);
+        if (optimize_info->logging != MagickFalse)
+          (void) LogMagickEvent(CoderEvent,GetMagickModule(),
+            "    Optimize: filters=0x%02x strategy=%d level=%d: %.20g bytes",
+            filter_mask,strategy,levels[k],(double) size);
+        if (size < best)
+          {
+            best=size;
+            optimize_info->filter_mask=filter_mask;
+            optimize_info->strategy=strategy;
+            optimize_info->level=levels[k];
+          }
+      }
+    }
+  }
+  if (optimize_info->logging != MagickFalse)
+    (void) LogMagickEvent(CoderEvent,GetMagickModule(),
+      "    Optimize: chose filters=0x%02x strategy=%d level=%d after %gs",
+      optimize_info->filter_mask,optimize_info->strategy,optimize_info->level,
+      GetUserTime(timer));
+  timer=DestroyTimerInfo(timer);
+  compressed=(unsigned char *) RelinquishMagickMemory(compressed);
+  scratch=(unsigned char *) RelinquishMagickMemory(scratch);
+  sample=(unsigned char *) RelinquishMagickMemory(sample);
+  packed=(unsigned char *) RelinquishMagickMemory(packed);
+  return(MagickTrue);
+}
+
+static void WritePNGInfo(png_struct *ping,png_info *ping_info,Image *image,
+  const MagickBooleanType exclude_vpAg,const MagickBooleanType logging)
+{
+  /*
+    Write the chunks that precede the image data, then set up libpng to pack
+    the rows; png_set_packing() depends on the bit depth written in IHDR.
+  */
+  png_write_info(ping,ping_info);
+
+  /* write any PNG-chunk-m profiles */
+  (void) Magick_png_write_chunk_from_profile(image,"PNG-chunk-m",logging);
+
+  if (exclude_vpAg == MagickFalse)
+    {
+      if ((image->page.width != 0 && image->page.width != image->columns) ||
+          (image->page.height != 0 && image->page.height != image->rows))
+        {
+          unsigned char
+            chunk[14];
+
+          (void) WriteBlobMSBULong(image,9L);  /* data length=8 */
+          PNGType(chunk,mng_vpAg);
+          LogPNGChunk(logging,mng_vpAg,9L);
+          PNGLong(chunk+4,(png_uint_32) image->page.width);
+          PNGLong(chunk+8,(png_uint_32) image->page.height);
+          chunk[12]=0;   /* unit = pixels */
+          (void) WriteBlob(image,13,chunk);
+          (void) WriteBlobMSBULong(image,crc32(0,chunk,13));
+        }
+    }
+
+#if (PNG_LIBPNG_VER == 10206)
+    /* avoid libpng-1.2.6 bug by setting PNG_HAVE_IDAT flag */
+#define PNG_HAVE_IDAT               0x04
+    ping->mode |= PNG_HAVE_IDAT;
+#undef PNG_HAVE_IDAT
+#endif
+
+  png_set_packing(ping);
+}
+
+static void WritePNGRow(png_struct *ping,PNGOptimizeInfo *optimize_info,
+  PNGStripInfo *strip_info,png_bytep pixels)
+{
+  if ((optimize_info != (PNGOptimizeInfo *) NULL) &&
+      (optimize_info->rows_buffered < optimize_info->sample_rows))
+    {
+      register ssize_t
+        y;
+
+      (void) CopyMagickMemory(optimize_info->pixels+
+        optimize_info->rows_buffered*optimize_info->rowbytes,pixels,
+        optimize_info->rowbytes);
+      optimize_info->rows_buffered++;
+      if (optimize_info->rows_buffered < optimize_info->sample_rows)
+        return;
+      if (OptimizePNGSettings(optimize_info) == MagickFalse)
+        png_error(ping,"PNG optimization failed");
+      if (strip_info != (PNGStripInfo *) NULL)
+        {
+          strip_info->filter_mask=optimize_info->filter_mask;
+          strip_info->level=optimize_info->level;
+          strip_info->strategy=optimize_info->strategy;
+        }
+      else
+        {
+          /*
+            libpng 1.2 initializes zlib in png_write_info(), so the settings
+            must be in place before it is called.
+          */
+          png_set_filter(ping,PNG_FILTER_TYPE_BASE,optimize_info->filter_mask);
+          png_set_compression_level(ping,optimize_info->level);
+          png_set_compression_strategy(ping,optimize_info->strategy);
+        }
+      WritePNGInfo(ping,optimize_info->ping_info,optimize_info->image,
+        optimize_info->exclude_vpAg,optimize_info->logging);
+      for (y=0; y < (ssize_t) optimize_info->sample_rows; y++)
+        WritePNGRow(ping,(PNGOptimizeInfo *) NULL,strip_info,
+          optimize_info->pixels+y*optimize_info->rowbytes);
+      return;
+    }
+  if (strip_info == (PNGStripInfo *) NULL)
+    {
+      png_write_row(ping,pixels);
+      return;
+    }
+  if (WritePNGStripRow(strip_info,pixels) == MagickFalse)
+    png_error(ping,"Parallel IDAT encoding failed");
+}
+
+static void WritePNGEnd(png_struct *ping,png_info *ping_info,Image *image,
+  const MagickBooleanType logging)
+{
+  int
+    number_text;
+
+  png_textp
+    text;
+
+  register ssize_t
+    i;
+
+  unsigned char
+    chunk[4];
+
+  /*
+    png_write_end() refuses to run when libpng has not written the IDAT
+    itself, so write the tEXt, zTXt and iTXt chunks it would have written,
+    then IEND.  Text already written by png_write_info() is marked with a
+    *_WR compression type and skipped.  ImageMagick hands libpng no tIME or
+    after-IDAT unknown chunks; its PNG-chunk-e profiles are written directly.
+  */
+  text=(png_textp) NULL;
+  number_text=png_get_text(ping,ping_info,&text,(int *) NULL);
+  for (i=0; i < (ssize_t) number_text; i++)
+  {
+    const char
+      *language,
+      *translated_key;
+
+    MagickBooleanType
+      compress_text;
+
+    size_t
+      extent,
+      key_length,
+      language_length,
+      length,
+      text_length,
+      translated_length;
+
+    uLongf
+      compressed_length;
+
+    unsigned char
+      *datum;
+
+    if ((text[i].compression != PNG_TEXT_COMPRESSION_NONE) &&
+        (text[i].compression != PNG_TEXT_COMPRESSION_zTXt)
+#if defined(PNG_iTXt_SUPPORTED)
+        && (text[i].compression != PNG_ITXT_COMPRESSION_NONE) &&
+        (text[i].compression != PNG_ITXT_COMPRESSION_zTXt)
+#endif
+       )
+      continue;  /* already written */
+    key_length=strlen(text[i].key);
+    if ((key_length == 0) || (key_length > 79))
+      continue;
+    language="";
+    translated_key="";
+    text_length=text[i].text_length;
+#if defined(PNG_iTXt_SUPPORTED)
+    if (text[i].compression > 0)
+      {
+        if (text[i].lang != (png_charp) NULL)
+          language=text[i].lang;
+        if (text[i].lang_key != (png_charp) NULL)
+          translated_key=text[i].lang_key;
+        text_length=text[i].text == (png_charp) NULL ? 0 :
+          strlen(text[i].text);
+      }
+#endif
+    compress_text=(text[i].compression == PNG_TEXT_COMPRESSION_zTXt) ?
+      MagickTrue : MagickFalse;
+#if defined(PNG_iTXt_SUPPORTED)
+    if (text[i].compression == PNG_ITXT_COMPRESSION_zTXt)
+      compress_text=MagickTrue;
+#endif
+    language_length=strlen(language);
+    translated_length=strlen(translated_key);
+    compressed_length=compressBound((uLong) text_length);
+    extent=key_length+language_length+translated_length+compressed_length+
+      text_length+8;
+    datum=(unsigned char *) AcquireQuantumMemory(extent,sizeof(*datum));
+    if (datum == (unsigned char *) NULL)
+      png_error(ping,"Memory allocation failed");
+    (void) CopyMagickMemory(datum+4,text[i].key,key_length+1);
+    length=key_length+1;
+    if (text[i].compression == PNG_TEXT_COMPRESSION_NONE)
+      PNGType(datum,mng_tEXt);
+    else
+      if (text[i].compression == PNG_TEXT_COMPRESSION_zTXt)
+        {
+          PNGType(datum,mng_zTXt);
+          datum[4+length++]=0;  /* compression method */
+        }
+      else
+        {
+          PNGType(datum,mng_iTXt);
+          datum[4+length++]=(unsigned char) compress_text;  /* flag */
+          datum[4+length++]=0;  /* compression method */
+          (void) CopyMagickMemory(datum+4+length,language,language_length+1);
+          length+=language_length+1;
+          (void) CopyMagickMemory(datum+4+length,translated_key,
+            translated_length+1);
+          length+=translated_length+1;
+        }
+    if (compress_text == MagickFalse)
+      {
+        (void) CopyMagickMemory(datum+4+length,text[i].text,text_length);
+        length+=text_length;
+      }
+    else
+      {
+        if (compress(datum+4+length,&compressed_length,(const Bytef *)
+            text[i].text,(uLong) text_length) != Z_OK)
+          {
+            datum=(unsigned char *) RelinquishMagickMemory(datum);
+            png_error(ping,"text chunk compression failed");
+          }
+        length+=compressed_length;
+      }
+    WritePNGChunk(image,datum,length,logging);
+    datum=(unsigned char *) RelinquishMagickMemory(datum);
+  }
+  PNGType(chunk,mng_IEND);
+  WritePNGChunk(image,chunk,0,logging);
+}
+
+/* Write one PNG image */
+#ifdef PNG_USE_CLONE
+static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
+   const ImageInfo *IMimage_info,Image *IMimage)
+#else
+static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
+   const ImageInfo *image_info,Image *image)
+#endif
+{
+#ifdef PNG_USE_CLONE
+  Image
+    *image;
+
+  ImageInfo
+    *image_info;
+#endif
+
+  char
+    s[2];
+
+  const char
+    *name,
+    *property,
+    *value;
+
+  const StringInfo
+    *profile;
+
+  int
+    num_passes,
+    pass;
+
+  png_byte
+     ping_trans_alpha[256];
+
+  png_color
+     palette[257];
+
+  png_color_16
+    ping_background,
+    ping_trans_color;
+
+  png_info
+    *ping_info;
+
+  png_struct
+    *ping;
+
+  png_uint_32
+    ping_height,
+    ping_width;
+
+  ssize_t
+    y;
+
+  MagickBooleanType
+    image_matte,
+    logging,
+    matte,
+
+    ping_have_blob,
+    ping_have_cheap_transparency,
+    ping_have_color,
+    ping_have_non_bw,
+    ping_have_PLTE,
+    ping_have_bKGD,
+    ping_have_pHYs,
+    ping_have_tRNS,
+
+    ping_exclude_bKGD,
+    ping_exclude_cHRM,
+    ping_exclude_date,
+    /* ping_exclude_EXIF, */
+    ping_exclude_gAMA,
+    ping_exclude_iCCP,
+    /* ping_exclude_iTXt, */
+    ping_exclude_oFFs,
+    ping_exclude_pHYs,
+    ping_exclude_sRGB,
+    ping_exclude_tEXt,
+    /* ping_exclude_tRNS, */
+    ping_exclude_vpAg,
+    ping_exclude_zCCP, /* hex-encoded iCCP */
+    ping_exclude_zTXt,
+
+    ping_preserve_colormap,
+    ping_need_colortype_warning,
+
+    status,
+    tried_332,
+    tried_333,
+    tried_444;
+
+  PNGOptimizeInfo
+    *volatile optimize_info;
+
+  PNGStripInfo
+    *volatile strip_info;
+
+  QuantumInfo
+    *quantum_info;
+
+  register ssize_t
+    i,
+    x;
+
+  unsigned char
+    *ping_pixels;
+
+  volatile int
+    image_colors,
+    ping_filter_mask,
+    ping_bit_depth,
+    ping_color_type,
+    ping_interlace_method,
+    ping_compression_method,
+    ping_filter_method,
+    ping_num_trans;
+
+  volatile size_t
+    image_depth,
+    old_bit_depth;
+
+  size_t
+    quality,
+    rowbytes,
+    save_image_depth;
+
+  int
+    j,
+    number_colors,
+    number_opaque,
+    number_semitransparent,
+    number_transparent,
+    ping_pHYs_unit_type;
+
+  png_uint_32
+    ping_pHYs_x_resolution,
+    ping_pHYs_y_resolution;
+
+  logging=LogMagickEvent(CoderEvent,GetMagickModule(),
+    "  Enter WriteOnePNGImage()");
+
+#ifdef PNG_USE_CLONE
   image = CloneImage(IMimage,0,0,MagickFalse,&IMimage->exception);
   image_info=(ImageInfo *) CloneImageInfo(IMimage_info);
   if (image_info == (ImageInfo *) NULL)
@@ -7542,7 +8743,10 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
   ping_interlace_method=0,
   ping_compression_method=0,
   ping_filter_method=0,
+  ping_filter_mask=PNG_NO_FILTERS,
   ping_num_trans = 0;
+  optimize_info=(PNGOptimizeInfo *) NULL;
+  strip_info=(PNGStripInfo *) NULL;
 
   ping_background.red = 0;
   ping_background.green = 0;
@@ -9846,14 +11050,18 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
       if (((int) ping_color_type == PNG_COLOR_TYPE_GRAY) ||
          ((int) ping_color_type == PNG_COLOR_TYPE_PALETTE) ||
          (quality < 50))
-        png_set_filter(ping,PNG_FILTER_TYPE_BASE,PNG_NO_FILTERS);
+        ping_filter_mask=PNG_NO_FILTERS;
       else
-        png_set_filter(ping,PNG_FILTER_TYPE_BASE,PNG_ALL_FILTERS);
+        ping_filter_mask=PNG_ALL_FILTERS;
+      png_set_filter(ping,PNG_FILTER_TYPE_BASE,ping_filter_mask);
      }
 
   else if (mng_info->write_png_compression_filter == 7 ||
       mng_info->write_png_compression_filter == 10)
-    png_set_filter(ping,PNG_FILTER_TYPE_BASE,PNG_ALL_FILTERS);
+    {
+      ping_filter_mask=PNG_ALL_FILTERS;
+      png_set_filter(ping,PNG_FILTER_TYPE_BASE,ping_filter_mask);
+    }
 
   else if (mng_info->write_png_compression_filter == 8)
     {
@@ -9865,15 +11073,21 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
         ping_filter_method=PNG_INTRAPIXEL_DIFFERENCING;
       }
 #endif
-      png_set_filter(ping,PNG_FILTER_TYPE_BASE,PNG_NO_FILTERS);
+      ping_filter_mask=PNG_NO_FILTERS;
+      png_set_filter(ping,PNG_FILTER_TYPE_BASE,ping_filter_mask);
     }
 
   else if (mng_info->write_png_compression_filter == 9)
-    png_set_filter(ping,PNG_FILTER_TYPE_BASE,PNG_NO_FILTERS);
+    {
+      ping_filter_mask=PNG_NO_FILTERS;
+      png_set_filter(ping,PNG_FILTER_TYPE_BASE,ping_filter_mask);
+    }
 
   else if (mng_info->write_png_compression_filter != 0)
-    png_set_filter(ping,PNG_FILTER_TYPE_BASE,
-       mng_info->write_png_compression_filter-1);
+    {
+      ping_filter_mask=(int) mng_info->write_png_compression_filter-1;
+      png_set_filter(ping,PNG_FILTER_TYPE_BASE,ping_filter_mask);
+    }
 
   if (mng_info->write_png_compression_strategy != 0)
     png_set_compression_strategy(ping,
@@ -10231,38 +11445,6 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
   /* write any png-chunk-b profiles */
   (void) Magick_png_write_chunk_from_profile(image,"PNG-chunk-b",logging);
 
-  png_write_info(ping,ping_info);
-
-  /* write any PNG-chunk-m profiles */
-  (void) Magick_png_write_chunk_from_profile(image,"PNG-chunk-m",logging);
-
-  if (ping_exclude_vpAg == MagickFalse)
-    {
-      if ((image->page.width != 0 && image->page.width != image->columns) ||
-          (image->page.height != 0 && image->page.height != image->rows))
-        {
-          unsigned char
-            chunk[14];
-
-          (void) WriteBlobMSBULong(image,9L);  /* data length=8 */
-          PNGType(chunk,mng_vpAg);
-          LogPNGChunk(logging,mng_vpAg,9L);
-          PNGLong(chunk+4,(png_uint_32) image->page.width);
-          PNGLong(chunk+8,(png_uint_32) image->page.height);
-          chunk[12]=0;   /* unit = pixels */
-          (void) WriteBlob(image,13,chunk);
-          (void) WriteBlobMSBULong(image,crc32(0,chunk,13));
-        }
-    }
-
-#if (PNG_LIBPNG_VER == 10206)
-    /* avoid libpng-1.2.6 bug by setting PNG_HAVE_IDAT flag */
-#define PNG_HAVE_IDAT               0x04
-    ping->mode |= PNG_HAVE_IDAT;
-#undef PNG_HAVE_IDAT
-#endif
-
-  png_set_packing(ping);
   /*
     Allocate memory.
   */
@@ -10301,6 +11483,76 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
   if (ping_pixels == (unsigned char *) NULL)
     ThrowWriterException(ResourceLimitError,"MemoryAllocationFailed");
 
+  if ((mng_info->write_png_parallel != MagickFalse) ||
+      (mng_info->write_png_optimize != MagickFalse))
+    {
+      if ((ping_interlace_method != PNG_INTERLACE_NONE) ||
+          (ping_filter_method != PNG_FILTER_TYPE_BASE))
+        {
+          if (logging != MagickFalse)
+            (void) LogMagickEvent(CoderEvent,GetMagickModule(),
+              "    Parallel IDAT or optimization not supported for this image");
+        }
+      else
+        {
+          int
+            level,
+            strategy;
+
+          /*
+            Resolve the filters, level, and strategy libpng would use.
+          */
+          if (ping_filter_mask == PNG_NO_FILTERS)
+            {
+              if (((int) ping_color_type == PNG_COLOR_TYPE_PALETTE) ||
+                  (ping_bit_depth < 8))
+                ping_filter_mask=PNG_FILTER_NONE;
+              else
+                ping_filter_mask=PNG_ALL_FILTERS;
+            }
+          else if ((ping_filter_mask & PNG_ALL_FILTERS) == 0)
+            ping_filter_mask=PNG_FILTER_NONE;
+          else
+            ping_filter_mask&=PNG_ALL_FILTERS;
+          level=Z_DEFAULT_COMPRESSION;
+          if (mng_info->write_png_compression_level != 0)
+            level=(int) mng_info->write_png_compression_level-1;
+          strategy=ping_filter_mask != PNG_FILTER_NONE ? Z_FILTERED :
+            Z_DEFAULT_STRATEGY;
+          if (mng_info->write_png_compression_strategy != 0)
+            strategy=(int) mng_info->write_png_compression_strategy-1;
+          if (mng_info->write_png_parallel != MagickFalse)
+            {
+              strip_info=AcquirePNGStripInfo(image,image->columns,
+                image->rows,ping_color_type,ping_bit_depth,ping_filter_mask,
+                level,strategy,logging);
+              if (strip_info == (PNGStripInfo *) NULL)
+                {
+                  ping_pixels=(unsigned char *)
+                    RelinquishMagickMemory(ping_pixels);
+                  ThrowWriterException(ResourceLimitError,
+                    "MemoryAllocationFailed");
+                }
+            }
+          if (mng_info->write_png_optimize != MagickFalse)
+            {
+              optimize_info=AcquirePNGOptimizeInfo(image,ping_info,
+                image->columns,image->rows,rowbytes,ping_color_type,
+                ping_bit_depth,ping_filter_mask,level,strategy,
+                mng_info->write_png_optimize_time,ping_exclude_vpAg,logging);
+              if (optimize_info == (PNGOptimizeInfo *) NULL)
+                {
+                  if (strip_info != (PNGStripInfo *) NULL)
+                    strip_info=DestroyPNGStripInfo(strip_info);
+                  ping_pixels=(unsigned char *)
+                    RelinquishMagickMemory(ping_pixels);
+                  ThrowWriterException(ResourceLimitError,
+                    "MemoryAllocationFailed");
+                }
+            }
+        }
+    }
+
   /*
     Initialize image scanlines.
   */
@@ -10318,6 +11570,10 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
         quantum_info=DestroyQuantumInfo(quantum_info);
       if (ping_pixels != (unsigned char *) NULL)
         ping_pixels=(unsigned char *) RelinquishMagickMemory(ping_pixels);
+      if (strip_info != (PNGStripInfo *) NULL)
+        strip_info=DestroyPNGStripInfo(strip_info);
+      if (optimize_info != (PNGOptimizeInfo *) NULL)
+        optimize_info=DestroyPNGOptimizeInfo(optimize_info);
 #if defined(PNG_SETJMP_NOT_THREAD_SAFE)
       UnlockSemaphoreInfo(ping_semaphore);
 #endif
@@ -10329,6 +11585,12 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
 #endif
       return(MagickFalse);
     }
+  /*
+    With png:optimize, the header is written once the sampled rows have
+    chosen the filter and zlib settings.
+  */
+  if (optimize_info == (PNGOptimizeInfo *) NULL)
+    WritePNGInfo(ping,ping_info,image,ping_exclude_vpAg,logging);
   quantum_info=AcquireQuantumInfo(image_info,image);
   if (quantum_info == (QuantumInfo *) NULL)
     ThrowWriterException(ResourceLimitError,"MemoryAllocationFailed");
@@ -10394,7 +11656,7 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
             (void) LogMagickEvent(CoderEvent,GetMagickModule(),
                 "    Writing row of pixels (1)");
 
-          png_write_row(ping,ping_pixels);
+          WritePNGRow(ping,optimize_info,strip_info,ping_pixels);
         }
         if (image->previous == (Image *) NULL)
           {
@@ -10455,7 +11717,7 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
               (void) LogMagickEvent(CoderEvent,GetMagickModule(),
                   "    Writing row of pixels (2)");
 
-            png_write_row(ping,ping_pixels);
+            WritePNGRow(ping,optimize_info,strip_info,ping_pixels);
           }
 
           if (image->previous == (Image *) NULL)
@@ -10520,7 +11782,7 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
                   (void) LogMagickEvent(CoderEvent,GetMagickModule(),
                       "    Writing row of pixels (3)");
 
-                png_write_row(ping,ping_pixels);
+                WritePNGRow(ping,optimize_info,strip_info,ping_pixels);
               }
             }
 
@@ -10586,7 +11848,7 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
                           (int)ping_pixels[0],(int)ping_pixels[1]);
                     }
                   }
-                png_write_row(ping,ping_pixels);
+                WritePNGRow(ping,optimize_info,strip_info,ping_pixels);
               }
             }
 
@@ -10603,6 +11865,17 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
   if (quantum_info != (QuantumInfo *) NULL)
     quantum_info=DestroyQuantumInfo(quantum_info);
 
+  if (optimize_info != (PNGOptimizeInfo *) NULL)
+    {
+      if (optimize_info->rows_buffered < optimize_info->sample_rows)
+        png_error(ping,"PNG image data is incomplete");
+      optimize_info=DestroyPNGOptimizeInfo(optimize_info);
+    }
+
+  if ((strip_info != (PNGStripInfo *) NULL) &&
+      (strip_info->rows_written < strip_info->rows))
+    png_error(ping,"Parallel IDAT is incomplete");
+
   if (logging != MagickFalse)
     {
       (void) LogMagickEvent(CoderEvent,GetMagickModule(),
@@ -10706,7 +11979,13 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
     (void) LogMagickEvent(CoderEvent,GetMagickModule(),
       "  Writing PNG end info");
 
-  png_write_end(ping,ping_info);
+  if (strip_info != (PNGStripInfo *) NULL)
+    {
+      WritePNGEnd(ping,ping_info,image,logging);
+      strip_info=DestroyPNGStripInfo(strip_info);
+    }
+  else
+    png_write_end(ping,ping_info);
 
   if (mng_info->need_fram && (int) image->dispose == BackgroundDispose)
     {
@@ -10898,6 +12177,20 @@ static MagickBooleanType WriteOnePNGImage(MngInfo *mng_info,
 %  is not intended for external use.  It is only used internally by the
 %  PNG encoder to inform the JNG encoder of the depth of the alpha channel.
 %
+%  If the "png:optimize" option is true, the encoder tries each PNG filter,
+%  adaptive filtering, and several zlib strategies and levels on a sample of
+%  the first rows of a non-interlaced image, and keeps the combination that
+%  compresses the sample best.  The search stops once "png:optimize-time"
+%  seconds of CPU time (default 0.5) have been spent.  Only the sampled rows,
+%  about 256K of image data, are held in memory; the rest are streamed.
+%
+%  If the "png:parallel" option is true, the image data of non-interlaced
+%  images is filtered and deflated in strips, one per thread, each strip
+%  being primed with the last 32K of its predecessor.  The result is a
+%  single valid zlib datastream, usually a few bytes larger than the one
+%  libpng writes.  It is off by default: on a single core it is slower than
+%  the libpng path.
+%
 %  It is possible to request that the PNG encoder write previously-formatted
 %  ancillary chunks in the output PNG file, using the "-profile" commandline
 %  option as shown below or by setting the profile via a programming
@@ -11295,6 +12588,25 @@ static MagickBooleanType WritePNGImage(const ImageInfo *image_info,
              "=%s",value);
     }
 
+  mng_info->write_png_optimize_time=0.5;
+  value=GetImageArtifact(image,"png:optimize");
+  if (value == NULL)
+     value=GetImageOption(image_info,"png:optimize");
+  if (value != NULL)
+    mng_info->write_png_optimize=IsMagickTrue(value);
+
+  value=GetImageArtifact(image,"png:optimize-time");
+  if (value == NULL)
+     value=GetImageOption(image_info,"png:optimize-time");
+  if (value != NULL)
+    mng_info->write_png_optimize_time=StringToDouble(value,(char **) NULL);
+
+  value=GetImageArtifact(image,"png:parallel");
+  if (value == NULL)
+     value=GetImageOption(image_info,"png:parallel");
+  if (value != NULL)
+    mng_info->write_png_parallel=IsMagickTrue(value);
+
   excluding=MagickFalse;
 
   for (source=0; source<1; source++)
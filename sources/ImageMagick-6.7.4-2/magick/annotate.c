@@ -58,8 +58,10 @@
 #include "magick/exception-private.h"
 #include "magick/gem.h"
 #include "magick/geometry.h"
+#include "magick/hashmap.h"
 #include "magick/image-private.h"
 #include "magick/log.h"
+#include "magick/policy.h"
 #include "magick/quantum.h"
 #include "magick/quantum-private.h"
 #include "magick/property.h"
@@ -67,6 +69,7 @@
 #include "magick/semaphore.h"
 #include "magick/statistic.h"
 #include "magick/string_.h"
+#include "magick/string-private.h"
 #include "magick/token-private.h"
 #include "magick/transform.h"
 #include "magick/type.h"
@@ -101,11 +104,91 @@
 #endif /* defined(FT_BBOX_H) */
 #endif
 
+#if defined(MAGICKCORE_FREETYPE_DELEGATE)
+/*
+  Define declarations.
+*/
+#define FaceCacheLimit  8
+#define GlyphCacheLimit  "8MiB"
+
+/*
+  Typedef declarations.
+*/
+typedef struct _FaceCacheInfo
+{
+  char
+    *key;
+
+  FT_Library
+    library;
+
+  FT_Face
+    face;
+
+  struct _FaceCacheInfo
+    *next;
+} FaceCacheInfo;
+
+typedef struct _GlyphCacheInfo
+{
+  char
+    *key;
+
+  FT_BBox
+    bounds;
+
+  FT_Vector
+    advance;
+
+  FT_Int
+    left,
+    top;
+
+  FT_Bitmap
+    bitmap;
+
+  size_t
+    extent;
+
+  ssize_t
+    reference_count;
+
+  struct _GlyphCacheInfo
+    *previous,
+    *next;
+} GlyphCacheInfo;
+#endif
+
 /*
   Annotate semaphores.
 */
 static SemaphoreInfo
   *annotate_semaphore = (SemaphoreInfo *) NULL;
+
+#if defined(MAGICKCORE_FREETYPE_DELEGATE)
+/*
+  Idle font faces, most recently used first.
+*/
+static FaceCacheInfo
+  *face_list = (FaceCacheInfo *) NULL;
+
+/*
+  Rendered glyphs, most recently used first.
+*/
+static GlyphCacheInfo
+  *glyph_list = (GlyphCacheInfo *) NULL,
+  *glyph_list_tail = (GlyphCacheInfo *) NULL;
+
+static HashmapInfo
+  *glyph_cache = (HashmapInfo *) NULL;
+
+static MagickSizeType
+  glyph_cache_extent = 0,
+  glyph_cache_limit = 0;
+
+static SemaphoreInfo
+  *glyph_semaphore = (SemaphoreInfo *) NULL;
+#endif
 
 /*
   Forward declarations.
@@ -138,6 +221,9 @@ static MagickBooleanType
 MagickExport MagickBooleanType AnnotateComponentGenesis(void)
 {
   AcquireSemaphoreInfo(&annotate_semaphore);
+#if defined(MAGICKCORE_FREETYPE_DELEGATE)
+  AcquireSemaphoreInfo(&glyph_semaphore);
+#endif
   return(MagickTrue);
 }
 
@@ -164,6 +250,40 @@ MagickExport void AnnotateComponentTerminus(void)
   if (annotate_semaphore == (SemaphoreInfo *) NULL)
     AcquireSemaphoreInfo(&annotate_semaphore);
   DestroySemaphoreInfo(&annotate_semaphore);
+#if defined(MAGICKCORE_FREETYPE_DELEGATE)
+  if (glyph_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&glyph_semaphore);
+  LockSemaphoreInfo(glyph_semaphore);
+  if (glyph_cache != (HashmapInfo *) NULL)
+    glyph_cache=DestroyHashmap(glyph_cache);
+  while (glyph_list != (GlyphCacheInfo *) NULL)
+  {
+    GlyphCacheInfo
+      *next;
+
+    next=glyph_list->next;
+    glyph_list->bitmap.buffer=(unsigned char *) RelinquishMagickMemory(
+      glyph_list->bitmap.buffer);
+    glyph_list=(GlyphCacheInfo *) RelinquishMagickMemory(glyph_list);
+    glyph_list=next;
+  }
+  glyph_list_tail=(GlyphCacheInfo *) NULL;
+  glyph_cache_extent=0;
+  while (face_list != (FaceCacheInfo *) NULL)
+  {
+    FaceCacheInfo
+      *next;
+
+    next=face_list->next;
+    (void) FT_Done_Face(face_list->face);
+    (void) FT_Done_FreeType(face_list->library);
+    face_list->key=DestroyString(face_list->key);
+    face_list=(FaceCacheInfo *) RelinquishMagickMemory(face_list);
+    face_list=next;
+  }
+  UnlockSemaphoreInfo(glyph_semaphore);
+  DestroySemaphoreInfo(&glyph_semaphore);
+#endif
 }
 
 /*
@@ -1010,6 +1130,333 @@ static int TraceQuadraticBezier(FT_Vector *control,FT_Vector *to,
   return(0);
 }
 
+static MagickBooleanType AcquireFreetypeFace(const char *key,
+  FT_Library *library,FT_Face *face)
+{
+  FaceCacheInfo
+    *p,
+    *q;
+
+  /*
+    A face is not safe to share between threads, so an idle one is taken off
+    the list and handed back by RelinquishFreetypeFace() when done.
+  */
+  if (*key == '\0')
+    return(MagickFalse);
+  if (glyph_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&glyph_semaphore);
+  LockSemaphoreInfo(glyph_semaphore);
+  q=(FaceCacheInfo *) NULL;
+  for (p=face_list; p != (FaceCacheInfo *) NULL; p=p->next)
+  {
+    if (strcmp(p->key,key) == 0)
+      break;
+    q=p;
+  }
+  if (p == (FaceCacheInfo *) NULL)
+    {
+      UnlockSemaphoreInfo(glyph_semaphore);
+      return(MagickFalse);
+    }
+  if (q == (FaceCacheInfo *) NULL)
+    face_list=p->next;
+  else
+    q->next=p->next;
+  UnlockSemaphoreInfo(glyph_semaphore);
+  *library=p->library;
+  *face=p->face;
+  p->key=DestroyString(p->key);
+  p=(FaceCacheInfo *) RelinquishMagickMemory(p);
+  return(MagickTrue);
+}
+
+static void RelinquishFreetypeFace(const char *key,FT_Library library,
+  FT_Face face)
+{
+  FaceCacheInfo
+    *p,
+    *q;
+
+  ssize_t
+    i;
+
+  /*
+    Keep the face for the next call, closing the least recently used idle
+    faces beyond the cache limit.
+  */
+  p=(FaceCacheInfo *) NULL;
+  if (*key != '\0')
+    p=(FaceCacheInfo *) AcquireMagickMemory(sizeof(*p));
+  if (p == (FaceCacheInfo *) NULL)
+    {
+      (void) FT_Done_Face(face);
+      (void) FT_Done_FreeType(library);
+      return;
+    }
+  p->key=ConstantString(key);
+  p->library=library;
+  p->face=face;
+  if (glyph_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&glyph_semaphore);
+  LockSemaphoreInfo(glyph_semaphore);
+  p->next=face_list;
+  face_list=p;
+  for (i=1; (p != (FaceCacheInfo *) NULL) && (i < FaceCacheLimit); i++)
+    p=p->next;
+  q=(FaceCacheInfo *) NULL;
+  if (p != (FaceCacheInfo *) NULL)
+    {
+      q=p->next;
+      p->next=(FaceCacheInfo *) NULL;
+    }
+  UnlockSemaphoreInfo(glyph_semaphore);
+  while (q != (FaceCacheInfo *) NULL)
+  {
+    p=q->next;
+    (void) FT_Done_Face(q->face);
+    (void) FT_Done_FreeType(q->library);
+    q->key=DestroyString(q->key);
+    q=(FaceCacheInfo *) RelinquishMagickMemory(q);
+    q=p;
+  }
+}
+
+static MagickBooleanType SetGlyphBitmap(GlyphCacheInfo *glyph_info,
+  const FT_Bitmap *bitmap)
+{
+  size_t
+    extent;
+
+  /*
+    Copy a glyph coverage bitmap, growing the buffer as needed.
+  */
+  extent=(size_t) (bitmap->pitch < 0 ? -bitmap->pitch : bitmap->pitch)*
+    bitmap->rows;
+  if (extent > glyph_info->extent)
+    {
+      glyph_info->bitmap.buffer=(unsigned char *) ResizeQuantumMemory(
+        glyph_info->bitmap.buffer,extent,sizeof(*glyph_info->bitmap.buffer));
+      if (glyph_info->bitmap.buffer == (unsigned char *) NULL)
+        {
+          glyph_info->extent=0;
+          return(MagickFalse);
+        }
+      glyph_info->extent=extent;
+    }
+  glyph_info->bitmap.rows=bitmap->rows;
+  glyph_info->bitmap.width=bitmap->width;
+  glyph_info->bitmap.pitch=bitmap->pitch;
+  glyph_info->bitmap.num_grays=bitmap->num_grays;
+  glyph_info->bitmap.pixel_mode=bitmap->pixel_mode;
+  if (extent != 0)
+    (void) CopyMagickMemory(glyph_info->bitmap.buffer,bitmap->buffer,extent);
+  return(MagickTrue);
+}
+
+static void RelinquishGlyphBitmap(GlyphCacheInfo *glyph_info)
+{
+  if (glyph_info->bitmap.buffer != (unsigned char *) NULL)
+    glyph_info->bitmap.buffer=(unsigned char *) RelinquishMagickMemory(
+      glyph_info->bitmap.buffer);
+  glyph_info=(GlyphCacheInfo *) RelinquishMagickMemory(glyph_info);
+}
+
+static void CacheGlyphBitmap(const char *key,const GlyphCacheInfo *glyph_info)
+{
+  GlyphCacheInfo
+    *p;
+
+  /*
+    Add a rendered glyph to the cache, retiring the least recently used
+    glyphs beyond the cache limit.  The copy is made before taking the lock;
+    once cached, a glyph is never modified.
+  */
+  p=(GlyphCacheInfo *) AcquireMagickMemory(sizeof(*p));
+  if (p == (GlyphCacheInfo *) NULL)
+    return;
+  (void) ResetMagickMemory(p,0,sizeof(*p));
+  p->bounds=glyph_info->bounds;
+  p->advance=glyph_info->advance;
+  p->left=glyph_info->left;
+  p->top=glyph_info->top;
+  if (SetGlyphBitmap(p,&glyph_info->bitmap) == MagickFalse)
+    {
+      RelinquishGlyphBitmap(p);
+      return;
+    }
+  p->key=ConstantString(key);
+  LockSemaphoreInfo(glyph_semaphore);
+  if ((GetValueFromHashmap(glyph_cache,key) != (void *) NULL) ||
+      (PutEntryInHashmap(glyph_cache,p->key,p) == MagickFalse))
+    {
+      UnlockSemaphoreInfo(glyph_semaphore);
+      p->key=DestroyString(p->key);
+      RelinquishGlyphBitmap(p);
+      return;
+    }
+  p->extent+=sizeof(*p)+strlen(key)+1;
+  glyph_cache_extent+=p->extent;
+  p->next=glyph_list;
+  if (glyph_list != (GlyphCacheInfo *) NULL)
+    glyph_list->previous=p;
+  glyph_list=p;
+  if (glyph_list_tail == (GlyphCacheInfo *) NULL)
+    glyph_list_tail=p;
+  while ((glyph_cache_extent > glyph_cache_limit) &&
+         (glyph_list_tail != glyph_list))
+  {
+    p=glyph_list_tail;
+    glyph_list_tail=p->previous;
+    glyph_list_tail->next=(GlyphCacheInfo *) NULL;
+    glyph_cache_extent-=p->extent;
+    (void) RemoveEntryFromHashmap(glyph_cache,p->key);
+    p->key=(char *) NULL;
+    p->previous=(GlyphCacheInfo *) NULL;
+    if (p->reference_count == 0)
+      RelinquishGlyphBitmap(p);
+  }
+  UnlockSemaphoreInfo(glyph_semaphore);
+}
+
+static MagickBooleanType GetGlyphBitmap(FT_Face face,const char *font_key,
+  const FT_UInt id,const FT_Int32 flags,FT_Matrix *affine,
+  const FT_Vector *origin,GlyphCacheInfo *glyph_info)
+{
+  char
+    key[MaxTextExtent];
+
+  FT_BitmapGlyph
+    bitmap;
+
+  FT_Error
+    status;
+
+  FT_Glyph
+    image;
+
+  FT_Vector
+    delta,
+    offset;
+
+  GlyphCacheInfo
+    *p;
+
+  MagickBooleanType
+    cache;
+
+  /*
+    A glyph is rendered at the subpixel part of its origin and moved into
+    place by whole pixels, so one rendering serves every position that shares
+    that subpixel offset.
+  */
+  delta.x=origin->x & 63;
+  delta.y=origin->y & 63;
+  offset.x=(origin->x-delta.x)/64;
+  offset.y=(origin->y-delta.y)/64;
+  cache=MagickFalse;
+  if (font_key != (const char *) NULL)
+    {
+      (void) FormatLocaleString(key,MaxTextExtent,"%s;%u;%ld,%ld",font_key,
+        (unsigned int) id,(long) delta.x,(long) delta.y);
+      if (glyph_semaphore == (SemaphoreInfo *) NULL)
+        AcquireSemaphoreInfo(&glyph_semaphore);
+      LockSemaphoreInfo(glyph_semaphore);
+      if (glyph_cache == (HashmapInfo *) NULL)
+        {
+          char
+            *limit;
+
+          glyph_cache=NewHashmap(MediumHashmapSize,HashStringType,
+            CompareHashmapString,RelinquishMagickMemory,(void *(*)(void *))
+            NULL);
+          limit=GetEnvironmentValue("MAGICK_GLYPH_LIMIT");
+          if (limit == (char *) NULL)
+            limit=GetPolicyValue("glyph");
+          glyph_cache_limit=(MagickSizeType) SiPrefixToDoubleInterval(
+            limit != (char *) NULL ? limit : GlyphCacheLimit,100.0);
+          if (limit != (char *) NULL)
+            limit=DestroyString(limit);
+        }
+      cache=glyph_cache_limit != 0 ? MagickTrue : MagickFalse;
+      p=(GlyphCacheInfo *) GetValueFromHashmap(glyph_cache,key);
+      if (p != (GlyphCacheInfo *) NULL)
+        {
+          MagickBooleanType
+            status;
+
+          /*
+            Cache hit: move the glyph to the front of the list.
+          */
+          if (p != glyph_list)
+            {
+              p->previous->next=p->next;
+              if (p->next != (GlyphCacheInfo *) NULL)
+                p->next->previous=p->previous;
+              else
+                glyph_list_tail=p->previous;
+              p->previous=(GlyphCacheInfo *) NULL;
+              p->next=glyph_list;
+              glyph_list->previous=p;
+              glyph_list=p;
+            }
+          glyph_info->bounds=p->bounds;
+          glyph_info->advance=p->advance;
+          glyph_info->left=p->left+offset.x;
+          glyph_info->top=p->top+offset.y;
+          /*
+            Copy the bitmap outside the lock; the reference keeps a glyph
+            retired meanwhile alive until the copy is done.
+          */
+          p->reference_count++;
+          UnlockSemaphoreInfo(glyph_semaphore);
+          status=SetGlyphBitmap(glyph_info,&p->bitmap);
+          LockSemaphoreInfo(glyph_semaphore);
+          p->reference_count--;
+          if ((p->reference_count == 0) && (p->key == (char *) NULL))
+            RelinquishGlyphBitmap(p);
+          UnlockSemaphoreInfo(glyph_semaphore);
+          return(status);
+        }
+      UnlockSemaphoreInfo(glyph_semaphore);
+    }
+  status=FT_Load_Glyph(face,id,flags);
+  if (status != 0)
+    return(MagickFalse);
+  status=FT_Get_Glyph(face->glyph,&image);
+  if (status != 0)
+    return(MagickFalse);
+  status=FT_Outline_Get_BBox(&((FT_OutlineGlyph) image)->outline,
+    &glyph_info->bounds);
+  if (status != 0)
+    {
+      FT_Done_Glyph(image);
+      return(MagickFalse);
+    }
+  glyph_info->advance=face->glyph->advance;
+  (void) FT_Glyph_Transform(image,affine,&delta);
+  status=FT_Glyph_To_Bitmap(&image,ft_render_mode_normal,(FT_Vector *) NULL,
+    MagickTrue);
+  if (status != 0)
+    {
+      FT_Done_Glyph(image);
+      return(MagickFalse);
+    }
+  bitmap=(FT_BitmapGlyph) image;
+  glyph_info->left=bitmap->left;
+  glyph_info->top=bitmap->top;
+  if (SetGlyphBitmap(glyph_info,&bitmap->bitmap) == MagickFalse)
+    {
+      FT_Done_Glyph(image);
+      return(MagickFalse);
+    }
+  FT_Done_Glyph(image);
+  if (cache != MagickFalse)
+    CacheGlyphBitmap(key,glyph_info);
+  glyph_info->left+=offset.x;
+  glyph_info->top+=offset.y;
+  return(MagickTrue);
+}
+
 static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
   const char *encoding,const PointInfo *offset,TypeMetric *metrics)
 {
@@ -1024,12 +1471,14 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
 
     FT_Vector
       origin;
-
-    FT_Glyph
-      image;
   } GlyphInfo;
 
+  char
+    face_key[MaxTextExtent],
+    font_key[MaxTextExtent];
+
   const char
+    *font,
     *value;
 
   double
@@ -1038,12 +1487,6 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
   DrawInfo
     *annotate_info;
 
-  FT_BBox
-    bounds;
-
-  FT_BitmapGlyph
-    bitmap;
-
   FT_Encoding
     encoding_type;
 
@@ -1068,6 +1511,9 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
   FT_Vector
     origin;
 
+  GlyphCacheInfo
+    glyph_info;
+
   GlyphInfo
     glyph,
     last_glyph;
@@ -1097,33 +1543,39 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
     *utf8;
 
   /*
-    Initialize Truetype library.
+    Initialize Truetype library, reusing an idle face for this font if any.
   */
-  status=FT_Init_FreeType(&library);
-  if (status != 0)
-    ThrowBinaryException(TypeError,"UnableToInitializeFreetypeLibrary",
-      image->filename);
-  args.flags=FT_OPEN_PATHNAME;
-  if (draw_info->font == (char *) NULL)
-    args.pathname=ConstantString("helvetica");
-  else
-    if (*draw_info->font != '@')
-      args.pathname=ConstantString(draw_info->font);
-    else
-      args.pathname=ConstantString(draw_info->font+1);
-  face=(FT_Face) NULL;
-  status=FT_Open_Face(library,&args,(long) draw_info->face,&face);
-  args.pathname=DestroyString(args.pathname);
-  if (status != 0)
+  font="helvetica";
+  if (draw_info->font != (char *) NULL)
+    font=(*draw_info->font != '@') ? draw_info->font : draw_info->font+1;
+  *face_key='\0';
+  if ((strlen(font)+(draw_info->metrics == (char *) NULL ? 0 :
+       strlen(draw_info->metrics))) < (MaxTextExtent/2))
+    (void) FormatLocaleString(face_key,MaxTextExtent,"%s;%s;%ld",font,
+      draw_info->metrics != (char *) NULL ? draw_info->metrics : "",
+      (long) draw_info->face);
+  if (AcquireFreetypeFace(face_key,&library,&face) == MagickFalse)
     {
-      (void) FT_Done_FreeType(library);
-      (void) ThrowMagickException(&image->exception,GetMagickModule(),
-        TypeError,"UnableToReadFont","`%s'",draw_info->font);
-      return(RenderPostscript(image,draw_info,offset,metrics));
+      status=FT_Init_FreeType(&library);
+      if (status != 0)
+        ThrowBinaryException(TypeError,"UnableToInitializeFreetypeLibrary",
+          image->filename);
+      args.flags=FT_OPEN_PATHNAME;
+      args.pathname=ConstantString(font);
+      face=(FT_Face) NULL;
+      status=FT_Open_Face(library,&args,(long) draw_info->face,&face);
+      args.pathname=DestroyString(args.pathname);
+      if (status != 0)
+        {
+          (void) FT_Done_FreeType(library);
+          (void) ThrowMagickException(&image->exception,GetMagickModule(),
+            TypeError,"UnableToReadFont","`%s'",draw_info->font);
+          return(RenderPostscript(image,draw_info,offset,metrics));
+        }
+      if ((draw_info->metrics != (char *) NULL) &&
+          (IsPathAccessible(draw_info->metrics) != MagickFalse))
+        (void) FT_Attach_File(face,draw_info->metrics);
     }
-  if ((draw_info->metrics != (char *) NULL) &&
-      (IsPathAccessible(draw_info->metrics) != MagickFalse))
-    (void) FT_Attach_File(face,draw_info->metrics);
   encoding_type=ft_encoding_unicode;
   status=FT_Select_Charmap(face,encoding_type);
   if ((status != 0) && (face->num_charmaps != 0))
@@ -1162,7 +1614,10 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
         encoding_type=ft_encoding_wansung;
       status=FT_Select_Charmap(face,encoding_type);
       if (status != 0)
-        ThrowBinaryException(TypeError,"UnrecognizedFontEncoding",encoding);
+        {
+          RelinquishFreetypeFace(face_key,library,face);
+          ThrowBinaryException(TypeError,"UnrecognizedFontEncoding",encoding);
+        }
     }
   /*
     Set text size.
@@ -1205,8 +1660,7 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
   metrics->underline_thickness=face->underline_thickness/64.0;
   if ((draw_info->text == (char *) NULL) || (*draw_info->text == '\0'))
     {
-      (void) FT_Done_Face(face);
-      (void) FT_Done_FreeType(library);
+      RelinquishFreetypeFace(face_key,library,face);
       return(MagickTrue);
     }
   /*
@@ -1224,9 +1678,7 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
   if ((value != (const char *) NULL) && (LocaleCompare(value,"off") == 0))
     flags|=FT_LOAD_NO_HINTING;
   glyph.id=0;
-  glyph.image=NULL;
   last_glyph.id=0;
-  last_glyph.image=NULL;
   origin.x=0;
   origin.y=0;
   affine.xx=65536L;
@@ -1240,6 +1692,20 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
       affine.xy=(FT_Fixed) (-65536L*draw_info->affine.ry+0.5);
       affine.yy=(FT_Fixed) (65536L*draw_info->affine.sy+0.5);
     }
+  /*
+    Glyph bitmaps are cached by font, size, resolution, load flags, and
+    transform.
+  */
+  (void) ResetMagickMemory(&glyph_info,0,sizeof(glyph_info));
+  *font_key='\0';
+  if ((strlen(font)+(draw_info->metrics == (char *) NULL ? 0 :
+       strlen(draw_info->metrics))) < (MaxTextExtent/2))
+    (void) FormatLocaleString(font_key,MaxTextExtent,
+      "%s;%s;%ld;%.20g;%.20gx%.20g;%ld;%ld,%ld,%ld,%ld",font,
+      draw_info->metrics != (char *) NULL ? draw_info->metrics : "",
+      (long) draw_info->face,draw_info->pointsize,resolution.x,resolution.y,
+      (long) flags,(long) affine.xx,(long) affine.yx,(long) affine.xy,
+      (long) affine.yy);
   annotate_info=CloneDrawInfo((ImageInfo *) NULL,draw_info);
   (void) CloneString(&annotate_info->primitive,"path '");
   if (draw_info->render != MagickFalse)
@@ -1291,24 +1757,22 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
             }
         }
     glyph.origin=origin;
-    status=FT_Load_Glyph(face,glyph.id,flags);
-    if (status != 0)
-      continue;
-    status=FT_Get_Glyph(face->glyph,&glyph.image);
-    if (status != 0)
-      continue;
-    status=FT_Outline_Get_BBox(&((FT_OutlineGlyph) glyph.image)->outline,
-      &bounds);
-    if (status != 0)
+    FT_Vector_Transform(&glyph.origin,&affine);
+    if (GetGlyphBitmap(face,*font_key != '\0' ? font_key : (char *) NULL,
+          glyph.id,flags,&affine,&glyph.origin,&glyph_info) == MagickFalse)
       continue;
-    if ((p == draw_info->text) || (bounds.xMin < metrics->bounds.x1))
-      metrics->bounds.x1=bounds.xMin;
-    if ((p == draw_info->text) || (bounds.yMin < metrics->bounds.y1))
-      metrics->bounds.y1=bounds.yMin;
-    if ((p == draw_info->text) || (bounds.xMax > metrics->bounds.x2))
-      metrics->bounds.x2=bounds.xMax;
-    if ((p == draw_info->text) || (bounds.yMax > metrics->bounds.y2))
-      metrics->bounds.y2=bounds.yMax;
+    if ((p == draw_info->text) ||
+        (glyph_info.bounds.xMin < metrics->bounds.x1))
+      metrics->bounds.x1=glyph_info.bounds.xMin;
+    if ((p == draw_info->text) ||
+        (glyph_info.bounds.yMin < metrics->bounds.y1))
+      metrics->bounds.y1=glyph_info.bounds.yMin;
+    if ((p == draw_info->text) ||
+        (glyph_info.bounds.xMax > metrics->bounds.x2))
+      metrics->bounds.x2=glyph_info.bounds.xMax;
+    if ((p == draw_info->text) ||
+        (glyph_info.bounds.yMax > metrics->bounds.y2))
+      metrics->bounds.y2=glyph_info.bounds.yMax;
     if (draw_info->render != MagickFalse)
       if ((draw_info->stroke.opacity != TransparentOpacity) ||
           (draw_info->stroke_pattern != (Image *) NULL))
@@ -1316,20 +1780,17 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
           /*
             Trace the glyph.
           */
-          annotate_info->affine.tx=glyph.origin.x/64.0;
-          annotate_info->affine.ty=glyph.origin.y/64.0;
-          (void) FT_Outline_Decompose(&((FT_OutlineGlyph) glyph.image)->
-            outline,&OutlineMethods,annotate_info);
+          status=FT_Load_Glyph(face,glyph.id,flags);
+          if (status == 0)
+            {
+              annotate_info->affine.tx=origin.x/64.0;
+              annotate_info->affine.ty=origin.y/64.0;
+              (void) FT_Outline_Decompose(&face->glyph->outline,
+                &OutlineMethods,annotate_info);
+            }
         }
-    FT_Vector_Transform(&glyph.origin,&affine);
-    (void) FT_Glyph_Transform(glyph.image,&affine,&glyph.origin);
-    status=FT_Glyph_To_Bitmap(&glyph.image,ft_render_mode_normal,
-      (FT_Vector *) NULL,MagickTrue);
-    if (status != 0)
-      continue;
-    bitmap=(FT_BitmapGlyph) glyph.image;
-    point.x=offset->x+bitmap->left;
-    point.y=offset->y-bitmap->top;
+    point.x=offset->x+glyph_info.left;
+    point.y=offset->y-glyph_info.top;
     if (draw_info->render != MagickFalse)
       {
         CacheView
@@ -1349,9 +1810,9 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
         */
         status=MagickTrue;
         exception=(&image->exception);
-        p=bitmap->bitmap.buffer;
+        p=glyph_info.bitmap.buffer;
         image_view=AcquireCacheView(image);
-        for (y=0; y < (ssize_t) bitmap->bitmap.rows; y++)
+        for (y=0; y < (ssize_t) glyph_info.bitmap.rows; y++)
         {
           MagickBooleanType
             active,
@@ -1386,11 +1847,11 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
           else
             {
               q=GetCacheViewAuthenticPixels(image_view,x_offset,y_offset,
-                bitmap->bitmap.width,1,exception);
+                glyph_info.bitmap.width,1,exception);
               active=q != (PixelPacket *) NULL ? MagickTrue : MagickFalse;
             }
-          n=y*bitmap->bitmap.pitch-1;
-          for (x=0; x < (ssize_t) bitmap->bitmap.width; x++)
+          n=y*glyph_info.bitmap.pitch-1;
+          for (x=0; x < (ssize_t) glyph_info.bitmap.width; x++)
           {
             n++;
             x_offset++;
@@ -1399,10 +1860,11 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
                 q++;
                 continue;
               }
-            if (bitmap->bitmap.pixel_mode != ft_pixel_mode_mono)
-              fill_opacity=(MagickRealType) (p[n])/(bitmap->bitmap.num_grays-1);
+            if (glyph_info.bitmap.pixel_mode != ft_pixel_mode_mono)
+              fill_opacity=(MagickRealType) (p[n])/
+                (glyph_info.bitmap.num_grays-1);
             else
-              fill_opacity=((p[(x >> 3)+y*bitmap->bitmap.pitch] &
+              fill_opacity=((p[(x >> 3)+y*glyph_info.bitmap.pitch] &
                 (1 << (~x & 0x07)))) == 0 ? 0.0 : 1.0;
             if (draw_info->text_antialias == MagickFalse)
               fill_opacity=fill_opacity >= 0.5 ? 1.0 : 0.0;
@@ -1432,23 +1894,21 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
         }
         image_view=DestroyCacheView(image_view);
       }
-    if ((bitmap->left+bitmap->bitmap.width) > metrics->width)
-      metrics->width=bitmap->left+bitmap->bitmap.width;
+    if ((glyph_info.left+glyph_info.bitmap.width) > metrics->width)
+      metrics->width=glyph_info.left+glyph_info.bitmap.width;
     if ((draw_info->interword_spacing != 0.0) &&
         (IsUTFSpace(GetUTFCode(p)) != MagickFalse) &&
         (IsUTFSpace(code) == MagickFalse))
       origin.x+=64.0*direction*draw_info->interword_spacing;
     else
-      origin.x+=direction*face->glyph->advance.x;
+      origin.x+=direction*glyph_info.advance.x;
     metrics->origin.x=origin.x;
     metrics->origin.y=origin.y;
-    FT_Done_Glyph(last_glyph.image);
     last_glyph=glyph;
     code=GetUTFCode(p);
   }
   if (utf8 != (unsigned char *) NULL)
     utf8=(unsigned char *) RelinquishMagickMemory(utf8);
-  FT_Done_Glyph(last_glyph.image);
   if ((draw_info->stroke.opacity != TransparentOpacity) ||
       (draw_info->stroke_pattern != (Image *) NULL))
     {
@@ -1469,27 +1929,11 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
   */
   glyph.id=FT_Get_Char_Index(face,'_');
   glyph.origin=origin;
-  status=FT_Load_Glyph(face,glyph.id,flags);
-  if (status == 0)
-    {
-      status=FT_Get_Glyph(face->glyph,&glyph.image);
-      if (status == 0)
-        {
-          status=FT_Outline_Get_BBox(&((FT_OutlineGlyph) glyph.image)->
-            outline,&bounds);
-          if (status == 0)
-            {
-              FT_Vector_Transform(&glyph.origin,&affine);
-              (void) FT_Glyph_Transform(glyph.image,&affine,&glyph.origin);
-              status=FT_Glyph_To_Bitmap(&glyph.image,ft_render_mode_normal,
-                (FT_Vector *) NULL,MagickTrue);
-              bitmap=(FT_BitmapGlyph) glyph.image;
-              if (bitmap->left > metrics->width)
-                metrics->width=bitmap->left;
-            }
-        }
-      FT_Done_Glyph(glyph.image);
-    }
+  FT_Vector_Transform(&glyph.origin,&affine);
+  if (GetGlyphBitmap(face,*font_key != '\0' ? font_key : (char *) NULL,
+        glyph.id,flags,&affine,&glyph.origin,&glyph_info) != MagickFalse)
+    if (glyph_info.left > metrics->width)
+      metrics->width=glyph_info.left;
   metrics->width-=metrics->bounds.x1/64.0;
   metrics->bounds.x1/=64.0;
   metrics->bounds.y1/=64.0;
@@ -1500,9 +1944,11 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
   /*
     Relinquish resources.
   */
+  if (glyph_info.bitmap.buffer != (unsigned char *) NULL)
+    glyph_info.bitmap.buffer=(unsigned char *) RelinquishMagickMemory(
+      glyph_info.bitmap.buffer);
   annotate_info=DestroyDrawInfo(annotate_info);
-  (void) FT_Done_Face(face);
-  (void) FT_Done_FreeType(library);
+  RelinquishFreetypeFace(face_key,library,face);
   return(MagickTrue);
 }
 #else
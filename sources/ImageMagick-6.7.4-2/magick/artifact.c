@@ -83,7 +83,8 @@
 %                                                                             %
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %
-%  CloneImageArtifacts() clones one or more image artifacts.
+%  CloneImageArtifacts() clones one or more image artifacts.  The artifact
+%  strings are shared with the clone rather than copied.
 %
 %  The format of the CloneImageArtifacts method is:
 %
@@ -110,7 +111,7 @@ MagickExport MagickBooleanType CloneImageArtifacts(Image *image,
     (void) LogMagickEvent(TraceEvent,GetMagickModule(),"%s",
       clone_image->filename);
   if (clone_image->artifacts != (void *) NULL)
-    image->artifacts=CloneSplayTree((SplayTreeInfo *) clone_image->artifacts,
+    image->artifacts=ShareSplayTree((SplayTreeInfo *) clone_image->artifacts,
       (void *(*)(void *)) ConstantString,(void *(*)(void *)) ConstantString);
   return(MagickTrue);
 }
@@ -319,6 +319,79 @@ MagickExport const void *AcquirePixelCachePixels(const Image *image,
   return((const void *) cache_info->pixels);
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   C a c h e C o m p o n e n t F o r k C h i l d                             %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  CacheComponentForkChild() releases the pixel cache component in the child
+%  process after a fork().
+%
+%  The format of the CacheComponentForkChild method is:
+%
+%      CacheComponentForkChild(void)
+%
+*/
+MagickExport void CacheComponentForkChild(void)
+{
+  UnlockSemaphoreInfo(cache_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   C a c h e C o m p o n e n t F o r k P a r e n t                           %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  CacheComponentForkParent() releases the pixel cache component in the parent
+%  process after a fork().
+%
+%  The format of the CacheComponentForkParent method is:
+%
+%      CacheComponentForkParent(void)
+%
+*/
+MagickExport void CacheComponentForkParent(void)
+{
+  UnlockSemaphoreInfo(cache_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   C a c h e C o m p o n e n t F o r k P r e p a r e                         %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  CacheComponentForkPrepare() locks the pixel cache component before a fork().
+%
+%  The format of the CacheComponentForkPrepare method is:
+%
+%      CacheComponentForkPrepare(void)
+%
+*/
+MagickExport void CacheComponentForkPrepare(void)
+{
+  if (cache_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&cache_semaphore);
+  LockSemaphoreInfo(cache_semaphore);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -67,6 +67,9 @@ extern MagickExport VirtualPixelMethod
   SetPixelCacheVirtualMethod(const Image *,const VirtualPixelMethod);
 
 extern MagickExport void
+  CacheComponentForkChild(void),
+  CacheComponentForkParent(void),
+  CacheComponentForkPrepare(void),
   CacheComponentTerminus(void),
   *GetPixelCachePixels(Image *,MagickSizeType *,ExceptionInfo *);
 
@@ -63,6 +63,7 @@
 #include "magick/quantum.h"
 #include "magick/semaphore.h"
 #include "magick/string_.h"
+#include "magick/string-private.h"
 #include "magick/token.h"
 #include "magick/utility.h"
 #include "magick/xml-tree.h"
@@ -781,12 +782,22 @@ static const ColorMapInfo
 /*
   Static declarations.
 */
+static const ColorInfo
+  **color_entries = (const ColorInfo **) NULL;
+
 static LinkedListInfo
   *color_list = (LinkedListInfo *) NULL;
 
 static SemaphoreInfo
   *color_semaphore = (SemaphoreInfo *) NULL;
 
+static size_t
+  color_extent = 0,
+  *color_table = (size_t *) NULL;
+
+static ssize_t
+  *color_links = (ssize_t *) NULL;
+
 static volatile MagickBooleanType
   instantiate_color = MagickFalse;
 
@@ -797,6 +808,79 @@ static MagickBooleanType
   InitializeColorList(ExceptionInfo *),
   LoadColorLists(const char *,ExceptionInfo *);
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   C o l o r C o m p o n e n t F o r k C h i l d                             %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ColorComponentForkChild() releases the color component in the child process
+%  after a fork().
+%
+%  The format of the ColorComponentForkChild method is:
+%
+%      ColorComponentForkChild(void)
+%
+*/
+MagickExport void ColorComponentForkChild(void)
+{
+  UnlockSemaphoreInfo(color_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   C o l o r C o m p o n e n t F o r k P a r e n t                           %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ColorComponentForkParent() releases the color component in the parent
+%  process after a fork().
+%
+%  The format of the ColorComponentForkParent method is:
+%
+%      ColorComponentForkParent(void)
+%
+*/
+MagickExport void ColorComponentForkParent(void)
+{
+  UnlockSemaphoreInfo(color_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   C o l o r C o m p o n e n t F o r k P r e p a r e                         %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ColorComponentForkPrepare() locks the color component before a fork().
+%
+%  The format of the ColorComponentForkPrepare method is:
+%
+%      ColorComponentForkPrepare(void)
+%
+*/
+MagickExport void ColorComponentForkPrepare(void)
+{
+  if (color_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&color_semaphore);
+  LockSemaphoreInfo(color_semaphore);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -862,6 +946,14 @@ MagickExport void ColorComponentTerminus(void)
   if (color_semaphore == (SemaphoreInfo *) NULL)
     AcquireSemaphoreInfo(&color_semaphore);
   LockSemaphoreInfo(color_semaphore);
+  if (color_table != (size_t *) NULL)
+    color_table=(size_t *) RelinquishMagickMemory(color_table);
+  if (color_links != (ssize_t *) NULL)
+    color_links=(ssize_t *) RelinquishMagickMemory(color_links);
+  if (color_entries != (const ColorInfo **) NULL)
+    color_entries=(const ColorInfo **) RelinquishMagickMemory((void *)
+      color_entries);
+  color_extent=0;
   if (color_list != (LinkedListInfo *) NULL)
     color_list=DestroyLinkedList(color_list,DestroyColorElement);
   instantiate_color=MagickFalse;
@@ -906,6 +998,9 @@ MagickExport const ColorInfo *GetColorCompliance(const char *name,
   register const ColorInfo
     *p;
 
+  register const char
+    *r;
+
   register char
     *q;
 
@@ -922,34 +1017,56 @@ MagickExport const ColorInfo *GetColorCompliance(const char *name,
   /*
     Strip names of whitespace.
   */
-  (void) CopyMagickString(colorname,name,MaxTextExtent);
-  for (q=colorname; *q != '\0'; q++)
-  {
-    if (isspace((int) ((unsigned char) *q)) == 0)
-      continue;
-    (void) CopyMagickString(q,q+1,MaxTextExtent);
-    q--;
-  }
+  q=colorname;
+  for (r=name; (*r != '\0') && (q < (colorname+MaxTextExtent-1)); r++)
+    if (isspace((int) ((unsigned char) *r)) == 0)
+      *q++=(*r);
+  *q='\0';
   /*
-    Search for color tag.
+    Search for color tag.  The color table is immutable once the color list
+    is loaded, so no lock is needed.
   */
-  LockSemaphoreInfo(color_semaphore);
-  ResetLinkedListIterator(color_list);
-  p=(const ColorInfo *) GetNextValueInLinkedList(color_list);
-  while (p != (const ColorInfo *) NULL)
-  {
-    if (((p->compliance & compliance) != 0) &&
-        (LocaleCompare(colorname,p->name) == 0))
-      break;
-    p=(const ColorInfo *) GetNextValueInLinkedList(color_list);
-  }
+  p=(const ColorInfo *) NULL;
+  if (color_table != (size_t *) NULL)
+    {
+      register size_t
+        i;
+
+      register ssize_t
+        j;
+
+      for (i=HashLocaleString(colorname) & (color_extent-1);
+           color_table[i] != 0; i=(i+1) & (color_extent-1))
+      {
+        j=(ssize_t) color_table[i]-1;
+        if (LocaleCompare(colorname,color_entries[j]->name) != 0)
+          continue;
+        for ( ; j >= 0; j=color_links[j])
+          if ((color_entries[j]->compliance & compliance) != 0)
+            {
+              p=color_entries[j];
+              break;
+            }
+        break;
+      }
+    }
+  else
+    {
+      LockSemaphoreInfo(color_semaphore);
+      ResetLinkedListIterator(color_list);
+      p=(const ColorInfo *) GetNextValueInLinkedList(color_list);
+      while (p != (const ColorInfo *) NULL)
+      {
+        if (((p->compliance & compliance) != 0) &&
+            (LocaleCompare(colorname,p->name) == 0))
+          break;
+        p=(const ColorInfo *) GetNextValueInLinkedList(color_list);
+      }
+      UnlockSemaphoreInfo(color_semaphore);
+    }
   if (p == (ColorInfo *) NULL)
     (void) ThrowMagickException(exception,GetMagickModule(),OptionWarning,
       "UnrecognizedColor","`%s'",name);
-  else
-    (void) InsertValueInLinkedList(color_list,0,
-      RemoveElementByValueFromLinkedList(color_list,p));
-  UnlockSemaphoreInfo(color_semaphore);
   return(p);
 }
 
@@ -1487,6 +1604,70 @@ MagickExport void GetColorTuple(const MagickPixelPacket *pixel,
 %    o exception: return any errors or warnings in this structure.
 %
 */
+static void CompileColorList(void)
+{
+  register const ColorInfo
+    *p;
+
+  register ssize_t
+    i,
+    j;
+
+  size_t
+    number_colors;
+
+  /*
+    Index the color list by name.  Colors that share a name are chained in
+    list order so the first that meets the requested compliance wins.
+  */
+  number_colors=GetNumberOfElementsInLinkedList(color_list);
+  if (number_colors == 0)
+    return;
+  for (color_extent=16; color_extent < (2*number_colors+1); color_extent<<=1) ;
+  color_entries=(const ColorInfo **) AcquireQuantumMemory(number_colors,
+    sizeof(*color_entries));
+  color_links=(ssize_t *) AcquireQuantumMemory(number_colors,
+    sizeof(*color_links));
+  color_table=(size_t *) AcquireQuantumMemory(color_extent,
+    sizeof(*color_table));
+  if ((color_entries == (const ColorInfo **) NULL) ||
+      (color_links == (ssize_t *) NULL) || (color_table == (size_t *) NULL))
+    {
+      if (color_table != (size_t *) NULL)
+        color_table=(size_t *) RelinquishMagickMemory(color_table);
+      if (color_links != (ssize_t *) NULL)
+        color_links=(ssize_t *) RelinquishMagickMemory(color_links);
+      if (color_entries != (const ColorInfo **) NULL)
+        color_entries=(const ColorInfo **) RelinquishMagickMemory((void *)
+          color_entries);
+      return;
+    }
+  (void) ResetMagickMemory(color_table,0,color_extent*sizeof(*color_table));
+  ResetLinkedListIterator(color_list);
+  for (i=0; i < (ssize_t) number_colors; i++)
+  {
+    register size_t
+      k;
+
+    p=(const ColorInfo *) GetNextValueInLinkedList(color_list);
+    color_entries[i]=p;
+    color_links[i]=(-1);
+    if (p->name == (char *) NULL)
+      continue;
+    for (k=HashLocaleString(p->name) & (color_extent-1);
+         color_table[k] != 0; k=(k+1) & (color_extent-1))
+      if (LocaleCompare(p->name,color_entries[color_table[k]-1]->name) == 0)
+        break;
+    if (color_table[k] == 0)
+      {
+        color_table[k]=(size_t) i+1;
+        continue;
+      }
+    for (j=(ssize_t) color_table[k]-1; color_links[j] >= 0; j=color_links[j]) ;
+    color_links[j]=i;
+  }
+}
+
 static MagickBooleanType InitializeColorList(ExceptionInfo *exception)
 {
   if ((color_list == (LinkedListInfo *) NULL) &&
@@ -1499,6 +1680,8 @@ static MagickBooleanType InitializeColorList(ExceptionInfo *exception)
           (instantiate_color == MagickFalse))
         {
           (void) LoadColorLists(ColorFilename,exception);
+          if (color_list != (LinkedListInfo *) NULL)
+            CompileColorList();
           instantiate_color=MagickTrue;
         }
       UnlockSemaphoreInfo(color_semaphore);
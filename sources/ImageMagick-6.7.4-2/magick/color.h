@@ -97,6 +97,9 @@ extern MagickExport MagickBooleanType
     const ComplianceType,char *,ExceptionInfo *);
 
 extern MagickExport void
+  ColorComponentForkChild(void),
+  ColorComponentForkParent(void),
+  ColorComponentForkPrepare(void),
   ColorComponentTerminus(void),
   ConcatenateColorComponent(const MagickPixelPacket *,const ChannelType,
     const ComplianceType,char *),
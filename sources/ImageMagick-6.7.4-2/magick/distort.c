@@ -61,6 +61,8 @@
 #include "magick/pixel-private.h"
 #include "magick/resample.h"
 #include "magick/resample-private.h"
+#include "magick/resize.h"
+#include "magick/resize-private.h"
 #include "magick/registry.h"
 #include "magick/semaphore.h"
 #include "magick/shear.h"
@@ -69,6 +71,7 @@
 #include "magick/thread-private.h"
 #include "magick/token.h"
 #include "magick/transform.h"
+#include "magick/utility.h"
 
 /*
   Numerous internal routines for image distortions.
@@ -1579,6 +1582,426 @@ MagickExport Image *DistortResizeImage(const Image *image,
   return(resize_image);
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   S e p a r a b l e D i s t o r t I m a g e                                 %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  SeparableDistortImage() resamples an axis aligned affine distortion (a
+%  scale and translation without rotation or shearing) in two 1-D passes,
+%  first down the columns and then along the rows.  The weights of each pass
+%  depend only on the destination column or row, so they are calculated once
+%  for the whole image rather than once per pixel as the EWA resampler must.
+%
+%  The destination pixel (x,y) samples the source image at
+%  (scale.x*x+offset.x,scale.y*y+offset.y), in pixel index coordinates.
+%
+%  The format of the SeparableDistortImage method is:
+%
+%      MagickBooleanType SeparableDistortImage(const Image *image,
+%        const PointInfo *scale,const PointInfo *offset,Image *distort_image,
+%        ExceptionInfo *exception)
+%
+%  A description of each parameter follows:
+%
+%    o image: the source image.
+%
+%    o scale: source pixels per destination pixel along each axis.
+%
+%    o offset: the source coordinate of the first destination pixel.
+%
+%    o distort_image: the destination image.
+%
+%    o exception: return any errors or warnings in this structure.
+%
+*/
+
+static double *AcquireDistortWeights(const ResizeFilter *resize_filter,
+  const size_t length,const double scale,const double offset,ssize_t *start,
+  size_t *width)
+{
+  double
+    blur,
+    center,
+    density,
+    support,
+    *weights;
+
+  register ssize_t
+    i,
+    k;
+
+  /*
+    Normalized filter weights of the source pixels contributing to each
+    destination pixel along one axis.
+  */
+  blur=MagickMax(fabs(scale),1.0);
+  support=blur*GetResizeFilterSupport(resize_filter);
+  if (support < 0.5)
+    {
+      support=0.5;
+      blur=1.0;
+    }
+  *width=(size_t) (2.0*support+3.0);
+  weights=(double *) AcquireQuantumMemory(length,*width*sizeof(*weights));
+  if (weights == (double *) NULL)
+    return((double *) NULL);
+  (void) ResetMagickMemory(weights,0,length*(*width)*sizeof(*weights));
+  for (i=0; i < (ssize_t) length; i++)
+  {
+    center=scale*i+offset;
+    start[i]=(ssize_t) ceil(center-support);
+    density=0.0;
+    for (k=0; k < (ssize_t) *width; k++)
+    {
+      if ((double) (start[i]+k) > (center+support))
+        break;
+      weights[i*(*width)+k]=GetResizeFilterWeight(resize_filter,
+        ((double) (start[i]+k)-center)/blur);
+      density+=weights[i*(*width)+k];
+    }
+    if ((density != 0.0) && (density != 1.0))
+      {
+        density=1.0/density;
+        for (k=0; k < (ssize_t) *width; k++)
+          weights[i*(*width)+k]*=density;
+      }
+  }
+  return(weights);
+}
+
+static inline void FilterDistortPixel(const Image *image,
+  const double *weights,const size_t number_weights,const PixelPacket *p,
+  const IndexPacket *indexes,const ssize_t stride,PixelPacket *q,
+  IndexPacket *index)
+{
+  double
+    alpha,
+    gamma;
+
+  MagickPixelPacket
+    pixel;
+
+  register ssize_t
+    k;
+
+  (void) ResetMagickMemory(&pixel,0,sizeof(pixel));
+  gamma=0.0;
+  for (k=0; k < (ssize_t) number_weights; k++)
+  {
+    alpha=weights[k];
+    if (image->matte != MagickFalse)
+      alpha*=QuantumScale*GetPixelAlpha(p+k*stride);
+    pixel.red+=alpha*GetPixelRed(p+k*stride);
+    pixel.green+=alpha*GetPixelGreen(p+k*stride);
+    pixel.blue+=alpha*GetPixelBlue(p+k*stride);
+    pixel.opacity+=weights[k]*GetPixelOpacity(p+k*stride);
+    if (index != (IndexPacket *) NULL)
+      pixel.index+=alpha*GetPixelIndex(indexes+k*stride);
+    gamma+=alpha;
+  }
+  if (image->matte == MagickFalse)
+    gamma=1.0;
+  else
+    gamma=1.0/(fabs((double) gamma) <= MagickEpsilon ? 1.0 : gamma);
+  SetPixelRed(q,ClampToQuantum(gamma*pixel.red));
+  SetPixelGreen(q,ClampToQuantum(gamma*pixel.green));
+  SetPixelBlue(q,ClampToQuantum(gamma*pixel.blue));
+  SetPixelOpacity(q,ClampToQuantum(pixel.opacity));
+  if (index != (IndexPacket *) NULL)
+    SetPixelIndex(index,ClampToQuantum(gamma*pixel.index));
+}
+
+static MagickBooleanType SeparableDistortImage(const Image *image,
+  const PointInfo *scale,const PointInfo *offset,Image *distort_image,
+  ExceptionInfo *exception)
+{
+#define DistortImageTag  "Distort/Image"
+
+  CacheView
+    *distort_view,
+    *filter_view,
+    *image_view;
+
+  double
+    *x_weights,
+    *y_weights;
+
+  Image
+    *filter_image;
+
+  MagickBooleanType
+    status;
+
+  MagickOffsetType
+    progress;
+
+  ResizeFilter
+    *resize_filter;
+
+  size_t
+    x_width,
+    y_width;
+
+  ssize_t
+    *x_start,
+    *y_start,
+    x_offset,
+    y;
+
+  resize_filter=AcquireResizeFilter(image,image->filter == UndefinedFilter ?
+    RobidouxFilter : image->filter,image->blur,MagickFalse,exception);
+  if (resize_filter == (ResizeFilter *) NULL)
+    return(MagickFalse);
+  x_start=(ssize_t *) AcquireQuantumMemory(distort_image->columns,
+    sizeof(*x_start));
+  y_start=(ssize_t *) AcquireQuantumMemory(distort_image->rows,
+    sizeof(*y_start));
+  x_weights=(double *) NULL;
+  y_weights=(double *) NULL;
+  if ((x_start != (ssize_t *) NULL) && (y_start != (ssize_t *) NULL))
+    {
+      x_weights=AcquireDistortWeights(resize_filter,distort_image->columns,
+        scale->x,offset->x,x_start,&x_width);
+      y_weights=AcquireDistortWeights(resize_filter,distort_image->rows,
+        scale->y,offset->y,y_start,&y_width);
+    }
+  resize_filter=DestroyResizeFilter(resize_filter);
+  filter_image=(Image *) NULL;
+  x_offset=0;
+  if ((x_weights != (double *) NULL) && (y_weights != (double *) NULL))
+    {
+      /*
+        The intermediate image spans exactly the source columns that the
+        second pass reads, so only the first pass sees virtual pixels.
+      */
+      x_offset=x_start[0];
+      if (x_start[distort_image->columns-1] < x_offset)
+        x_offset=x_start[distort_image->columns-1];
+      filter_image=CloneImage(image,(size_t) (MagickMax((double) x_start[0],
+        (double) x_start[distort_image->columns-1])-x_offset+x_width),
+        distort_image->rows,MagickTrue,exception);
+    }
+  if (filter_image == (Image *) NULL)
+    {
+      if (y_weights != (double *) NULL)
+        y_weights=(double *) RelinquishMagickMemory(y_weights);
+      if (x_weights != (double *) NULL)
+        x_weights=(double *) RelinquishMagickMemory(x_weights);
+      if (y_start != (ssize_t *) NULL)
+        y_start=(ssize_t *) RelinquishMagickMemory(y_start);
+      if (x_start != (ssize_t *) NULL)
+        x_start=(ssize_t *) RelinquishMagickMemory(x_start);
+      (void) ThrowMagickException(exception,GetMagickModule(),
+        ResourceLimitError,"MemoryAllocationFailed","`%s'",image->filename);
+      return(MagickFalse);
+    }
+  filter_image->matte=distort_image->matte;
+  status=SetImageStorageClass(filter_image,DirectClass);
+  if (status == MagickFalse)
+    InheritException(exception,&filter_image->exception);
+  progress=0;
+  /*
+    Filter the columns of the source image.
+  */
+  image_view=AcquireCacheView(image);
+  filter_view=AcquireCacheView(filter_image);
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for schedule(static,4) shared(progress,status)
+#endif
+  for (y=0; y < (ssize_t) filter_image->rows; y++)
+  {
+    register const IndexPacket
+      *restrict indexes;
+
+    register const PixelPacket
+      *restrict p;
+
+    register IndexPacket
+      *restrict filter_indexes;
+
+    register PixelPacket
+      *restrict q;
+
+    register ssize_t
+      x;
+
+    if (status == MagickFalse)
+      continue;
+    p=GetCacheViewVirtualPixels(image_view,x_offset,y_start[y],
+      filter_image->columns,y_width,exception);
+    q=QueueCacheViewAuthenticPixels(filter_view,0,y,filter_image->columns,1,
+      exception);
+    if ((p == (const PixelPacket *) NULL) || (q == (PixelPacket *) NULL))
+      {
+        status=MagickFalse;
+        continue;
+      }
+    indexes=GetCacheViewVirtualIndexQueue(image_view);
+    filter_indexes=GetCacheViewAuthenticIndexQueue(filter_view);
+    for (x=0; x < (ssize_t) filter_image->columns; x++)
+      FilterDistortPixel(distort_image,y_weights+y*y_width,y_width,p+x,
+        indexes+x,(ssize_t) filter_image->columns,q+x,
+        image->colorspace == CMYKColorspace ? filter_indexes+x :
+        (IndexPacket *) NULL);
+    if (SyncCacheViewAuthenticPixels(filter_view,exception) == MagickFalse)
+      status=MagickFalse;
+    if (image->progress_monitor != (MagickProgressMonitor) NULL)
+      {
+        MagickBooleanType
+          proceed;
+
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp critical (MagickCore_SeparableDistortImage)
+#endif
+        proceed=SetImageProgress(image,DistortImageTag,progress++,
+          2*distort_image->rows);
+        if (proceed == MagickFalse)
+          status=MagickFalse;
+      }
+  }
+  image_view=DestroyCacheView(image_view);
+  /*
+    Filter the rows of the intermediate image.
+  */
+  distort_view=AcquireCacheView(distort_image);
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for schedule(static,4) shared(progress,status)
+#endif
+  for (y=0; y < (ssize_t) distort_image->rows; y++)
+  {
+    register const IndexPacket
+      *restrict indexes;
+
+    register const PixelPacket
+      *restrict p;
+
+    register IndexPacket
+      *restrict distort_indexes;
+
+    register PixelPacket
+      *restrict q;
+
+    register ssize_t
+      x;
+
+    if (status == MagickFalse)
+      continue;
+    p=GetCacheViewVirtualPixels(filter_view,0,y,filter_image->columns,1,
+      exception);
+    q=QueueCacheViewAuthenticPixels(distort_view,0,y,distort_image->columns,1,
+      exception);
+    if ((p == (const PixelPacket *) NULL) || (q == (PixelPacket *) NULL))
+      {
+        status=MagickFalse;
+        continue;
+      }
+    indexes=GetCacheViewVirtualIndexQueue(filter_view);
+    distort_indexes=GetCacheViewAuthenticIndexQueue(distort_view);
+    for (x=0; x < (ssize_t) distort_image->columns; x++)
+      FilterDistortPixel(distort_image,x_weights+x*x_width,x_width,
+        p+(x_start[x]-x_offset),indexes+(x_start[x]-x_offset),1,q+x,
+        image->colorspace == CMYKColorspace ? distort_indexes+x :
+        (IndexPacket *) NULL);
+    if (SyncCacheViewAuthenticPixels(distort_view,exception) == MagickFalse)
+      status=MagickFalse;
+    if (image->progress_monitor != (MagickProgressMonitor) NULL)
+      {
+        MagickBooleanType
+          proceed;
+
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp critical (MagickCore_SeparableDistortImage)
+#endif
+        proceed=SetImageProgress(image,DistortImageTag,progress++,
+          2*distort_image->rows);
+        if (proceed == MagickFalse)
+          status=MagickFalse;
+      }
+  }
+  distort_view=DestroyCacheView(distort_view);
+  filter_view=DestroyCacheView(filter_view);
+  filter_image=DestroyImage(filter_image);
+  y_weights=(double *) RelinquishMagickMemory(y_weights);
+  x_weights=(double *) RelinquishMagickMemory(x_weights);
+  y_start=(ssize_t *) RelinquishMagickMemory(y_start);
+  x_start=(ssize_t *) RelinquishMagickMemory(x_start);
+  return(status);
+}
+
+/*
+  Source coordinates, validity and EWA scaling vectors of one row of
+  destination pixels.  The entry past the end of the row remembers the
+  scaling vectors last applied to the thread's resample filter.
+*/
+typedef struct _DistortMapInfo
+{
+  PointInfo
+    point;
+
+  double
+    validity,
+    scaling[4];
+
+  MagickBooleanType
+    scaled;
+} DistortMapInfo;
+
+static DistortMapInfo **DestroyDistortMapThreadSet(DistortMapInfo **map)
+{
+  register ssize_t
+    i;
+
+  assert(map != (DistortMapInfo **) NULL);
+  for (i=0; i < (ssize_t) GetOpenMPMaximumThreads(); i++)
+    if (map[i] != (DistortMapInfo *) NULL)
+      map[i]=(DistortMapInfo *) RelinquishMagickMemory(map[i]);
+  map=(DistortMapInfo **) RelinquishMagickMemory(map);
+  return(map);
+}
+
+static DistortMapInfo **AcquireDistortMapThreadSet(const size_t columns)
+{
+  DistortMapInfo
+    **map;
+
+  register ssize_t
+    i;
+
+  size_t
+    number_threads;
+
+  number_threads=GetOpenMPMaximumThreads();
+  map=(DistortMapInfo **) AcquireQuantumMemory(number_threads,sizeof(*map));
+  if (map == (DistortMapInfo **) NULL)
+    return((DistortMapInfo **) NULL);
+  (void) ResetMagickMemory(map,0,number_threads*sizeof(*map));
+  for (i=0; i < (ssize_t) number_threads; i++)
+  {
+    map[i]=(DistortMapInfo *) AcquireQuantumMemory(columns+1,sizeof(**map));
+    if (map[i] == (DistortMapInfo *) NULL)
+      return(DestroyDistortMapThreadSet(map));
+    (void) ResetMagickMemory(map[i],0,(columns+1)*sizeof(**map));
+  }
+  return(map);
+}
+
+static inline void ScaleDistortMap(DistortMapInfo *map,const double dux,
+  const double duy,const double dvx,const double dvy)
+{
+  map->scaled=MagickTrue;
+  map->scaling[0]=dux;
+  map->scaling[1]=duy;
+  map->scaling[2]=dvx;
+  map->scaling[3]=dvy;
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -1658,6 +2081,11 @@ MagickExport Image *DistortResizeImage(const Image *image,
 %        Scale the size of the output canvas by this amount to provide a
 %        method of Zooming, and for super-sampling the results.
 %
+%    o "distort:separable"
+%        Resample affine distortions that neither rotate nor shear the image
+%        with two 1-D filter passes rather than the slower EWA (cylindrical)
+%        area resampling.  The result differs slightly from the EWA result.
+%
 %  Other settings that can effect results include
 %
 %    o 'interpolate' For source image lookups (scale enlargements)
@@ -2257,8 +2685,8 @@ MagickExport Image *DistortImage(const Image *image,DistortImageMethod method,
       output_scaling = 1/output_scaling;
     }
   }
-#define ScaleFilter(F,A,B,C,D) \
-    ScaleResampleFilter( (F), \
+#define ScaleFilter(M,A,B,C,D) \
+    ScaleDistortMap( (M), \
       output_scaling*(A), output_scaling*(B), \
       output_scaling*(C), output_scaling*(D) )
 
@@ -2281,12 +2709,40 @@ MagickExport Image *DistortImage(const Image *image,DistortImageMethod method,
   if (distort_image->background_color.opacity != OpaqueOpacity)
     distort_image->matte=MagickTrue;
 
+  if ( method == AffineDistortion && coeff[1] == 0.0 && coeff[3] == 0.0 &&
+       image->filter != PointFilter &&
+       IsMagickTrue(GetImageArtifact(image,"distort:separable")) ) {
+    /* An affine distortion that neither rotates nor shears the image is
+       separable, so resample it as two 1-D filter passes.
+    */
+    PointInfo
+      offset,
+      scale;
+
+    scale.x = coeff[0]*output_scaling;
+    scale.y = coeff[4]*output_scaling;
+    offset.x = coeff[0]*(geometry.x+0.5)*output_scaling + coeff[2] - 0.5;
+    offset.y = coeff[4]*(geometry.y+0.5)*output_scaling + coeff[5] - 0.5;
+    if ( bestfit ) {
+      offset.x -= image->page.x;
+      offset.y -= image->page.y;
+    }
+    if ( SeparableDistortImage(image,&scale,&offset,distort_image,
+           exception) == MagickFalse )
+      distort_image=DestroyImage(distort_image);
+    coeff = (double *) RelinquishMagickMemory(coeff);
+    return(distort_image);
+  }
+
   { /* ----- MAIN CODE -----
        Sample the source image to each pixel in the distort image.
      */
     CacheView
       *distort_view;
 
+    DistortMapInfo
+      **restrict distort_map;
+
     MagickBooleanType
       status;
 
@@ -2307,6 +2763,14 @@ MagickExport Image *DistortImage(const Image *image,DistortImageMethod method,
     GetMagickPixelPacket(distort_image,&zero);
     resample_filter=AcquireResampleFilterThreadSet(image,
       UndefinedVirtualPixelMethod,MagickFalse,exception);
+    distort_map=AcquireDistortMapThreadSet(distort_image->columns);
+    if (distort_map == (DistortMapInfo **) NULL)
+      {
+        resample_filter=DestroyResampleFilterThreadSet(resample_filter);
+        coeff = (double *) RelinquishMagickMemory(coeff);
+        distort_image=DestroyImage(distort_image);
+        ThrowImageException(ResourceLimitError,"MemoryAllocationFailed");
+      }
     distort_view=AcquireCacheView(distort_image);
 #if defined(MAGICKCORE_OPENMP_SUPPORT)
   #pragma omp parallel for schedule(static,4) shared(progress,status)
@@ -2330,6 +2794,10 @@ MagickExport Image *DistortImage(const Image *image,DistortImageMethod method,
         d,
         s;  /* transform destination image x,y  to source image x,y */
 
+      register DistortMapInfo
+        *restrict last,
+        *restrict map;
+
       register IndexPacket
         *restrict indexes;
 
@@ -2347,22 +2815,10 @@ MagickExport Image *DistortImage(const Image *image,DistortImageMethod method,
           continue;
         }
       indexes=GetCacheViewAuthenticIndexQueue(distort_view);
+      map=distort_map[id];
+      last=map+distort_image->columns;
       pixel=zero;
 
-      /* Define constant scaling vectors for Affine Distortions
-        Other methods are either variable, or use interpolated lookup
-      */
-      switch (method)
-      {
-        case AffineDistortion:
-          ScaleFilter( resample_filter[id],
-            coeff[0], coeff[1],
-            coeff[3], coeff[4] );
-          break;
-        default:
-          break;
-      }
-
       /* Initialize default pixel validity
       *    negative:         pixel is invalid  output 'matte_color'
       *    0.0 to 1.0:       antialiased, mix with resample output
@@ -2376,19 +2832,27 @@ MagickExport Image *DistortImage(const Image *image,DistortImageMethod method,
       if (distort_image->colorspace == CMYKColorspace)
         ConvertRGBToCMYK(&invalid);   /* what about other color spaces? */
 
+      /* First map the whole row of destination pixels to source coordinates,
+         validity and scaling vectors, then resample the source image.
+      */
       for (i=0; i < (ssize_t) distort_image->columns; i++)
       {
         /* map pixel coordinate to distortion space coordinate */
         d.x = (double) (geometry.x+i+0.5)*output_scaling;
         d.y = (double) (geometry.y+j+0.5)*output_scaling;
         s = d;  /* default is a no-op mapping */
+        map[i].scaled = MagickFalse;
         switch (method)
         {
           case AffineDistortion:
           {
             s.x=coeff[0]*d.x+coeff[1]*d.y+coeff[2];
             s.y=coeff[3]*d.x+coeff[4]*d.y+coeff[5];
-            /* Affine partial derivitives are constant -- set above */
+            /* Affine partial derivitives are constant for the whole row */
+            if ( i == 0 )
+              ScaleFilter( map+i,
+                coeff[0], coeff[1],
+                coeff[3], coeff[4] );
             break;
           }
           case PerspectiveDistortion:
@@ -2419,7 +2883,7 @@ MagickExport Image *DistortImage(const Image *image,DistortImageMethod method,
               s.y = q*scale;
               /* Perspective Partial Derivatives or Scaling Vectors */
               scale *= scale;
-              ScaleFilter( resample_filter[id],
+              ScaleFilter( map+i,
                 (r*coeff[0] - p*coeff[6])*scale,
                 (r*coeff[1] - p*coeff[7])*scale,
                 (r*coeff[3] - q*coeff[6])*scale,
@@ -2434,7 +2898,7 @@ MagickExport Image *DistortImage(const Image *image,DistortImageMethod method,
             s.y=coeff[4]*d.x+coeff[5]*d.y
                     +coeff[6]*d.x*d.y+coeff[7];
             /* Bilinear partial derivitives of scaling vectors */
-            ScaleFilter( resample_filter[id],
+            ScaleFilter( map+i,
                 coeff[0] + coeff[2]*d.y,
                 coeff[1] + coeff[2]*d.x,
                 coeff[4] + coeff[6]*d.y,
@@ -2499,7 +2963,7 @@ MagickExport Image *DistortImage(const Image *image,DistortImageMethod method,
               dv.x += poly_basis_dx(k,d.x,d.y)*coeff[2+k+nterms];
               dv.y += poly_basis_dy(k,d.x,d.y)*coeff[2+k+nterms];
             }
-            ScaleFilter( resample_filter[id], du.x,du.y,dv.x,dv.y );
+            ScaleFilter( map+i, du.x,du.y,dv.x,dv.y );
             break;
           }
           case ArcDistortion:
@@ -2515,10 +2979,10 @@ MagickExport Image *DistortImage(const Image *image,DistortImageMethod method,
               The results is a very simple orthogonal aligned ellipse.
             */
             if ( s.y > MagickEpsilon )
-              ScaleFilter( resample_filter[id],
+              ScaleFilter( map+i,
                   (double) (coeff[1]/(Magick2PI*s.y)), 0, 0, coeff[3] );
             else
-              ScaleFilter( resample_filter[id],
+              ScaleFilter( map+i,
                   distort_image->columns*2, 0, 0, coeff[3] );
 
             /* now scale the angle and radius for source image lookup point */
@@ -2540,10 +3004,10 @@ MagickExport Image *DistortImage(const Image *image,DistortImageMethod method,
                This results in very simple orthogonal scaling vectors
             */
             if ( s.y > MagickEpsilon )
-              ScaleFilter( resample_filter[id],
+              ScaleFilter( map+i,
                 (double) (coeff[6]/(Magick2PI*s.y)), 0, 0, coeff[7] );
             else
-              ScaleFilter( resample_filter[id],
+              ScaleFilter( map+i,
                   distort_image->columns*2, 0, 0, coeff[7] );
 
             /* now finish mapping radius/angle to source x,y coords */
@@ -2572,7 +3036,7 @@ MagickExport Image *DistortImage(const Image *image,DistortImageMethod method,
             s.x = coeff[1]*ax;      /* u  = r*atan(x/r) */
             s.y = d.y*cx;           /* v  = y*cos(u/r) */
             /* derivatives... (see personnal notes) */
-            ScaleFilter( resample_filter[id],
+            ScaleFilter( map+i,
                   1.0/(1.0+d.x*d.x), 0.0, -d.x*s.y*cx*cx/coeff[1], s.y/d.y );
 #if 0
 if ( i == 0 && j == 0 ) {
@@ -2603,7 +3067,7 @@ if ( i == 0 && j == 0 ) {
               s.x = coeff[1]*tx;         /* u = r * tan(x/r) */
               s.y = d.y*cx;              /* v = y / cos(x/r) */
               /* derivatives...  (see Anthony Thyssen's personal notes) */
-              ScaleFilter( resample_filter[id],
+              ScaleFilter( map+i,
                     cx*cx, 0.0, s.y*cx/coeff[1], cx );
 #if 1
 /*if ( i == 0 && j == 0 ) {*/
@@ -2641,7 +3105,7 @@ if ( d.x == 0.5 && d.y == 0.5 ) {
               /* Set the source pixel to lookup and EWA derivative vectors */
               s.x = d.x*fx + coeff[8];
               s.y = d.y*fy + coeff[9];
-              ScaleFilter( resample_filter[id],
+              ScaleFilter( map+i,
                   gx*d.x*d.x + fx, gx*d.x*d.y,
                   gy*d.x*d.y,      gy*d.y*d.y + fy );
             }
@@ -2653,11 +3117,11 @@ if ( d.x == 0.5 && d.y == 0.5 ) {
               ** otherwise...   s.x=coeff[8]; s.y=coeff[9];
               */
               if ( method == BarrelDistortion )
-                ScaleFilter( resample_filter[id],
+                ScaleFilter( map+i,
                      coeff[3], 0, 0, coeff[7] );
               else /* method == BarrelInverseDistortion */
                 /* FUTURE, trap for D==0 causing division by zero */
-                ScaleFilter( resample_filter[id],
+                ScaleFilter( map+i,
                      1.0/coeff[3], 0, 0, 1.0/coeff[7] );
             }
             break;
@@ -2707,14 +3171,34 @@ if ( d.x == 0.5 && d.y == 0.5 ) {
         }
         s.x -= 0.5;
         s.y -= 0.5;
+        map[i].point = s;
+        map[i].validity = validity;
+      }
 
+      for (i=0; i < (ssize_t) distort_image->columns; i++)
+      {
+        /* only rescale the filter when the scaling vectors change,
+           the entry past the end of the row holds those last applied */
+        if ( map[i].scaled != MagickFalse &&
+             ( last->scaled == MagickFalse ||
+               map[i].scaling[0] != last->scaling[0] ||
+               map[i].scaling[1] != last->scaling[1] ||
+               map[i].scaling[2] != last->scaling[2] ||
+               map[i].scaling[3] != last->scaling[3] ) ) {
+          ScaleResampleFilter( resample_filter[id],
+            map[i].scaling[0], map[i].scaling[1],
+            map[i].scaling[2], map[i].scaling[3] );
+          *last = map[i];
+        }
+        validity = map[i].validity;
         if ( validity <= 0.0 ) {
           /* result of distortion is an invalid pixel - don't resample */
           SetPixelPacket(distort_image,&invalid,q,indexes);
         }
         else {
           /* resample the source image to find its correct color */
-          (void) ResamplePixelColor(resample_filter[id],s.x,s.y,&pixel);
+          (void) ResamplePixelColor(resample_filter[id],map[i].point.x,
+            map[i].point.y,&pixel);
           /* if validity between 0.0 and 1.0 mix result with invalid pixel */
           if ( validity < 1.0 ) {
             /* Do a blend of sample color and invalid pixel */
@@ -2745,6 +3229,7 @@ if ( d.x == 0.5 && d.y == 0.5 ) {
         }
     }
     distort_view=DestroyCacheView(distort_view);
+    distort_map=DestroyDistortMapThreadSet(distort_map);
     resample_filter=DestroyResampleFilterThreadSet(resample_filter);
 
     if (status == MagickFalse)
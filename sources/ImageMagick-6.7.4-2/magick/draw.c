@@ -112,6 +112,15 @@ typedef struct _EdgeInfo
     highwater;
 } EdgeInfo;
 
+typedef struct _EdgeCrossingInfo
+{
+  MagickRealType
+    x;
+
+  ssize_t
+    direction;
+} EdgeCrossingInfo;
+
 typedef struct _ElementInfo
 {
   MagickRealType
@@ -399,6 +408,36 @@ static int CompareEdges(const void *x,const void *y)
   return(-1);
 }
 
+static int CompareEdgeCrossings(const void *x,const void *y)
+{
+  register const EdgeCrossingInfo
+    *p,
+    *q;
+
+  p=(const EdgeCrossingInfo *) x;
+  q=(const EdgeCrossingInfo *) y;
+  if (p->x > q->x)
+    return(1);
+  if (p->x < q->x)
+    return(-1);
+  return(0);
+}
+
+static int CompareEdgeSpans(const void *x,const void *y)
+{
+  register const SegmentInfo
+    *p,
+    *q;
+
+  p=(const SegmentInfo *) x;
+  q=(const SegmentInfo *) y;
+  if (p->x1 > q->x1)
+    return(1);
+  if (p->x1 < q->x1)
+    return(-1);
+  return(0);
+}
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }
 #endif
@@ -3792,12 +3831,202 @@ static MagickRealType GetOpacityPixel(PolygonInfo *polygon_info,
   return(subpath_opacity);
 }
 
+static inline void DrawPolygonPixel(const DrawInfo *draw_info,
+  PolygonInfo *polygon_info,const MagickRealType mid,
+  const MagickBooleanType fill,const ssize_t x,const ssize_t y,PixelPacket *q)
+{
+  MagickRealType
+    fill_opacity,
+    stroke_opacity;
+
+  PixelPacket
+    fill_color,
+    stroke_color;
+
+  /*
+    Fill and/or stroke.
+  */
+  fill_opacity=GetOpacityPixel(polygon_info,mid,fill,draw_info->fill_rule,
+    (double) x,(double) y,&stroke_opacity);
+  if (draw_info->stroke_antialias == MagickFalse)
+    {
+      fill_opacity=fill_opacity > 0.25 ? 1.0 : 0.0;
+      stroke_opacity=stroke_opacity > 0.25 ? 1.0 : 0.0;
+    }
+  (void) GetFillColor(draw_info,x,y,&fill_color);
+  fill_opacity=(MagickRealType) (QuantumRange-fill_opacity*(QuantumRange-
+    fill_color.opacity));
+  MagickCompositeOver(&fill_color,fill_opacity,q,(MagickRealType) q->opacity,q);
+  (void) GetStrokeColor(draw_info,x,y,&stroke_color);
+  stroke_opacity=(MagickRealType) (QuantumRange-stroke_opacity*(QuantumRange-
+    stroke_color.opacity));
+  MagickCompositeOver(&stroke_color,stroke_opacity,q,(MagickRealType)
+    q->opacity,q);
+}
+
+static void GetPolygonScanline(PolygonInfo *polygon_info,
+  const MagickRealType mid,const MagickRealType distance,
+  const MagickBooleanType fill,const double y,const ssize_t start,
+  const ssize_t stop,PolygonInfo *active_info,SegmentInfo *spans,
+  size_t *number_spans,EdgeCrossingInfo *crossings,size_t *number_crossings)
+{
+  MagickBooleanType
+    active,
+    crossing;
+
+  MagickRealType
+    alpha,
+    x1,
+    x2;
+
+  register EdgeInfo
+    *p;
+
+  register const PointInfo
+    *q;
+
+  register ssize_t
+    i;
+
+  ssize_t
+    j,
+    high,
+    low;
+
+  /*
+    Build the active edge table for this scan line: the edges that can affect
+    it, where each edge crosses it, and the spans of pixels close enough to an
+    edge that their coverage must be computed with GetOpacityPixel().
+  */
+  active_info->number_edges=0;
+  *number_spans=0;
+  *number_crossings=0;
+  active=MagickTrue;
+  crossing=fill;
+  p=polygon_info->edges;
+  for (j=0; j < (ssize_t) polygon_info->number_edges; j++, p++)
+  {
+    if (y <= (p->bounds.y1-mid-0.5))
+      active=MagickFalse;
+    if (y <= p->bounds.y1)
+      crossing=MagickFalse;
+    if (y < (p->bounds.y1-distance))
+      {
+        if (y < (p->bounds.y1-distance-1.0))
+          break;
+        continue;
+      }
+    if (y > (p->bounds.y2+distance))
+      continue;
+    if ((active != MagickFalse) && (y <= (p->bounds.y2+mid+0.5)))
+      {
+        /*
+          Advance the edge high water mark to this scan line.
+        */
+        i=(ssize_t) MagickMax((double) p->highwater,1.0);
+        for ( ; i < (ssize_t) p->number_points; i++)
+        {
+          if (y <= (p->points[i-1].y-mid-0.5))
+            break;
+          if (y > (p->points[i].y+mid+0.5))
+            continue;
+          if (p->scanline != y)
+            {
+              p->scanline=y;
+              p->highwater=(size_t) i;
+            }
+          break;
+        }
+        active_info->edges[active_info->number_edges++]=(*p);
+      }
+    /*
+      First point at or below the scan line band.
+    */
+    low=1;
+    high=(ssize_t) p->number_points-1;
+    while (low < high)
+    {
+      i=(low+high)/2;
+      if (p->points[i].y < (y-distance))
+        low=i+1;
+      else
+        high=i;
+    }
+    x1=MagickHuge;
+    x2=(-MagickHuge);
+    for (i=low; i < (ssize_t) p->number_points; i++)
+    {
+      q=p->points+i-1;
+      if (q->y > (y+distance))
+        break;
+      if ((q+1)->y == q->y)
+        {
+          x1=MagickMin(x1,MagickMin(q->x,(q+1)->x));
+          x2=MagickMax(x2,MagickMax(q->x,(q+1)->x));
+          continue;
+        }
+      alpha=(y-distance-q->y)/((q+1)->y-q->y);
+      alpha=alpha < 0.0 ? 0.0 : alpha > 1.0 ? 1.0 : alpha;
+      alpha=q->x+alpha*((q+1)->x-q->x);
+      x1=MagickMin(x1,alpha);
+      x2=MagickMax(x2,alpha);
+      alpha=(y+distance-q->y)/((q+1)->y-q->y);
+      alpha=alpha < 0.0 ? 0.0 : alpha > 1.0 ? 1.0 : alpha;
+      alpha=q->x+alpha*((q+1)->x-q->x);
+      x1=MagickMin(x1,alpha);
+      x2=MagickMax(x2,alpha);
+    }
+    x1=ceil(x1-distance);
+    x2=floor(x2+distance);
+    if (x1 < (MagickRealType) start)
+      x1=(MagickRealType) start;
+    if (x2 > (MagickRealType) stop)
+      x2=(MagickRealType) stop;
+    if (x1 <= x2)
+      {
+        spans[*number_spans].x1=x1;
+        spans[*number_spans].x2=x2;
+        (*number_spans)++;
+      }
+    if ((crossing == MagickFalse) || (y > p->bounds.y2))
+      continue;
+    /*
+      Where the edge crosses the scan line.
+    */
+    low=1;
+    high=(ssize_t) p->number_points-1;
+    while (low < high)
+    {
+      i=(low+high)/2;
+      if (p->points[i].y < y)
+        low=i+1;
+      else
+        high=i;
+    }
+    q=p->points+low-1;
+    crossings[*number_crossings].x=q->x+(y-q->y)*((q+1)->x-q->x)/
+      ((q+1)->y-q->y);
+    crossings[*number_crossings].direction=p->direction ? 1 : -1;
+    (*number_crossings)++;
+  }
+  if (*number_spans > 1)
+    qsort(spans,*number_spans,sizeof(*spans),CompareEdgeSpans);
+  if (*number_crossings > 1)
+    qsort(crossings,*number_crossings,sizeof(*crossings),CompareEdgeCrossings);
+}
+
 static MagickBooleanType DrawPolygonPrimitive(Image *image,
   const DrawInfo *draw_info,const PrimitiveInfo *primitive_info)
 {
   CacheView
     *image_view;
 
+  EdgeCrossingInfo
+    *crossing_info;
+
+  EdgeInfo
+    *edge_info;
+
   ExceptionInfo
     *exception;
 
@@ -3806,6 +4035,7 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
     status;
 
   MagickRealType
+    distance,
     mid;
 
   PolygonInfo
@@ -3818,7 +4048,11 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
     i;
 
   SegmentInfo
-    bounds;
+    bounds,
+    *span_info;
+
+  size_t
+    number_edges;
 
   ssize_t
     start,
@@ -3927,6 +4161,34 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
   /*
     Draw polygon or line.
   */
+  number_edges=polygon_info[0]->number_edges+1;
+  span_info=(SegmentInfo *) AcquireQuantumMemory(GetOpenMPMaximumThreads()*
+    number_edges,sizeof(*span_info));
+  crossing_info=(EdgeCrossingInfo *) AcquireQuantumMemory(
+    GetOpenMPMaximumThreads()*number_edges,sizeof(*crossing_info));
+  edge_info=(EdgeInfo *) AcquireQuantumMemory(GetOpenMPMaximumThreads()*
+    number_edges,sizeof(*edge_info));
+  if ((span_info == (SegmentInfo *) NULL) ||
+      (crossing_info == (EdgeCrossingInfo *) NULL) ||
+      (edge_info == (EdgeInfo *) NULL))
+    {
+      if (span_info != (SegmentInfo *) NULL)
+        span_info=(SegmentInfo *) RelinquishMagickMemory(span_info);
+      if (crossing_info != (EdgeCrossingInfo *) NULL)
+        crossing_info=(EdgeCrossingInfo *) RelinquishMagickMemory(
+          crossing_info);
+      if (edge_info != (EdgeInfo *) NULL)
+        edge_info=(EdgeInfo *) RelinquishMagickMemory(edge_info);
+      image_view=DestroyCacheView(image_view);
+      polygon_info=DestroyPolygonThreadSet(polygon_info);
+      ThrowBinaryException(ResourceLimitError,"MemoryAllocationFailed",
+        image->filename);
+    }
+  /*
+    Pixels farther than this from every edge are either fully inside or fully
+    outside the fill and untouched by the stroke.
+  */
+  distance=MagickMax(mid+0.75,1.0)+0.5;
   if (image->matte == MagickFalse)
     (void) SetImageAlphaChannel(image,OpaqueAlphaChannel);
 #if defined(MAGICKCORE_OPENMP_SUPPORT)
@@ -3937,13 +4199,17 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
     const int
       id = GetOpenMPThreadId();
 
+    EdgeCrossingInfo
+      *crossings;
+
     MagickRealType
-      fill_opacity,
-      stroke_opacity;
+      fill_opacity;
 
     PixelPacket
-      fill_color,
-      stroke_color;
+      fill_color;
+
+    PolygonInfo
+      active_info;
 
     register PixelPacket
       *restrict q;
@@ -3951,6 +4217,20 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
     register ssize_t
       x;
 
+    SegmentInfo
+      *spans;
+
+    size_t
+      number_crossings,
+      number_spans;
+
+    ssize_t
+      j,
+      k,
+      n,
+      next,
+      winding_number;
+
     if (status == MagickFalse)
       continue;
     q=GetCacheViewAuthenticPixels(image_view,start,y,(size_t) (stop-
@@ -3960,33 +4240,69 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
         status=MagickFalse;
         continue;
       }
-    for (x=start; x <= stop; x++)
+    /*
+      Evaluate the leading pixels against the whole edge list until finished
+      edges are retired, exactly as a pixel-by-pixel scan would.
+    */
+    x=start;
+    do
+    {
+      n=(ssize_t) polygon_info[id]->number_edges;
+      DrawPolygonPixel(draw_info,polygon_info[id],mid,fill,x,y,q+x-start);
+      x++;
+    } while ((x <= stop) && ((ssize_t) polygon_info[id]->number_edges != n));
+    spans=span_info+id*number_edges;
+    crossings=crossing_info+id*number_edges;
+    active_info.edges=edge_info+id*number_edges;
+    GetPolygonScanline(polygon_info[id],mid,distance,fill,(double) y,x,stop,
+      &active_info,spans,&number_spans,crossings,&number_crossings);
+    j=0;
+    k=0;
+    winding_number=0;
+    while (x <= stop)
     {
+      while ((k < (ssize_t) number_spans) && (spans[k].x2 < (double) x))
+        k++;
+      if ((k < (ssize_t) number_spans) && (spans[k].x1 <= (double) x))
+        {
+          /*
+            Near an edge: compute the coverage of each pixel.
+          */
+          next=(ssize_t) spans[k].x2;
+          for ( ; x <= next; x++)
+            DrawPolygonPixel(draw_info,&active_info,mid,fill,x,y,q+x-start);
+          continue;
+        }
       /*
-        Fill and/or stroke.
+        Away from every edge the fill is all or nothing and there is no
+        stroke: the winding number only changes where an edge crosses.
       */
-      fill_opacity=GetOpacityPixel(polygon_info[id],mid,fill,
-        draw_info->fill_rule,(double) x,(double) y,&stroke_opacity);
-      if (draw_info->stroke_antialias == MagickFalse)
+      next=k < (ssize_t) number_spans ? (ssize_t) spans[k].x1-1 : stop;
+      while ((j < (ssize_t) number_crossings) &&
+             (crossings[j].x < (double) x))
+        winding_number+=crossings[j++].direction;
+      if ((j < (ssize_t) number_crossings) &&
+          (crossings[j].x < (double) next))
+        next=(ssize_t) floor(crossings[j].x);
+      if ((fill != MagickFalse) && (draw_info->fill_rule != NonZeroRule ?
+           (MagickAbsoluteValue(winding_number) & 0x01) != 0 :
+           winding_number != 0))
+        for ( ; x <= next; x++)
         {
-          fill_opacity=fill_opacity > 0.25 ? 1.0 : 0.0;
-          stroke_opacity=stroke_opacity > 0.25 ? 1.0 : 0.0;
+          (void) GetFillColor(draw_info,x,y,&fill_color);
+          fill_opacity=(MagickRealType) (QuantumRange-(QuantumRange-
+            fill_color.opacity));
+          MagickCompositeOver(&fill_color,fill_opacity,q+x-start,
+            (MagickRealType) q[x-start].opacity,q+x-start);
         }
-      (void) GetFillColor(draw_info,x,y,&fill_color);
-      fill_opacity=(MagickRealType) (QuantumRange-fill_opacity*(QuantumRange-
-        fill_color.opacity));
-      MagickCompositeOver(&fill_color,fill_opacity,q,(MagickRealType)
-        q->opacity,q);
-      (void) GetStrokeColor(draw_info,x,y,&stroke_color);
-      stroke_opacity=(MagickRealType) (QuantumRange-stroke_opacity*
-        (QuantumRange-stroke_color.opacity));
-      MagickCompositeOver(&stroke_color,stroke_opacity,q,(MagickRealType)
-        q->opacity,q);
-      q++;
+      x=next+1;
     }
     if (SyncCacheViewAuthenticPixels(image_view,exception) == MagickFalse)
       status=MagickFalse;
   }
+  edge_info=(EdgeInfo *) RelinquishMagickMemory(edge_info);
+  crossing_info=(EdgeCrossingInfo *) RelinquishMagickMemory(crossing_info);
+  span_info=(SegmentInfo *) RelinquishMagickMemory(span_info);
   image_view=DestroyCacheView(image_view);
   polygon_info=DestroyPolygonThreadSet(polygon_info);
   if (image->debug != MagickFalse)
@@ -99,6 +99,178 @@
 #define LogicalAndOperator 0xfb
 #define LogicalOrOperator 0xfc
 #define ExponentialNotation 0xfd
+#define MaxFxSymbolCache  8
+
+/*
+  Typedef declarations.
+*/
+typedef enum
+{
+  UndefinedFxOpcode,
+  ConstantFxOpcode,
+  InterpretFxOpcode,
+  SymbolFxOpcode,
+  RandomFxOpcode,
+  ComplementFxOpcode,
+  NotFxOpcode,
+  PowerFxOpcode,
+  MultiplyFxOpcode,
+  DivideFxOpcode,
+  ModulusFxOpcode,
+  AddFxOpcode,
+  SubtractFxOpcode,
+  LeftShiftFxOpcode,
+  RightShiftFxOpcode,
+  LessThanFxOpcode,
+  LessThanEqualFxOpcode,
+  GreaterThanFxOpcode,
+  GreaterThanEqualFxOpcode,
+  EqualFxOpcode,
+  NotEqualFxOpcode,
+  BitwiseAndFxOpcode,
+  BitwiseOrFxOpcode,
+  LogicalAndFxOpcode,
+  LogicalOrFxOpcode,
+  TernaryFxOpcode,
+  CommaFxOpcode,
+  SeparatorFxOpcode,
+  ProductFxOpcode,
+  PlusFxOpcode,
+  NegateFxOpcode,
+  BitwiseNotFxOpcode,
+  AbsFxOpcode,
+  AcoshFxOpcode,
+  AcosFxOpcode,
+  AiryFxOpcode,
+  AsinhFxOpcode,
+  AsinFxOpcode,
+  AltFxOpcode,
+  Atan2FxOpcode,
+  AtanhFxOpcode,
+  AtanFxOpcode,
+  CeilFxOpcode,
+  CoshFxOpcode,
+  CosFxOpcode,
+  DrcFxOpcode,
+  ExpFxOpcode,
+  FloorFxOpcode,
+  GaussFxOpcode,
+  GcdFxOpcode,
+  HypotFxOpcode,
+  IntFxOpcode,
+  IsnanFxOpcode,
+  J0FxOpcode,
+  J1FxOpcode,
+  JincFxOpcode,
+  LnFxOpcode,
+  LogtwoFxOpcode,
+  LogFxOpcode,
+  MaxFxOpcode,
+  MinFxOpcode,
+  ModFxOpcode,
+  LogicalNotFxOpcode,
+  PowFxOpcode,
+  RoundFxOpcode,
+  SignFxOpcode,
+  SincFxOpcode,
+  SinhFxOpcode,
+  SinFxOpcode,
+  SqrtFxOpcode,
+  SquishFxOpcode,
+  TanhFxOpcode,
+  TanFxOpcode,
+  TruncFxOpcode
+} FxOpcode;
+
+typedef enum
+{
+  UndefinedFxSymbol,
+  ConstantFxSymbol,
+  ColumnFxSymbol,
+  RowFxSymbol,
+  ChannelFxSymbol,
+  RedFxSymbol,
+  GreenFxSymbol,
+  BlueFxSymbol,
+  AlphaFxSymbol,
+  OpacityFxSymbol,
+  BlackFxSymbol,
+  IntensityFxSymbol,
+  LuminanceFxSymbol,
+  HueFxSymbol,
+  SaturationFxSymbol,
+  LightnessFxSymbol
+} FxSymbolType;
+
+typedef enum
+{
+  UndefinedFxPoint,
+  AbsoluteFxPoint,
+  RelativeFxPoint
+} FxPointType;
+
+typedef struct _FxNode
+{
+  FxOpcode
+    opcode;
+
+  char
+    *expression,
+    *symbol;
+
+  ssize_t
+    left,
+    right,
+    other;
+
+  MagickRealType
+    value,
+    beta;
+
+  FxSymbolType
+    type;
+
+  const Image
+    *image;
+
+  ssize_t
+    image_index,
+    index,
+    point;
+
+  FxPointType
+    point_type;
+
+  size_t
+    length;
+
+  MagickBooleanType
+    use_color;
+
+  MagickPixelPacket
+    color;
+
+  size_t
+    cached;
+
+  ChannelType
+    channels[MaxFxSymbolCache];
+
+  MagickRealType
+    values[MaxFxSymbolCache];
+} FxNode;
+
+typedef struct _FxFunctionInfo
+{
+  const char
+    *name;
+
+  const FxOpcode
+    opcode;
+
+  const MagickRealType
+    value;
+} FxFunctionInfo;
 
 struct _FxInfo
 {
@@ -123,7 +295,41 @@ struct _FxInfo
 
   ExceptionInfo
     *exception;
+
+  FxNode
+    *nodes;
+
+  size_t
+    number_nodes,
+    extent;
+
+  ssize_t
+    program;
+
+  MagickBooleanType
+    vectorize;
+
+  size_t
+    height,
+    row_extent;
+
+  MagickRealType
+    *row_alpha,
+    *row_beta;
+
+  ssize_t
+    *row_columns,
+    *row_positions;
 };
+
+/*
+  Forward declarations.
+*/
+static ssize_t
+  FxCompileSubexpression(FxInfo *,const char *,ExceptionInfo *);
+
+static size_t
+  FxInspectNode(const FxInfo *,const ssize_t,MagickBooleanType *);
 
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -157,6 +363,9 @@ MagickExport FxInfo *AcquireFxInfo(const Image *image,const char *expression)
   const Image
     *next;
 
+  ExceptionInfo
+    *exception;
+
   FxInfo
     *fx_info;
 
@@ -214,6 +423,35 @@ MagickExport FxInfo *AcquireFxInfo(const Image *image,const char *expression)
   (void) SubstituteString(&fx_info->expression,"||",fx_op);
   *fx_op=(char) ExponentialNotation;
   (void) SubstituteString(&fx_info->expression,"**",fx_op);
+  /*
+    Compile the expression once so that each pixel walks a tree of typed nodes
+    rather than re-parsing the expression string.  Assignments update the
+    symbol table as a side effect and are left to the interpreter, as are
+    random virtual pixels whose values depend on the order of evaluation.
+  */
+  fx_info->program=(-1);
+  for (next=GetFirstImageInList(fx_info->images); next != (Image *) NULL;
+       next=GetNextImageInList(next))
+    if (GetImageVirtualPixelMethod(next) == RandomVirtualPixelMethod)
+      break;
+  if ((next == (Image *) NULL) &&
+      (strchr(fx_info->expression,'=') == (char *) NULL) &&
+      (strlen(fx_info->expression) < MaxTextExtent))
+    {
+      exception=AcquireExceptionInfo();
+      fx_info->program=FxCompileSubexpression(fx_info,fx_info->expression,
+        exception);
+      exception=DestroyExceptionInfo(exception);
+    }
+  /*
+    A program free of side effects can be evaluated a row at a time.
+  */
+  if (fx_info->program >= 0)
+    {
+      fx_info->vectorize=MagickTrue;
+      fx_info->height=FxInspectNode(fx_info,fx_info->program,
+        &fx_info->vectorize);
+    }
   return(fx_info);
 }
 
@@ -1046,6 +1284,26 @@ MagickExport FxInfo *DestroyFxInfo(FxInfo *fx_info)
   register ssize_t
     i;
 
+  for (i=0; i < (ssize_t) fx_info->number_nodes; i++)
+  {
+    fx_info->nodes[i].expression=DestroyString(fx_info->nodes[i].expression);
+    if (fx_info->nodes[i].symbol != (char *) NULL)
+      fx_info->nodes[i].symbol=DestroyString(fx_info->nodes[i].symbol);
+  }
+  if (fx_info->nodes != (FxNode *) NULL)
+    fx_info->nodes=(FxNode *) RelinquishMagickMemory(fx_info->nodes);
+  if (fx_info->row_alpha != (MagickRealType *) NULL)
+    fx_info->row_alpha=(MagickRealType *) RelinquishMagickMemory(
+      fx_info->row_alpha);
+  if (fx_info->row_beta != (MagickRealType *) NULL)
+    fx_info->row_beta=(MagickRealType *) RelinquishMagickMemory(
+      fx_info->row_beta);
+  if (fx_info->row_columns != (ssize_t *) NULL)
+    fx_info->row_columns=(ssize_t *) RelinquishMagickMemory(
+      fx_info->row_columns);
+  if (fx_info->row_positions != (ssize_t *) NULL)
+    fx_info->row_positions=(ssize_t *) RelinquishMagickMemory(
+      fx_info->row_positions);
   fx_info->exception=DestroyExceptionInfo(fx_info->exception);
   fx_info->expression=DestroyString(fx_info->expression);
   fx_info->symbols=DestroySplayTree(fx_info->symbols);
@@ -2062,6 +2320,8 @@ static const char *FxOperatorPrecedence(const char *expression,
         }
     if (strchr("(",(int) *expression) != (char *) NULL)
       expression=FxSubexpression(expression,exception);
+    if (*expression == '\0')
+      break;
     c=(int) (*expression++);
   }
   return(subexpression);
@@ -2859,43 +3119,1905 @@ static MagickRealType FxEvaluateSubexpression(FxInfo *fx_info,
   return(alpha);
 }
 
-MagickExport MagickBooleanType FxEvaluateExpression(FxInfo *fx_info,
-  MagickRealType *alpha,ExceptionInfo *exception)
+static const FxFunctionInfo
+  FxFunctions[] =
+  {
+    { "abs", AbsFxOpcode, 0.0 },
+#if defined(MAGICKCORE_HAVE_ACOSH)
+    { "acosh", AcoshFxOpcode, 0.0 },
+#endif
+    { "acos", AcosFxOpcode, 0.0 },
+#if defined(MAGICKCORE_HAVE_J1)
+    { "airy", AiryFxOpcode, 0.0 },
+#endif
+#if defined(MAGICKCORE_HAVE_ASINH)
+    { "asinh", AsinhFxOpcode, 0.0 },
+#endif
+    { "asin", AsinFxOpcode, 0.0 },
+    { "alt", AltFxOpcode, 0.0 },
+    { "atan2", Atan2FxOpcode, 0.0 },
+#if defined(MAGICKCORE_HAVE_ATANH)
+    { "atanh", AtanhFxOpcode, 0.0 },
+#endif
+    { "atan", AtanFxOpcode, 0.0 },
+    { "a", SymbolFxOpcode, 0.0 },
+    { "b", SymbolFxOpcode, 0.0 },
+    { "ceil", CeilFxOpcode, 0.0 },
+    { "cosh", CoshFxOpcode, 0.0 },
+    { "cos", CosFxOpcode, 0.0 },
+    { "c", SymbolFxOpcode, 0.0 },
+    { "debug", InterpretFxOpcode, 0.0 },
+    { "drc", DrcFxOpcode, 0.0 },
+    { "epsilon", ConstantFxOpcode, (MagickRealType) MagickEpsilon },
+    { "exp", ExpFxOpcode, 0.0 },
+    { "e", ConstantFxOpcode, (MagickRealType) 2.7182818284590452354 },
+    { "floor", FloorFxOpcode, 0.0 },
+    { "gauss", GaussFxOpcode, 0.0 },
+    { "gcd", GcdFxOpcode, 0.0 },
+    { "g", SymbolFxOpcode, 0.0 },
+    { "h", SymbolFxOpcode, 0.0 },
+    { "hue", SymbolFxOpcode, 0.0 },
+    { "hypot", HypotFxOpcode, 0.0 },
+    { "k", SymbolFxOpcode, 0.0 },
+    { "intensity", SymbolFxOpcode, 0.0 },
+    { "int", IntFxOpcode, 0.0 },
+#if defined(MAGICKCORE_HAVE_ISNAN)
+    { "isnan", IsnanFxOpcode, 0.0 },
+#endif
+    { "i", SymbolFxOpcode, 0.0 },
+    { "j", SymbolFxOpcode, 0.0 },
+#if defined(MAGICKCORE_HAVE_J0)
+    { "j0", J0FxOpcode, 0.0 },
+#endif
+#if defined(MAGICKCORE_HAVE_J1)
+    { "j1", J1FxOpcode, 0.0 },
+    { "jinc", JincFxOpcode, 0.0 },
+#endif
+    { "ln", LnFxOpcode, 0.0 },
+    { "logtwo", LogtwoFxOpcode, 0.0 },
+    { "log", LogFxOpcode, 0.0 },
+    { "lightness", SymbolFxOpcode, 0.0 },
+    { "MaxRGB", ConstantFxOpcode, (MagickRealType) QuantumRange },
+    { "maxima", UndefinedFxOpcode, 0.0 },
+    { "max", MaxFxOpcode, 0.0 },
+    { "minima", UndefinedFxOpcode, 0.0 },
+    { "min", MinFxOpcode, 0.0 },
+    { "mod", ModFxOpcode, 0.0 },
+    { "m", SymbolFxOpcode, 0.0 },
+    { "not", LogicalNotFxOpcode, 0.0 },
+    { "n", SymbolFxOpcode, 0.0 },
+    { "Opaque", ConstantFxOpcode, 1.0 },
+    { "o", SymbolFxOpcode, 0.0 },
+    { "phi", ConstantFxOpcode, (MagickRealType) MagickPHI },
+    { "pi", ConstantFxOpcode, (MagickRealType) MagickPI },
+    { "pow", PowFxOpcode, 0.0 },
+    { "p", SymbolFxOpcode, 0.0 },
+    { "QuantumRange", ConstantFxOpcode, (MagickRealType) QuantumRange },
+    { "QuantumScale", ConstantFxOpcode, (MagickRealType) QuantumScale },
+    { "rand", RandomFxOpcode, 0.0 },
+    { "round", RoundFxOpcode, 0.0 },
+    { "r", SymbolFxOpcode, 0.0 },
+    { "saturation", SymbolFxOpcode, 0.0 },
+    { "sign", SignFxOpcode, 0.0 },
+    { "sinc", SincFxOpcode, 0.0 },
+    { "sinh", SinhFxOpcode, 0.0 },
+    { "sin", SinFxOpcode, 0.0 },
+    { "sqrt", SqrtFxOpcode, 0.0 },
+    { "squish", SquishFxOpcode, 0.0 },
+    { "s", SymbolFxOpcode, 0.0 },
+    { "tanh", TanhFxOpcode, 0.0 },
+    { "tan", TanFxOpcode, 0.0 },
+    { "Transparent", ConstantFxOpcode, 0.0 },
+    { "trunc", TruncFxOpcode, 0.0 },
+    { "t", SymbolFxOpcode, 0.0 },
+    { "u", SymbolFxOpcode, 0.0 },
+    { "v", SymbolFxOpcode, 0.0 },
+    { "while", InterpretFxOpcode, 0.0 },
+    { "w", SymbolFxOpcode, 0.0 },
+    { "y", SymbolFxOpcode, 0.0 },
+    { "z", SymbolFxOpcode, 0.0 }
+  };
+
+static ssize_t FxAcquireNode(FxInfo *fx_info,const FxOpcode opcode,
+  const char *expression)
 {
-  MagickBooleanType
-    status;
+  register FxNode
+    *node;
 
-  status=FxEvaluateChannelExpression(fx_info,GrayChannel,0,0,alpha,exception);
-  return(status);
+  if (fx_info->number_nodes >= fx_info->extent)
+    {
+      fx_info->extent+=32;
+      fx_info->nodes=(FxNode *) ResizeQuantumMemory(fx_info->nodes,
+        fx_info->extent,sizeof(*fx_info->nodes));
+      if (fx_info->nodes == (FxNode *) NULL)
+        ThrowFatalException(ResourceLimitFatalError,"MemoryAllocationFailed");
+    }
+  node=fx_info->nodes+fx_info->number_nodes;
+  (void) ResetMagickMemory(node,0,sizeof(*node));
+  node->opcode=opcode;
+  node->expression=ConstantString(expression);
+  node->left=(-1);
+  node->right=(-1);
+  node->other=(-1);
+  node->index=(-1);
+  node->point=(-1);
+  return((ssize_t) fx_info->number_nodes++);
 }
 
-MagickExport MagickBooleanType FxPreprocessExpression(FxInfo *fx_info,
-  MagickRealType *alpha,ExceptionInfo *exception)
+static FxSymbolType FxClassifySymbol(const char *symbol)
 {
-  FILE
-    *file;
-
-  MagickBooleanType
-    status;
-
-  file=fx_info->file;
-  fx_info->file=(FILE *) NULL;
-  status=FxEvaluateChannelExpression(fx_info,GrayChannel,0,0,alpha,exception);
-  fx_info->file=file;
-  return(status);
+  if (*symbol == '\0')
+    return(ChannelFxSymbol);
+  switch (*symbol)
+  {
+    case 'A':
+    case 'a':
+    {
+      if (LocaleCompare(symbol,"a") == 0)
+        return(AlphaFxSymbol);
+      break;
+    }
+    case 'B':
+    case 'b':
+    {
+      if (LocaleCompare(symbol,"b") == 0)
+        return(BlueFxSymbol);
+      break;
+    }
+    case 'C':
+    case 'c':
+    {
+      if (LocaleNCompare(symbol,"channel",7) == 0)
+        return(ConstantFxSymbol);
+      if (LocaleCompare(symbol,"c") == 0)
+        return(RedFxSymbol);
+      break;
+    }
+    case 'D':
+    case 'd':
+    {
+      if (LocaleNCompare(symbol,"depth",5) == 0)
+        return(ConstantFxSymbol);
+      break;
+    }
+    case 'G':
+    case 'g':
+    {
+      if (LocaleCompare(symbol,"g") == 0)
+        return(GreenFxSymbol);
+      break;
+    }
+    case 'K':
+    case 'k':
+    {
+      if (LocaleNCompare(symbol,"kurtosis",8) == 0)
+        return(ConstantFxSymbol);
+      if (LocaleCompare(symbol,"k") == 0)
+        return(BlackFxSymbol);
+      break;
+    }
+    case 'H':
+    case 'h':
+    {
+      if (LocaleCompare(symbol,"h") == 0)
+        return(ConstantFxSymbol);
+      if (LocaleCompare(symbol,"hue") == 0)
+        return(HueFxSymbol);
+      break;
+    }
+    case 'I':
+    case 'i':
+    {
+      if ((LocaleCompare(symbol,"image.depth") == 0) ||
+          (LocaleCompare(symbol,"image.minima") == 0) ||
+          (LocaleCompare(symbol,"image.maxima") == 0) ||
+          (LocaleCompare(symbol,"image.mean") == 0) ||
+          (LocaleCompare(symbol,"image.kurtosis") == 0) ||
+          (LocaleCompare(symbol,"image.skewness") == 0) ||
+          (LocaleCompare(symbol,"image.standard_deviation") == 0) ||
+          (LocaleCompare(symbol,"image.resolution.x") == 0) ||
+          (LocaleCompare(symbol,"image.resolution.y") == 0))
+        return(ConstantFxSymbol);
+      if (LocaleCompare(symbol,"intensity") == 0)
+        return(IntensityFxSymbol);
+      if (LocaleCompare(symbol,"i") == 0)
+        return(ColumnFxSymbol);
+      break;
+    }
+    case 'J':
+    case 'j':
+    {
+      if (LocaleCompare(symbol,"j") == 0)
+        return(RowFxSymbol);
+      break;
+    }
+    case 'L':
+    case 'l':
+    {
+      if (LocaleCompare(symbol,"lightness") == 0)
+        return(LightnessFxSymbol);
+      if (LocaleCompare(symbol,"luminance") == 0)
+        return(LuminanceFxSymbol);
+      break;
+    }
+    case 'M':
+    case 'm':
+    {
+      if ((LocaleNCompare(symbol,"maxima",6) == 0) ||
+          (LocaleNCompare(symbol,"mean",4) == 0) ||
+          (LocaleNCompare(symbol,"minima",6) == 0))
+        return(ConstantFxSymbol);
+      if (LocaleCompare(symbol,"m") == 0)
+        return(BlueFxSymbol);
+      break;
+    }
+    case 'N':
+    case 'n':
+    {
+      if (LocaleCompare(symbol,"n") == 0)
+        return(ConstantFxSymbol);
+      break;
+    }
+    case 'O':
+    case 'o':
+    {
+      if (LocaleCompare(symbol,"o") == 0)
+        return(OpacityFxSymbol);
+      break;
+    }
+    case 'P':
+    case 'p':
+    {
+      if ((LocaleCompare(symbol,"page.height") == 0) ||
+          (LocaleCompare(symbol,"page.width") == 0) ||
+          (LocaleCompare(symbol,"page.x") == 0) ||
+          (LocaleCompare(symbol,"page.y") == 0))
+        return(ConstantFxSymbol);
+      break;
+    }
+    case 'R':
+    case 'r':
+    {
+      if ((LocaleCompare(symbol,"resolution.x") == 0) ||
+          (LocaleCompare(symbol,"resolution.y") == 0))
+        return(ConstantFxSymbol);
+      if (LocaleCompare(symbol,"r") == 0)
+        return(RedFxSymbol);
+      break;
+    }
+    case 'S':
+    case 's':
+    {
+      if (LocaleCompare(symbol,"saturation") == 0)
+        return(SaturationFxSymbol);
+      if ((LocaleNCompare(symbol,"skewness",8) == 0) ||
+          (LocaleNCompare(symbol,"standard_deviation",18) == 0))
+        return(ConstantFxSymbol);
+      break;
+    }
+    case 'T':
+    case 't':
+    {
+      if (LocaleCompare(symbol,"t") == 0)
+        return(ConstantFxSymbol);
+      break;
+    }
+    case 'W':
+    case 'w':
+    {
+      if (LocaleCompare(symbol,"w") == 0)
+        return(ConstantFxSymbol);
+      break;
+    }
+    case 'Y':
+    case 'y':
+    {
+      if (LocaleCompare(symbol,"y") == 0)
+        return(GreenFxSymbol);
+      break;
+    }
+    case 'Z':
+    case 'z':
+    {
+      if (LocaleCompare(symbol,"z") == 0)
+        return(ConstantFxSymbol);
+      break;
+    }
+    default:
+      break;
+  }
+  return(UndefinedFxSymbol);
 }
 
-MagickExport MagickBooleanType FxEvaluateChannelExpression(FxInfo *fx_info,
-  const ChannelType channel,const ssize_t x,const ssize_t y,
-  MagickRealType *alpha,ExceptionInfo *exception)
+static const char *FxCompileSubscript(FxInfo *fx_info,const char *p,
+  const int open,const int close,ssize_t *node,ExceptionInfo *exception)
 {
-  MagickRealType
-    beta;
+  char
+    *q,
+    subexpression[MaxTextExtent];
 
-  beta=0.0;
-  *alpha=FxEvaluateSubexpression(fx_info,channel,x,y,fx_info->expression,&beta,
-    exception);
-  return(exception->severity == OptionError ? MagickFalse : MagickTrue);
+  size_t
+    level;
+
+  /*
+    Compile the subscript of a u[], p[], or p{} reference.
+  */
+  level=1;
+  q=subexpression;
+  for (p++; *p != '\0'; )
+  {
+    if (*p == open)
+      level++;
+    else
+      if (*p == close)
+        {
+          level--;
+          if (level == 0)
+            break;
+        }
+    *q++=(*p++);
+  }
+  *q='\0';
+  if (*p == '\0')
+    return((const char *) NULL);
+  *node=FxCompileSubexpression(fx_info,subexpression,exception);
+  return(p+1);
+}
+
+static ssize_t FxCompileSymbol(FxInfo *fx_info,const char *expression,
+  ExceptionInfo *exception)
+{
+  char
+    *q,
+    symbol[MaxTextExtent];
+
+  const char
+    *p;
+
+  FxPointType
+    point_type;
+
+  FxSymbolType
+    type;
+
+  MagickBooleanType
+    use_color;
+
+  MagickPixelPacket
+    color;
+
+  ssize_t
+    i,
+    index,
+    n,
+    point;
+
+  /*
+    Resolve the image, offset, and channel of a symbol the same way
+    FxGetSymbol() does, once, instead of for every pixel.
+  */
+  n=FxAcquireNode(fx_info,SymbolFxOpcode,expression);
+  p=expression;
+  i=GetImageIndexInList(fx_info->images);
+  index=(-1);
+  point=(-1);
+  point_type=UndefinedFxPoint;
+  use_color=MagickFalse;
+  (void) ResetMagickMemory(&color,0,sizeof(color));
+  type=UndefinedFxSymbol;
+  if (isalpha((int) *(p+1)) == 0)
+    {
+      if (strchr("suv",(int) *p) != (char *) NULL)
+        {
+          switch (*p)
+          {
+            case 's':
+            default:
+            {
+              i=GetImageIndexInList(fx_info->images);
+              break;
+            }
+            case 'u': i=0; break;
+            case 'v': i=1; break;
+          }
+          p++;
+          if ((p != (const char *) NULL) && (*p == '['))
+            p=FxCompileSubscript(fx_info,p,'[',']',&index,exception);
+          if ((p != (const char *) NULL) && (*p == '.'))
+            p++;
+        }
+      if ((p != (const char *) NULL) && (isalpha((int) *(p+1)) == 0) &&
+          (*p == 'p'))
+        {
+          p++;
+          if (*p == '{')
+            {
+              point_type=AbsoluteFxPoint;
+              p=FxCompileSubscript(fx_info,p,'{','}',&point,exception);
+            }
+          else
+            if (*p == '[')
+              {
+                point_type=RelativeFxPoint;
+                p=FxCompileSubscript(fx_info,p,'[',']',&point,exception);
+              }
+          if ((p != (const char *) NULL) && (*p == '.'))
+            p++;
+        }
+    }
+  if ((p != (const char *) NULL) && (strlen(p) > 2) &&
+      (LocaleCompare(p,"intensity") != 0) &&
+      (LocaleCompare(p,"luminance") != 0) &&
+      (LocaleCompare(p,"hue") != 0) &&
+      (LocaleCompare(p,"saturation") != 0) &&
+      (LocaleCompare(p,"lightness") != 0))
+    {
+      char
+        name[MaxTextExtent];
+
+      (void) CopyMagickString(name,p,MaxTextExtent);
+      for (q=name+(strlen(name)-1); q > name; q--)
+      {
+        if (*q == ')')
+          break;
+        if (*q == '.')
+          {
+            *q='\0';
+            break;
+          }
+      }
+      if ((strlen(name) > 2) &&
+          (GetValueFromSplayTree(fx_info->symbols,name) == (const char *) NULL))
+        {
+          const MagickPixelPacket
+            *value;
+
+          value=(const MagickPixelPacket *) GetValueFromSplayTree(
+            fx_info->colors,name);
+          if (value != (const MagickPixelPacket *) NULL)
+            {
+              color=(*value);
+              use_color=MagickTrue;
+            }
+          else
+            if (QueryMagickColor(name,&color,fx_info->exception) != MagickFalse)
+              {
+                (void) AddValueToSplayTree(fx_info->colors,ConstantString(name),
+                  CloneMagickPixelPacket(&color));
+                use_color=MagickTrue;
+              }
+          if (use_color != MagickFalse)
+            p+=strlen(name);
+        }
+    }
+  if (p != (const char *) NULL)
+    {
+      (void) CopyMagickString(symbol,p,MaxTextExtent);
+      StripString(symbol);
+      type=FxClassifySymbol(symbol);
+      fx_info->nodes[n].symbol=ConstantString(p);
+    }
+  if (((type == ConstantFxSymbol) || (type == ColumnFxSymbol) ||
+       (type == RowFxSymbol)) && ((index >= 0) || (point >= 0)))
+    type=UndefinedFxSymbol;  /* subscripts may have side effects */
+  fx_info->nodes[n].type=type;
+  fx_info->nodes[n].length=GetImageListLength(fx_info->images);
+  while (i < 0)
+    i+=(ssize_t) fx_info->nodes[n].length;
+  i%=fx_info->nodes[n].length;
+  fx_info->nodes[n].image_index=i;
+  fx_info->nodes[n].image=GetImageFromList(fx_info->images,i);
+  fx_info->nodes[n].index=index;
+  fx_info->nodes[n].point=point;
+  fx_info->nodes[n].point_type=point_type;
+  fx_info->nodes[n].use_color=use_color;
+  fx_info->nodes[n].color=color;
+  if (fx_info->nodes[n].image == (const Image *) NULL)
+    fx_info->nodes[n].type=UndefinedFxSymbol;
+  return(n);
+}
+
+static MagickRealType
+  FxExecuteNode(FxInfo *,const ssize_t,const ChannelType,const ssize_t,
+    const ssize_t,MagickRealType *,ExceptionInfo *);
+
+static ssize_t FxFoldNode(FxInfo *fx_info,const ssize_t n)
+{
+  ExceptionInfo
+    *exception;
+
+  MagickRealType
+    alpha,
+    beta;
+
+  register FxNode
+    *node;
+
+  /*
+    Fold operators whose operands are all constant.
+  */
+  node=fx_info->nodes+n;
+  if ((node->left < 0) ||
+      (fx_info->nodes[node->left].opcode != ConstantFxOpcode))
+    return(n);
+  if ((node->opcode == TernaryFxOpcode) &&
+      (node->right >= 0) && (node->other >= 0))
+    {
+      if (fabs((double) fx_info->nodes[node->left].value) > MagickEpsilon)
+        return(node->right);
+      return(node->other);
+    }
+  if ((node->right >= 0) &&
+      (fx_info->nodes[node->right].opcode != ConstantFxOpcode))
+    return(n);
+  exception=AcquireExceptionInfo();
+  alpha=FxExecuteNode(fx_info,n,UndefinedChannel,0,0,&beta,exception);
+  if (exception->severity == UndefinedException)
+    {
+      node->opcode=ConstantFxOpcode;
+      node->value=alpha;
+      node->beta=beta;
+    }
+  exception=DestroyExceptionInfo(exception);
+  return(n);
+}
+
+static ssize_t FxCompileSubexpression(FxInfo *fx_info,const char *expression,
+  ExceptionInfo *exception)
+{
+  char
+    *q,
+    subexpression[MaxTextExtent];
+
+  const char
+    *p;
+
+  FxOpcode
+    opcode;
+
+  MagickRealType
+    alpha;
+
+  register ssize_t
+    i;
+
+  ssize_t
+    left,
+    n,
+    other,
+    right;
+
+  /*
+    Build the node tree by splitting the expression exactly where
+    FxEvaluateSubexpression() would.
+  */
+  while (isspace((int) *expression) != 0)
+    expression++;
+  if (*expression == '\0')
+    return(FxAcquireNode(fx_info,InterpretFxOpcode,expression));
+  *subexpression='\0';
+  p=FxOperatorPrecedence(expression,exception);
+  if (exception->severity != UndefinedException)
+    {
+      ClearMagickException(exception);
+      return(FxAcquireNode(fx_info,InterpretFxOpcode,expression));
+    }
+  if (p == expression)
+    return(FxAcquireNode(fx_info,InterpretFxOpcode,expression));
+  if (p != (const char *) NULL)
+    {
+      (void) CopyMagickString(subexpression,expression,(size_t)
+        (p-expression+1));
+      left=FxCompileSubexpression(fx_info,subexpression,exception);
+      right=(-1);
+      other=(-1);
+      switch ((unsigned char) *p)
+      {
+        case '~': opcode=ComplementFxOpcode; break;
+        case '!': opcode=NotFxOpcode; break;
+        case '^': opcode=PowerFxOpcode; break;
+        case '*':
+        case ExponentialNotation: opcode=MultiplyFxOpcode; break;
+        case '/': opcode=DivideFxOpcode; break;
+        case '%': opcode=ModulusFxOpcode; break;
+        case '+': opcode=AddFxOpcode; break;
+        case '-': opcode=SubtractFxOpcode; break;
+        case LeftShiftOperator: opcode=LeftShiftFxOpcode; break;
+        case RightShiftOperator: opcode=RightShiftFxOpcode; break;
+        case '<': opcode=LessThanFxOpcode; break;
+        case LessThanEqualOperator: opcode=LessThanEqualFxOpcode; break;
+        case '>': opcode=GreaterThanFxOpcode; break;
+        case GreaterThanEqualOperator: opcode=GreaterThanEqualFxOpcode; break;
+        case EqualOperator: opcode=EqualFxOpcode; break;
+        case NotEqualOperator: opcode=NotEqualFxOpcode; break;
+        case '&': opcode=BitwiseAndFxOpcode; break;
+        case '|': opcode=BitwiseOrFxOpcode; break;
+        case LogicalAndOperator: opcode=LogicalAndFxOpcode; break;
+        case LogicalOrOperator: opcode=LogicalOrFxOpcode; break;
+        case '?':
+        {
+          (void) CopyMagickString(subexpression,++p,MaxTextExtent);
+          q=subexpression;
+          p=StringToken(":",&q);
+          if (q == (char *) NULL)
+            return(FxAcquireNode(fx_info,InterpretFxOpcode,expression));
+          opcode=TernaryFxOpcode;
+          right=FxCompileSubexpression(fx_info,p,exception);
+          other=FxCompileSubexpression(fx_info,q,exception);
+          break;
+        }
+        case '=':
+          return(FxAcquireNode(fx_info,InterpretFxOpcode,expression));
+        case ',': opcode=CommaFxOpcode; break;
+        case ';': opcode=SeparatorFxOpcode; break;
+        default:
+        {
+          opcode=ProductFxOpcode;
+          right=FxCompileSubexpression(fx_info,p,exception);
+          break;
+        }
+      }
+      if (right < 0)
+        right=FxCompileSubexpression(fx_info,++p,exception);
+      n=FxAcquireNode(fx_info,opcode,expression);
+      fx_info->nodes[n].left=left;
+      fx_info->nodes[n].right=right;
+      fx_info->nodes[n].other=other;
+      return(FxFoldNode(fx_info,n));
+    }
+  if (strchr("(",(int) *expression) != (char *) NULL)
+    {
+      (void) CopyMagickString(subexpression,expression+1,MaxTextExtent);
+      subexpression[strlen(subexpression)-1]='\0';
+      return(FxCompileSubexpression(fx_info,subexpression,exception));
+    }
+  opcode=UndefinedFxOpcode;
+  switch (*expression)
+  {
+    case '+': opcode=PlusFxOpcode; break;
+    case '-': opcode=NegateFxOpcode; break;
+    case '~': opcode=BitwiseNotFxOpcode; break;
+    default: break;
+  }
+  if (opcode != UndefinedFxOpcode)
+    {
+      left=FxCompileSubexpression(fx_info,expression+1,exception);
+      n=FxAcquireNode(fx_info,opcode,expression);
+      fx_info->nodes[n].left=left;
+      return(FxFoldNode(fx_info,n));
+    }
+  for (i=0; i < (ssize_t) (sizeof(FxFunctions)/sizeof(*FxFunctions)); i++)
+  {
+    opcode=FxFunctions[i].opcode;
+    if ((opcode == ConstantFxOpcode) || (opcode == SymbolFxOpcode))
+      {
+        if (LocaleCompare(expression,FxFunctions[i].name) != 0)
+          continue;
+        if (opcode == SymbolFxOpcode)
+          return(FxCompileSymbol(fx_info,expression,exception));
+        n=FxAcquireNode(fx_info,ConstantFxOpcode,expression);
+        fx_info->nodes[n].value=FxFunctions[i].value;
+        return(n);
+      }
+    if (LocaleNCompare(expression,FxFunctions[i].name,
+          strlen(FxFunctions[i].name)) != 0)
+      continue;
+    if (opcode == UndefinedFxOpcode)
+      break;
+    if ((opcode == InterpretFxOpcode) || (opcode == RandomFxOpcode))
+      return(FxAcquireNode(fx_info,opcode,expression));
+    left=FxCompileSubexpression(fx_info,expression+
+      strlen(FxFunctions[i].name),exception);
+    n=FxAcquireNode(fx_info,opcode,expression);
+    fx_info->nodes[n].left=left;
+    return(FxFoldNode(fx_info,n));
+  }
+  q=(char *) expression;
+  alpha=InterpretSiPrefixValue(expression,&q);
+  if (q == expression)
+    return(FxCompileSymbol(fx_info,expression,exception));
+  n=FxAcquireNode(fx_info,ConstantFxOpcode,expression);
+  fx_info->nodes[n].value=alpha;
+  return(n);
+}
+
+static inline MagickRealType FxApplyFunction(const FxOpcode opcode,
+  const MagickRealType alpha,const MagickRealType beta)
+{
+  MagickRealType
+    gamma;
+
+  switch (opcode)
+  {
+    case PlusFxOpcode: return(1.0*alpha);
+    case NegateFxOpcode: return(-1.0*alpha);
+    case BitwiseNotFxOpcode:
+      return((MagickRealType) (~(size_t) (alpha+0.5)));
+    case AbsFxOpcode: return((MagickRealType) fabs((double) alpha));
+#if defined(MAGICKCORE_HAVE_ACOSH)
+    case AcoshFxOpcode: return((MagickRealType) acosh((double) alpha));
+#endif
+    case AcosFxOpcode: return((MagickRealType) acos((double) alpha));
+#if defined(MAGICKCORE_HAVE_J1)
+    case AiryFxOpcode:
+    {
+      if (alpha == 0.0)
+        return(1.0);
+      gamma=2.0*j1((double) (MagickPI*alpha))/(MagickPI*alpha);
+      return(gamma*gamma);
+    }
+#endif
+#if defined(MAGICKCORE_HAVE_ASINH)
+    case AsinhFxOpcode: return((MagickRealType) asinh((double) alpha));
+#endif
+    case AsinFxOpcode: return((MagickRealType) asin((double) alpha));
+    case AltFxOpcode: return(((ssize_t) alpha) & 0x01 ? -1.0 : 1.0);
+    case Atan2FxOpcode:
+      return((MagickRealType) atan2((double) alpha,(double) beta));
+#if defined(MAGICKCORE_HAVE_ATANH)
+    case AtanhFxOpcode: return((MagickRealType) atanh((double) alpha));
+#endif
+    case AtanFxOpcode: return((MagickRealType) atan((double) alpha));
+    case CeilFxOpcode: return((MagickRealType) ceil((double) alpha));
+    case CoshFxOpcode: return((MagickRealType) cosh((double) alpha));
+    case CosFxOpcode: return((MagickRealType) cos((double) alpha));
+    case DrcFxOpcode:
+      return((MagickRealType) (alpha/(beta*(alpha-1.0)+1.0)));
+    case ExpFxOpcode: return((MagickRealType) exp((double) alpha));
+    case FloorFxOpcode: return((MagickRealType) floor((double) alpha));
+    case GaussFxOpcode:
+    {
+      gamma=exp((double) (-alpha*alpha/2.0))/sqrt(2.0*MagickPI);
+      return((MagickRealType) gamma);
+    }
+    case GcdFxOpcode:
+    {
+      MagickOffsetType
+        gcd;
+
+      gcd=FxGCD((MagickOffsetType) (alpha+0.5),(MagickOffsetType)
+        (beta+0.5));
+      return((MagickRealType) gcd);
+    }
+    case HypotFxOpcode:
+      return((MagickRealType) hypot((double) alpha,(double) beta));
+    case IntFxOpcode: return((MagickRealType) floor(alpha));
+#if defined(MAGICKCORE_HAVE_ISNAN)
+    case IsnanFxOpcode: return((MagickRealType) !!isnan((double) alpha));
+#endif
+#if defined(MAGICKCORE_HAVE_J0)
+    case J0FxOpcode: return((MagickRealType) j0((double) alpha));
+#endif
+#if defined(MAGICKCORE_HAVE_J1)
+    case J1FxOpcode: return((MagickRealType) j1((double) alpha));
+    case JincFxOpcode:
+    {
+      if (alpha == 0.0)
+        return(1.0);
+      gamma=(MagickRealType) (2.0*j1((double) (MagickPI*alpha))/
+        (MagickPI*alpha));
+      return(gamma);
+    }
+#endif
+    case LnFxOpcode: return((MagickRealType) log((double) alpha));
+    case LogtwoFxOpcode:
+      return((MagickRealType) log10((double) alpha))/log10(2.0);
+    case LogFxOpcode: return((MagickRealType) log10((double) alpha));
+    case MaxFxOpcode: return(alpha > beta ? alpha : beta);
+    case MinFxOpcode: return(alpha < beta ? alpha : beta);
+    case ModFxOpcode:
+    {
+      gamma=alpha-floor((double) (alpha/beta))*beta;
+      return(gamma);
+    }
+    case LogicalNotFxOpcode: return((MagickRealType) (alpha < MagickEpsilon));
+    case PowFxOpcode:
+      return((MagickRealType) pow((double) alpha,(double) beta));
+    case RoundFxOpcode: return((MagickRealType) floor((double) alpha+0.5));
+    case SignFxOpcode: return(alpha < 0.0 ? -1.0 : 1.0);
+    case SincFxOpcode:
+    {
+      if (alpha == 0)
+        return(1.0);
+      gamma=(MagickRealType) (sin((double) (MagickPI*alpha))/
+        (MagickPI*alpha));
+      return(gamma);
+    }
+    case SinhFxOpcode: return((MagickRealType) sinh((double) alpha));
+    case SinFxOpcode: return((MagickRealType) sin((double) alpha));
+    case SqrtFxOpcode: return((MagickRealType) sqrt((double) alpha));
+    case SquishFxOpcode:
+      return((MagickRealType) (1.0/(1.0+exp((double) (4.0*alpha)))));
+    case TanhFxOpcode: return((MagickRealType) tanh((double) alpha));
+    case TanFxOpcode: return((MagickRealType) tan((double) alpha));
+    case TruncFxOpcode:
+    {
+      if (alpha >= 0.0)
+        return((MagickRealType) floor((double) alpha));
+      return((MagickRealType) ceil((double) alpha));
+    }
+    default:
+      break;
+  }
+  return(0.0);
+}
+
+static MagickRealType FxSelectSymbol(const FxNode *node,const Image *image,
+  const MagickPixelPacket *pixel,const ChannelType channel,
+  ExceptionInfo *exception)
+{
+  MagickRealType
+    alpha;
+
+  switch (node->type)
+  {
+    case ChannelFxSymbol:
+    {
+      switch (channel)
+      {
+        case RedChannel: return(QuantumScale*pixel->red);
+        case GreenChannel: return(QuantumScale*pixel->green);
+        case BlueChannel: return(QuantumScale*pixel->blue);
+        case OpacityChannel:
+        {
+          if (pixel->matte == MagickFalse)
+            return(1.0);
+          alpha=(MagickRealType) (QuantumScale*GetPixelAlpha(pixel));
+          return(alpha);
+        }
+        case IndexChannel:
+        {
+          if (image->colorspace != CMYKColorspace)
+            {
+              (void) ThrowMagickException(exception,GetMagickModule(),
+                ImageError,"ColorSeparatedImageRequired","`%s'",
+                image->filename);
+              return(0.0);
+            }
+          return(QuantumScale*pixel->index);
+        }
+        case DefaultChannels:
+          return(QuantumScale*MagickPixelIntensityToQuantum(pixel));
+        default:
+          break;
+      }
+      (void) ThrowMagickException(exception,GetMagickModule(),OptionError,
+        "UnableToParseExpression","`%s'",node->symbol);
+      return(0.0);
+    }
+    case RedFxSymbol: return(QuantumScale*pixel->red);
+    case GreenFxSymbol: return(QuantumScale*pixel->green);
+    case BlueFxSymbol: return(QuantumScale*pixel->blue);
+    case AlphaFxSymbol:
+      return((MagickRealType) (QuantumScale*GetPixelAlpha(pixel)));
+    case OpacityFxSymbol: return(QuantumScale*pixel->opacity);
+    case BlackFxSymbol:
+    {
+      if (image->colorspace != CMYKColorspace)
+        {
+          (void) ThrowMagickException(exception,GetMagickModule(),OptionError,
+            "ColorSeparatedImageRequired","`%s'",image->filename);
+          return(0.0);
+        }
+      return(QuantumScale*pixel->index);
+    }
+    case IntensityFxSymbol:
+      return(QuantumScale*MagickPixelIntensityToQuantum(pixel));
+    case LuminanceFxSymbol:
+    {
+      double
+        luminence;
+
+      luminence=0.2126*pixel->red+0.7152*pixel->green+0.0722*pixel->blue;
+      return(QuantumScale*luminence);
+    }
+    case HueFxSymbol:
+    case SaturationFxSymbol:
+    case LightnessFxSymbol:
+    {
+      double
+        hue,
+        lightness,
+        saturation;
+
+      ConvertRGBToHSL(ClampToQuantum(pixel->red),ClampToQuantum(pixel->green),
+        ClampToQuantum(pixel->blue),&hue,&saturation,&lightness);
+      if (node->type == HueFxSymbol)
+        return(hue);
+      if (node->type == SaturationFxSymbol)
+        return(saturation);
+      return(lightness);
+    }
+    default:
+      break;
+  }
+  return(0.0);
+}
+
+static MagickRealType FxExecuteSymbol(FxInfo *fx_info,FxNode *node,
+  const ChannelType channel,const ssize_t x,const ssize_t y,
+  ExceptionInfo *exception)
+{
+  const Image
+    *image;
+
+  MagickPixelPacket
+    pixel;
+
+  MagickRealType
+    alpha,
+    beta;
+
+  PointInfo
+    point;
+
+  register ssize_t
+    i;
+
+  switch (node->type)
+  {
+    case UndefinedFxSymbol:
+      return(FxGetSymbol(fx_info,channel,x,y,node->expression,exception));
+    case ConstantFxSymbol:
+    {
+      /*
+        Image attributes and statistics are resolved once per channel.
+      */
+      for (i=0; i < (ssize_t) node->cached; i++)
+        if (node->channels[i] == channel)
+          return(node->values[i]);
+      alpha=FxGetSymbol(fx_info,channel,x,y,node->expression,exception);
+      if ((exception->severity == UndefinedException) &&
+          (node->cached < MaxFxSymbolCache))
+        {
+          node->channels[node->cached]=channel;
+          node->values[node->cached]=alpha;
+          node->cached++;
+        }
+      return(alpha);
+    }
+    case ColumnFxSymbol:
+      return((MagickRealType) x);
+    case RowFxSymbol:
+      return((MagickRealType) y);
+    default:
+      break;
+  }
+  i=node->image_index;
+  image=node->image;
+  if (node->index >= 0)
+    {
+      alpha=FxExecuteNode(fx_info,node->index,channel,x,y,&beta,exception);
+      i=(ssize_t) (alpha+0.5);
+      while (i < 0)
+        i+=(ssize_t) node->length;
+      i%=node->length;
+      image=GetImageFromList(fx_info->images,i);
+    }
+  point.x=(double) x;
+  point.y=(double) y;
+  if (node->point >= 0)
+    {
+      alpha=FxExecuteNode(fx_info,node->point,channel,x,y,&beta,exception);
+      if (node->point_type == AbsoluteFxPoint)
+        {
+          point.x=alpha;
+          point.y=beta;
+        }
+      else
+        {
+          point.x+=alpha;
+          point.y+=beta;
+        }
+    }
+  GetMagickPixelPacket(image,&pixel);
+  if (node->use_color != MagickFalse)
+    pixel=node->color;
+  else
+    (void) InterpolateMagickPixelPacket(image,fx_info->view[i],
+      image->interpolate,point.x,point.y,&pixel,exception);
+  return(FxSelectSymbol(node,image,&pixel,channel,exception));
+}
+
+static MagickRealType FxExecuteNode(FxInfo *fx_info,const ssize_t n,
+  const ChannelType channel,const ssize_t x,const ssize_t y,
+  MagickRealType *beta,ExceptionInfo *exception)
+{
+  MagickRealType
+    alpha,
+    gamma;
+
+  register FxNode
+    *node;
+
+  /*
+    Each node stands for one FxEvaluateSubexpression() call and keeps its
+    conventions: beta carries the second operand of two-argument functions,
+    and once an exception is pending every subexpression returns zero.
+  */
+  *beta=0.0;
+  if (exception->severity != UndefinedException)
+    return(0.0);
+  node=fx_info->nodes+n;
+  switch (node->opcode)
+  {
+    case ConstantFxOpcode:
+    {
+      *beta=node->beta;
+      return(node->value);
+    }
+    case InterpretFxOpcode:
+      return(FxEvaluateSubexpression(fx_info,channel,x,y,node->expression,beta,
+        exception));
+    case SymbolFxOpcode:
+      return(FxExecuteSymbol(fx_info,node,channel,x,y,exception));
+    case RandomFxOpcode:
+      return((MagickRealType) GetPseudoRandomValue(fx_info->random_info));
+    default:
+      break;
+  }
+  alpha=FxExecuteNode(fx_info,node->left,channel,x,y,beta,exception);
+  switch (node->opcode)
+  {
+    case ComplementFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      *beta=(MagickRealType) (~(size_t) *beta);
+      return(*beta);
+    }
+    case NotFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      return(*beta == 0.0 ? 1.0 : 0.0);
+    }
+    case PowerFxOpcode:
+    {
+      *beta=pow((double) alpha,(double) FxExecuteNode(fx_info,node->right,
+        channel,x,y,beta,exception));
+      return(*beta);
+    }
+    case MultiplyFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      return(alpha*(*beta));
+    }
+    case DivideFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      if (*beta == 0.0)
+        {
+          if (exception->severity == UndefinedException)
+            (void) ThrowMagickException(exception,GetMagickModule(),
+              OptionError,"DivideByZero","`%s'",node->expression);
+          return(0.0);
+        }
+      return(alpha/(*beta));
+    }
+    case ModulusFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      *beta=fabs(floor(((double) *beta)+0.5));
+      if (*beta == 0.0)
+        {
+          (void) ThrowMagickException(exception,GetMagickModule(),
+            OptionError,"DivideByZero","`%s'",node->expression);
+          return(0.0);
+        }
+      return(fmod((double) alpha,(double) *beta));
+    }
+    case AddFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      return(alpha+(*beta));
+    }
+    case SubtractFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      return(alpha-(*beta));
+    }
+    case LeftShiftFxOpcode:
+    {
+      gamma=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      *beta=(MagickRealType) ((size_t) (alpha+0.5) << (size_t) (gamma+0.5));
+      return(*beta);
+    }
+    case RightShiftFxOpcode:
+    {
+      gamma=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      *beta=(MagickRealType) ((size_t) (alpha+0.5) >> (size_t) (gamma+0.5));
+      return(*beta);
+    }
+    case LessThanFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      return(alpha < *beta ? 1.0 : 0.0);
+    }
+    case LessThanEqualFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      return(alpha <= *beta ? 1.0 : 0.0);
+    }
+    case GreaterThanFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      return(alpha > *beta ? 1.0 : 0.0);
+    }
+    case GreaterThanEqualFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      return(alpha >= *beta ? 1.0 : 0.0);
+    }
+    case EqualFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      return(fabs(alpha-(*beta)) <= MagickEpsilon ? 1.0 : 0.0);
+    }
+    case NotEqualFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      return(fabs(alpha-(*beta)) > MagickEpsilon ? 1.0 : 0.0);
+    }
+    case BitwiseAndFxOpcode:
+    {
+      gamma=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      *beta=(MagickRealType) ((size_t) (alpha+0.5) & (size_t) (gamma+0.5));
+      return(*beta);
+    }
+    case BitwiseOrFxOpcode:
+    {
+      gamma=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      *beta=(MagickRealType) ((size_t) (alpha+0.5) | (size_t) (gamma+0.5));
+      return(*beta);
+    }
+    case LogicalAndFxOpcode:
+    {
+      gamma=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      *beta=(alpha > 0.0) && (gamma > 0.0) ? 1.0 : 0.0;
+      return(*beta);
+    }
+    case LogicalOrFxOpcode:
+    {
+      gamma=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      *beta=(alpha > 0.0) || (gamma > 0.0) ? 1.0 : 0.0;
+      return(*beta);
+    }
+    case TernaryFxOpcode:
+    {
+      if (fabs((double) alpha) > MagickEpsilon)
+        return(FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception));
+      return(FxExecuteNode(fx_info,node->other,channel,x,y,beta,exception));
+    }
+    case CommaFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      return(alpha);
+    }
+    case SeparatorFxOpcode:
+    {
+      *beta=FxExecuteNode(fx_info,node->right,channel,x,y,beta,exception);
+      return(*beta);
+    }
+    case ProductFxOpcode:
+    {
+      gamma=alpha*FxExecuteNode(fx_info,node->right,channel,x,y,beta,
+        exception);
+      return(gamma);
+    }
+    default:
+      break;
+  }
+  return(FxApplyFunction(node->opcode,alpha,*beta));
+}
+
+MagickExport MagickBooleanType FxEvaluateExpression(FxInfo *fx_info,
+  MagickRealType *alpha,ExceptionInfo *exception)
+{
+  MagickBooleanType
+    status;
+
+  status=FxEvaluateChannelExpression(fx_info,GrayChannel,0,0,alpha,exception);
+  return(status);
+}
+
+MagickExport MagickBooleanType FxPreprocessExpression(FxInfo *fx_info,
+  MagickRealType *alpha,ExceptionInfo *exception)
+{
+  FILE
+    *file;
+
+  MagickBooleanType
+    status;
+
+  file=fx_info->file;
+  fx_info->file=(FILE *) NULL;
+  status=FxEvaluateChannelExpression(fx_info,GrayChannel,0,0,alpha,exception);
+  fx_info->file=file;
+  return(status);
+}
+
+static size_t FxInspectNode(const FxInfo *fx_info,const ssize_t n,
+  MagickBooleanType *vectorize)
+{
+  register const FxNode
+    *node;
+
+  size_t
+    extent,
+    height;
+
+  /*
+    Return the height of a subtree and note any node that has side effects
+    and must therefore run one pixel at a time.
+  */
+  if (n < 0)
+    return(0);
+  node=fx_info->nodes+n;
+  if ((node->opcode == InterpretFxOpcode) ||
+      (node->opcode == RandomFxOpcode) ||
+      ((node->opcode == SymbolFxOpcode) && (node->type == UndefinedFxSymbol)))
+    *vectorize=MagickFalse;
+  height=FxInspectNode(fx_info,node->left,vectorize);
+  extent=FxInspectNode(fx_info,node->right,vectorize);
+  if (extent > height)
+    height=extent;
+  extent=FxInspectNode(fx_info,node->other,vectorize);
+  if (extent > height)
+    height=extent;
+  extent=FxInspectNode(fx_info,node->index,vectorize);
+  if (extent > height)
+    height=extent;
+  extent=FxInspectNode(fx_info,node->point,vectorize);
+  if (extent > height)
+    height=extent;
+  return(height+1);
+}
+
+static inline MagickBooleanType IsFxSymbolSelectable(const FxNode *node,
+  const Image *image,const ChannelType channel)
+{
+  if (node->type == BlackFxSymbol)
+    return(image->colorspace == CMYKColorspace ? MagickTrue : MagickFalse);
+  if (node->type != ChannelFxSymbol)
+    return(MagickTrue);
+  switch (channel)
+  {
+    case RedChannel:
+    case GreenChannel:
+    case BlueChannel:
+    case OpacityChannel:
+    case DefaultChannels:
+      return(MagickTrue);
+    case IndexChannel:
+      return(image->colorspace == CMYKColorspace ? MagickTrue : MagickFalse);
+    default:
+      break;
+  }
+  return(MagickFalse);
+}
+
+static inline void FxGetPixel(const Image *image,
+  const InterpolatePixelMethod method,const PixelPacket *p,
+  const IndexPacket *indexes,MagickPixelPacket *pixel)
+{
+  MagickRealType
+    alpha,
+    gamma;
+
+  /*
+    Same result as InterpolateMagickPixelPacket() at an integral coordinate.
+  */
+  if ((method == IntegerInterpolatePixel) ||
+      (method == NearestNeighborInterpolatePixel))
+    {
+      SetMagickPixelPacket(image,p,indexes,pixel);
+      return;
+    }
+  if (image->matte == MagickFalse)
+    {
+      pixel->red=(MagickRealType) GetPixelRed(p);
+      pixel->green=(MagickRealType) GetPixelGreen(p);
+      pixel->blue=(MagickRealType) GetPixelBlue(p);
+      pixel->opacity=(MagickRealType) GetPixelOpacity(p);
+      if (image->colorspace == CMYKColorspace)
+        pixel->index=(MagickRealType) GetPixelIndex(indexes);
+      return;
+    }
+  alpha=QuantumScale*GetPixelAlpha(p);
+  gamma=1.0/(fabs((double) alpha) <= MagickEpsilon ? 1.0 : alpha);
+  pixel->red=gamma*(alpha*GetPixelRed(p));
+  pixel->green=gamma*(alpha*GetPixelGreen(p));
+  pixel->blue=gamma*(alpha*GetPixelBlue(p));
+  pixel->opacity=(MagickRealType) GetPixelOpacity(p);
+  if (image->colorspace == CMYKColorspace)
+    pixel->index=gamma*(alpha*GetPixelIndex(indexes));
+}
+
+static MagickBooleanType
+  FxExecuteRow(FxInfo *,const ssize_t,const ChannelType,const ssize_t,
+    const ssize_t *,const size_t,const size_t,MagickRealType *,
+    MagickRealType *,ExceptionInfo *);
+
+static MagickBooleanType FxExecuteSymbolRow(FxInfo *fx_info,FxNode *node,
+  const ChannelType channel,const ssize_t y,const ssize_t *columns,
+  const size_t count,const size_t depth,MagickRealType *alpha,
+  MagickRealType *beta,ExceptionInfo *exception)
+{
+  const Image
+    *image;
+
+  InterpolatePixelMethod
+    method;
+
+  MagickPixelPacket
+    pixel;
+
+  MagickRealType
+    *gamma,
+    value;
+
+  PointInfo
+    offset;
+
+  register ssize_t
+    i;
+
+  ssize_t
+    j;
+
+  gamma=fx_info->row_alpha+(depth+1)*fx_info->row_extent;
+  switch (node->type)
+  {
+    case ConstantFxSymbol:
+    {
+      for (i=0; i < (ssize_t) node->cached; i++)
+        if (node->channels[i] == channel)
+          break;
+      if (i < (ssize_t) node->cached)
+        value=node->values[i];
+      else
+        {
+          ExceptionInfo
+            *sans;
+
+          MagickBooleanType
+            status;
+
+          sans=AcquireExceptionInfo();
+          value=FxExecuteSymbol(fx_info,node,channel,columns[0],y,sans);
+          status=sans->severity == UndefinedException ? MagickTrue :
+            MagickFalse;
+          sans=DestroyExceptionInfo(sans);
+          if (status == MagickFalse)
+            return(MagickFalse);
+        }
+      for (i=0; i < (ssize_t) count; i++)
+        alpha[i]=value;
+      break;
+    }
+    case ColumnFxSymbol:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+        alpha[i]=(MagickRealType) columns[i];
+      break;
+    }
+    case RowFxSymbol:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+        alpha[i]=(MagickRealType) y;
+      break;
+    }
+    case UndefinedFxSymbol:
+      return(MagickFalse);
+    default:
+    {
+      if ((node->index >= 0) && (FxExecuteRow(fx_info,node->index,channel,y,
+           columns,count,depth+1,gamma,beta,exception) == MagickFalse))
+        return(MagickFalse);
+      if ((node->point >= 0) && (FxExecuteRow(fx_info,node->point,channel,y,
+           columns,count,depth+1,alpha,beta,exception) == MagickFalse))
+        return(MagickFalse);
+      image=node->image;
+      method=image->interpolate;
+      offset.x=0.0;
+      offset.y=0.0;
+      if (node->point >= 0)
+        {
+          offset.x=fx_info->nodes[node->point].value;
+          offset.y=fx_info->nodes[node->point].beta;
+        }
+      if ((node->index < 0) && (node->use_color == MagickFalse) &&
+          ((node->point < 0) || ((node->point_type == RelativeFxPoint) &&
+           (fx_info->nodes[node->point].opcode == ConstantFxOpcode) &&
+           (offset.x == floor(offset.x)) && (fabs(offset.x) < 1.0e9) &&
+           (offset.y == floor(offset.y)) && (fabs(offset.y) < 1.0e9))) &&
+          ((method == UndefinedInterpolatePixel) ||
+           (method == BilinearInterpolatePixel) ||
+           (method == IntegerInterpolatePixel) ||
+           (method == NearestNeighborInterpolatePixel)) &&
+          ((columns[count-1]-columns[0]) == (ssize_t) (count-1)))
+        {
+          const IndexPacket
+            *restrict indexes;
+
+          MagickPixelPacket
+            zero;
+
+          register const PixelPacket
+            *restrict p;
+
+          /*
+            Current pixel or a fixed neighbor: fetch the whole span at once.
+          */
+          if (IsFxSymbolSelectable(node,image,channel) == MagickFalse)
+            return(MagickFalse);
+          p=GetCacheViewVirtualPixels(fx_info->view[node->image_index],
+            columns[0]+(ssize_t) offset.x,y+(ssize_t) offset.y,count,1,
+            exception);
+          if (p == (const PixelPacket *) NULL)
+            return(MagickFalse);
+          indexes=GetCacheViewVirtualIndexQueue(fx_info->view[
+            node->image_index]);
+          GetMagickPixelPacket(image,&zero);
+          for (i=0; i < (ssize_t) count; i++)
+          {
+            pixel=zero;
+            FxGetPixel(image,method,p+i,indexes != (const IndexPacket *) NULL ?
+              indexes+i : (const IndexPacket *) NULL,&pixel);
+            alpha[i]=FxSelectSymbol(node,image,&pixel,channel,exception);
+          }
+          break;
+        }
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        PointInfo
+          point;
+
+        j=node->image_index;
+        image=node->image;
+        if (node->index >= 0)
+          {
+            j=(ssize_t) (gamma[i]+0.5);
+            while (j < 0)
+              j+=(ssize_t) node->length;
+            j%=node->length;
+            image=GetImageFromList(fx_info->images,j);
+          }
+        if (IsFxSymbolSelectable(node,image,channel) == MagickFalse)
+          return(MagickFalse);
+        point.x=(double) columns[i];
+        point.y=(double) y;
+        if (node->point_type == AbsoluteFxPoint)
+          {
+            point.x=alpha[i];
+            point.y=beta[i];
+          }
+        else
+          if (node->point_type == RelativeFxPoint)
+            {
+              point.x+=alpha[i];
+              point.y+=beta[i];
+            }
+        GetMagickPixelPacket(image,&pixel);
+        if (node->use_color != MagickFalse)
+          pixel=node->color;
+        else
+          (void) InterpolateMagickPixelPacket(image,fx_info->view[j],
+            image->interpolate,point.x,point.y,&pixel,exception);
+        alpha[i]=FxSelectSymbol(node,image,&pixel,channel,exception);
+      }
+      break;
+    }
+  }
+  for (i=0; i < (ssize_t) count; i++)
+    beta[i]=0.0;
+  return(MagickTrue);
+}
+
+static MagickBooleanType FxExecuteRow(FxInfo *fx_info,const ssize_t n,
+  const ChannelType channel,const ssize_t y,const ssize_t *columns,
+  const size_t count,const size_t depth,MagickRealType *alpha,
+  MagickRealType *beta,ExceptionInfo *exception)
+{
+  MagickRealType
+    *delta,
+    *gamma;
+
+  register FxNode
+    *node;
+
+  register ssize_t
+    i;
+
+  size_t
+    offset;
+
+  /*
+    Evaluate a node for a span of pixels, one operator at a time over
+    contiguous arrays of operands.  MagickFalse means some pixel would raise
+    an exception, in which case the caller evaluates the row pixel by pixel.
+  */
+  node=fx_info->nodes+n;
+  offset=(depth+1)*fx_info->row_extent;
+  gamma=fx_info->row_alpha+offset;
+  delta=fx_info->row_beta+offset;
+  switch (node->opcode)
+  {
+    case ConstantFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        alpha[i]=node->value;
+        beta[i]=node->beta;
+      }
+      return(MagickTrue);
+    }
+    case SymbolFxOpcode:
+      return(FxExecuteSymbolRow(fx_info,node,channel,y,columns,count,depth,
+        alpha,beta,exception));
+    case InterpretFxOpcode:
+    case RandomFxOpcode:
+      return(MagickFalse);
+    default:
+      break;
+  }
+  if (FxExecuteRow(fx_info,node->left,channel,y,columns,count,depth+1,alpha,
+      beta,exception) == MagickFalse)
+    return(MagickFalse);
+  if (node->opcode == TernaryFxOpcode)
+    {
+      ssize_t
+        *lanes,
+        *positions;
+
+      size_t
+        number_false,
+        number_true;
+
+      /*
+        Partition the span on the condition, evaluate each branch only for
+        its own pixels, then scatter the results back.
+      */
+      lanes=fx_info->row_columns+offset;
+      positions=fx_info->row_positions+offset;
+      number_true=0;
+      for (i=0; i < (ssize_t) count; i++)
+        if (fabs((double) alpha[i]) > MagickEpsilon)
+          {
+            positions[number_true]=i;
+            lanes[number_true++]=columns[i];
+          }
+      number_false=number_true;
+      for (i=0; i < (ssize_t) count; i++)
+        if (fabs((double) alpha[i]) <= MagickEpsilon)
+          {
+            positions[number_false]=i;
+            lanes[number_false++]=columns[i];
+          }
+      if ((number_true != 0) && (FxExecuteRow(fx_info,node->right,channel,y,
+           lanes,number_true,depth+1,gamma,delta,exception) == MagickFalse))
+        return(MagickFalse);
+      if ((number_true != count) && (FxExecuteRow(fx_info,node->other,channel,
+           y,lanes+number_true,count-number_true,depth+1,gamma+number_true,
+           delta+number_true,exception) == MagickFalse))
+        return(MagickFalse);
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        alpha[positions[i]]=gamma[i];
+        beta[positions[i]]=delta[i];
+      }
+      return(MagickTrue);
+    }
+  if (node->right < 0)
+    {
+      switch (node->opcode)
+      {
+        case PlusFxOpcode:
+        {
+          for (i=0; i < (ssize_t) count; i++)
+            alpha[i]=1.0*alpha[i];
+          break;
+        }
+        case NegateFxOpcode:
+        {
+          for (i=0; i < (ssize_t) count; i++)
+            alpha[i]=(-1.0)*alpha[i];
+          break;
+        }
+        default:
+        {
+          for (i=0; i < (ssize_t) count; i++)
+            alpha[i]=FxApplyFunction(node->opcode,alpha[i],beta[i]);
+          break;
+        }
+      }
+      return(MagickTrue);
+    }
+  if (FxExecuteRow(fx_info,node->right,channel,y,columns,count,depth+1,gamma,
+      delta,exception) == MagickFalse)
+    return(MagickFalse);
+  switch (node->opcode)
+  {
+    case ComplementFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=(MagickRealType) (~(size_t) gamma[i]);
+        alpha[i]=beta[i];
+      }
+      break;
+    }
+    case NotFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=gamma[i];
+        alpha[i]=gamma[i] == 0.0 ? 1.0 : 0.0;
+      }
+      break;
+    }
+    case PowerFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=pow((double) alpha[i],(double) gamma[i]);
+        alpha[i]=beta[i];
+      }
+      break;
+    }
+    case MultiplyFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=gamma[i];
+        alpha[i]=alpha[i]*gamma[i];
+      }
+      break;
+    }
+    case DivideFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+        if (gamma[i] == 0.0)
+          return(MagickFalse);
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=gamma[i];
+        alpha[i]=alpha[i]/gamma[i];
+      }
+      break;
+    }
+    case ModulusFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=fabs(floor(((double) gamma[i])+0.5));
+        if (beta[i] == 0.0)
+          return(MagickFalse);
+        alpha[i]=fmod((double) alpha[i],(double) beta[i]);
+      }
+      break;
+    }
+    case AddFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=gamma[i];
+        alpha[i]=alpha[i]+gamma[i];
+      }
+      break;
+    }
+    case SubtractFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=gamma[i];
+        alpha[i]=alpha[i]-gamma[i];
+      }
+      break;
+    }
+    case LeftShiftFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=(MagickRealType) ((size_t) (alpha[i]+0.5) << (size_t)
+          (gamma[i]+0.5));
+        alpha[i]=beta[i];
+      }
+      break;
+    }
+    case RightShiftFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=(MagickRealType) ((size_t) (alpha[i]+0.5) >> (size_t)
+          (gamma[i]+0.5));
+        alpha[i]=beta[i];
+      }
+      break;
+    }
+    case LessThanFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=gamma[i];
+        alpha[i]=alpha[i] < gamma[i] ? 1.0 : 0.0;
+      }
+      break;
+    }
+    case LessThanEqualFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=gamma[i];
+        alpha[i]=alpha[i] <= gamma[i] ? 1.0 : 0.0;
+      }
+      break;
+    }
+    case GreaterThanFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=gamma[i];
+        alpha[i]=alpha[i] > gamma[i] ? 1.0 : 0.0;
+      }
+      break;
+    }
+    case GreaterThanEqualFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=gamma[i];
+        alpha[i]=alpha[i] >= gamma[i] ? 1.0 : 0.0;
+      }
+      break;
+    }
+    case EqualFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=gamma[i];
+        alpha[i]=fabs(alpha[i]-gamma[i]) <= MagickEpsilon ? 1.0 : 0.0;
+      }
+      break;
+    }
+    case NotEqualFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=gamma[i];
+        alpha[i]=fabs(alpha[i]-gamma[i]) > MagickEpsilon ? 1.0 : 0.0;
+      }
+      break;
+    }
+    case BitwiseAndFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=(MagickRealType) ((size_t) (alpha[i]+0.5) & (size_t)
+          (gamma[i]+0.5));
+        alpha[i]=beta[i];
+      }
+      break;
+    }
+    case BitwiseOrFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=(MagickRealType) ((size_t) (alpha[i]+0.5) | (size_t)
+          (gamma[i]+0.5));
+        alpha[i]=beta[i];
+      }
+      break;
+    }
+    case LogicalAndFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=(alpha[i] > 0.0) && (gamma[i] > 0.0) ? 1.0 : 0.0;
+        alpha[i]=beta[i];
+      }
+      break;
+    }
+    case LogicalOrFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=(alpha[i] > 0.0) || (gamma[i] > 0.0) ? 1.0 : 0.0;
+        alpha[i]=beta[i];
+      }
+      break;
+    }
+    case CommaFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+        beta[i]=gamma[i];
+      break;
+    }
+    case SeparatorFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        beta[i]=gamma[i];
+        alpha[i]=gamma[i];
+      }
+      break;
+    }
+    case ProductFxOpcode:
+    {
+      for (i=0; i < (ssize_t) count; i++)
+      {
+        alpha[i]=alpha[i]*gamma[i];
+        beta[i]=delta[i];
+      }
+      break;
+    }
+    default:
+      return(MagickFalse);
+  }
+  return(MagickTrue);
+}
+
+static const MagickRealType *FxEvaluateChannelRow(FxInfo *fx_info,
+  const ChannelType channel,const ssize_t y,const size_t columns,
+  ExceptionInfo *exception)
+{
+  register ssize_t
+    x;
+
+  size_t
+    length;
+
+  /*
+    Evaluate the compiled expression for an entire row; NULL means the row
+    must be evaluated one pixel at a time.  The exception belongs to the
+    calling thread, so a pending one is this thread's own.
+  */
+  if ((fx_info->vectorize == MagickFalse) || (columns == 0) ||
+      (exception->severity != UndefinedException))
+    return((const MagickRealType *) NULL);
+  if (columns > fx_info->row_extent)
+    {
+      length=(fx_info->height+1)*columns;
+      fx_info->row_extent=0;
+      fx_info->row_alpha=(MagickRealType *) ResizeQuantumMemory(
+        fx_info->row_alpha,length,sizeof(*fx_info->row_alpha));
+      fx_info->row_beta=(MagickRealType *) ResizeQuantumMemory(
+        fx_info->row_beta,length,sizeof(*fx_info->row_beta));
+      fx_info->row_columns=(ssize_t *) ResizeQuantumMemory(
+        fx_info->row_columns,length,sizeof(*fx_info->row_columns));
+      fx_info->row_positions=(ssize_t *) ResizeQuantumMemory(
+        fx_info->row_positions,length,sizeof(*fx_info->row_positions));
+      if ((fx_info->row_alpha == (MagickRealType *) NULL) ||
+          (fx_info->row_beta == (MagickRealType *) NULL) ||
+          (fx_info->row_columns == (ssize_t *) NULL) ||
+          (fx_info->row_positions == (ssize_t *) NULL))
+        {
+          fx_info->vectorize=MagickFalse;
+          return((const MagickRealType *) NULL);
+        }
+      fx_info->row_extent=columns;
+      for (x=0; x < (ssize_t) columns; x++)
+        fx_info->row_columns[x]=x;
+    }
+  if (FxExecuteRow(fx_info,fx_info->program,channel,y,fx_info->row_columns,
+      columns,0,fx_info->row_alpha,fx_info->row_beta,exception) == MagickFalse)
+    return((const MagickRealType *) NULL);
+  return(fx_info->row_alpha);
+}
+
+MagickExport MagickBooleanType FxEvaluateChannelExpression(FxInfo *fx_info,
+  const ChannelType channel,const ssize_t x,const ssize_t y,
+  MagickRealType *alpha,ExceptionInfo *exception)
+{
+  MagickRealType
+    beta;
+
+  beta=0.0;
+  if (fx_info->program >= 0)
+    *alpha=FxExecuteNode(fx_info,fx_info->program,channel,x,y,&beta,exception);
+  else
+    *alpha=FxEvaluateSubexpression(fx_info,channel,x,y,fx_info->expression,
+      &beta,exception);
+  return(exception->severity == OptionError ? MagickFalse : MagickTrue);
 }
 
 /*
@@ -2930,6 +5052,19 @@ MagickExport MagickBooleanType FxEvaluateChannelExpression(FxInfo *fx_info,
 %
 */
 
+static ExceptionInfo **DestroyExceptionThreadSet(ExceptionInfo **exception)
+{
+  register ssize_t
+    i;
+
+  assert(exception != (ExceptionInfo **) NULL);
+  for (i=0; i < (ssize_t) GetOpenMPMaximumThreads(); i++)
+    if (exception[i] != (ExceptionInfo *) NULL)
+      exception[i]=DestroyExceptionInfo(exception[i]);
+  exception=(ExceptionInfo **) RelinquishMagickMemory(exception);
+  return(exception);
+}
+
 static FxInfo **DestroyFxThreadSet(FxInfo **fx_info)
 {
   register ssize_t
@@ -2943,6 +5078,28 @@ static FxInfo **DestroyFxThreadSet(FxInfo **fx_info)
   return(fx_info);
 }
 
+static ExceptionInfo **AcquireExceptionThreadSet(void)
+{
+  ExceptionInfo
+    **exception;
+
+  register ssize_t
+    i;
+
+  size_t
+    number_threads;
+
+  number_threads=GetOpenMPMaximumThreads();
+  exception=(ExceptionInfo **) AcquireQuantumMemory(number_threads,
+    sizeof(*exception));
+  if (exception == (ExceptionInfo **) NULL)
+    return((ExceptionInfo **) NULL);
+  (void) ResetMagickMemory(exception,0,number_threads*sizeof(*exception));
+  for (i=0; i < (ssize_t) number_threads; i++)
+    exception[i]=AcquireExceptionInfo();
+  return(exception);
+}
+
 static FxInfo **AcquireFxThreadSet(const Image *image,const char *expression,
   ExceptionInfo *exception)
 {
@@ -2991,6 +5148,79 @@ MagickExport Image *FxImage(const Image *image,const char *expression,
   return(fx_image);
 }
 
+static MagickBooleanType FxImageChannelRow(FxInfo *fx_info,
+  const Image *image,const ChannelType channel,Image *fx_image,
+  const ssize_t y,PixelPacket *restrict q,IndexPacket *restrict fx_indexes,
+  ExceptionInfo *exception)
+{
+  register const MagickRealType
+    *restrict alpha;
+
+  register ssize_t
+    x;
+
+  /*
+    Evaluate each channel of a row as a span; MagickFalse defers the row to
+    the per-pixel loop.
+  */
+  if ((channel & RedChannel) != 0)
+    {
+      alpha=FxEvaluateChannelRow(fx_info,RedChannel,y,fx_image->columns,
+        exception);
+      if (alpha == (const MagickRealType *) NULL)
+        return(MagickFalse);
+      for (x=0; x < (ssize_t) fx_image->columns; x++)
+        SetPixelRed(q+x,ClampToQuantum((MagickRealType) QuantumRange*
+          alpha[x]));
+    }
+  if ((channel & GreenChannel) != 0)
+    {
+      alpha=FxEvaluateChannelRow(fx_info,GreenChannel,y,fx_image->columns,
+        exception);
+      if (alpha == (const MagickRealType *) NULL)
+        return(MagickFalse);
+      for (x=0; x < (ssize_t) fx_image->columns; x++)
+        SetPixelGreen(q+x,ClampToQuantum((MagickRealType) QuantumRange*
+          alpha[x]));
+    }
+  if ((channel & BlueChannel) != 0)
+    {
+      alpha=FxEvaluateChannelRow(fx_info,BlueChannel,y,fx_image->columns,
+        exception);
+      if (alpha == (const MagickRealType *) NULL)
+        return(MagickFalse);
+      for (x=0; x < (ssize_t) fx_image->columns; x++)
+        SetPixelBlue(q+x,ClampToQuantum((MagickRealType) QuantumRange*
+          alpha[x]));
+    }
+  if ((channel & OpacityChannel) != 0)
+    {
+      alpha=FxEvaluateChannelRow(fx_info,OpacityChannel,y,fx_image->columns,
+        exception);
+      if (alpha == (const MagickRealType *) NULL)
+        return(MagickFalse);
+      for (x=0; x < (ssize_t) fx_image->columns; x++)
+        if (image->matte == MagickFalse)
+          SetPixelOpacity(q+x,ClampToQuantum((MagickRealType) QuantumRange*
+            alpha[x]));
+        else
+          SetPixelOpacity(q+x,ClampToQuantum((MagickRealType)
+            (QuantumRange-QuantumRange*alpha[x])));
+    }
+  if (((channel & IndexChannel) != 0) &&
+      (fx_image->colorspace == CMYKColorspace))
+    {
+      alpha=FxEvaluateChannelRow(fx_info,IndexChannel,y,fx_image->columns,
+        exception);
+      if (alpha == (const MagickRealType *) NULL)
+        return(MagickFalse);
+      for (x=0; x < (ssize_t) fx_image->columns; x++)
+        SetPixelIndex(fx_indexes+x,ClampToQuantum((MagickRealType)
+          QuantumRange*alpha[x]));
+    }
+  return(MagickTrue);
+}
+
 MagickExport Image *FxImageChannel(const Image *image,const ChannelType channel,
   const char *expression,ExceptionInfo *exception)
 {
@@ -2999,6 +5229,9 @@ MagickExport Image *FxImageChannel(const Image *image,const ChannelType channel,
   CacheView
     *fx_view;
 
+  ExceptionInfo
+    **restrict fx_exception;
+
   FxInfo
     **restrict fx_info;
 
@@ -3014,6 +5247,9 @@ MagickExport Image *FxImageChannel(const Image *image,const ChannelType channel,
   MagickRealType
     alpha;
 
+  register ssize_t
+    i;
+
   ssize_t
     y;
 
@@ -3044,8 +5280,17 @@ MagickExport Image *FxImageChannel(const Image *image,const ChannelType channel,
       return((Image *) NULL);
     }
   /*
-    Fx image.
+    Fx image.  Each thread evaluates into its own exception: the evaluator
+    stops at the first error it sees, so it must not see another thread's.
+    The FxInfo exception is not used; it swallows failed color lookups.
   */
+  fx_exception=AcquireExceptionThreadSet();
+  if (fx_exception == (ExceptionInfo **) NULL)
+    {
+      fx_image=DestroyImage(fx_image);
+      fx_info=DestroyFxThreadSet(fx_info);
+      ThrowImageException(ResourceLimitError,"MemoryAllocationFailed");
+    }
   status=MagickTrue;
   progress=0;
   fx_view=AcquireCacheView(fx_image);
@@ -3078,51 +5323,58 @@ MagickExport Image *FxImageChannel(const Image *image,const ChannelType channel,
         continue;
       }
     fx_indexes=GetCacheViewAuthenticIndexQueue(fx_view);
-    alpha=0.0;
-    for (x=0; x < (ssize_t) fx_image->columns; x++)
-    {
-      if ((channel & RedChannel) != 0)
-        {
-          (void) FxEvaluateChannelExpression(fx_info[id],RedChannel,x,y,
-            &alpha,exception);
-          SetPixelRed(q,ClampToQuantum((MagickRealType) QuantumRange*
-            alpha));
-        }
-      if ((channel & GreenChannel) != 0)
-        {
-          (void) FxEvaluateChannelExpression(fx_info[id],GreenChannel,x,y,
-            &alpha,exception);
-          SetPixelGreen(q,ClampToQuantum((MagickRealType) QuantumRange*
-            alpha));
-        }
-      if ((channel & BlueChannel) != 0)
-        {
-          (void) FxEvaluateChannelExpression(fx_info[id],BlueChannel,x,y,
-            &alpha,exception);
-          SetPixelBlue(q,ClampToQuantum((MagickRealType) QuantumRange*
-            alpha));
-        }
-      if ((channel & OpacityChannel) != 0)
-        {
-          (void) FxEvaluateChannelExpression(fx_info[id],OpacityChannel,x,y,
-            &alpha,exception);
-          if (image->matte == MagickFalse)
-            SetPixelOpacity(q,ClampToQuantum((MagickRealType)
-              QuantumRange*alpha));
-          else
-            SetPixelOpacity(q,ClampToQuantum((MagickRealType)
-              (QuantumRange-QuantumRange*alpha)));
-        }
-      if (((channel & IndexChannel) != 0) &&
-          (fx_image->colorspace == CMYKColorspace))
+    if (FxImageChannelRow(fx_info[id],image,channel,fx_image,y,q,
+        fx_indexes,fx_exception[id]) == MagickFalse)
+      {
+        /*
+          Evaluate the row one pixel at a time.
+        */
+        alpha=0.0;
+        for (x=0; x < (ssize_t) fx_image->columns; x++)
         {
-          (void) FxEvaluateChannelExpression(fx_info[id],IndexChannel,x,y,
-            &alpha,exception);
-          SetPixelIndex(fx_indexes+x,ClampToQuantum((MagickRealType)
-            QuantumRange*alpha));
+          if ((channel & RedChannel) != 0)
+            {
+              (void) FxEvaluateChannelExpression(fx_info[id],RedChannel,x,y,
+                &alpha,fx_exception[id]);
+              SetPixelRed(q,ClampToQuantum((MagickRealType) QuantumRange*
+                alpha));
+            }
+          if ((channel & GreenChannel) != 0)
+            {
+              (void) FxEvaluateChannelExpression(fx_info[id],GreenChannel,x,y,
+                &alpha,fx_exception[id]);
+              SetPixelGreen(q,ClampToQuantum((MagickRealType) QuantumRange*
+                alpha));
+            }
+          if ((channel & BlueChannel) != 0)
+            {
+              (void) FxEvaluateChannelExpression(fx_info[id],BlueChannel,x,y,
+                &alpha,fx_exception[id]);
+              SetPixelBlue(q,ClampToQuantum((MagickRealType) QuantumRange*
+                alpha));
+            }
+          if ((channel & OpacityChannel) != 0)
+            {
+              (void) FxEvaluateChannelExpression(fx_info[id],OpacityChannel,x,y,
+                &alpha,fx_exception[id]);
+              if (image->matte == MagickFalse)
+                SetPixelOpacity(q,ClampToQuantum((MagickRealType)
+                  QuantumRange*alpha));
+              else
+                SetPixelOpacity(q,ClampToQuantum((MagickRealType)
+                  (QuantumRange-QuantumRange*alpha)));
+            }
+          if (((channel & IndexChannel) != 0) &&
+              (fx_image->colorspace == CMYKColorspace))
+            {
+              (void) FxEvaluateChannelExpression(fx_info[id],IndexChannel,x,y,
+                &alpha,fx_exception[id]);
+              SetPixelIndex(fx_indexes+x,ClampToQuantum((MagickRealType)
+                QuantumRange*alpha));
+            }
+          q++;
         }
-      q++;
-    }
+      }
     if (SyncCacheViewAuthenticPixels(fx_view,exception) == MagickFalse)
       status=MagickFalse;
     if (image->progress_monitor != (MagickProgressMonitor) NULL)
@@ -3139,6 +5391,9 @@ MagickExport Image *FxImageChannel(const Image *image,const ChannelType channel,
       }
   }
   fx_view=DestroyCacheView(fx_view);
+  for (i=0; i < (ssize_t) GetOpenMPMaximumThreads(); i++)
+    InheritException(exception,fx_exception[i]);
+  fx_exception=DestroyExceptionThreadSet(fx_exception);
   fx_info=DestroyFxThreadSet(fx_info);
   if (status == MagickFalse)
     fx_image=DestroyImage(fx_image);
@@ -750,6 +750,9 @@ MagickExport MagickStatusType ParseGeometry(const char *geometry,
     pedantic_geometry[MaxTextExtent],
     *q;
 
+  const char
+    *r;
+
   double
     value;
 
@@ -768,57 +771,47 @@ MagickExport MagickStatusType ParseGeometry(const char *geometry,
     return(flags);
   if (strlen(geometry) >= (MaxTextExtent-1))
     return(flags);
-  (void) CopyMagickString(pedantic_geometry,geometry,MaxTextExtent);
-  for (p=pedantic_geometry; *p != '\0'; )
+  q=pedantic_geometry;
+  for (r=geometry; *r != '\0'; r++)
   {
-    if (isspace((int) ((unsigned char) *p)) != 0)
-      {
-        (void) CopyMagickString(p,p+1,MaxTextExtent);
-        continue;
-      }
-    c=(int) ((unsigned char) *p);
+    if (isspace((int) ((unsigned char) *r)) != 0)
+      continue;
+    c=(int) ((unsigned char) *r);
     switch (c)
     {
       case '%':
       {
         flags|=PercentValue;
-        (void) CopyMagickString(p,p+1,MaxTextExtent);
         break;
       }
       case '!':
       {
         flags|=AspectValue;
-        (void) CopyMagickString(p,p+1,MaxTextExtent);
         break;
       }
       case '<':
       {
         flags|=LessValue;
-        (void) CopyMagickString(p,p+1,MaxTextExtent);
         break;
       }
       case '>':
       {
         flags|=GreaterValue;
-        (void) CopyMagickString(p,p+1,MaxTextExtent);
         break;
       }
       case '^':
       {
         flags|=MinimumValue;
-        (void) CopyMagickString(p,p+1,MaxTextExtent);
         break;
       }
       case '@':
       {
         flags|=AreaValue;
-        (void) CopyMagickString(p,p+1,MaxTextExtent);
         break;
       }
       case '(':
       case ')':
       {
-        (void) CopyMagickString(p,p+1,MaxTextExtent);
         break;
       }
       case '-':
@@ -840,12 +833,12 @@ MagickExport MagickStatusType ParseGeometry(const char *geometry,
       case ':':
       case 215:
       {
-        p++;
+        *q++=(*r);
         break;
       }
       case '.':
       {
-        p++;
+        *q++=(*r);
         flags|=DecimalValue;
         break;
       }
@@ -853,6 +846,7 @@ MagickExport MagickStatusType ParseGeometry(const char *geometry,
         return(flags);
     }
   }
+  *q='\0';
   /*
     Parse rho, sigma, xi, psi, and optionally chi.
   */
@@ -180,6 +180,9 @@ static LinkedListInfo
 static SemaphoreInfo
   *log_semaphore = (SemaphoreInfo *) NULL;
 
+static volatile LogEventType
+  log_event_mask = NoEvents;
+
 static volatile MagickBooleanType
   instantiate_log = MagickFalse;
 
@@ -539,6 +542,9 @@ static MagickBooleanType InitializeLogList(ExceptionInfo *exception)
           (instantiate_log == MagickFalse))
         {
           (void) LoadLogLists(LogFilename,exception);
+          if (IsLinkedListEmpty(log_list) == MagickFalse)
+            log_event_mask=((LogInfo *) GetValueFromLinkedList(log_list,0))->
+              event_mask;
           instantiate_log=MagickTrue;
         }
       UnlockSemaphoreInfo(log_semaphore);
@@ -567,19 +573,7 @@ static MagickBooleanType InitializeLogList(ExceptionInfo *exception)
 */
 MagickExport MagickBooleanType IsEventLogging(void)
 {
-  const LogInfo
-    *log_info;
-
-  ExceptionInfo
-    *exception;
-
-  if ((log_list == (LinkedListInfo *) NULL) ||
-      (IsLinkedListEmpty(log_list) != MagickFalse))
-    return(MagickFalse);
-  exception=AcquireExceptionInfo();
-  log_info=GetLogInfo("*",exception);
-  exception=DestroyExceptionInfo(exception);
-  return(log_info->event_mask != NoEvents ? MagickTrue : MagickFalse);
+  return(log_event_mask != NoEvents ? MagickTrue : MagickFalse);
 }
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -669,6 +663,88 @@ MagickExport MagickBooleanType ListLogInfo(FILE *file,ExceptionInfo *exception)
   return(MagickTrue);
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   L o g C o m p o n e n t F o r k C h i l d                                 %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  LogComponentForkChild() releases the log component in the child process
+%  after a fork().
+%
+%  The format of the LogComponentForkChild method is:
+%
+%      LogComponentForkChild(void)
+%
+*/
+MagickExport void LogComponentForkChild(void)
+{
+  UnlockSemaphoreInfo(log_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   L o g C o m p o n e n t F o r k P a r e n t                               %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  LogComponentForkParent() releases the log component in the parent process
+%  after a fork().
+%
+%  The format of the LogComponentForkParent method is:
+%
+%      LogComponentForkParent(void)
+%
+*/
+MagickExport void LogComponentForkParent(void)
+{
+  UnlockSemaphoreInfo(log_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   L o g C o m p o n e n t F o r k P r e p a r e                             %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  LogComponentForkPrepare() locks the log component and flushes the log file
+%  so no event is half written, or buffered twice, when the process forks.
+%
+%  The format of the LogComponentForkPrepare method is:
+%
+%      LogComponentForkPrepare(void)
+%
+*/
+MagickExport void LogComponentForkPrepare(void)
+{
+  LogInfo
+    *log_info;
+
+  if (log_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&log_semaphore);
+  LockSemaphoreInfo(log_semaphore);
+  if (log_list == (LinkedListInfo *) NULL)
+    return;
+  log_info=(LogInfo *) GetValueFromLinkedList(log_list,0);
+  if ((log_info != (LogInfo *) NULL) && (log_info->file != (FILE *) NULL))
+    (void) fflush(log_info->file);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -745,6 +821,7 @@ MagickExport void LogComponentTerminus(void)
   LockSemaphoreInfo(log_semaphore);
   if (log_list != (LinkedListInfo *) NULL)
     log_list=DestroyLinkedList(log_list,DestroyLogElement);
+  log_event_mask=NoEvents;
   instantiate_log=MagickFalse;
   UnlockSemaphoreInfo(log_semaphore);
   DestroySemaphoreInfo(&log_semaphore);
@@ -783,9 +860,9 @@ MagickExport void LogComponentTerminus(void)
 %    o format: the output format.
 %
 */
-static char *TranslateEvent(const LogEventType magick_unused(type),
-  const char *module,const char *function,const size_t line,
-  const char *domain,const char *event)
+static char *TranslateEvent(LogInfo *log_info,
+  const LogEventType magick_unused(type),const char *module,
+  const char *function,const size_t line,const char *domain,const char *event)
 {
   char
     *text;
@@ -794,12 +871,6 @@ static char *TranslateEvent(const LogEventType magick_unused(type),
     elapsed_time,
     user_time;
 
-  ExceptionInfo
-    *exception;
-
-  LogInfo
-    *log_info;
-
   register char
     *q;
 
@@ -812,9 +883,6 @@ static char *TranslateEvent(const LogEventType magick_unused(type),
   time_t
     seconds;
 
-  exception=AcquireExceptionInfo();
-  log_info=(LogInfo *) GetLogInfo("*",exception);
-  exception=DestroyExceptionInfo(exception);
   seconds=time((time_t *) NULL);
   elapsed_time=GetElapsedTime(&log_info->timer);
   user_time=GetUserTime(&log_info->timer);
@@ -1118,26 +1186,20 @@ MagickBooleanType LogMagickEventList(const LogEventType type,const char *module,
   const char
     *domain;
 
-  ExceptionInfo
-    *exception;
-
   int
     n;
 
   LogInfo
     *log_info;
 
-  if (IsEventLogging() == MagickFalse)
+  /*
+    The event mask is cached so the common case, logging disabled or the
+    event filtered out, costs a single test and takes no lock.
+  */
+  if (log_event_mask == NoEvents)
     return(MagickFalse);
-  exception=AcquireExceptionInfo();
-  log_info=(LogInfo *) GetLogInfo("*",exception);
-  exception=DestroyExceptionInfo(exception);
-  LockSemaphoreInfo(log_semaphore);
-  if ((log_info->event_mask & type) == 0)
-    {
-      UnlockSemaphoreInfo(log_semaphore);
-      return(MagickTrue);
-    }
+  if ((log_event_mask & type) == 0)
+    return(MagickTrue);
   domain=CommandOptionToMnemonic(MagickLogEventOptions,type);
 #if defined(MAGICKCORE_HAVE_VSNPRINTF)
   n=vsnprintf(event,MaxTextExtent,format,operands);
@@ -1146,7 +1208,14 @@ MagickBooleanType LogMagickEventList(const LogEventType type,const char *module,
 #endif
   if (n < 0)
     event[MaxTextExtent-1]='\0';
-  text=TranslateEvent(type,module,function,line,domain,event);
+  LockSemaphoreInfo(log_semaphore);
+  log_info=(LogInfo *) GetValueFromLinkedList(log_list,0);
+  if ((log_info == (LogInfo *) NULL) || ((log_info->event_mask & type) == 0))
+    {
+      UnlockSemaphoreInfo(log_semaphore);
+      return(MagickTrue);
+    }
+  text=TranslateEvent(log_info,type,module,function,line,domain,event);
   if (text == (char *) NULL)
     {
       (void) ContinueTimer((TimerInfo *) &log_info->timer);
@@ -1695,6 +1764,7 @@ MagickExport LogEventType SetLogEventMask(const char *events)
   log_info->event_mask=(LogEventType) option;
   if (option == -1)
     log_info->event_mask=UndefinedEvents;
+  log_event_mask=log_info->event_mask;
   UnlockSemaphoreInfo(log_semaphore);
   return(log_info->event_mask);
 }
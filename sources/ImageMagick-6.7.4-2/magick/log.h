@@ -85,6 +85,9 @@ extern MagickExport MagickBooleanType
 
 extern MagickExport void
   CloseMagickLog(void),
+  LogComponentForkChild(void),
+  LogComponentForkParent(void),
+  LogComponentForkPrepare(void),
   LogComponentTerminus(void),
   SetLogFormat(const char *);
 
@@ -197,12 +197,19 @@ static const MagicMapInfo
     { "XWD", 5, MagickString("\000\000\007") }
  };
 
+static const MagicInfo
+  **magic_signatures = (const MagicInfo **) NULL;
+
 static LinkedListInfo
   *magic_list = (LinkedListInfo *) NULL;
 
 static SemaphoreInfo
   *magic_semaphore = (SemaphoreInfo *) NULL;
 
+static size_t
+  magic_bucket[258],
+  *magic_indexes = (size_t *) NULL;
+
 static volatile MagickBooleanType
   instantiate_magic = MagickFalse;
 
@@ -248,37 +255,46 @@ MagickExport const MagicInfo *GetMagicInfo(const unsigned char *magic,
   register const MagicInfo
     *p;
 
+  register const size_t
+    *q,
+    *r;
+
+  const size_t
+    *q_end,
+    *r_end;
+
   assert(exception != (ExceptionInfo *) NULL);
   if ((magic_list == (LinkedListInfo *) NULL) ||
       (instantiate_magic == MagickFalse))
     if (InitializeMagicList(exception) == MagickFalse)
       return((const MagicInfo *) NULL);
-  if ((magic_list == (LinkedListInfo *) NULL) ||
-      (IsLinkedListEmpty(magic_list) != MagickFalse))
+  if (magic_signatures == (const MagicInfo **) NULL)
     return((const MagicInfo *) NULL);
   if (magic == (const unsigned char *) NULL)
-    return((const MagicInfo *) GetValueFromLinkedList(magic_list,0));
+    return(magic_signatures[0]);
   if (length == 0)
     return((const MagicInfo *) NULL);
   /*
-    Search for magic tag.
+    Search for magic tag.  The signature table is immutable once built, so no
+    lock is needed: merge the signatures at offset zero that begin with the
+    first byte of the magic with those at other offsets, in list order, and
+    return the first that matches.
   */
-  LockSemaphoreInfo(magic_semaphore);
-  ResetLinkedListIterator(magic_list);
-  p=(const MagicInfo *) GetNextValueInLinkedList(magic_list);
-  while (p != (const MagicInfo *) NULL)
+  q=magic_indexes+magic_bucket[*magic];
+  q_end=magic_indexes+magic_bucket[*magic+1];
+  r=magic_indexes+magic_bucket[256];
+  r_end=magic_indexes+magic_bucket[257];
+  while ((q < q_end) || (r < r_end))
   {
-    assert(p->offset >= 0);
+    if ((r >= r_end) || ((q < q_end) && (*q < *r)))
+      p=magic_signatures[*q++];
+    else
+      p=magic_signatures[*r++];
     if (((size_t) (p->offset+p->length) <= length) &&
         (memcmp(magic+p->offset,p->magic,p->length) == 0))
-      break;
-    p=(const MagicInfo *) GetNextValueInLinkedList(magic_list);
+      return(p);
   }
-  if (p != (const MagicInfo *) NULL)
-    (void) InsertValueInLinkedList(magic_list,0,
-      RemoveElementByValueFromLinkedList(magic_list,p));
-  UnlockSemaphoreInfo(magic_semaphore);
-  return(p);
+  return((const MagicInfo *) NULL);
 }
 
 /*
@@ -521,6 +537,66 @@ MagickExport const char *GetMagicName(const MagicInfo *magic_info)
 %    o exception: return any errors or warnings in this structure.
 %
 */
+static void CompileMagicList(void)
+{
+  const MagicInfo
+    *p;
+
+  register ssize_t
+    i;
+
+  size_t
+    number_signatures;
+
+  ssize_t
+    j;
+
+  /*
+    Index the magic list by the leading byte of each signature at offset zero;
+    other signatures share the last bucket.
+  */
+  number_signatures=GetNumberOfElementsInLinkedList(magic_list);
+  if (number_signatures == 0)
+    return;
+  magic_signatures=(const MagicInfo **) AcquireQuantumMemory(
+    number_signatures,sizeof(*magic_signatures));
+  magic_indexes=(size_t *) AcquireQuantumMemory(number_signatures,
+    sizeof(*magic_indexes));
+  if ((magic_signatures == (const MagicInfo **) NULL) ||
+      (magic_indexes == (size_t *) NULL))
+    {
+      if (magic_indexes != (size_t *) NULL)
+        magic_indexes=(size_t *) RelinquishMagickMemory(magic_indexes);
+      if (magic_signatures != (const MagicInfo **) NULL)
+        magic_signatures=(const MagicInfo **) RelinquishMagickMemory((void *)
+          magic_signatures);
+      return;
+    }
+  (void) ResetMagickMemory(magic_bucket,0,sizeof(magic_bucket));
+  ResetLinkedListIterator(magic_list);
+  for (i=0; i < (ssize_t) number_signatures; i++)
+  {
+    p=(const MagicInfo *) GetNextValueInLinkedList(magic_list);
+    assert(p->offset >= 0);
+    magic_signatures[i]=p;
+    if ((p->offset == 0) && (p->length != 0))
+      magic_bucket[*p->magic+1]++;
+    else
+      magic_bucket[257]++;
+  }
+  for (j=1; j < 258; j++)
+    magic_bucket[j]+=magic_bucket[j-1];
+  for (i=0; i < (ssize_t) number_signatures; i++)
+  {
+    p=magic_signatures[i];
+    j=((p->offset == 0) && (p->length != 0)) ? (ssize_t) *p->magic : 256;
+    magic_indexes[magic_bucket[j]++]=(size_t) i;
+  }
+  for (j=257; j > 0; j--)
+    magic_bucket[j]=magic_bucket[j-1];
+  magic_bucket[0]=0;
+}
+
 static MagickBooleanType InitializeMagicList(ExceptionInfo *exception)
 {
   if ((magic_list == (LinkedListInfo *) NULL) &&
@@ -533,6 +609,8 @@ static MagickBooleanType InitializeMagicList(ExceptionInfo *exception)
           (instantiate_magic == MagickFalse))
         {
           (void) LoadMagicLists(MagicFilename,exception);
+          if (magic_list != (LinkedListInfo *) NULL)
+            CompileMagicList();
           instantiate_magic=MagickTrue;
         }
       UnlockSemaphoreInfo(magic_semaphore);
@@ -997,6 +1075,79 @@ static MagickBooleanType LoadMagicLists(const char *filename,
   return(status != 0 ? MagickTrue : MagickFalse);
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   M a g i c C o m p o n e n t F o r k C h i l d                             %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  MagicComponentForkChild() releases the magic component in the child process
+%  after a fork().
+%
+%  The format of the MagicComponentForkChild method is:
+%
+%      MagicComponentForkChild(void)
+%
+*/
+MagickExport void MagicComponentForkChild(void)
+{
+  UnlockSemaphoreInfo(magic_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   M a g i c C o m p o n e n t F o r k P a r e n t                           %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  MagicComponentForkParent() releases the magic component in the parent
+%  process after a fork().
+%
+%  The format of the MagicComponentForkParent method is:
+%
+%      MagicComponentForkParent(void)
+%
+*/
+MagickExport void MagicComponentForkParent(void)
+{
+  UnlockSemaphoreInfo(magic_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   M a g i c C o m p o n e n t F o r k P r e p a r e                         %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  MagicComponentForkPrepare() locks the magic component before a fork().
+%
+%  The format of the MagicComponentForkPrepare method is:
+%
+%      MagicComponentForkPrepare(void)
+%
+*/
+MagickExport void MagicComponentForkPrepare(void)
+{
+  if (magic_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&magic_semaphore);
+  LockSemaphoreInfo(magic_semaphore);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -1066,6 +1217,11 @@ MagickExport void MagicComponentTerminus(void)
   if (magic_semaphore == (SemaphoreInfo *) NULL)
     AcquireSemaphoreInfo(&magic_semaphore);
   LockSemaphoreInfo(magic_semaphore);
+  if (magic_indexes != (size_t *) NULL)
+    magic_indexes=(size_t *) RelinquishMagickMemory(magic_indexes);
+  if (magic_signatures != (const MagicInfo **) NULL)
+    magic_signatures=(const MagicInfo **) RelinquishMagickMemory((void *)
+      magic_signatures);
   if (magic_list != (LinkedListInfo *) NULL)
     magic_list=DestroyLinkedList(magic_list,DestroyMagicElement);
   instantiate_magic=MagickFalse;
@@ -65,6 +65,9 @@ extern MagickExport const MagicInfo
   **GetMagicInfoList(const char *,size_t *,ExceptionInfo *);
 
 extern MagickExport void
+  MagicComponentForkChild(void),
+  MagicComponentForkParent(void),
+  MagicComponentForkPrepare(void),
   MagicComponentTerminus(void);
 
 #if defined(__cplusplus) || defined(c_plusplus)
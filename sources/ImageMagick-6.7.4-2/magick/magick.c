@@ -48,12 +48,14 @@
 #include "magick/coder.h"
 #include "magick/client.h"
 #include "magick/coder.h"
+#include "magick/color.h"
 #include "magick/configure.h"
 #include "magick/constitute.h"
 #include "magick/delegate.h"
 #include "magick/draw.h"
 #include "magick/exception.h"
 #include "magick/exception-private.h"
+#include "magick/hashmap.h"
 #include "magick/locale_.h"
 #include "magick/log.h"
 #include "magick/magic.h"
@@ -77,6 +79,7 @@
 #include "magick/thread_.h"
 #include "magick/thread-private.h"
 #include "magick/token.h"
+#include "magick/type.h"
 #include "magick/utility.h"
 #include "magick/xwindow-private.h"
 
@@ -101,6 +104,19 @@
 */
 typedef MAGICKCORE_RETSIGTYPE
   SignalHandler(int);
+
+typedef struct _MagickMapInfo
+{
+  const MagickInfo
+    **entries;
+
+  size_t
+    extent,
+    generation;
+
+  struct _MagickMapInfo
+    *previous;
+} MagickMapInfo;
 
 /*
   Global declarations.
@@ -114,7 +130,17 @@ static SignalHandler
 static SplayTreeInfo
   *magick_list = (SplayTreeInfo *) NULL;
 
+static LinkedListInfo
+  *magick_retired = (LinkedListInfo *) NULL;
+
+static MagickMapInfo
+  *volatile magick_map = (MagickMapInfo *) NULL;
+
+static volatile size_t
+  magick_generation = 0;
+
 static volatile MagickBooleanType
+  fork_handlers = MagickFalse,
   instantiate_magick = MagickFalse,
   instantiate_magickcore = MagickFalse;
 
@@ -374,6 +400,86 @@ MagickExport MagickBooleanType GetMagickEndianSupport(
   return(magick_info->endian_support);
 }
 
+static inline const MagickInfo *LookupMagickMap(const MagickMapInfo *map,
+  const char *name)
+{
+  register const MagickInfo
+    *p;
+
+  register size_t
+    i;
+
+  if (map == (const MagickMapInfo *) NULL)
+    return((const MagickInfo *) NULL);
+  for (i=HashLocaleString(name) & (map->extent-1); ;
+       i=(i+1) & (map->extent-1))
+  {
+    p=map->entries[i];
+    if ((p == (const MagickInfo *) NULL) || (LocaleCompare(p->name,name) == 0))
+      break;
+  }
+  return(p);
+}
+
+static void PublishMagickMap(void)
+{
+  MagickMapInfo
+    *map;
+
+  register const MagickInfo
+    *p;
+
+  register size_t
+    i;
+
+  size_t
+    generation,
+    number_entries;
+
+  /*
+    Rebuild the coder hash table if the registry changed since it was last
+    published; the caller holds magick_semaphore.  Tables are never modified
+    once published and superseded tables are retained until the magick
+    component terminus, since a lock-free reader may still be probing them.
+  */
+  generation=magick_generation;
+  map=magick_map;
+  if ((map != (MagickMapInfo *) NULL) && (map->generation == generation))
+    return;
+  map=(MagickMapInfo *) AcquireMagickMemory(sizeof(*map));
+  if (map == (MagickMapInfo *) NULL)
+    return;
+  number_entries=GetNumberOfNodesInSplayTree(magick_list);
+  for (map->extent=16; map->extent < (2*number_entries+1); map->extent<<=1) ;
+  map->entries=(const MagickInfo **) AcquireQuantumMemory(map->extent,
+    sizeof(*map->entries));
+  if (map->entries == (const MagickInfo **) NULL)
+    {
+      map=(MagickMapInfo *) RelinquishMagickMemory(map);
+      return;
+    }
+  (void) ResetMagickMemory((void *) map->entries,0,map->extent*
+    sizeof(*map->entries));
+  map->generation=generation;
+  ResetSplayTreeIterator(magick_list);
+  p=(const MagickInfo *) GetNextValueInSplayTree(magick_list);
+  for ( ; p != (const MagickInfo *) NULL; )
+  {
+    for (i=HashLocaleString(p->name) & (map->extent-1);
+         map->entries[i] != (const MagickInfo *) NULL;
+         i=(i+1) & (map->extent-1)) ;
+    map->entries[i]=p;
+    p=(const MagickInfo *) GetNextValueInSplayTree(magick_list);
+  }
+  map->previous=magick_map;
+#if defined(__GNUC__)
+  __sync_synchronize();
+#elif defined(MAGICKCORE_WINDOWS_SUPPORT)
+  MemoryBarrier();
+#endif
+  magick_map=map;
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -403,6 +509,9 @@ MagickExport MagickBooleanType GetMagickEndianSupport(
 MagickExport const MagickInfo *GetMagickInfo(const char *name,
   ExceptionInfo *exception)
 {
+  const MagickMapInfo
+    *map;
+
   register const MagickInfo
     *p;
 
@@ -424,32 +533,27 @@ MagickExport const MagickInfo *GetMagickInfo(const char *name,
       return(p);
     }
   /*
-    Find name in list.
+    Find name in the published coder table without locking; fall back to the
+    locked path only on a miss or when coders were registered since.
   */
+  map=magick_map;
+  if ((map != (const MagickMapInfo *) NULL) &&
+      (map->generation == magick_generation))
+    {
+      p=LookupMagickMap(map,name);
+      if (p != (const MagickInfo *) NULL)
+        return(p);
+    }
   LockSemaphoreInfo(magick_semaphore);
-  ResetSplayTreeIterator(magick_list);
-  p=(const MagickInfo *) GetNextValueInSplayTree(magick_list);
-  while (p != (const MagickInfo *) NULL)
-  {
-    if (LocaleCompare(p->name,name) == 0)
-      break;
-    p=(const MagickInfo *) GetNextValueInSplayTree(magick_list);
-  }
+  p=(const MagickInfo *) GetValueFromSplayTree(magick_list,name);
 #if defined(MAGICKCORE_MODULES_SUPPORT)
-  if (p == (const MagickInfo *) NULL)
+  if ((p == (const MagickInfo *) NULL) && (*name != '\0'))
     {
-      if (*name != '\0')
-        (void) OpenModule(name,exception);
-      ResetSplayTreeIterator(magick_list);
-      p=(const MagickInfo *) GetNextValueInSplayTree(magick_list);
-      while (p != (const MagickInfo *) NULL)
-      {
-        if (LocaleCompare(p->name,name) == 0)
-          break;
-        p=(const MagickInfo *) GetNextValueInSplayTree(magick_list);
-      }
+      (void) OpenModule(name,exception);
+      p=(const MagickInfo *) GetValueFromSplayTree(magick_list,name);
     }
 #endif
+  PublishMagickMap();
   UnlockSemaphoreInfo(magick_semaphore);
   return(p);
 }
@@ -836,7 +940,9 @@ static MagickBooleanType InitializeMagickList(ExceptionInfo *exception)
 
           magick_list=NewSplayTree(CompareSplayTreeString,
             (void *(*)(void *)) NULL,DestroyMagickNode);
-          if (magick_list == (SplayTreeInfo *) NULL)
+          magick_retired=NewLinkedList(0);
+          if ((magick_list == (SplayTreeInfo *) NULL) ||
+              (magick_retired == (LinkedListInfo *) NULL))
             ThrowFatalException(ResourceLimitFatalError,
               "MemoryAllocationFailed");
           magick_info=SetMagickInfo("ephemeral");
@@ -1085,16 +1191,157 @@ MagickExport MagickBooleanType MagickComponentGenesis(void)
 */
 MagickExport void MagickComponentTerminus(void)
 {
+  MagickMapInfo
+    *map;
+
   if (magick_semaphore == (SemaphoreInfo *) NULL)
     AcquireSemaphoreInfo(&magick_semaphore);
   LockSemaphoreInfo(magick_semaphore);
+  while (magick_map != (MagickMapInfo *) NULL)
+  {
+    map=magick_map;
+    magick_map=map->previous;
+    map->entries=(const MagickInfo **) RelinquishMagickMemory((void *)
+      map->entries);
+    map=(MagickMapInfo *) RelinquishMagickMemory(map);
+  }
   if (magick_list != (SplayTreeInfo *) NULL)
     magick_list=DestroySplayTree(magick_list);
+  if (magick_retired != (LinkedListInfo *) NULL)
+    magick_retired=DestroyLinkedList(magick_retired,DestroyMagickNode);
   instantiate_magick=MagickFalse;
   UnlockSemaphoreInfo(magick_semaphore);
   DestroySemaphoreInfo(&magick_semaphore);
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%   M a g i c k C o r e F o r k C h i l d                                     %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  MagickCoreForkChild() releases the locks taken by MagickCoreForkPrepare()
+%  in the child process and resets the per-process state the child must not
+%  share with its parent.  The configuration, policies and registered coders
+%  remain shared with the parent copy-on-write.
+%
+%  The child is limited to a single thread.  The GNU OpenMP runtime does not
+%  survive a fork(): once the parent has run a parallel region, a child that
+%  starts a parallel region with more than one thread waits forever for the
+%  parent's worker threads.  Raise the limit with SetMagickResourceLimit()
+%  only if the parent has not run one.
+%
+%  The format of the MagickCoreForkChild method is:
+%
+%      MagickCoreForkChild(void)
+%
+*/
+MagickExport void MagickCoreForkChild(void)
+{
+  if (instantiate_magickcore != MagickFalse)
+    {
+      LogComponentForkChild();
+      ResourceComponentForkChild();
+      CacheComponentForkChild();
+      MagicComponentForkChild();
+      PolicyComponentForkChild();
+      ColorComponentForkChild();
+      TypeComponentForkChild();
+      RandomComponentForkChild();
+      ModuleComponentForkChild();
+      UnlockSemaphoreInfo(magick_semaphore);
+      (void) SetMagickResourceLimit(ThreadResource,1);
+    }
+  UnlockMagickMutex();
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%   M a g i c k C o r e F o r k P a r e n t                                   %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  MagickCoreForkParent() releases the locks taken by MagickCoreForkPrepare()
+%  in the parent process.
+%
+%  The format of the MagickCoreForkParent method is:
+%
+%      MagickCoreForkParent(void)
+%
+*/
+MagickExport void MagickCoreForkParent(void)
+{
+  if (instantiate_magickcore != MagickFalse)
+    {
+      LogComponentForkParent();
+      ResourceComponentForkParent();
+      CacheComponentForkParent();
+      MagicComponentForkParent();
+      PolicyComponentForkParent();
+      ColorComponentForkParent();
+      TypeComponentForkParent();
+      RandomComponentForkParent();
+      ModuleComponentForkParent();
+      UnlockSemaphoreInfo(magick_semaphore);
+    }
+  UnlockMagickMutex();
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%   M a g i c k C o r e F o r k P r e p a r e                                 %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  MagickCoreForkPrepare() quiesces the MagickCore environment before a fork()
+%  so that neither process inherits a lock held in the middle of an update.
+%  Call it immediately before fork() and MagickCoreForkParent() or
+%  MagickCoreForkChild() immediately after, or let RegisterMagickForkHandlers()
+%  arrange that.
+%
+%  The format of the MagickCoreForkPrepare method is:
+%
+%      MagickCoreForkPrepare(void)
+%
+*/
+MagickExport void MagickCoreForkPrepare(void)
+{
+  /*
+    Take the component locks outermost first, the order they nest in: a coder
+    lookup holds the coder registry while it opens a module, the type
+    component consults the policy, and most components log.  The components
+    release them in the reverse order.
+  */
+  LockMagickMutex();
+  if (instantiate_magickcore == MagickFalse)
+    return;
+  LockSemaphoreInfo(magick_semaphore);
+  ModuleComponentForkPrepare();
+  RandomComponentForkPrepare();
+  TypeComponentForkPrepare();
+  ColorComponentForkPrepare();
+  PolicyComponentForkPrepare();
+  MagicComponentForkPrepare();
+  CacheComponentForkPrepare();
+  ResourceComponentForkPrepare();
+  LogComponentForkPrepare();
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -1122,6 +1369,58 @@ MagickExport void MagickComponentTerminus(void)
 %
 */
 
+static void PreloadMagickCoders(void)
+{
+  char
+    *coders,
+    name[MaxTextExtent];
+
+  ExceptionInfo
+    *exception;
+
+  register char
+    *q;
+
+  register const char
+    *p;
+
+  /*
+    Load and register the coders named by MAGICK_PRELOAD_CODERS (or the
+    preload-coders policy) up front, so a server that forks workers after
+    genesis shares the registry and the published coder table with them and
+    never searches the module path for those formats again.
+  */
+  coders=GetEnvironmentValue("MAGICK_PRELOAD_CODERS");
+  if (coders == (char *) NULL)
+    coders=GetPolicyValue("preload-coders");
+  if (coders == (char *) NULL)
+    return;
+  exception=AcquireExceptionInfo();
+  p=coders;
+  while (*p != '\0')
+  {
+    while ((isspace((int) ((unsigned char) *p)) != 0) || (*p == ','))
+      p++;
+    q=name;
+    while ((*p != '\0') && (*p != ',') &&
+           (isspace((int) ((unsigned char) *p)) == 0) &&
+           (q < (name+MaxTextExtent-1)))
+      *q++=(*p++);
+    *q='\0';
+    if (*name == '\0')
+      continue;
+    (void) LogMagickEvent(ModuleEvent,GetMagickModule(),
+      "Preloading coder \"%s\"",name);
+    (void) GetMagickInfo(name,exception);
+  }
+  LockSemaphoreInfo(magick_semaphore);
+  PublishMagickMap();
+  UnlockSemaphoreInfo(magick_semaphore);
+  CatchException(exception);
+  exception=DestroyExceptionInfo(exception);
+  coders=DestroyString(coders);
+}
+
 static SignalHandler *SetMagickSignalHandler(int signal_number,
   SignalHandler *handler)
 {
@@ -1347,6 +1646,7 @@ MagickExport void MagickCoreGenesis(const char *path,
 #if defined(MAGICKCORE_X11_DELEGATE)
   (void) XComponentGenesis();
 #endif
+  PreloadMagickCoders();
   instantiate_magickcore=MagickTrue;
   UnlockMagickMutex();
 }
@@ -1411,6 +1711,50 @@ MagickExport void MagickCoreTerminus(void)
   UnlockMagickMutex();
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%   R e g i s t e r M a g i c k F o r k H a n d l e r s                       %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  RegisterMagickForkHandlers() installs MagickCoreForkPrepare(),
+%  MagickCoreForkParent() and MagickCoreForkChild() as pthread_atfork()
+%  handlers.  A preforking server calls it once after MagickCoreGenesis() so
+%  its workers inherit a ready MagickCore environment instead of initializing
+%  their own.  It returns MagickFalse if the handlers cannot be installed.
+%
+%  The format of the RegisterMagickForkHandlers method is:
+%
+%      MagickBooleanType RegisterMagickForkHandlers(void)
+%
+*/
+MagickExport MagickBooleanType RegisterMagickForkHandlers(void)
+{
+#if defined(MAGICKCORE_THREAD_SUPPORT)
+  int
+    status;
+
+  status=0;
+  LockMagickMutex();
+  if (fork_handlers == MagickFalse)
+    {
+      status=pthread_atfork(MagickCoreForkPrepare,MagickCoreForkParent,
+        MagickCoreForkChild);
+      if (status == 0)
+        fork_handlers=MagickTrue;
+    }
+  UnlockMagickMutex();
+  return(status == 0 ? MagickTrue : MagickFalse);
+#else
+  return(MagickFalse);
+#endif
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -1442,17 +1786,24 @@ MagickExport MagickInfo *RegisterMagickInfo(MagickInfo *magick_info)
   MagickBooleanType
     status;
 
+  MagickInfo
+    *p;
+
   /*
-    Delete any existing name.
+    Retire any existing name; GetMagickInfo() readers may still hold it.
   */
   assert(magick_info != (MagickInfo *) NULL);
   assert(magick_info->signature == MagickSignature);
   (void) LogMagickEvent(TraceEvent,GetMagickModule(),"%s",magick_info->name);
   if (magick_list == (SplayTreeInfo *) NULL)
     return((MagickInfo *) NULL);
+  p=(MagickInfo *) RemoveNodeFromSplayTree(magick_list,magick_info->name);
+  if ((p != (MagickInfo *) NULL) && (p != magick_info))
+    (void) AppendValueToLinkedList(magick_retired,p);
   status=AddValueToSplayTree(magick_list,magick_info->name,magick_info);
   if (status == MagickFalse)
     ThrowFatalException(ResourceLimitFatalError,"MemoryAllocationFailed");
+  magick_generation++;
   return(magick_info);
 }
 
@@ -1583,7 +1934,17 @@ MagickExport MagickBooleanType UnregisterMagickInfo(const char *name)
       break;
     p=(const MagickInfo *) GetNextValueInSplayTree(magick_list);
   }
-  status=DeleteNodeByValueFromSplayTree(magick_list,p);
+  status=MagickFalse;
+  if ((p != (const MagickInfo *) NULL) &&
+      (RemoveNodeByValueFromSplayTree(magick_list,p) != (void *) NULL))
+    {
+      /*
+        Retire rather than free: GetMagickInfo() readers may still hold it.
+      */
+      (void) AppendValueToLinkedList(magick_retired,(void *) p);
+      magick_generation++;
+      status=MagickTrue;
+    }
   UnlockSemaphoreInfo(magick_semaphore);
   return(status);
 }
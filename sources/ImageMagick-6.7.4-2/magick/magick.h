@@ -118,6 +118,7 @@ extern MagickExport MagickBooleanType
   GetMagickSeekableStream(const MagickInfo *),
   IsMagickInstantiated(void),
   MagickComponentGenesis(void),
+  RegisterMagickForkHandlers(void),
   UnregisterMagickInfo(const char *);
 
 extern const MagickExport MagickInfo
@@ -133,6 +134,9 @@ extern MagickExport MagickStatusType
 
 extern MagickExport void
   MagickComponentTerminus(void),
+  MagickCoreForkChild(void),
+  MagickCoreForkParent(void),
+  MagickCoreForkPrepare(void),
   MagickCoreGenesis(const char *,const MagickBooleanType),
   MagickCoreTerminus(void);
 
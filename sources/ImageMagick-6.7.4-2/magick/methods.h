@@ -130,6 +130,9 @@ extern "C" {
 #define BorderImage  PrependMagickMethod(BorderImage)
 #define BrightnessContrastImageChannel  PrependMagickMethod(BrightnessContrastImageChannel)
 #define BrightnessContrastImage  PrependMagickMethod(BrightnessContrastImage)
+#define CacheComponentForkChild  PrependMagickMethod(CacheComponentForkChild)
+#define CacheComponentForkParent  PrependMagickMethod(CacheComponentForkParent)
+#define CacheComponentForkPrepare  PrependMagickMethod(CacheComponentForkPrepare)
 #define CacheComponentGenesis  PrependMagickMethod(CacheComponentGenesis)
 #define CacheComponentTerminus  PrependMagickMethod(CacheComponentTerminus)
 #define CanonicalXMLContent  PrependMagickMethod(CanonicalXMLContent)
@@ -175,6 +178,9 @@ extern "C" {
 #define CoalesceImages  PrependMagickMethod(CoalesceImages)
 #define CoderComponentGenesis  PrependMagickMethod(CoderComponentGenesis)
 #define CoderComponentTerminus  PrependMagickMethod(CoderComponentTerminus)
+#define ColorComponentForkChild  PrependMagickMethod(ColorComponentForkChild)
+#define ColorComponentForkParent  PrependMagickMethod(ColorComponentForkParent)
+#define ColorComponentForkPrepare  PrependMagickMethod(ColorComponentForkPrepare)
 #define ColorComponentGenesis  PrependMagickMethod(ColorComponentGenesis)
 #define ColorComponentTerminus  PrependMagickMethod(ColorComponentTerminus)
 #define ColorDecisionListImage  PrependMagickMethod(ColorDecisionListImage)
@@ -720,15 +726,24 @@ extern "C" {
 #define LocaleNCompare  PrependMagickMethod(LocaleNCompare)
 #define LocaleUpper  PrependMagickMethod(LocaleUpper)
 #define LockSemaphoreInfo  PrependMagickMethod(LockSemaphoreInfo)
+#define LogComponentForkChild  PrependMagickMethod(LogComponentForkChild)
+#define LogComponentForkParent  PrependMagickMethod(LogComponentForkParent)
+#define LogComponentForkPrepare  PrependMagickMethod(LogComponentForkPrepare)
 #define LogComponentGenesis  PrependMagickMethod(LogComponentGenesis)
 #define LogComponentTerminus  PrependMagickMethod(LogComponentTerminus)
 #define LogMagickEventList  PrependMagickMethod(LogMagickEventList)
 #define LogMagickEvent  PrependMagickMethod(LogMagickEvent)
 #define LZWEncodeImage  PrependMagickMethod(LZWEncodeImage)
+#define MagicComponentForkChild  PrependMagickMethod(MagicComponentForkChild)
+#define MagicComponentForkParent  PrependMagickMethod(MagicComponentForkParent)
+#define MagicComponentForkPrepare  PrependMagickMethod(MagicComponentForkPrepare)
 #define MagicComponentGenesis  PrependMagickMethod(MagicComponentGenesis)
 #define MagicComponentTerminus  PrependMagickMethod(MagicComponentTerminus)
 #define MagickComponentGenesis  PrependMagickMethod(MagickComponentGenesis)
 #define MagickComponentTerminus  PrependMagickMethod(MagickComponentTerminus)
+#define MagickCoreForkChild  PrependMagickMethod(MagickCoreForkChild)
+#define MagickCoreForkParent  PrependMagickMethod(MagickCoreForkParent)
+#define MagickCoreForkPrepare  PrependMagickMethod(MagickCoreForkPrepare)
 #define MagickCoreGenesis  PrependMagickMethod(MagickCoreGenesis)
 #define MagickCoreTerminus  PrependMagickMethod(MagickCoreTerminus)
 #define MagickCreateThreadKey  PrependMagickMethod(MagickCreateThreadKey)
@@ -755,6 +770,9 @@ extern "C" {
 #define MinMaxStretchImage  PrependMagickMethod(MinMaxStretchImage)
 #define ModifyImage  PrependMagickMethod(ModifyImage)
 #define ModulateImage  PrependMagickMethod(ModulateImage)
+#define ModuleComponentForkChild  PrependMagickMethod(ModuleComponentForkChild)
+#define ModuleComponentForkParent  PrependMagickMethod(ModuleComponentForkParent)
+#define ModuleComponentForkPrepare  PrependMagickMethod(ModuleComponentForkPrepare)
 #define MontageImageList  PrependMagickMethod(MontageImageList)
 #define MontageImages  PrependMagickMethod(MontageImages)
 #define MorphImages  PrependMagickMethod(MorphImages)
@@ -816,6 +834,9 @@ extern "C" {
 #define PlasmaImage  PrependMagickMethod(PlasmaImage)
 #define PlasmaImageProxy  PrependMagickMethod(PlasmaImageProxy)
 #define PolaroidImage  PrependMagickMethod(PolaroidImage)
+#define PolicyComponentForkChild  PrependMagickMethod(PolicyComponentForkChild)
+#define PolicyComponentForkParent  PrependMagickMethod(PolicyComponentForkParent)
+#define PolicyComponentForkPrepare  PrependMagickMethod(PolicyComponentForkPrepare)
 #define PolicyComponentGenesis  PrependMagickMethod(PolicyComponentGenesis)
 #define PolicyComponentTerminus  PrependMagickMethod(PolicyComponentTerminus)
 #define PopImageList  PrependMagickMethod(PopImageList)
@@ -845,6 +866,9 @@ extern "C" {
 #define RadialBlurImage  PrependMagickMethod(RadialBlurImage)
 #define RaiseImage  PrependMagickMethod(RaiseImage)
 #define RandomChannelThresholdImage  PrependMagickMethod(RandomChannelThresholdImage)
+#define RandomComponentForkChild  PrependMagickMethod(RandomComponentForkChild)
+#define RandomComponentForkParent  PrependMagickMethod(RandomComponentForkParent)
+#define RandomComponentForkPrepare  PrependMagickMethod(RandomComponentForkPrepare)
 #define RandomComponentGenesis  PrependMagickMethod(RandomComponentGenesis)
 #define RandomComponentTerminus  PrependMagickMethod(RandomComponentTerminus)
 #define RandomThresholdImageChannel  PrependMagickMethod(RandomThresholdImageChannel)
@@ -908,6 +932,7 @@ extern "C" {
 #define RegisterLABELImage  PrependMagickMethod(RegisterLABELImage)
 #define RegisterMCPImage  PrependMagickMethod(RegisterMACImage)
 #define RegisterMAGICKImage  PrependMagickMethod(RegisterMAGICKImage)
+#define RegisterMagickForkHandlers  PrependMagickMethod(RegisterMagickForkHandlers)
 #define RegisterMagickInfo  PrependMagickMethod(RegisterMagickInfo)
 #define RegisterMAPImage  PrependMagickMethod(RegisterMAPImage)
 #define RegisterMATImage  PrependMagickMethod(RegisterMATImage)
@@ -1026,6 +1051,9 @@ extern "C" {
 #define ResizeImage  PrependMagickMethod(ResizeImage)
 #define ResizeMagickMemory  PrependMagickMethod(ResizeMagickMemory)
 #define ResizeQuantumMemory  PrependMagickMethod(ResizeQuantumMemory)
+#define ResourceComponentForkChild  PrependMagickMethod(ResourceComponentForkChild)
+#define ResourceComponentForkParent  PrependMagickMethod(ResourceComponentForkParent)
+#define ResourceComponentForkPrepare  PrependMagickMethod(ResourceComponentForkPrepare)
 #define ResourceComponentGenesis  PrependMagickMethod(ResourceComponentGenesis)
 #define ResourceComponentTerminus  PrependMagickMethod(ResourceComponentTerminus)
 #define ReverseImageList  PrependMagickMethod(ReverseImageList)
@@ -1123,6 +1151,7 @@ extern "C" {
 #define SetXMLTreeContent  PrependMagickMethod(SetXMLTreeContent)
 #define ShadeImage  PrependMagickMethod(ShadeImage)
 #define ShadowImage  PrependMagickMethod(ShadowImage)
+#define ShareSplayTree  PrependMagickMethod(ShareSplayTree)
 #define SharpenImageChannel  PrependMagickMethod(SharpenImageChannel)
 #define SharpenImage  PrependMagickMethod(SharpenImage)
 #define ShaveImage  PrependMagickMethod(ShaveImage)
@@ -1196,6 +1225,9 @@ extern "C" {
 #define TransposeImage  PrependMagickMethod(TransposeImage)
 #define TransverseImage  PrependMagickMethod(TransverseImage)
 #define TrimImage  PrependMagickMethod(TrimImage)
+#define TypeComponentForkChild  PrependMagickMethod(TypeComponentForkChild)
+#define TypeComponentForkParent  PrependMagickMethod(TypeComponentForkParent)
+#define TypeComponentForkPrepare  PrependMagickMethod(TypeComponentForkPrepare)
 #define TypeComponentGenesis  PrependMagickMethod(TypeComponentGenesis)
 #define TypeComponentTerminus  PrependMagickMethod(TypeComponentTerminus)
 #define UniqueImageColors  PrependMagickMethod(UniqueImageColors)
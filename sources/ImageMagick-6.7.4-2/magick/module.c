@@ -1135,6 +1135,80 @@ MagickExport MagickBooleanType ListModuleInfo(FILE *file,
   return(MagickTrue);
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   M o d u l e C o m p o n e n t F o r k C h i l d                           %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ModuleComponentForkChild() releases the module component in the child
+%  process after a fork().
+%
+%  The format of the ModuleComponentForkChild method is:
+%
+%      ModuleComponentForkChild(void)
+%
+*/
+MagickExport void ModuleComponentForkChild(void)
+{
+  UnlockSemaphoreInfo(module_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   M o d u l e C o m p o n e n t F o r k P a r e n t                         %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ModuleComponentForkParent() releases the module component in the parent
+%  process after a fork().
+%
+%  The format of the ModuleComponentForkParent method is:
+%
+%      ModuleComponentForkParent(void)
+%
+*/
+MagickExport void ModuleComponentForkParent(void)
+{
+  UnlockSemaphoreInfo(module_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   M o d u l e C o m p o n e n t F o r k P r e p a r e                       %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ModuleComponentForkPrepare() locks the module component before a fork(),
+%  including any module being opened.
+%
+%  The format of the ModuleComponentForkPrepare method is:
+%
+%      ModuleComponentForkPrepare(void)
+%
+*/
+MagickExport void ModuleComponentForkPrepare(void)
+{
+  if (module_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&module_semaphore);
+  LockSemaphoreInfo(module_semaphore);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -1254,8 +1328,16 @@ MagickExport MagickBooleanType OpenModule(const char *module,
   p=GetCoderInfo(module,exception);
   if (p != (CoderInfo *) NULL)
     (void) CopyMagickString(module_name,p->name,MaxTextExtent);
+  /*
+    Hold the module lock until the module is registered so a fork() never
+    catches a module half loaded.
+  */
+  LockSemaphoreInfo(module_semaphore);
   if (GetValueFromSplayTree(module_list,module_name) != (void *) NULL)
-    return(MagickTrue);  /* module already opened, return */
+    {
+      UnlockSemaphoreInfo(module_semaphore);
+      return(MagickTrue);  /* module already opened, return */
+    }
   /*
     Locate module.
   */
@@ -1266,7 +1348,10 @@ MagickExport MagickBooleanType OpenModule(const char *module,
   *path='\0';
   status=GetMagickModulePath(filename,MagickImageCoderModule,path,exception);
   if (status == MagickFalse)
-    return(MagickFalse);
+    {
+      UnlockSemaphoreInfo(module_semaphore);
+      return(MagickFalse);
+    }
   /*
     Load module
   */
@@ -1277,6 +1362,7 @@ MagickExport MagickBooleanType OpenModule(const char *module,
     {
       (void) ThrowMagickException(exception,GetMagickModule(),ModuleError,
         "UnableToLoadModule","`%s': %s",path,lt_dlerror());
+      UnlockSemaphoreInfo(module_semaphore);
       return(MagickFalse);
     }
   /*
@@ -1285,7 +1371,10 @@ MagickExport MagickBooleanType OpenModule(const char *module,
   module_info=AcquireModuleInfo(path,module_name);
   module_info->handle=handle;
   if (RegisterModule(module_info,exception) == (ModuleInfo *) NULL)
-    return(MagickFalse);
+    {
+      UnlockSemaphoreInfo(module_semaphore);
+      return(MagickFalse);
+    }
   /*
     Define RegisterFORMATImage method.
   */
@@ -1295,6 +1384,7 @@ MagickExport MagickBooleanType OpenModule(const char *module,
     {
       (void) ThrowMagickException(exception,GetMagickModule(),ModuleError,
         "UnableToRegisterImageFormat","`%s': %s",module_name,lt_dlerror());
+      UnlockSemaphoreInfo(module_semaphore);
       return(MagickFalse);
     }
   (void) LogMagickEvent(ModuleEvent,GetMagickModule(),
@@ -1309,6 +1399,7 @@ MagickExport MagickBooleanType OpenModule(const char *module,
     {
       (void) ThrowMagickException(exception,GetMagickModule(),ModuleError,
         "UnableToRegisterImageFormat","`%s': %s",module_name,lt_dlerror());
+      UnlockSemaphoreInfo(module_semaphore);
       return(MagickFalse);
     }
   (void) LogMagickEvent(ModuleEvent,GetMagickModule(),
@@ -1320,8 +1411,10 @@ MagickExport MagickBooleanType OpenModule(const char *module,
       (void) ThrowMagickException(exception,GetMagickModule(),ModuleError,
         "ImageCoderSignatureMismatch","`%s': %8lx != %8lx",module_name,
         (unsigned long) signature,(unsigned long) MagickImageCoderSignature);
+      UnlockSemaphoreInfo(module_semaphore);
       return(MagickFalse);
     }
+  UnlockSemaphoreInfo(module_semaphore);
   return(MagickTrue);
 }
 
@@ -86,6 +86,9 @@ extern MagickExport ModuleInfo
 
 extern MagickExport void
   DestroyModuleList(void),
+  ModuleComponentForkChild(void),
+  ModuleComponentForkParent(void),
+  ModuleComponentForkPrepare(void),
   ModuleComponentTerminus(void),
   RegisterStaticModules(void),
   UnregisterStaticModules(void);
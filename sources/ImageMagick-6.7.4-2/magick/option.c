@@ -923,6 +923,7 @@ static const OptionInfo
     { "Undefined", UndefinedDitherMethod, UndefinedOptionFlag, MagickTrue },
     { "None", NoDitherMethod, UndefinedOptionFlag, MagickFalse },
     { "FloydSteinberg", FloydSteinbergDitherMethod, UndefinedOptionFlag, MagickFalse },
+    { "Ordered", OrderedDitherMethod, UndefinedOptionFlag, MagickFalse },
     { "Riemersma", RiemersmaDitherMethod, UndefinedOptionFlag, MagickFalse },
     { (char *) NULL, UndefinedEndian, UndefinedOptionFlag, MagickFalse }
   },
@@ -1523,6 +1524,7 @@ static const OptionInfo
     { "Identify", IdentifyValidate, UndefinedOptionFlag, MagickFalse },
     { "ImportExport", ImportExportValidate, UndefinedOptionFlag, MagickFalse },
     { "Montage", MontageValidate, UndefinedOptionFlag, MagickFalse },
+    { "Properties", PropertiesValidate, UndefinedOptionFlag, MagickFalse },
     { "Stream", StreamValidate, UndefinedOptionFlag, MagickFalse },
     { "None", NoValidate, UndefinedOptionFlag, MagickFalse },
     { (char *) NULL, UndefinedValidate, UndefinedOptionFlag, MagickFalse }
@@ -1560,7 +1562,8 @@ static const OptionInfo
 %                                                                             %
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %
-%  CloneImageOptions() clones one or more image options.
+%  CloneImageOptions() clones one or more image options.  The option strings
+%  are shared with the clone rather than copied.
 %
 %  The format of the CloneImageOptions method is:
 %
@@ -1585,7 +1588,7 @@ MagickExport MagickBooleanType CloneImageOptions(ImageInfo *image_info,
   assert(clone_info != (const ImageInfo *) NULL);
   assert(clone_info->signature == MagickSignature);
   if (clone_info->options != (void *) NULL)
-    image_info->options=CloneSplayTree((SplayTreeInfo *) clone_info->options,
+    image_info->options=ShareSplayTree((SplayTreeInfo *) clone_info->options,
       (void *(*)(void *)) ConstantString,(void *(*)(void *)) ConstantString);
   return(MagickTrue);
 }
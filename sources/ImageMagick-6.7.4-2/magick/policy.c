@@ -116,12 +116,21 @@ static const PolicyMapInfo
       (const char *) NULL, (const char *) NULL }
   };
 
+static const PolicyInfo
+  **policy_rules = (const PolicyInfo **) NULL;
+
 static LinkedListInfo
   *policy_list = (LinkedListInfo *) NULL;
 
+static MagickBooleanType
+  *policy_literals = (MagickBooleanType *) NULL;
+
 static SemaphoreInfo
   *policy_semaphore = (SemaphoreInfo *) NULL;
 
+static size_t
+  policy_bucket[SystemPolicyDomain+2];
+
 static volatile MagickBooleanType
   instantiate_policy = MagickFalse;
 
@@ -420,6 +429,85 @@ MagickExport char *GetPolicyValue(const char *name)
 %    o exception: return any errors or warnings in this structure.
 %
 */
+static void CompilePolicyList(void)
+{
+  const PolicyInfo
+    *p;
+
+  register ssize_t
+    i;
+
+  size_t
+    number_policies;
+
+  ssize_t
+    j;
+
+  /*
+    Group the policies by domain so a rights check only visits the rules of
+    its own domain, and note which patterns are plain strings that need no
+    glob evaluation.
+  */
+  (void) ResetMagickMemory(policy_bucket,0,sizeof(policy_bucket));
+  number_policies=GetNumberOfElementsInLinkedList(policy_list);
+  if (number_policies == 0)
+    return;
+  policy_rules=(const PolicyInfo **) AcquireQuantumMemory(number_policies,
+    sizeof(*policy_rules));
+  policy_literals=(MagickBooleanType *) AcquireQuantumMemory(number_policies,
+    sizeof(*policy_literals));
+  if ((policy_rules == (const PolicyInfo **) NULL) ||
+      (policy_literals == (MagickBooleanType *) NULL))
+    {
+      if (policy_literals != (MagickBooleanType *) NULL)
+        policy_literals=(MagickBooleanType *) RelinquishMagickMemory(
+          policy_literals);
+      if (policy_rules != (const PolicyInfo **) NULL)
+        policy_rules=(const PolicyInfo **) RelinquishMagickMemory((void *)
+          policy_rules);
+      return;
+    }
+  ResetLinkedListIterator(policy_list);
+  p=(const PolicyInfo *) GetNextValueInLinkedList(policy_list);
+  while (p != (const PolicyInfo *) NULL)
+  {
+    if ((p->domain >= UndefinedPolicyDomain) &&
+        (p->domain <= SystemPolicyDomain))
+      policy_bucket[p->domain+1]++;
+    p=(const PolicyInfo *) GetNextValueInLinkedList(policy_list);
+  }
+  for (j=1; j <= (ssize_t) (SystemPolicyDomain+1); j++)
+    policy_bucket[j]+=policy_bucket[j-1];
+  ResetLinkedListIterator(policy_list);
+  p=(const PolicyInfo *) GetNextValueInLinkedList(policy_list);
+  while (p != (const PolicyInfo *) NULL)
+  {
+    if ((p->domain >= UndefinedPolicyDomain) &&
+        (p->domain <= SystemPolicyDomain))
+      {
+        register const char
+          *q;
+
+        i=(ssize_t) policy_bucket[p->domain]++;
+        policy_rules[i]=p;
+        policy_literals[i]=MagickFalse;
+        if ((p->pattern != (char *) NULL) && (*p->pattern != '\0') &&
+            (strcmp(p->pattern,"*") != 0))
+          {
+            for (q=p->pattern; *q != '\0'; q++)
+              if ((((unsigned char) *q) >= 0x80) ||
+                  (strchr("*?[{\\",*q) != (char *) NULL))
+                break;
+            policy_literals[i]=(*q == '\0') ? MagickTrue : MagickFalse;
+          }
+      }
+    p=(const PolicyInfo *) GetNextValueInLinkedList(policy_list);
+  }
+  for (j=(ssize_t) (SystemPolicyDomain+1); j > 0; j--)
+    policy_bucket[j]=policy_bucket[j-1];
+  policy_bucket[0]=0;
+}
+
 static MagickBooleanType InitializePolicyList(ExceptionInfo *exception)
 {
   if ((policy_list == (LinkedListInfo *) NULL) &&
@@ -432,6 +520,8 @@ static MagickBooleanType InitializePolicyList(ExceptionInfo *exception)
           (instantiate_policy == MagickFalse))
         {
           (void) LoadPolicyLists(PolicyFilename,exception);
+          if (policy_list != (LinkedListInfo *) NULL)
+            CompilePolicyList();
           instantiate_policy=MagickTrue;
         }
       UnlockSemaphoreInfo(policy_semaphore);
@@ -470,35 +560,47 @@ static MagickBooleanType InitializePolicyList(ExceptionInfo *exception)
 MagickExport MagickBooleanType IsRightsAuthorized(const PolicyDomain domain,
   const PolicyRights rights,const char *pattern)
 {
-  const PolicyInfo
-    *policy_info;
-
-  ExceptionInfo
-    *exception;
-
   MagickBooleanType
-    authorized;
+    authorized,
+    match;
 
-  register PolicyInfo
+  register const PolicyInfo
     *p;
 
+  register ssize_t
+    i;
+
   (void) LogMagickEvent(PolicyEvent,GetMagickModule(),
     "Domain: %s; rights=%s; pattern=\"%s\" ...",
     CommandOptionToMnemonic(MagickPolicyDomainOptions,domain),
     CommandOptionToMnemonic(MagickPolicyRightsOptions,rights),pattern);
-  exception=AcquireExceptionInfo();
-  policy_info=GetPolicyInfo("*",exception);
-  exception=DestroyExceptionInfo(exception);
-  if (policy_info == (PolicyInfo *) NULL)
+  if ((policy_list == (LinkedListInfo *) NULL) ||
+      (instantiate_policy == MagickFalse))
+    {
+      ExceptionInfo
+        *exception;
+
+      exception=AcquireExceptionInfo();
+      (void) GetPolicyInfo("*",exception);
+      exception=DestroyExceptionInfo(exception);
+    }
+  if ((policy_rules == (const PolicyInfo **) NULL) ||
+      (domain < UndefinedPolicyDomain) || (domain > SystemPolicyDomain))
     return(MagickTrue);
+  /*
+    The compiled rules are immutable once loaded, so no lock is needed.
+  */
   authorized=MagickTrue;
-  LockSemaphoreInfo(policy_semaphore);
-  ResetLinkedListIterator(policy_list);
-  p=(PolicyInfo *) GetNextValueInLinkedList(policy_list);
-  while ((p != (PolicyInfo *) NULL) && (authorized != MagickFalse))
+  for (i=(ssize_t) policy_bucket[domain];
+       (i < (ssize_t) policy_bucket[domain+1]) && (authorized != MagickFalse);
+       i++)
   {
-    if ((p->domain == domain) &&
-        (GlobExpression(pattern,p->pattern,MagickFalse) != MagickFalse))
+    p=policy_rules[i];
+    if (policy_literals[i] != MagickFalse)
+      match=strcmp(pattern,p->pattern) == 0 ? MagickTrue : MagickFalse;
+    else
+      match=GlobExpression(pattern,p->pattern,MagickFalse);
+    if (match != MagickFalse)
       {
         if (((rights & ReadPolicyRights) != 0) &&
             ((p->rights & ReadPolicyRights) == 0))
@@ -510,9 +612,7 @@ MagickExport MagickBooleanType IsRightsAuthorized(const PolicyDomain domain,
             ((p->rights & ExecutePolicyRights) == 0))
           authorized=MagickFalse;
       }
-    p=(PolicyInfo *) GetNextValueInLinkedList(policy_list);
   }
-  UnlockSemaphoreInfo(policy_semaphore);
   return(authorized);
 }
 
@@ -945,6 +1045,79 @@ static MagickBooleanType LoadPolicyLists(const char *filename,
   return(status != 0 ? MagickTrue : MagickFalse);
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   P o l i c y C o m p o n e n t F o r k C h i l d                           %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  PolicyComponentForkChild() releases the policy component in the child
+%  process after a fork().
+%
+%  The format of the PolicyComponentForkChild method is:
+%
+%      PolicyComponentForkChild(void)
+%
+*/
+MagickExport void PolicyComponentForkChild(void)
+{
+  UnlockSemaphoreInfo(policy_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   P o l i c y C o m p o n e n t F o r k P a r e n t                         %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  PolicyComponentForkParent() releases the policy component in the parent
+%  process after a fork().
+%
+%  The format of the PolicyComponentForkParent method is:
+%
+%      PolicyComponentForkParent(void)
+%
+*/
+MagickExport void PolicyComponentForkParent(void)
+{
+  UnlockSemaphoreInfo(policy_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   P o l i c y C o m p o n e n t F o r k P r e p a r e                       %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  PolicyComponentForkPrepare() locks the policy component before a fork().
+%
+%  The format of the PolicyComponentForkPrepare method is:
+%
+%      PolicyComponentForkPrepare(void)
+%
+*/
+MagickExport void PolicyComponentForkPrepare(void)
+{
+  if (policy_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&policy_semaphore);
+  LockSemaphoreInfo(policy_semaphore);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -1014,6 +1187,13 @@ MagickExport void PolicyComponentTerminus(void)
   if (policy_semaphore == (SemaphoreInfo *) NULL)
     AcquireSemaphoreInfo(&policy_semaphore);
   LockSemaphoreInfo(policy_semaphore);
+  if (policy_literals != (MagickBooleanType *) NULL)
+    policy_literals=(MagickBooleanType *) RelinquishMagickMemory(
+      policy_literals);
+  if (policy_rules != (const PolicyInfo **) NULL)
+    policy_rules=(const PolicyInfo **) RelinquishMagickMemory((void *)
+      policy_rules);
+  (void) ResetMagickMemory(policy_bucket,0,sizeof(policy_bucket));
   if (policy_list != (LinkedListInfo *) NULL)
     policy_list=DestroyLinkedList(policy_list,DestroyPolicyElement);
   instantiate_policy=MagickFalse;
@@ -61,6 +61,9 @@ extern MagickExport MagickBooleanType
   PolicyComponentGenesis(void);
 
 extern MagickExport void
+  PolicyComponentForkChild(void),
+  PolicyComponentForkParent(void),
+  PolicyComponentForkPrepare(void),
   PolicyComponentTerminus(void);
 
 #if defined(__cplusplus) || defined(c_plusplus)
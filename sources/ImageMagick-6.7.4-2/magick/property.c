@@ -89,7 +89,8 @@
 %                                                                             %
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %
-%  CloneImageProperties() clones one or more image properties.
+%  CloneImageProperties() clones one or more image properties.  The property
+%  strings are shared with the clone rather than copied.
 %
 %  The format of the CloneImageProperties method is:
 %
@@ -165,7 +166,7 @@ MagickExport MagickBooleanType CloneImageProperties(Image *image,
     {
       if (image->properties != (void *) NULL)
         DestroyImageProperties(image);
-      image->properties=CloneSplayTree((SplayTreeInfo *)
+      image->properties=ShareSplayTree((SplayTreeInfo *)
         clone_image->properties,(void *(*)(void *)) ConstantString,
         (void *(*)(void *)) ConstantString);
     }
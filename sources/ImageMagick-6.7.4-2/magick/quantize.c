@@ -175,6 +175,7 @@
   Include declarations.
 */
 #include "magick/studio.h"
+#include "magick/artifact.h"
 #include "magick/cache-view.h"
 #include "magick/color.h"
 #include "magick/color-private.h"
@@ -197,6 +198,7 @@
 #include "magick/quantum.h"
 #include "magick/string_.h"
 #include "magick/thread-private.h"
+#include "magick/threshold-private.h"
 
 /*
   Define declarations.
@@ -206,6 +208,8 @@
 #else
 #define CacheShift  3
 #endif
+#define ClassifyBlockExtent  65536
+#define ClosestColorCacheLength  4096
 #define ErrorQueueLength  16
 #define MaxNodes  266817
 #define MaxTreeDepth  8
@@ -223,6 +227,15 @@ typedef struct _RealPixelPacket
     opacity;
 } RealPixelPacket;
 
+typedef struct _ClosestColorInfo
+{
+  PixelPacket
+    color;
+
+  ssize_t
+    index;
+} ClosestColorInfo;
+
 typedef struct _NodeInfo
 {
   struct _NodeInfo
@@ -488,6 +501,66 @@ static inline MagickBooleanType IsSameColor(const Image *image,
   return(MagickTrue);
 }
 
+static ClosestColorInfo **DestroyClosestColorThreadSet(
+  ClosestColorInfo **closest_color)
+{
+  register ssize_t
+    i;
+
+  assert(closest_color != (ClosestColorInfo **) NULL);
+  for (i=0; i < (ssize_t) GetOpenMPMaximumThreads(); i++)
+    if (closest_color[i] != (ClosestColorInfo *) NULL)
+      closest_color[i]=(ClosestColorInfo *) RelinquishMagickMemory(
+        closest_color[i]);
+  closest_color=(ClosestColorInfo **) RelinquishMagickMemory(closest_color);
+  return(closest_color);
+}
+
+static ClosestColorInfo **AcquireClosestColorThreadSet(void)
+{
+  ClosestColorInfo
+    **closest_color;
+
+  register ssize_t
+    i,
+    j;
+
+  size_t
+    number_threads;
+
+  number_threads=GetOpenMPMaximumThreads();
+  closest_color=(ClosestColorInfo **) AcquireQuantumMemory(number_threads,
+    sizeof(*closest_color));
+  if (closest_color == (ClosestColorInfo **) NULL)
+    return((ClosestColorInfo **) NULL);
+  (void) ResetMagickMemory(closest_color,0,number_threads*
+    sizeof(*closest_color));
+  for (i=0; i < (ssize_t) number_threads; i++)
+  {
+    closest_color[i]=(ClosestColorInfo *) AcquireQuantumMemory(
+      ClosestColorCacheLength,sizeof(**closest_color));
+    if (closest_color[i] == (ClosestColorInfo *) NULL)
+      return(DestroyClosestColorThreadSet(closest_color));
+    for (j=0; j < (ssize_t) ClosestColorCacheLength; j++)
+      closest_color[i][j].index=(-1);
+  }
+  return(closest_color);
+}
+
+static inline size_t ClosestColorHash(const Image *image,
+  const PixelPacket *pixel)
+{
+  size_t
+    hash;
+
+  hash=(size_t) ScaleQuantumToShort(GetPixelRed(pixel));
+  hash=65599*hash+ScaleQuantumToShort(GetPixelGreen(pixel));
+  hash=65599*hash+ScaleQuantumToShort(GetPixelBlue(pixel));
+  if (image->matte != MagickFalse)
+    hash=65599*hash+ScaleQuantumToShort(GetPixelOpacity(pixel));
+  return((hash ^ (hash >> 15)) & (ClosestColorCacheLength-1));
+}
+
 static MagickBooleanType AssignImageColors(Image *image,CubeInfo *cube_info)
 {
 #define AssignImageTag  "Assign/Image"
@@ -525,12 +598,24 @@ static MagickBooleanType AssignImageColors(Image *image,CubeInfo *cube_info)
       CacheView
         *image_view;
 
+      ClosestColorInfo
+        **closest_color;
+
       ExceptionInfo
         *exception;
 
       MagickBooleanType
         status;
 
+      /*
+        Each thread remembers the colormap entry of the colors it has seen
+        in a small direct-mapped table, so repeated colors skip the tree
+        search.
+      */
+      closest_color=AcquireClosestColorThreadSet();
+      if (closest_color == (ClosestColorInfo **) NULL)
+        ThrowBinaryException(ResourceLimitError,"MemoryAllocationFailed",
+          image->filename);
       status=MagickTrue;
       exception=(&image->exception);
       image_view=AcquireCacheView(image);
@@ -539,6 +624,9 @@ static MagickBooleanType AssignImageColors(Image *image,CubeInfo *cube_info)
 #endif
       for (y=0; y < (ssize_t) image->rows; y++)
       {
+        ClosestColorInfo
+          *cache;
+
         CubeInfo
           cube;
 
@@ -565,8 +653,12 @@ static MagickBooleanType AssignImageColors(Image *image,CubeInfo *cube_info)
           }
         indexes=GetCacheViewAuthenticIndexQueue(image_view);
         cube=(*cube_info);
+        cache=closest_color[GetOpenMPThreadId()];
         for (x=0; x < (ssize_t) image->columns; x+=count)
         {
+          ClosestColorInfo
+            *entry;
+
           RealPixelPacket
             pixel;
 
@@ -580,29 +672,38 @@ static MagickBooleanType AssignImageColors(Image *image,CubeInfo *cube_info)
             id,
             index;
 
-          /*
-            Identify the deepest node containing the pixel's color.
-          */
           for (count=1; (x+count) < (ssize_t) image->columns; count++)
             if (IsSameColor(image,q,q+count) == MagickFalse)
               break;
-          AssociateAlphaPixel(&cube,q,&pixel);
-          node_info=cube.root;
-          for (index=MaxTreeDepth-1; (ssize_t) index > 0; index--)
-          {
-            id=ColorToNodeId(&cube,&pixel,index);
-            if (node_info->child[id] == (NodeInfo *) NULL)
-              break;
-            node_info=node_info->child[id];
-          }
-          /*
-            Find closest color among siblings and their children.
-          */
-          cube.target=pixel;
-          cube.distance=(MagickRealType) (4.0*(QuantumRange+1.0)*
-            (QuantumRange+1.0)+1.0);
-          ClosestColor(image,&cube,node_info->parent);
-          index=cube.color_number;
+          entry=cache+ClosestColorHash(image,q);
+          if ((entry->index >= 0) &&
+              (IsSameColor(image,q,&entry->color) != MagickFalse))
+            index=(size_t) entry->index;
+          else
+            {
+              /*
+                Identify the deepest node containing the pixel's color.
+              */
+              AssociateAlphaPixel(&cube,q,&pixel);
+              node_info=cube.root;
+              for (index=MaxTreeDepth-1; (ssize_t) index > 0; index--)
+              {
+                id=ColorToNodeId(&cube,&pixel,index);
+                if (node_info->child[id] == (NodeInfo *) NULL)
+                  break;
+                node_info=node_info->child[id];
+              }
+              /*
+                Find closest color among siblings and their children.
+              */
+              cube.target=pixel;
+              cube.distance=(MagickRealType) (4.0*(QuantumRange+1.0)*
+                (QuantumRange+1.0)+1.0);
+              ClosestColor(image,&cube,node_info->parent);
+              index=cube.color_number;
+              entry->color=(*q);
+              entry->index=(ssize_t) index;
+            }
           for (i=0; i < (ssize_t) count; i++)
           {
             if (image->storage_class == PseudoClass)
@@ -633,6 +734,7 @@ static MagickBooleanType AssignImageColors(Image *image,CubeInfo *cube_info)
           }
       }
       image_view=DestroyCacheView(image_view);
+      closest_color=DestroyClosestColorThreadSet(closest_color);
     }
   if (cube_info->quantize_info->measure_error != MagickFalse)
     (void) GetImageQuantizeError(image);
@@ -730,6 +832,20 @@ static MagickBooleanType AssignImageColors(Image *image,CubeInfo *cube_info)
 %
 */
 
+static inline ssize_t MagickMax(const ssize_t x,const ssize_t y)
+{
+  if (x > y)
+    return(x);
+  return(y);
+}
+
+static inline ssize_t MagickMin(const ssize_t x,const ssize_t y)
+{
+  if (x < y)
+    return(x);
+  return(y);
+}
+
 static inline void SetAssociatedAlpha(const Image *image,CubeInfo *cube_info)
 {
   MagickBooleanType
@@ -744,17 +860,10 @@ static inline void SetAssociatedAlpha(const Image *image,CubeInfo *cube_info)
   cube_info->associate_alpha=associate_alpha;
 }
 
-static MagickBooleanType ClassifyImageColors(CubeInfo *cube_info,
-  const Image *image,ExceptionInfo *exception)
+static MagickBooleanType ClassifyImagePixels(CubeInfo *cube_info,
+  const Image *image,const PixelPacket *p,const size_t depth,
+  ExceptionInfo *exception)
 {
-#define ClassifyImageTag  "Classify/Image"
-
-  CacheView
-    *image_view;
-
-  MagickBooleanType
-    proceed;
-
   MagickRealType
     bisect;
 
@@ -767,13 +876,183 @@ static MagickBooleanType ClassifyImageColors(CubeInfo *cube_info,
     midpoint,
     pixel;
 
+  register ssize_t
+    x;
+
   size_t
     count,
     id,
     index,
     level;
 
+  midpoint.red=(MagickRealType) QuantumRange/2.0;
+  midpoint.green=(MagickRealType) QuantumRange/2.0;
+  midpoint.blue=(MagickRealType) QuantumRange/2.0;
+  midpoint.opacity=(MagickRealType) QuantumRange/2.0;
+  error.opacity=0.0;
+  for (x=0; x < (ssize_t) image->columns; x+=(ssize_t) count)
+  {
+    /*
+      Start at the root and descend the color cube tree.
+    */
+    for (count=1; (x+(ssize_t) count) < (ssize_t) image->columns; count++)
+      if (IsSameColor(image,p,p+count) == MagickFalse)
+        break;
+    AssociateAlphaPixel(cube_info,p,&pixel);
+    index=MaxTreeDepth-1;
+    bisect=((MagickRealType) QuantumRange+1.0)/2.0;
+    mid=midpoint;
+    node_info=cube_info->root;
+    for (level=1; level <= depth; level++)
+    {
+      bisect*=0.5;
+      id=ColorToNodeId(cube_info,&pixel,index);
+      mid.red+=(id & 1) != 0 ? bisect : -bisect;
+      mid.green+=(id & 2) != 0 ? bisect : -bisect;
+      mid.blue+=(id & 4) != 0 ? bisect : -bisect;
+      mid.opacity+=(id & 8) != 0 ? bisect : -bisect;
+      if (node_info->child[id] == (NodeInfo *) NULL)
+        {
+          /*
+            Set colors of new node to contain pixel.
+          */
+          node_info->child[id]=GetNodeInfo(cube_info,id,level,node_info);
+          if (node_info->child[id] == (NodeInfo *) NULL)
+            {
+              (void) ThrowMagickException(exception,GetMagickModule(),
+                ResourceLimitError,"MemoryAllocationFailed","`%s'",
+                image->filename);
+              return(MagickFalse);
+            }
+          if (level == depth)
+            cube_info->colors++;
+        }
+      /*
+        Approximate the quantization error represented by this node.
+      */
+      node_info=node_info->child[id];
+      error.red=QuantumScale*(pixel.red-mid.red);
+      error.green=QuantumScale*(pixel.green-mid.green);
+      error.blue=QuantumScale*(pixel.blue-mid.blue);
+      if (cube_info->associate_alpha != MagickFalse)
+        error.opacity=QuantumScale*(pixel.opacity-mid.opacity);
+      node_info->quantize_error+=sqrt((double) (count*error.red*error.red+
+        count*error.green*error.green+count*error.blue*error.blue+
+        count*error.opacity*error.opacity));
+      cube_info->root->quantize_error+=node_info->quantize_error;
+      index--;
+    }
+    /*
+      Sum RGB for this leaf for later derivation of the mean cube color.
+    */
+    node_info->number_unique+=count;
+    node_info->total_color.red+=count*QuantumScale*pixel.red;
+    node_info->total_color.green+=count*QuantumScale*pixel.green;
+    node_info->total_color.blue+=count*QuantumScale*pixel.blue;
+    if (cube_info->associate_alpha != MagickFalse)
+      node_info->total_color.opacity+=count*QuantumScale*pixel.opacity;
+    p+=count;
+  }
+  return(MagickTrue);
+}
+
+static void AccumulateNodeInfo(const CubeInfo *cube_info,NodeInfo *target,
+  const NodeInfo *source)
+{
+  register ssize_t
+    i;
+
+  size_t
+    number_children;
+
+  /*
+    Fold the color statistics of a subtree into a single node, as
+    PruneChild() does.
+  */
+  number_children=cube_info->associate_alpha == MagickFalse ? 8UL : 16UL;
+  for (i=0; i < (ssize_t) number_children; i++)
+    if (source->child[i] != (NodeInfo *) NULL)
+      AccumulateNodeInfo(cube_info,target,source->child[i]);
+  target->number_unique+=source->number_unique;
+  target->total_color.red+=source->total_color.red;
+  target->total_color.green+=source->total_color.green;
+  target->total_color.blue+=source->total_color.blue;
+  target->total_color.opacity+=source->total_color.opacity;
+}
+
+static MagickBooleanType MergeNodeInfo(CubeInfo *cube_info,NodeInfo *target,
+  const NodeInfo *source,const size_t depth)
+{
+  register ssize_t
+    i;
+
+  size_t
+    number_children;
+
+  /*
+    Add the statistics of a node of a block tree to the matching node of the
+    color cube; subtrees below the current depth are folded into target.
+  */
+  target->number_unique+=source->number_unique;
+  target->total_color.red+=source->total_color.red;
+  target->total_color.green+=source->total_color.green;
+  target->total_color.blue+=source->total_color.blue;
+  target->total_color.opacity+=source->total_color.opacity;
+  target->quantize_error+=source->quantize_error;
+  number_children=cube_info->associate_alpha == MagickFalse ? 8UL : 16UL;
+  for (i=0; i < (ssize_t) number_children; i++)
+  {
+    if (source->child[i] == (NodeInfo *) NULL)
+      continue;
+    if (source->child[i]->level > depth)
+      {
+        AccumulateNodeInfo(cube_info,target,source->child[i]);
+        continue;
+      }
+    if (target->child[i] == (NodeInfo *) NULL)
+      {
+        target->child[i]=GetNodeInfo(cube_info,(size_t) i,
+          source->child[i]->level,target);
+        if (target->child[i] == (NodeInfo *) NULL)
+          return(MagickFalse);
+        if (source->child[i]->level == depth)
+          cube_info->colors++;
+      }
+    if (MergeNodeInfo(cube_info,target->child[i],source->child[i],depth) ==
+        MagickFalse)
+      return(MagickFalse);
+  }
+  return(MagickTrue);
+}
+
+static MagickBooleanType ClassifyImageColors(CubeInfo *cube_info,
+  const Image *image,ExceptionInfo *exception)
+{
+#define ClassifyImageTag  "Classify/Image"
+
+  CacheView
+    *image_view;
+
+  CubeInfo
+    **block_info;
+
+  MagickBooleanType
+    proceed,
+    status;
+
+  QuantizeInfo
+    block_quantize_info;
+
+  register ssize_t
+    i;
+
+  size_t
+    number_blocks,
+    number_threads,
+    rows_per_block;
+
   ssize_t
+    block,
     y;
 
   /*
@@ -789,20 +1068,13 @@ static MagickBooleanType ClassifyImageColors(CubeInfo *cube_info,
         (image->colorspace != CMYColorspace) &&
         (IsRGBColorspace(image->colorspace) == MagickFalse))
       (void) TransformImageColorspace((Image *) image,RGBColorspace);
-  midpoint.red=(MagickRealType) QuantumRange/2.0;
-  midpoint.green=(MagickRealType) QuantumRange/2.0;
-  midpoint.blue=(MagickRealType) QuantumRange/2.0;
-  midpoint.opacity=(MagickRealType) QuantumRange/2.0;
-  error.opacity=0.0;
+  status=MagickTrue;
   image_view=AcquireCacheView(image);
   for (y=0; y < (ssize_t) image->rows; y++)
   {
     register const PixelPacket
       *restrict p;
 
-    register ssize_t
-      x;
-
     p=GetCacheViewVirtualPixels(image_view,0,y,image->columns,1,exception);
     if (p == (const PixelPacket *) NULL)
       break;
@@ -814,66 +1086,12 @@ static MagickBooleanType ClassifyImageColors(CubeInfo *cube_info,
         PruneLevel(image,cube_info,cube_info->root);
         cube_info->depth--;
       }
-    for (x=0; x < (ssize_t) image->columns; x+=(ssize_t) count)
-    {
-      /*
-        Start at the root and descend the color cube tree.
-      */
-      for (count=1; (x+(ssize_t) count) < (ssize_t) image->columns; count++)
-        if (IsSameColor(image,p,p+count) == MagickFalse)
-          break;
-      AssociateAlphaPixel(cube_info,p,&pixel);
-      index=MaxTreeDepth-1;
-      bisect=((MagickRealType) QuantumRange+1.0)/2.0;
-      mid=midpoint;
-      node_info=cube_info->root;
-      for (level=1; level <= MaxTreeDepth; level++)
+    if (ClassifyImagePixels(cube_info,image,p,MaxTreeDepth,exception) ==
+        MagickFalse)
       {
-        bisect*=0.5;
-        id=ColorToNodeId(cube_info,&pixel,index);
-        mid.red+=(id & 1) != 0 ? bisect : -bisect;
-        mid.green+=(id & 2) != 0 ? bisect : -bisect;
-        mid.blue+=(id & 4) != 0 ? bisect : -bisect;
-        mid.opacity+=(id & 8) != 0 ? bisect : -bisect;
-        if (node_info->child[id] == (NodeInfo *) NULL)
-          {
-            /*
-              Set colors of new node to contain pixel.
-            */
-            node_info->child[id]=GetNodeInfo(cube_info,id,level,node_info);
-            if (node_info->child[id] == (NodeInfo *) NULL)
-              (void) ThrowMagickException(exception,GetMagickModule(),
-                ResourceLimitError,"MemoryAllocationFailed","`%s'",
-                image->filename);
-            if (level == MaxTreeDepth)
-              cube_info->colors++;
-          }
-        /*
-          Approximate the quantization error represented by this node.
-        */
-        node_info=node_info->child[id];
-        error.red=QuantumScale*(pixel.red-mid.red);
-        error.green=QuantumScale*(pixel.green-mid.green);
-        error.blue=QuantumScale*(pixel.blue-mid.blue);
-        if (cube_info->associate_alpha != MagickFalse)
-          error.opacity=QuantumScale*(pixel.opacity-mid.opacity);
-        node_info->quantize_error+=sqrt((double) (count*error.red*error.red+
-          count*error.green*error.green+count*error.blue*error.blue+
-          count*error.opacity*error.opacity));
-        cube_info->root->quantize_error+=node_info->quantize_error;
-        index--;
+        status=MagickFalse;
+        break;
       }
-      /*
-        Sum RGB for this leaf for later derivation of the mean cube color.
-      */
-      node_info->number_unique+=count;
-      node_info->total_color.red+=count*QuantumScale*pixel.red;
-      node_info->total_color.green+=count*QuantumScale*pixel.green;
-      node_info->total_color.blue+=count*QuantumScale*pixel.blue;
-      if (cube_info->associate_alpha != MagickFalse)
-        node_info->total_color.opacity+=count*QuantumScale*pixel.opacity;
-      p+=count;
-    }
     if (cube_info->colors > cube_info->maximum_colors)
       {
         PruneToCubeDepth(image,cube_info,cube_info->root);
@@ -884,97 +1102,131 @@ static MagickBooleanType ClassifyImageColors(CubeInfo *cube_info,
     if (proceed == MagickFalse)
       break;
   }
-  for (y++; y < (ssize_t) image->rows; y++)
+  y++;
+  if ((status == MagickFalse) || (y >= (ssize_t) image->rows))
+    {
+      image_view=DestroyCacheView(image_view);
+      if ((cube_info->quantize_info->colorspace != UndefinedColorspace) &&
+          (cube_info->quantize_info->colorspace != CMYKColorspace))
+        (void) TransformImageColorspace((Image *) image,RGBColorspace);
+      return(status);
+    }
+  /*
+    Classify the remaining rows to the cube depth.  Each thread classifies a
+    block of rows into a tree of its own; the trees are merged into the color
+    cube in block order, so the result does not depend on the thread count.
+    The tree is pruned between blocks rather than between rows, so images
+    that overflow it may quantize slightly differently than a row-by-row
+    classification would.
+  */
+  number_threads=GetOpenMPMaximumThreads();
+  block_info=(CubeInfo **) AcquireQuantumMemory(number_threads,
+    sizeof(*block_info));
+  if (block_info == (CubeInfo **) NULL)
+    {
+      image_view=DestroyCacheView(image_view);
+      (void) ThrowMagickException(exception,GetMagickModule(),
+        ResourceLimitError,"MemoryAllocationFailed","`%s'",image->filename);
+      return(MagickFalse);
+    }
+  (void) ResetMagickMemory(block_info,0,number_threads*sizeof(*block_info));
+  block_quantize_info=(*cube_info->quantize_info);
+  block_quantize_info.dither=MagickFalse;
+  rows_per_block=ClassifyBlockExtent/MagickMax((ssize_t) image->columns,1);
+  if (rows_per_block == 0)
+    rows_per_block=1;
+  number_blocks=(image->rows-y+rows_per_block-1)/rows_per_block;
+  for (block=0; block < (ssize_t) number_blocks; block+=number_threads)
   {
-    register const PixelPacket
-      *restrict p;
-
-    register ssize_t
-      x;
+    size_t
+      count,
+      depth;
 
-    p=GetCacheViewVirtualPixels(image_view,0,y,image->columns,1,exception);
-    if (p == (const PixelPacket *) NULL)
-      break;
-    if (cube_info->nodes > MaxNodes)
-      {
-        /*
-          Prune one level if the color tree is too large.
-        */
-        PruneLevel(image,cube_info,cube_info->root);
-        cube_info->depth--;
-      }
-    for (x=0; x < (ssize_t) image->columns; x+=(ssize_t) count)
+    count=MagickMin((ssize_t) number_threads,(ssize_t) number_blocks-block);
+    depth=cube_info->depth;
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+    #pragma omp parallel for schedule(static,1) shared(status)
+#endif
+    for (i=0; i < (ssize_t) count; i++)
     {
-      /*
-        Start at the root and descend the color cube tree.
-      */
-      for (count=1; (x+(ssize_t) count) < (ssize_t) image->columns; count++)
-        if (IsSameColor(image,p,p+count) == MagickFalse)
-          break;
-      AssociateAlphaPixel(cube_info,p,&pixel);
-      index=MaxTreeDepth-1;
-      bisect=((MagickRealType) QuantumRange+1.0)/2.0;
-      mid=midpoint;
-      node_info=cube_info->root;
-      for (level=1; level <= cube_info->depth; level++)
+      CubeInfo
+        *tree;
+
+      ssize_t
+        row,
+        rows;
+
+      if (status == MagickFalse)
+        continue;
+      tree=GetCubeInfo(&block_quantize_info,depth,cube_info->maximum_colors);
+      if (tree == (CubeInfo *) NULL)
+        {
+          status=MagickFalse;
+          continue;
+        }
+      tree->associate_alpha=cube_info->associate_alpha;
+      block_info[i]=tree;
+      row=y+(block+i)*(ssize_t) rows_per_block;
+      rows=MagickMin((ssize_t) rows_per_block,(ssize_t) image->rows-row);
+      for ( ; rows > 0; rows--, row++)
       {
-        bisect*=0.5;
-        id=ColorToNodeId(cube_info,&pixel,index);
-        mid.red+=(id & 1) != 0 ? bisect : -bisect;
-        mid.green+=(id & 2) != 0 ? bisect : -bisect;
-        mid.blue+=(id & 4) != 0 ? bisect : -bisect;
-        mid.opacity+=(id & 8) != 0 ? bisect : -bisect;
-        if (node_info->child[id] == (NodeInfo *) NULL)
+        register const PixelPacket
+          *restrict p;
+
+        p=GetCacheViewVirtualPixels(image_view,0,row,image->columns,1,
+          exception);
+        if (p == (const PixelPacket *) NULL)
           {
-            /*
-              Set colors of new node to contain pixel.
-            */
-            node_info->child[id]=GetNodeInfo(cube_info,id,level,node_info);
-            if (node_info->child[id] == (NodeInfo *) NULL)
-              (void) ThrowMagickException(exception,GetMagickModule(),
-                ResourceLimitError,"MemoryAllocationFailed","%s",
-                image->filename);
-            if (level == cube_info->depth)
-              cube_info->colors++;
+            status=MagickFalse;
+            break;
+          }
+        if (ClassifyImagePixels(tree,image,p,depth,exception) == MagickFalse)
+          {
+            status=MagickFalse;
+            break;
           }
-        /*
-          Approximate the quantization error represented by this node.
-        */
-        node_info=node_info->child[id];
-        error.red=QuantumScale*(pixel.red-mid.red);
-        error.green=QuantumScale*(pixel.green-mid.green);
-        error.blue=QuantumScale*(pixel.blue-mid.blue);
-        if (cube_info->associate_alpha != MagickFalse)
-          error.opacity=QuantumScale*(pixel.opacity-mid.opacity);
-        node_info->quantize_error+=sqrt((double) (count*error.red*error.red+
-          count*error.green*error.green+count*error.blue*error.blue+
-          count*error.opacity*error.opacity));
-        cube_info->root->quantize_error+=node_info->quantize_error;
-        index--;
       }
-      /*
-        Sum RGB for this leaf for later derivation of the mean cube color.
-      */
-      node_info->number_unique+=count;
-      node_info->total_color.red+=count*QuantumScale*pixel.red;
-      node_info->total_color.green+=count*QuantumScale*pixel.green;
-      node_info->total_color.blue+=count*QuantumScale*pixel.blue;
-      if (cube_info->associate_alpha != MagickFalse)
-        node_info->total_color.opacity+=count*QuantumScale*pixel.opacity;
-      p+=count;
     }
-    proceed=SetImageProgress(image,ClassifyImageTag,(MagickOffsetType) y,
-      image->rows);
+    for (i=0; i < (ssize_t) count; i++)
+    {
+      if (block_info[i] == (CubeInfo *) NULL)
+        continue;
+      if ((status != MagickFalse) && (MergeNodeInfo(cube_info,
+           cube_info->root,block_info[i]->root,cube_info->depth) ==
+           MagickFalse))
+        {
+          (void) ThrowMagickException(exception,GetMagickModule(),
+            ResourceLimitError,"MemoryAllocationFailed","`%s'",
+            image->filename);
+          status=MagickFalse;
+        }
+      DestroyCubeInfo(block_info[i]);
+      block_info[i]=(CubeInfo *) NULL;
+      if (cube_info->nodes > MaxNodes)
+        {
+          /*
+            Prune one level if the color tree is too large.
+          */
+          PruneLevel(image,cube_info,cube_info->root);
+          cube_info->depth--;
+        }
+    }
+    if (status == MagickFalse)
+      break;
+    proceed=SetImageProgress(image,ClassifyImageTag,(MagickOffsetType)
+      MagickMin((ssize_t) image->rows-1,y+(block+count)*(ssize_t)
+      rows_per_block),image->rows);
     if (proceed == MagickFalse)
       break;
   }
+  block_info=(CubeInfo **) RelinquishMagickMemory(block_info);
   image_view=DestroyCacheView(image_view);
   if ((cube_info->quantize_info->colorspace != UndefinedColorspace) &&
       (cube_info->quantize_info->colorspace != CMYKColorspace))
     (void) TransformImageColorspace((Image *) image,RGBColorspace);
-  return(MagickTrue);
+  return(status);
 }
-
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -1367,6 +1619,11 @@ MagickExport QuantizeInfo *DestroyQuantizeInfo(QuantizeInfo *quantize_info)
 %  serpentine-scan Floyd-Steinberg error diffusion. DitherImage returns
 %  MagickTrue if the image is dithered otherwise MagickFalse.
 %
+%  The ordered method instead offsets each pixel by an entry of a threshold
+%  map (o8x8 unless the dither:threshold-map artifact names another) before
+%  assigning it; since no error propagates, its rows are processed in
+%  parallel.
+%
 %  The format of the DitherImage method is:
 %
 %      MagickBooleanType DitherImage(Image *image,CubeInfo *cube_info)
@@ -1600,8 +1857,6 @@ static MagickBooleanType FloydSteinbergDither(Image *image,CubeInfo *cube_info)
           if (cube.associate_alpha != MagickFalse)
             SetPixelOpacity(q+u,image->colormap[index].opacity);
         }
-      if (SyncCacheViewAuthenticPixels(image_view,exception) == MagickFalse)
-        status=MagickFalse;
       /*
         Store the error.
       */
@@ -1611,20 +1866,22 @@ static MagickBooleanType FloydSteinbergDither(Image *image,CubeInfo *cube_info)
       current[u].blue=pixel.blue-color.blue;
       if (cube.associate_alpha != MagickFalse)
         current[u].opacity=pixel.opacity-color.opacity;
-      if (image->progress_monitor != (MagickProgressMonitor) NULL)
-        {
-          MagickBooleanType
-            proceed;
+    }
+    if (SyncCacheViewAuthenticPixels(image_view,exception) == MagickFalse)
+      status=MagickFalse;
+    if (image->progress_monitor != (MagickProgressMonitor) NULL)
+      {
+        MagickBooleanType
+          proceed;
 
 #if defined(MAGICKCORE_OPENMP_SUPPORT)
-          #pragma omp critical (MagickCore_FloydSteinbergDither)
+        #pragma omp critical (MagickCore_FloydSteinbergDither)
 #endif
-          proceed=SetImageProgress(image,DitherImageTag,(MagickOffsetType) y,
-            image->rows);
-          if (proceed == MagickFalse)
-            status=MagickFalse;
-        }
-    }
+        proceed=SetImageProgress(image,DitherImageTag,(MagickOffsetType) y,
+          image->rows);
+        if (proceed == MagickFalse)
+          status=MagickFalse;
+      }
   }
   image_view=DestroyCacheView(image_view);
   pixels=DestroyPixelThreadSet(pixels);
@@ -1849,18 +2106,194 @@ static MagickBooleanType RiemersmaDither(Image *image,CacheView *image_view,
   return(MagickTrue);
 }
 
-static inline ssize_t MagickMax(const ssize_t x,const ssize_t y)
+static MagickBooleanType OrderedDither(Image *image,CubeInfo *cube_info)
 {
-  if (x > y)
-    return(x);
-  return(y);
-}
+  CacheView
+    *image_view;
 
-static inline ssize_t MagickMin(const ssize_t x,const ssize_t y)
-{
-  if (x < y)
-    return(x);
-  return(y);
+  ClosestColorInfo
+    **closest_color;
+
+  const char
+    *map_id;
+
+  ExceptionInfo
+    *exception;
+
+  MagickBooleanType
+    status;
+
+  MagickOffsetType
+    progress;
+
+  MagickRealType
+    dimensions,
+    spread;
+
+  ThresholdMap
+    *map;
+
+  ssize_t
+    y;
+
+  /*
+    Offset each pixel by a threshold map entry before it is assigned to the
+    closest colormap entry.  No error is carried between pixels, so rows are
+    dithered independently.
+  */
+  exception=(&image->exception);
+  map_id=GetImageArtifact(image,"dither:threshold-map");
+  if (map_id == (const char *) NULL)
+    map_id="o8x8";
+  map=GetThresholdMap(map_id,exception);
+  if (map == (ThresholdMap *) NULL)
+    ThrowBinaryException(OptionError,"InvalidArgument",map_id);
+  closest_color=AcquireClosestColorThreadSet();
+  if (closest_color == (ClosestColorInfo **) NULL)
+    {
+      map=DestroyThresholdMap(map);
+      ThrowBinaryException(ResourceLimitError,"MemoryAllocationFailed",
+        image->filename);
+    }
+  /*
+    Spread the offsets over half the mean distance between colormap entries.
+  */
+  dimensions=cube_info->associate_alpha == MagickFalse ? 3.0 : 4.0;
+  if ((cube_info->quantize_info->colorspace == GRAYColorspace) ||
+      (image->colorspace == GRAYColorspace))
+    dimensions=1.0;
+  spread=0.5*QuantumRange/pow((double) MagickMax((ssize_t) image->colors,2),
+    1.0/dimensions);
+  status=MagickTrue;
+  progress=0;
+  image_view=AcquireCacheView(image);
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for schedule(static,4) shared(progress,status)
+#endif
+  for (y=0; y < (ssize_t) image->rows; y++)
+  {
+    ClosestColorInfo
+      *cache;
+
+    CubeInfo
+      cube;
+
+    register IndexPacket
+      *restrict indexes;
+
+    register PixelPacket
+      *restrict q;
+
+    register ssize_t
+      x;
+
+    if (status == MagickFalse)
+      continue;
+    q=GetCacheViewAuthenticPixels(image_view,0,y,image->columns,1,exception);
+    if (q == (PixelPacket *) NULL)
+      {
+        status=MagickFalse;
+        continue;
+      }
+    indexes=GetCacheViewAuthenticIndexQueue(image_view);
+    cube=(*cube_info);
+    cache=closest_color[GetOpenMPThreadId()];
+    for (x=0; x < (ssize_t) image->columns; x++)
+    {
+      ClosestColorInfo
+        *entry;
+
+      MagickRealType
+        threshold;
+
+      PixelPacket
+        color;
+
+      RealPixelPacket
+        pixel;
+
+      size_t
+        index;
+
+      threshold=spread*((MagickRealType) map->levels[(x % map->width)+
+        map->width*(y % map->height)]/map->divisor-0.5);
+      AssociateAlphaPixel(&cube,q,&pixel);
+      SetPixelRed(&color,ClampToQuantum(pixel.red+threshold));
+      SetPixelGreen(&color,ClampToQuantum(pixel.green+threshold));
+      SetPixelBlue(&color,ClampToQuantum(pixel.blue+threshold));
+      SetPixelOpacity(&color,GetPixelOpacity(q));
+      if (cube.associate_alpha != MagickFalse)
+        SetPixelOpacity(&color,ClampToQuantum(pixel.opacity+threshold));
+      entry=cache+ClosestColorHash(image,&color);
+      if ((entry->index >= 0) &&
+          (IsSameColor(image,&color,&entry->color) != MagickFalse))
+        index=(size_t) entry->index;
+      else
+        {
+          register NodeInfo
+            *node_info;
+
+          register size_t
+            id;
+
+          /*
+            Identify the deepest node containing the pixel's color.
+          */
+          pixel.red=(MagickRealType) GetPixelRed(&color);
+          pixel.green=(MagickRealType) GetPixelGreen(&color);
+          pixel.blue=(MagickRealType) GetPixelBlue(&color);
+          pixel.opacity=(MagickRealType) GetPixelOpacity(&color);
+          node_info=cube.root;
+          for (index=MaxTreeDepth-1; (ssize_t) index > 0; index--)
+          {
+            id=ColorToNodeId(&cube,&pixel,index);
+            if (node_info->child[id] == (NodeInfo *) NULL)
+              break;
+            node_info=node_info->child[id];
+          }
+          /*
+            Find closest color among siblings and their children.
+          */
+          cube.target=pixel;
+          cube.distance=(MagickRealType) (4.0*(QuantumRange+1.0)*(QuantumRange+
+            1.0)+1.0);
+          ClosestColor(image,&cube,node_info->parent);
+          index=cube.color_number;
+          entry->color=color;
+          entry->index=(ssize_t) index;
+        }
+      /*
+        Assign pixel to closest colormap entry.
+      */
+      if (image->storage_class == PseudoClass)
+        SetPixelIndex(indexes+x,index);
+      if (cube.quantize_info->measure_error == MagickFalse)
+        {
+          SetPixelRgb(q,image->colormap+index);
+          if (cube.associate_alpha != MagickFalse)
+            SetPixelOpacity(q,image->colormap[index].opacity);
+        }
+      q++;
+    }
+    if (SyncCacheViewAuthenticPixels(image_view,exception) == MagickFalse)
+      status=MagickFalse;
+    if (image->progress_monitor != (MagickProgressMonitor) NULL)
+      {
+        MagickBooleanType
+          proceed;
+
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+        #pragma omp critical (MagickCore_OrderedDither)
+#endif
+        proceed=SetImageProgress(image,DitherImageTag,progress++,image->rows);
+        if (proceed == MagickFalse)
+          status=MagickFalse;
+      }
+  }
+  image_view=DestroyCacheView(image_view);
+  closest_color=DestroyClosestColorThreadSet(closest_color);
+  map=DestroyThresholdMap(map);
+  return(status);
 }
 
 static MagickBooleanType DitherImage(Image *image,CubeInfo *cube_info)
@@ -1877,6 +2310,8 @@ static MagickBooleanType DitherImage(Image *image,CubeInfo *cube_info)
   size_t
     depth;
 
+  if (cube_info->quantize_info->dither_method == OrderedDitherMethod)
+    return(OrderedDither(image,cube_info));
   if (cube_info->quantize_info->dither_method != RiemersmaDitherMethod)
     return(FloydSteinbergDither(image,cube_info));
   /*
@@ -29,7 +29,8 @@ typedef enum
   UndefinedDitherMethod,
   NoDitherMethod,
   RiemersmaDitherMethod,
-  FloydSteinbergDitherMethod
+  FloydSteinbergDitherMethod,
+  OrderedDitherMethod
 } DitherMethod;
 
 typedef struct _QuantizeInfo
@@ -97,6 +97,10 @@ struct _RandomInfo
   SemaphoreInfo
     *semaphore;
 
+  struct _RandomInfo
+    *previous,
+    *next;
+
   ssize_t
     timestamp;
 
@@ -118,6 +122,9 @@ extern char
 /*
   Global declarations.
 */
+static RandomInfo
+  *random_list = (RandomInfo *) NULL;
+
 static SemaphoreInfo
   *random_semaphore = (SemaphoreInfo *) NULL;
 
@@ -244,6 +251,17 @@ MagickExport RandomInfo *AcquireRandomInfo(void)
   random_info->seed[1]=0x50a7f451UL;
   random_info->seed[2]=0x5365417eUL;
   random_info->seed[3]=0xc3a4171aUL;
+  /*
+    Keep track of the generator so a forked child can reseed it.
+  */
+  if (random_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&random_semaphore);
+  LockSemaphoreInfo(random_semaphore);
+  random_info->next=random_list;
+  if (random_list != (RandomInfo *) NULL)
+    random_list->previous=random_info;
+  random_list=random_info;
+  UnlockSemaphoreInfo(random_semaphore);
   return(random_info);
 }
 
@@ -275,6 +293,17 @@ MagickExport RandomInfo *DestroyRandomInfo(RandomInfo *random_info)
   (void) LogMagickEvent(TraceEvent,GetMagickModule(),"...");
   assert(random_info != (RandomInfo *) NULL);
   assert(random_info->signature == MagickSignature);
+  if (random_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&random_semaphore);
+  LockSemaphoreInfo(random_semaphore);
+  if (random_info->previous != (RandomInfo *) NULL)
+    random_info->previous->next=random_info->next;
+  else
+    if (random_list == random_info)
+      random_list=random_info->next;
+  if (random_info->next != (RandomInfo *) NULL)
+    random_info->next->previous=random_info->previous;
+  UnlockSemaphoreInfo(random_semaphore);
   LockSemaphoreInfo(random_info->semaphore);
   if (random_info->reservoir != (StringInfo *) NULL)
     random_info->reservoir=DestroyStringInfo(random_info->reservoir);
@@ -684,6 +713,132 @@ MagickExport double GetRandomValue(RandomInfo *random_info)
   return((double) key/range);
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   R a n d o m C o m p o n e n t F o r k C h i l d                           %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  RandomComponentForkChild() releases the random component in the child
+%  process after a fork().  Every random generator the child inherited is
+%  reseeded with entropy from the child, so the child does not repeat the
+%  keys of its parent or of its siblings.  A pseudo-random generator seeded
+%  with SeedPseudoRandomGenerator() keeps its deterministic sequence.
+%
+%  The format of the RandomComponentForkChild method is:
+%
+%      RandomComponentForkChild(void)
+%
+*/
+
+static void ReseedRandomInfo(RandomInfo *random_info)
+{
+  StringInfo
+    *entropy,
+    *key;
+
+  entropy=GenerateEntropicChaos(random_info);
+  if (entropy == (StringInfo *) NULL)
+    ThrowFatalException(ResourceLimitFatalError,"MemoryAllocationFailed");
+  LockSemaphoreInfo(random_info->semaphore);
+  InitializeSignature(random_info->signature_info);
+  UpdateSignature(random_info->signature_info,random_info->nonce);
+  UpdateSignature(random_info->signature_info,entropy);
+  FinalizeSignature(random_info->signature_info);
+  SetStringInfo(random_info->nonce,GetSignatureDigest(
+    random_info->signature_info));
+  random_info->i=0;
+  UnlockSemaphoreInfo(random_info->semaphore);
+  entropy=DestroyStringInfo(entropy);
+  if (random_seed == ~0UL)
+    {
+      key=GetRandomKey(random_info,sizeof(random_seed));
+      (void) CopyMagickMemory(random_info->seed,GetStringInfoDatum(key),
+        GetStringInfoLength(key));
+      key=DestroyStringInfo(key);
+      random_info->seed[1]=0x50a7f451UL;
+      random_info->seed[2]=0x5365417eUL;
+      random_info->seed[3]=0xc3a4171aUL;
+    }
+}
+
+MagickExport void RandomComponentForkChild(void)
+{
+  RandomInfo
+    *p;
+
+  for (p=random_list; p != (RandomInfo *) NULL; p=p->next)
+    UnlockSemaphoreInfo(p->semaphore);
+  for (p=random_list; p != (RandomInfo *) NULL; p=p->next)
+    ReseedRandomInfo(p);
+  UnlockSemaphoreInfo(random_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   R a n d o m C o m p o n e n t F o r k P a r e n t                         %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  RandomComponentForkParent() releases the random component in the parent
+%  process after a fork().
+%
+%  The format of the RandomComponentForkParent method is:
+%
+%      RandomComponentForkParent(void)
+%
+*/
+MagickExport void RandomComponentForkParent(void)
+{
+  RandomInfo
+    *p;
+
+  for (p=random_list; p != (RandomInfo *) NULL; p=p->next)
+    UnlockSemaphoreInfo(p->semaphore);
+  UnlockSemaphoreInfo(random_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   R a n d o m C o m p o n e n t F o r k P r e p a r e                       %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  RandomComponentForkPrepare() locks the random component, and each random
+%  generator in use, before a fork().
+%
+%  The format of the RandomComponentForkPrepare method is:
+%
+%      RandomComponentForkPrepare(void)
+%
+*/
+MagickExport void RandomComponentForkPrepare(void)
+{
+  RandomInfo
+    *p;
+
+  if (random_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&random_semaphore);
+  LockSemaphoreInfo(random_semaphore);
+  for (p=random_list; p != (RandomInfo *) NULL; p=p->next)
+    LockSemaphoreInfo(p->semaphore);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
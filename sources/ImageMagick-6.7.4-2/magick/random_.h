@@ -48,6 +48,9 @@ extern MagickExport StringInfo
   *GetRandomKey(RandomInfo *,const size_t);
 
 extern MagickExport void
+  RandomComponentForkChild(void),
+  RandomComponentForkParent(void),
+  RandomComponentForkPrepare(void),
   RandomComponentTerminus(void),
   SeedPseudoRandomGenerator(const unsigned long),
   SetRandomKey(RandomInfo *,const size_t,unsigned char *),
@@ -44,6 +44,7 @@
 #include "magick/artifact.h"
 #include "magick/color-private.h"
 #include "magick/cache.h"
+#include "magick/cache-private.h"
 #include "magick/draw.h"
 #include "magick/exception-private.h"
 #include "magick/gem.h"
@@ -121,6 +122,25 @@ struct _ResampleFilter
   MagickPixelPacket
     average_pixel;
 
+  /* source pixels read in place, when the image is held in memory */
+  MagickBooleanType
+    pixels_defined;
+
+  const PixelPacket
+    *pixels;
+
+  const IndexPacket
+    *indexes;
+
+  PixelPacket
+    *scanline;
+
+  IndexPacket
+    *scanline_indexes;
+
+  size_t
+    scanline_extent;
+
   /* current ellipitical area being resampled around center point */
   double
     A, B, C,
@@ -272,6 +292,12 @@ MagickExport ResampleFilter *DestroyResampleFilter(
   if (resample_filter->debug != MagickFalse)
     (void) LogMagickEvent(TraceEvent,GetMagickModule(),"%s",
       resample_filter->image->filename);
+  if (resample_filter->scanline != (PixelPacket *) NULL)
+    resample_filter->scanline=(PixelPacket *) RelinquishMagickMemory(
+      resample_filter->scanline);
+  if (resample_filter->scanline_indexes != (IndexPacket *) NULL)
+    resample_filter->scanline_indexes=(IndexPacket *) RelinquishMagickMemory(
+      resample_filter->scanline_indexes);
   resample_filter->view=DestroyCacheView(resample_filter->view);
   resample_filter->image=DestroyImage(resample_filter->image);
 #if ! FILTER_LUT
@@ -282,6 +308,186 @@ MagickExport ResampleFilter *DestroyResampleFilter(
   return(resample_filter);
 }
 
+static MagickBooleanType AcquireResampleScanline(
+  ResampleFilter *resample_filter,const size_t width)
+{
+  if (width <= resample_filter->scanline_extent)
+    return(MagickTrue);
+  resample_filter->scanline_extent=0;
+  resample_filter->scanline=(PixelPacket *) ResizeQuantumMemory(
+    resample_filter->scanline,width,sizeof(*resample_filter->scanline));
+  resample_filter->scanline_indexes=(IndexPacket *) ResizeQuantumMemory(
+    resample_filter->scanline_indexes,width,
+    sizeof(*resample_filter->scanline_indexes));
+  if ((resample_filter->scanline == (PixelPacket *) NULL) ||
+      (resample_filter->scanline_indexes == (IndexPacket *) NULL))
+    {
+      /*
+        Leave very wide ellipses to the cache view.
+      */
+      if (resample_filter->scanline != (PixelPacket *) NULL)
+        resample_filter->scanline=(PixelPacket *) RelinquishMagickMemory(
+          resample_filter->scanline);
+      if (resample_filter->scanline_indexes != (IndexPacket *) NULL)
+        resample_filter->scanline_indexes=(IndexPacket *)
+          RelinquishMagickMemory(resample_filter->scanline_indexes);
+      return(MagickFalse);
+    }
+  resample_filter->scanline_extent=width;
+  return(MagickTrue);
+}
+
+static const PixelPacket *GetResampleScanline(
+  ResampleFilter *resample_filter,const ssize_t u,const ssize_t v,
+  const size_t width,const IndexPacket **indexes)
+{
+  const Image
+    *image;
+
+  IndexPacket
+    *q_indexes;
+
+  PixelPacket
+    *q,
+    virtual_pixel;
+
+  register ssize_t
+    i;
+
+  ssize_t
+    offset,
+    x;
+
+  /*
+    Return a scan line of source pixels.  Pixels inside the image are read in
+    place; edge and constant virtual pixels are produced here, as the pixel
+    cache would, rather than one at a time through the cache view.
+  */
+  image=resample_filter->image;
+  if ((resample_filter->pixels != (const PixelPacket *) NULL) &&
+      (u >= 0) && ((u+(ssize_t) width) <= (ssize_t) image->columns) &&
+      (v >= 0) && (v < (ssize_t) image->rows))
+    {
+      offset=v*(ssize_t) image->columns+u;
+      *indexes=(const IndexPacket *) NULL;
+      if (resample_filter->indexes != (const IndexPacket *) NULL)
+        *indexes=resample_filter->indexes+offset;
+      return(resample_filter->pixels+offset);
+    }
+  switch (resample_filter->virtual_pixel)
+  {
+    case UndefinedVirtualPixelMethod:
+    case EdgeVirtualPixelMethod:
+    case BackgroundVirtualPixelMethod:
+    case ConstantVirtualPixelMethod:
+    case BlackVirtualPixelMethod:
+    case GrayVirtualPixelMethod:
+    case TransparentVirtualPixelMethod:
+    case MaskVirtualPixelMethod:
+    case WhiteVirtualPixelMethod:
+    {
+      if ((resample_filter->pixels != (const PixelPacket *) NULL) &&
+          (AcquireResampleScanline(resample_filter,width) != MagickFalse))
+        break;
+    }
+    default:
+    {
+      const PixelPacket
+        *p;
+
+      p=GetCacheViewVirtualPixels(resample_filter->view,u,v,width,1,
+        resample_filter->exception);
+      *indexes=GetCacheViewVirtualIndexQueue(resample_filter->view);
+      return(p);
+    }
+  }
+  switch (resample_filter->virtual_pixel)
+  {
+    case BlackVirtualPixelMethod:
+    {
+      SetPixelRed(&virtual_pixel,0);
+      SetPixelGreen(&virtual_pixel,0);
+      SetPixelBlue(&virtual_pixel,0);
+      SetPixelOpacity(&virtual_pixel,OpaqueOpacity);
+      break;
+    }
+    case GrayVirtualPixelMethod:
+    {
+      SetPixelRed(&virtual_pixel,QuantumRange/2);
+      SetPixelGreen(&virtual_pixel,QuantumRange/2);
+      SetPixelBlue(&virtual_pixel,QuantumRange/2);
+      SetPixelOpacity(&virtual_pixel,OpaqueOpacity);
+      break;
+    }
+    case TransparentVirtualPixelMethod:
+    {
+      SetPixelRed(&virtual_pixel,0);
+      SetPixelGreen(&virtual_pixel,0);
+      SetPixelBlue(&virtual_pixel,0);
+      SetPixelOpacity(&virtual_pixel,TransparentOpacity);
+      break;
+    }
+    case MaskVirtualPixelMethod:
+    case WhiteVirtualPixelMethod:
+    {
+      SetPixelRed(&virtual_pixel,QuantumRange);
+      SetPixelGreen(&virtual_pixel,QuantumRange);
+      SetPixelBlue(&virtual_pixel,QuantumRange);
+      SetPixelOpacity(&virtual_pixel,OpaqueOpacity);
+      break;
+    }
+    default:
+    {
+      virtual_pixel=image->background_color;
+      break;
+    }
+  }
+  q=resample_filter->scanline;
+  q_indexes=resample_filter->scanline_indexes;
+  for (i=0; i < (ssize_t) width; i++)
+  {
+    x=u+i;
+    switch (resample_filter->virtual_pixel)
+    {
+      case BackgroundVirtualPixelMethod:
+      case ConstantVirtualPixelMethod:
+      case BlackVirtualPixelMethod:
+      case GrayVirtualPixelMethod:
+      case TransparentVirtualPixelMethod:
+      case MaskVirtualPixelMethod:
+      case WhiteVirtualPixelMethod:
+      {
+        if ((x < 0) || (x >= (ssize_t) image->columns) || (v < 0) ||
+            (v >= (ssize_t) image->rows))
+          {
+            q[i]=virtual_pixel;
+            q_indexes[i]=(IndexPacket) 0;
+            continue;
+          }
+        offset=v*(ssize_t) image->columns+x;
+        break;
+      }
+      default:
+      {
+        /*
+          Edge virtual pixels repeat the nearest edge pixel.
+        */
+        offset=(v < 0 ? 0 : v >= (ssize_t) image->rows ?
+          (ssize_t) image->rows-1 : v)*(ssize_t) image->columns+(x < 0 ? 0 :
+          x >= (ssize_t) image->columns ? (ssize_t) image->columns-1 : x);
+        break;
+      }
+    }
+    q[i]=resample_filter->pixels[offset];
+    if (resample_filter->indexes != (const IndexPacket *) NULL)
+      q_indexes[i]=resample_filter->indexes[offset];
+  }
+  *indexes=(const IndexPacket *) NULL;
+  if (resample_filter->indexes != (const IndexPacket *) NULL)
+    *indexes=resample_filter->scanline_indexes;
+  return(resample_filter->scanline);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -326,7 +532,7 @@ MagickExport MagickBooleanType ResamplePixelColor(
   double divisor_c,divisor_m;
   register double weight;
   register const PixelPacket *pixels;
-  register const IndexPacket *indexes;
+  const IndexPacket *indexes;
   assert(resample_filter != (ResampleFilter *) NULL);
   assert(resample_filter->signature == MagickSignature);
 
@@ -557,6 +763,30 @@ MagickExport MagickBooleanType ResamplePixelColor(
 # define DEBUG_HIT_MISS 0 /* only valid if DEBUG_ELLIPSE is enabled */
 #endif
 
+  /*
+    Scan lines inside the image are read in place rather than through the
+    cache view, if the pixel cache of the image allows it.
+  */
+  if ( resample_filter->pixels_defined == MagickFalse ) {
+    CacheType
+      type;
+
+    resample_filter->pixels_defined = MagickTrue;
+    resample_filter->pixels = (const PixelPacket *) NULL;
+    resample_filter->indexes = (const IndexPacket *) NULL;
+    type = GetPixelCacheType(resample_filter->image);
+    if ( ( type == MemoryCache || type == MapCache ) &&
+         resample_filter->image->clip_mask == (Image *) NULL &&
+         resample_filter->image->mask == (Image *) NULL ) {
+      resample_filter->pixels=GetCacheViewVirtualPixels(resample_filter->view,
+        0,0,resample_filter->image->columns,resample_filter->image->rows,
+        resample_filter->exception);
+      if ( resample_filter->pixels != (const PixelPacket *) NULL )
+        resample_filter->indexes=GetCacheViewVirtualIndexQueue(
+          resample_filter->view);
+    }
+  }
+
   /*
     Do weighted resampling of all pixels,  within the scaled ellipse,
     bound by a Parellelogram fitted to the ellipse.
@@ -580,11 +810,9 @@ MagickExport MagickBooleanType ResamplePixelColor(
     DQ = resample_filter->A*(2.0*U+1) + resample_filter->B*V;
 
     /* get the scanline of pixels for this v */
-    pixels=GetCacheViewVirtualPixels(resample_filter->view,u,v,(size_t) uw,
-      1,resample_filter->exception);
+    pixels=GetResampleScanline(resample_filter,u,v,(size_t) uw,&indexes);
     if (pixels == (const PixelPacket *) NULL)
       return(MagickFalse);
-    indexes=GetCacheViewVirtualIndexQueue(resample_filter->view);
 
     /* count up the weighted pixel colors */
     for( u=0; u<uw; u++ ) {
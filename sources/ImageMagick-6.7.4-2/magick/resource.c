@@ -118,6 +118,30 @@ static SemaphoreInfo
 static SplayTreeInfo
   *temporary_resources = (SplayTreeInfo *) NULL;
 
+static inline MagickOffsetType AdjustMagickResource(
+  MagickOffsetType *resource,const MagickOffsetType size)
+{
+  MagickOffsetType
+    value;
+
+  /*
+    Adjust a resource counter and return its new value; the counters are
+    updated atomically where the compiler supports it, avoiding
+    resource_semaphore.
+  */
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+  value=__sync_add_and_fetch(resource,size);
+#else
+  if (resource_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&resource_semaphore);
+  LockSemaphoreInfo(resource_semaphore);
+  *resource+=size;
+  value=(*resource);
+  UnlockSemaphoreInfo(resource_semaphore);
+#endif
+  return(value);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -154,115 +178,83 @@ MagickExport MagickBooleanType AcquireMagickResource(const ResourceType type,
     resource_request[MaxTextExtent];
 
   MagickBooleanType
+    binary,
     status;
 
   MagickSizeType
+    current,
     limit;
 
-  status=MagickFalse;
-  (void) FormatMagickSize(size,MagickFalse,resource_request);
-  if (resource_semaphore == (SemaphoreInfo *) NULL)
-    AcquireSemaphoreInfo(&resource_semaphore);
-  LockSemaphoreInfo(resource_semaphore);
+  binary=MagickFalse;
+  current=size;
+  limit=MagickResourceInfinity;
   switch (type)
   {
     case AreaResource:
     {
       resource_info.area=(MagickOffsetType) size;
       limit=resource_info.area_limit;
-      status=(resource_info.area_limit == MagickResourceInfinity) ||
-        (size < limit) ? MagickTrue : MagickFalse;
-      (void) FormatMagickSize((MagickSizeType) resource_info.area,MagickFalse,
-        resource_current);
-      (void) FormatMagickSize(resource_info.area_limit,MagickFalse,
-        resource_limit);
       break;
     }
     case MemoryResource:
     {
-      resource_info.memory+=size;
+      binary=MagickTrue;
+      current=(MagickSizeType) AdjustMagickResource(&resource_info.memory,
+        (MagickOffsetType) size);
       limit=resource_info.memory_limit;
-      status=(resource_info.memory_limit == MagickResourceInfinity) ||
-        ((MagickSizeType) resource_info.memory < limit) ?
-        MagickTrue : MagickFalse;
-      (void) FormatMagickSize((MagickSizeType) resource_info.memory,MagickTrue,
-        resource_current);
-      (void) FormatMagickSize(resource_info.memory_limit,MagickTrue,
-        resource_limit);
       break;
     }
     case MapResource:
     {
-      resource_info.map+=size;
+      binary=MagickTrue;
+      current=(MagickSizeType) AdjustMagickResource(&resource_info.map,
+        (MagickOffsetType) size);
       limit=resource_info.map_limit;
-      status=(resource_info.map_limit == MagickResourceInfinity) ||
-        ((MagickSizeType) resource_info.map < limit) ?
-        MagickTrue : MagickFalse;
-      (void) FormatMagickSize((MagickSizeType) resource_info.map,MagickTrue,
-        resource_current);
-      (void) FormatMagickSize(resource_info.map_limit,MagickTrue,
-        resource_limit);
       break;
     }
     case DiskResource:
     {
-      resource_info.disk+=size;
+      binary=MagickTrue;
+      current=(MagickSizeType) AdjustMagickResource(&resource_info.disk,
+        (MagickOffsetType) size);
       limit=resource_info.disk_limit;
-      status=(resource_info.disk_limit == MagickResourceInfinity) ||
-        ((MagickSizeType) resource_info.disk < limit) ?
-        MagickTrue : MagickFalse;
-      (void) FormatMagickSize((MagickSizeType) resource_info.disk,MagickTrue,
-        resource_current);
-      (void) FormatMagickSize(resource_info.disk_limit,MagickTrue,
-        resource_limit);
       break;
     }
     case FileResource:
     {
-      resource_info.file+=size;
+      current=(MagickSizeType) AdjustMagickResource(&resource_info.file,
+        (MagickOffsetType) size);
       limit=resource_info.file_limit;
-      status=(resource_info.file_limit == MagickResourceInfinity) ||
-        ((MagickSizeType) resource_info.file < limit) ?
-        MagickTrue : MagickFalse;
-      (void) FormatMagickSize((MagickSizeType) resource_info.file,MagickFalse,
-        resource_current);
-      (void) FormatMagickSize((MagickSizeType) resource_info.file_limit,
-        MagickFalse,resource_limit);
       break;
     }
     case ThreadResource:
     {
-      resource_info.thread+=size;
+      current=(MagickSizeType) AdjustMagickResource(&resource_info.thread,
+        (MagickOffsetType) size);
       limit=resource_info.thread_limit;
-      status=(resource_info.thread_limit == MagickResourceInfinity) ||
-        ((MagickSizeType) resource_info.thread < limit) ?
-        MagickTrue : MagickFalse;
-      (void) FormatMagickSize((MagickSizeType) resource_info.thread,MagickFalse,
-        resource_current);
-      (void) FormatMagickSize((MagickSizeType) resource_info.thread_limit,
-        MagickFalse,resource_limit);
       break;
     }
     case TimeResource:
     {
-      resource_info.time+=size;
+      current=(MagickSizeType) AdjustMagickResource(&resource_info.time,
+        (MagickOffsetType) size);
       limit=resource_info.time_limit;
-      status=(resource_info.time_limit == MagickResourceInfinity) ||
-        ((MagickSizeType) resource_info.time < limit) ?
-        MagickTrue : MagickFalse;
-      (void) FormatMagickSize((MagickSizeType) resource_info.time,MagickFalse,
-        resource_current);
-      (void) FormatMagickSize((MagickSizeType) resource_info.time_limit,
-        MagickFalse,resource_limit);
       break;
     }
     default:
-      break;
+      return(MagickFalse);
   }
-  UnlockSemaphoreInfo(resource_semaphore);
-  (void) LogMagickEvent(ResourceEvent,GetMagickModule(),"%s: %s/%s/%s",
-    CommandOptionToMnemonic(MagickResourceOptions,(ssize_t) type),
-    resource_request,resource_current,resource_limit);
+  status=(limit == MagickResourceInfinity) || (current < limit) ? MagickTrue :
+    MagickFalse;
+  if (IsEventLogging() != MagickFalse)
+    {
+      (void) FormatMagickSize(size,MagickFalse,resource_request);
+      (void) FormatMagickSize(current,binary,resource_current);
+      (void) FormatMagickSize(limit,binary,resource_limit);
+      (void) LogMagickEvent(ResourceEvent,GetMagickModule(),"%s: %s/%s/%s",
+        CommandOptionToMnemonic(MagickResourceOptions,(ssize_t) type),
+        resource_request,resource_current,resource_limit);
+    }
   return(status);
 }
 
@@ -737,82 +729,81 @@ MagickExport void RelinquishMagickResource(const ResourceType type,
     resource_limit[MaxTextExtent],
     resource_request[MaxTextExtent];
 
-  (void) FormatMagickSize(size,MagickFalse,resource_request);
-  if (resource_semaphore == (SemaphoreInfo *) NULL)
-    AcquireSemaphoreInfo(&resource_semaphore);
-  LockSemaphoreInfo(resource_semaphore);
+  MagickBooleanType
+    binary;
+
+  MagickSizeType
+    current,
+    limit;
+
+  binary=MagickFalse;
+  current=size;
+  limit=MagickResourceInfinity;
   switch (type)
   {
     case AreaResource:
     {
       resource_info.area=(MagickOffsetType) size;
-      (void) FormatMagickSize((MagickSizeType) resource_info.area,MagickFalse,
-        resource_current);
-      (void) FormatMagickSize(resource_info.area_limit,MagickFalse,
-        resource_limit);
+      limit=resource_info.area_limit;
       break;
     }
     case MemoryResource:
     {
-      resource_info.memory-=size;
-      (void) FormatMagickSize((MagickSizeType) resource_info.memory,
-        MagickTrue,resource_current);
-      (void) FormatMagickSize(resource_info.memory_limit,MagickTrue,
-        resource_limit);
+      binary=MagickTrue;
+      current=(MagickSizeType) AdjustMagickResource(&resource_info.memory,
+        -((MagickOffsetType) size));
+      limit=resource_info.memory_limit;
       break;
     }
     case MapResource:
     {
-      resource_info.map-=size;
-      (void) FormatMagickSize((MagickSizeType) resource_info.map,MagickTrue,
-        resource_current);
-      (void) FormatMagickSize(resource_info.map_limit,MagickTrue,
-        resource_limit);
+      binary=MagickTrue;
+      current=(MagickSizeType) AdjustMagickResource(&resource_info.map,
+        -((MagickOffsetType) size));
+      limit=resource_info.map_limit;
       break;
     }
     case DiskResource:
     {
-      resource_info.disk-=size;
-      (void) FormatMagickSize((MagickSizeType) resource_info.disk,MagickTrue,
-        resource_current);
-      (void) FormatMagickSize(resource_info.disk_limit,MagickTrue,
-        resource_limit);
+      binary=MagickTrue;
+      current=(MagickSizeType) AdjustMagickResource(&resource_info.disk,
+        -((MagickOffsetType) size));
+      limit=resource_info.disk_limit;
       break;
     }
     case FileResource:
     {
-      resource_info.file-=size;
-      (void) FormatMagickSize((MagickSizeType) resource_info.file,MagickFalse,
-        resource_current);
-      (void) FormatMagickSize((MagickSizeType) resource_info.file_limit,
-        MagickFalse,resource_limit);
+      current=(MagickSizeType) AdjustMagickResource(&resource_info.file,
+        -((MagickOffsetType) size));
+      limit=resource_info.file_limit;
       break;
     }
     case ThreadResource:
     {
-      resource_info.thread-=size;
-      (void) FormatMagickSize((MagickSizeType) resource_info.thread,MagickFalse,
-        resource_current);
-      (void) FormatMagickSize((MagickSizeType) resource_info.thread_limit,
-        MagickFalse,resource_limit);
+      current=(MagickSizeType) AdjustMagickResource(&resource_info.thread,
+        -((MagickOffsetType) size));
+      limit=resource_info.thread_limit;
       break;
     }
     case TimeResource:
     {
-      resource_info.time-=size;
-      (void) FormatMagickSize((MagickSizeType) resource_info.time,MagickFalse,
-        resource_current);
-      (void) FormatMagickSize((MagickSizeType) resource_info.time_limit,
-        MagickFalse,resource_limit);
+      current=(MagickSizeType) AdjustMagickResource(&resource_info.time,
+        -((MagickOffsetType) size));
+      limit=resource_info.time_limit;
       break;
     }
     default:
-      break;
+      return;
   }
-  UnlockSemaphoreInfo(resource_semaphore);
-  (void) LogMagickEvent(ResourceEvent,GetMagickModule(),"%s: %s/%s/%s",
-    CommandOptionToMnemonic(MagickResourceOptions,(ssize_t) type),
-      resource_request,resource_current,resource_limit);
+  if (IsEventLogging() != MagickFalse)
+    {
+      (void) FormatMagickSize(size,MagickFalse,resource_request);
+      (void) FormatMagickSize(current,binary,resource_current);
+      (void) FormatMagickSize(limit,binary,resource_limit);
+      (void) LogMagickEvent(ResourceEvent,GetMagickModule(),"%s: %s/%s/%s",
+        CommandOptionToMnemonic(MagickResourceOptions,(ssize_t) type),
+        resource_request,resource_current,resource_limit);
+    }
 }
 
 /*
@@ -866,6 +857,88 @@ MagickExport MagickBooleanType RelinquishUniqueFileResource(const char *path)
   return(remove_utf8(path) == 0 ? MagickTrue : MagickFalse);
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   R e s o u r c e C o m p o n e n t F o r k C h i l d                       %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ResourceComponentForkChild() releases the resource component in the child
+%  process after a fork().  The child forgets the temporary files it inherited,
+%  since they belong to the parent.  Its temporary filenames differ from its
+%  parent's and siblings' because RandomComponentForkChild() reseeds the
+%  random generator that names them.
+%
+%  The format of the ResourceComponentForkChild method is:
+%
+%      ResourceComponentForkChild(void)
+%
+*/
+MagickExport void ResourceComponentForkChild(void)
+{
+  /*
+    The inherited list is abandoned rather than destroyed: destroying it
+    would remove the parent's files.
+  */
+  temporary_resources=(SplayTreeInfo *) NULL;
+  UnlockSemaphoreInfo(resource_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   R e s o u r c e C o m p o n e n t F o r k P a r e n t                     %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ResourceComponentForkParent() releases the resource component in the
+%  parent process after a fork().
+%
+%  The format of the ResourceComponentForkParent method is:
+%
+%      ResourceComponentForkParent(void)
+%
+*/
+MagickExport void ResourceComponentForkParent(void)
+{
+  UnlockSemaphoreInfo(resource_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   R e s o u r c e C o m p o n e n t F o r k P r e p a r e                   %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ResourceComponentForkPrepare() locks the resource component before a
+%  fork().
+%
+%  The format of the ResourceComponentForkPrepare method is:
+%
+%      ResourceComponentForkPrepare(void)
+%
+*/
+MagickExport void ResourceComponentForkPrepare(void)
+{
+  if (resource_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&resource_semaphore);
+  LockSemaphoreInfo(resource_semaphore);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -54,6 +54,9 @@ extern MagickExport MagickSizeType
 extern MagickExport void
   AsynchronousResourceComponentTerminus(void),
   RelinquishMagickResource(const ResourceType,const MagickSizeType),
+  ResourceComponentForkChild(void),
+  ResourceComponentForkParent(void),
+  ResourceComponentForkPrepare(void),
   ResourceComponentTerminus(void);
 
 #if defined(__cplusplus) || defined(c_plusplus)
@@ -40,7 +40,9 @@
   Include declarations.
 */
 #include "magick/studio.h"
+#include "magick/artifact.h"
 #include "magick/cache.h"
+#include "magick/cache-view.h"
 #include "magick/exception.h"
 #include "magick/exception-private.h"
 #include "magick/property.h"
@@ -51,15 +53,31 @@
 #include "magick/signature.h"
 #include "magick/signature-private.h"
 #include "magick/string_.h"
+#include "magick/thread-private.h"
+#if defined(__GNUC__) && ((__GNUC__ >= 5) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define MAGICKCORE_SHA_EXTENSIONS  1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 /*
   Define declarations.
 */
 #define SignatureBlocksize  64
 #define SignatureDigestsize  32
+#define SignatureStripExtent  65536
 
 /*
   Typedef declarations.
 */
+typedef enum
+{
+  SHA256SignatureAlgorithm,
+  SHA256TreeSignatureAlgorithm,
+  XXH64SignatureAlgorithm
+} SignatureAlgorithm;
+
 struct _SignatureInfo
 {
   unsigned int
@@ -79,7 +97,7 @@ struct _SignatureInfo
     offset;
 
   MagickBooleanType
-    lsb_first;
+    sha_extensions;
 
   ssize_t
     timestamp;
@@ -92,7 +110,8 @@ struct _SignatureInfo
   Forward declarations.
 */
 static void
-  TransformSignature(SignatureInfo *);
+  TransformSignature(SignatureInfo *,const unsigned char *),
+  UpdateSignatureBlocks(SignatureInfo *,const unsigned char *,size_t);
 
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -112,14 +131,34 @@ static void
 %      SignatureInfo *AcquireSignatureInfo(void)
 %
 */
+#if defined(MAGICKCORE_SHA_EXTENSIONS)
+static MagickBooleanType HasSHAExtensions(void)
+{
+  unsigned int
+    eax,
+    ebx,
+    ecx,
+    edx;
+
+  /*
+    SHA-NI is reported in leaf 7; the shuffles also need SSSE3 and SSE4.1.
+  */
+  if (__get_cpuid(1,&eax,&ebx,&ecx,&edx) == 0)
+    return(MagickFalse);
+  if (((ecx & bit_SSSE3) == 0) || ((ecx & bit_SSE4_1) == 0))
+    return(MagickFalse);
+  if (__get_cpuid_max(0,(unsigned int *) NULL) < 7)
+    return(MagickFalse);
+  __cpuid_count(7,0,eax,ebx,ecx,edx);
+  return((ebx & (1U << 29)) != 0 ? MagickTrue : MagickFalse);
+}
+#endif
+
 MagickExport SignatureInfo *AcquireSignatureInfo(void)
 {
   SignatureInfo
     *signature_info;
 
-  unsigned int
-    lsb_first;
-
   signature_info=(SignatureInfo *) AcquireMagickMemory(sizeof(*signature_info));
   if (signature_info == (SignatureInfo *) NULL)
     ThrowFatalException(ResourceLimitFatalError,"MemoryAllocationFailed");
@@ -132,9 +171,9 @@ MagickExport SignatureInfo *AcquireSignatureInfo(void)
     SignatureBlocksize,sizeof(*signature_info->accumulator));
   if (signature_info->accumulator == (unsigned int *) NULL)
     ThrowFatalException(ResourceLimitFatalError,"MemoryAllocationFailed");
-  lsb_first=1;
-  signature_info->lsb_first=(int) (*(char *) &lsb_first) == 1 ? MagickTrue :
-    MagickFalse;
+#if defined(MAGICKCORE_SHA_EXTENSIONS)
+  signature_info->sha_extensions=HasSHAExtensions();
+#endif
   signature_info->timestamp=(ssize_t) time(0);
   signature_info->signature=MagickSignature;
   InitializeSignature(signature_info);
@@ -240,7 +279,7 @@ MagickExport void FinalizeSignature(SignatureInfo *signature_info)
     {
       (void) ResetMagickMemory(datum+count,0,GetStringInfoLength(
         signature_info->message)-count);
-      TransformSignature(signature_info);
+      TransformSignature(signature_info,datum);
       (void) ResetMagickMemory(datum,0,GetStringInfoLength(
         signature_info->message)-8);
     }
@@ -252,7 +291,7 @@ MagickExport void FinalizeSignature(SignatureInfo *signature_info)
   datum[61]=(unsigned char) (low_order >> 16);
   datum[62]=(unsigned char) (low_order >> 8);
   datum[63]=(unsigned char) low_order;
-  TransformSignature(signature_info);
+  TransformSignature(signature_info,datum);
   p=signature_info->accumulator;
   q=GetStringInfoDatum(signature_info->digest);
   for (i=0; i < (SignatureDigestsize/4); i++)
@@ -456,6 +495,10 @@ MagickExport void SetSignatureDigest(SignatureInfo *signature_info,
 %  signature uniquely identifies the image and is convenient for determining
 %  if an image has been modified or whether two images are identical.
 %
+%  The signature:algorithm artifact selects sha256 (the default), sha256-tree
+%  (the SHA-256 of the SHA-256 digests of strips of the pixel stream, hashed
+%  in parallel), or xxh64 (a fast 64-bit non-cryptographic digest).
+%
 %  The format of the SignatureImage method is:
 %
 %      MagickBooleanType SignatureImage(Image *image)
@@ -465,6 +508,161 @@ MagickExport void SetSignatureDigest(SignatureInfo *signature_info,
 %    o image: the image.
 %
 */
+/*
+  A 64-bit non-cryptographic digest with the XXH64 construction, used by
+  SignatureImage() when signature:algorithm is xxh64.
+*/
+#define XXH64Prime1  MagickULLConstant(0x9e3779b185ebca87)
+#define XXH64Prime2  MagickULLConstant(0xc2b2ae3d27d4eb4f)
+#define XXH64Prime3  MagickULLConstant(0x165667b19e3779f9)
+#define XXH64Prime4  MagickULLConstant(0x85ebca77c2b2ca63)
+#define XXH64Prime5  MagickULLConstant(0x27d4eb2f165667c5)
+
+typedef struct _XXH64Info
+{
+  MagickSizeType
+    accumulator[4],
+    length;
+
+  unsigned char
+    message[32];
+
+  size_t
+    offset;
+} XXH64Info;
+
+static inline MagickSizeType XXH64Rotate(const MagickSizeType x,
+  const unsigned int n)
+{
+  return((x << n) | (x >> (64-n)));
+}
+
+static inline MagickSizeType XXH64Load64(const unsigned char *p)
+{
+  return((MagickSizeType) p[0] | ((MagickSizeType) p[1] << 8) |
+    ((MagickSizeType) p[2] << 16) | ((MagickSizeType) p[3] << 24) |
+    ((MagickSizeType) p[4] << 32) | ((MagickSizeType) p[5] << 40) |
+    ((MagickSizeType) p[6] << 48) | ((MagickSizeType) p[7] << 56));
+}
+
+static inline MagickSizeType XXH64Round(MagickSizeType accumulator,
+  const MagickSizeType value)
+{
+  accumulator+=value*XXH64Prime2;
+  accumulator=XXH64Rotate(accumulator,31);
+  return(accumulator*XXH64Prime1);
+}
+
+static inline MagickSizeType XXH64Merge(MagickSizeType accumulator,
+  const MagickSizeType value)
+{
+  accumulator^=XXH64Round(0,value);
+  return(accumulator*XXH64Prime1+XXH64Prime4);
+}
+
+static void InitializeXXH64(XXH64Info *xxh64_info)
+{
+  (void) ResetMagickMemory(xxh64_info,0,sizeof(*xxh64_info));
+  xxh64_info->accumulator[0]=XXH64Prime1+XXH64Prime2;
+  xxh64_info->accumulator[1]=XXH64Prime2;
+  xxh64_info->accumulator[2]=0;
+  xxh64_info->accumulator[3]=(MagickSizeType) 0-XXH64Prime1;
+}
+
+static inline void TransformXXH64(XXH64Info *xxh64_info,
+  const unsigned char *message)
+{
+  xxh64_info->accumulator[0]=XXH64Round(xxh64_info->accumulator[0],
+    XXH64Load64(message));
+  xxh64_info->accumulator[1]=XXH64Round(xxh64_info->accumulator[1],
+    XXH64Load64(message+8));
+  xxh64_info->accumulator[2]=XXH64Round(xxh64_info->accumulator[2],
+    XXH64Load64(message+16));
+  xxh64_info->accumulator[3]=XXH64Round(xxh64_info->accumulator[3],
+    XXH64Load64(message+24));
+}
+
+static void UpdateXXH64(XXH64Info *xxh64_info,const unsigned char *message,
+  size_t length)
+{
+  size_t
+    i;
+
+  xxh64_info->length+=length;
+  if (xxh64_info->offset != 0)
+    {
+      i=sizeof(xxh64_info->message)-xxh64_info->offset;
+      if (i > length)
+        i=length;
+      (void) CopyMagickMemory(xxh64_info->message+xxh64_info->offset,message,
+        i);
+      xxh64_info->offset+=i;
+      message+=i;
+      length-=i;
+      if (xxh64_info->offset != sizeof(xxh64_info->message))
+        return;
+      TransformXXH64(xxh64_info,xxh64_info->message);
+      xxh64_info->offset=0;
+    }
+  for ( ; length >= sizeof(xxh64_info->message); length-=32, message+=32)
+    TransformXXH64(xxh64_info,message);
+  (void) CopyMagickMemory(xxh64_info->message,message,length);
+  xxh64_info->offset=length;
+}
+
+static MagickSizeType FinalizeXXH64(const XXH64Info *xxh64_info)
+{
+  MagickSizeType
+    digest;
+
+  register const unsigned char
+    *p;
+
+  size_t
+    n;
+
+  if (xxh64_info->length < 32)
+    digest=XXH64Prime5;
+  else
+    {
+      digest=XXH64Rotate(xxh64_info->accumulator[0],1)+
+        XXH64Rotate(xxh64_info->accumulator[1],7)+
+        XXH64Rotate(xxh64_info->accumulator[2],12)+
+        XXH64Rotate(xxh64_info->accumulator[3],18);
+      digest=XXH64Merge(digest,xxh64_info->accumulator[0]);
+      digest=XXH64Merge(digest,xxh64_info->accumulator[1]);
+      digest=XXH64Merge(digest,xxh64_info->accumulator[2]);
+      digest=XXH64Merge(digest,xxh64_info->accumulator[3]);
+    }
+  digest+=xxh64_info->length;
+  p=xxh64_info->message;
+  for (n=xxh64_info->offset; n >= 8; n-=8, p+=8)
+  {
+    digest^=XXH64Round(0,XXH64Load64(p));
+    digest=XXH64Rotate(digest,27)*XXH64Prime1+XXH64Prime4;
+  }
+  if (n >= 4)
+    {
+      digest^=((MagickSizeType) p[0] | ((MagickSizeType) p[1] << 8) |
+        ((MagickSizeType) p[2] << 16) | ((MagickSizeType) p[3] << 24))*
+        XXH64Prime1;
+      digest=XXH64Rotate(digest,23)*XXH64Prime2+XXH64Prime3;
+      n-=4;
+      p+=4;
+    }
+  for ( ; n != 0; n--, p++)
+  {
+    digest^=(*p)*XXH64Prime5;
+    digest=XXH64Rotate(digest,11)*XXH64Prime1;
+  }
+  digest^=digest >> 33;
+  digest*=XXH64Prime2;
+  digest^=digest >> 29;
+  digest*=XXH64Prime3;
+  digest^=digest >> 32;
+  return(digest);
+}
+
 MagickExport MagickBooleanType SignatureImage(Image *image)
 {
   CacheView
@@ -473,32 +671,47 @@ MagickExport MagickBooleanType SignatureImage(Image *image)
   char
     *hex_signature;
 
+  const char
+    *artifact;
+
   ExceptionInfo
     *exception;
 
+  MagickBooleanType
+    status;
+
   QuantumInfo
-    *quantum_info;
+    **quantum_info;
 
   QuantumType
     quantum_type;
 
-  register const PixelPacket
-    *p;
+  SignatureAlgorithm
+    algorithm;
 
   SignatureInfo
     *signature_info;
 
   size_t
-    length;
+    extent,
+    *lengths,
+    number_strips,
+    number_threads,
+    rows_per_strip;
 
   ssize_t
-    y;
+    i,
+    strip;
 
   StringInfo
+    *digests,
     *signature;
 
   unsigned char
-    *pixels;
+    **strips;
+
+  XXH64Info
+    xxh64_info;
 
   /*
     Compute image digital signature.
@@ -507,10 +720,20 @@ MagickExport MagickBooleanType SignatureImage(Image *image)
   assert(image->signature == MagickSignature);
   if (image->debug != MagickFalse)
     (void) LogMagickEvent(TraceEvent,GetMagickModule(),"%s",image->filename);
-  quantum_info=AcquireQuantumInfo((const ImageInfo *) NULL,image);
-  if (quantum_info == (QuantumInfo *) NULL)
-    ThrowBinaryException(ResourceLimitError,"MemoryAllocationFailed",
-      image->filename);
+  algorithm=SHA256SignatureAlgorithm;
+  artifact=GetImageArtifact(image,"signature:algorithm");
+  if (artifact != (const char *) NULL)
+    {
+      if (LocaleCompare(artifact,"sha256-tree") == 0)
+        algorithm=SHA256TreeSignatureAlgorithm;
+      else
+        if (LocaleCompare(artifact,"xxh64") == 0)
+          algorithm=XXH64SignatureAlgorithm;
+        else
+          if (LocaleCompare(artifact,"sha256") != 0)
+            ThrowBinaryException(OptionError,"UnrecognizedSignatureAlgorithm",
+              artifact);
+    }
   quantum_type=RGBQuantum;
   if (image->matte != MagickFalse)
     quantum_type=RGBAQuantum;
@@ -520,35 +743,197 @@ MagickExport MagickBooleanType SignatureImage(Image *image)
       if (image->matte != MagickFalse)
         quantum_type=CMYKAQuantum;
     }
-  signature_info=AcquireSignatureInfo();
-  signature=AcquireStringInfo(quantum_info->extent);
-  pixels=GetQuantumPixels(quantum_info);
+  /*
+    Rows are exported in strips of about SignatureStripExtent pixels, a
+    batch of strips in parallel, and hashed in image order.  The strip
+    layout depends only on the image width, so the tree digest does not
+    depend on the number of threads.
+  */
+  rows_per_strip=SignatureStripExtent;
+  if (image->columns != 0)
+    rows_per_strip/=image->columns;
+  if (rows_per_strip == 0)
+    rows_per_strip=1;
+  number_strips=(image->rows+rows_per_strip-1)/rows_per_strip;
+  number_threads=GetOpenMPMaximumThreads();
+  strips=(unsigned char **) AcquireQuantumMemory(number_threads,
+    sizeof(*strips));
+  lengths=(size_t *) AcquireQuantumMemory(number_threads,sizeof(*lengths));
+  quantum_info=(QuantumInfo **) AcquireQuantumMemory(number_threads,
+    sizeof(*quantum_info));
+  digests=AcquireStringInfo((number_strips != 0 ? number_strips : 1)*
+    SignatureDigestsize);
+  if ((strips == (unsigned char **) NULL) || (lengths == (size_t *) NULL) ||
+      (quantum_info == (QuantumInfo **) NULL))
+    {
+      if (quantum_info != (QuantumInfo **) NULL)
+        quantum_info=(QuantumInfo **) RelinquishMagickMemory(quantum_info);
+      if (lengths != (size_t *) NULL)
+        lengths=(size_t *) RelinquishMagickMemory(lengths);
+      if (strips != (unsigned char **) NULL)
+        strips=(unsigned char **) RelinquishMagickMemory(strips);
+      digests=DestroyStringInfo(digests);
+      ThrowBinaryException(ResourceLimitError,"MemoryAllocationFailed",
+        image->filename);
+    }
+  status=MagickTrue;
   exception=(&image->exception);
+  (void) ResetMagickMemory(strips,0,number_threads*sizeof(*strips));
+  (void) ResetMagickMemory(quantum_info,0,number_threads*
+    sizeof(*quantum_info));
+  for (i=0; i < (ssize_t) number_threads; i++)
+  {
+    /*
+      ExportQuantumPixels() keeps its bit-packing state in the QuantumInfo,
+      so each thread exports through its own.
+    */
+    quantum_info[i]=AcquireQuantumInfo((const ImageInfo *) NULL,image);
+    if (quantum_info[i] == (QuantumInfo *) NULL)
+      {
+        (void) ThrowMagickException(exception,GetMagickModule(),
+          ResourceLimitError,"MemoryAllocationFailed","`%s'",image->filename);
+        status=MagickFalse;
+        break;
+      }
+    extent=GetQuantumExtent(image,quantum_info[i],quantum_type);
+    strips[i]=(unsigned char *) AcquireQuantumMemory(rows_per_strip,extent);
+    if (strips[i] == (unsigned char *) NULL)
+      {
+        (void) ThrowMagickException(exception,GetMagickModule(),
+          ResourceLimitError,"MemoryAllocationFailed","`%s'",image->filename);
+        status=MagickFalse;
+        break;
+      }
+  }
+  signature_info=AcquireSignatureInfo();
+  InitializeXXH64(&xxh64_info);
   image_view=AcquireCacheView(image);
-  for (y=0; y < (ssize_t) image->rows; y++)
+  for (strip=0; (status != MagickFalse) && (strip < (ssize_t) number_strips);
+       strip+=number_threads)
   {
-    p=GetCacheViewVirtualPixels(image_view,0,y,image->columns,1,exception);
-    if (p == (const PixelPacket *) NULL)
+    size_t
+      count;
+
+    count=number_strips-strip;
+    if (count > number_threads)
+      count=number_threads;
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+    #pragma omp parallel for schedule(static,1) shared(status)
+#endif
+    for (i=0; i < (ssize_t) count; i++)
+    {
+      const int
+        id = GetOpenMPThreadId();
+
+      register const PixelPacket
+        *p;
+
+      size_t
+        length;
+
+      ssize_t
+        rows,
+        y;
+
+      lengths[i]=0;
+      rows=(ssize_t) ((strip+i+1)*rows_per_strip);
+      if (rows > (ssize_t) image->rows)
+        rows=(ssize_t) image->rows;
+      for (y=(strip+i)*rows_per_strip; y < rows; y++)
+      {
+        p=GetCacheViewVirtualPixels(image_view,0,y,image->columns,1,
+          exception);
+        if (p == (const PixelPacket *) NULL)
+          {
+            status=MagickFalse;
+            break;
+          }
+        length=ExportQuantumPixels(image,image_view,quantum_info[id],
+          quantum_type,strips[i]+lengths[i],exception);
+        lengths[i]+=length;
+      }
+      if (algorithm == SHA256TreeSignatureAlgorithm)
+        {
+          SignatureInfo
+            *strip_info;
+
+          strip_info=AcquireSignatureInfo();
+          UpdateSignatureBlocks(strip_info,strips[i],lengths[i]);
+          FinalizeSignature(strip_info);
+          (void) CopyMagickMemory(GetStringInfoDatum(digests)+(strip+i)*
+            SignatureDigestsize,GetStringInfoDatum(strip_info->digest),
+            SignatureDigestsize);
+          strip_info=DestroySignatureInfo(strip_info);
+        }
+    }
+    if (status == MagickFalse)
       break;
-    length=ExportQuantumPixels(image,image_view,quantum_info,quantum_type,
-      pixels,&image->exception);
-    SetStringInfoLength(signature,length);
-    SetStringInfoDatum(signature,pixels);
-    UpdateSignature(signature_info,signature);
+    for (i=0; i < (ssize_t) count; i++)
+      if (algorithm == SHA256SignatureAlgorithm)
+        UpdateSignatureBlocks(signature_info,strips[i],lengths[i]);
+      else
+        if (algorithm == XXH64SignatureAlgorithm)
+          UpdateXXH64(&xxh64_info,strips[i],lengths[i]);
   }
   image_view=DestroyCacheView(image_view);
-  quantum_info=DestroyQuantumInfo(quantum_info);
-  FinalizeSignature(signature_info);
-  hex_signature=StringInfoToHexString(GetSignatureDigest(signature_info));
-  (void) DeleteImageProperty(image,"signature");
-  (void) SetImageProperty(image,"signature",hex_signature);
+  for (i=0; i < (ssize_t) number_threads; i++)
+    if (strips[i] != (unsigned char *) NULL)
+      strips[i]=(unsigned char *) RelinquishMagickMemory(strips[i]);
+  strips=(unsigned char **) RelinquishMagickMemory(strips);
+  lengths=(size_t *) RelinquishMagickMemory(lengths);
+  for (i=0; i < (ssize_t) number_threads; i++)
+    if (quantum_info[i] != (QuantumInfo *) NULL)
+      quantum_info[i]=DestroyQuantumInfo(quantum_info[i]);
+  quantum_info=(QuantumInfo **) RelinquishMagickMemory(quantum_info);
+  switch (algorithm)
+  {
+    case SHA256TreeSignatureAlgorithm:
+    {
+      /*
+        The image signature is the SHA-256 of the strip digests.
+      */
+      UpdateSignatureBlocks(signature_info,GetStringInfoDatum(digests),
+        number_strips*SignatureDigestsize);
+      FinalizeSignature(signature_info);
+      signature=CloneStringInfo(GetSignatureDigest(signature_info));
+      break;
+    }
+    case XXH64SignatureAlgorithm:
+    {
+      MagickSizeType
+        digest;
+
+      unsigned char
+        *q;
+
+      digest=FinalizeXXH64(&xxh64_info);
+      signature=AcquireStringInfo(8);
+      q=GetStringInfoDatum(signature);
+      for (i=0; i < 8; i++)
+        *q++=(unsigned char) (digest >> (56-8*i));
+      break;
+    }
+    default:
+    {
+      FinalizeSignature(signature_info);
+      signature=CloneStringInfo(GetSignatureDigest(signature_info));
+      break;
+    }
+  }
+  if (status != MagickFalse)
+    {
+      hex_signature=StringInfoToHexString(signature);
+      (void) DeleteImageProperty(image,"signature");
+      (void) SetImageProperty(image,"signature",hex_signature);
+      hex_signature=DestroyString(hex_signature);
+    }
   /*
     Free resources.
   */
-  hex_signature=DestroyString(hex_signature);
   signature=DestroyStringInfo(signature);
+  digests=DestroyStringInfo(digests);
   signature_info=DestroySignatureInfo(signature_info);
-  return(MagickTrue);
+  return(status);
 }
 
 /*
@@ -566,14 +951,96 @@ MagickExport MagickBooleanType SignatureImage(Image *image)
 %
 %  The format of the TransformSignature method is:
 %
-%      TransformSignature(SignatureInfo *signature_info)
+%      TransformSignature(SignatureInfo *signature_info,
+%        const unsigned char *message)
 %
 %  A description of each parameter follows:
 %
 %    o signature_info: the address of a structure of type SignatureInfo.
 %
+%    o message: a 64 byte message block.
+%
 */
 
+static const unsigned int
+  SHA256Constants[64] =
+  {
+    0x428a2f98U, 0x71374491U, 0xb5c0fbcfU, 0xe9b5dba5U, 0x3956c25bU,
+    0x59f111f1U, 0x923f82a4U, 0xab1c5ed5U, 0xd807aa98U, 0x12835b01U,
+    0x243185beU, 0x550c7dc3U, 0x72be5d74U, 0x80deb1feU, 0x9bdc06a7U,
+    0xc19bf174U, 0xe49b69c1U, 0xefbe4786U, 0x0fc19dc6U, 0x240ca1ccU,
+    0x2de92c6fU, 0x4a7484aaU, 0x5cb0a9dcU, 0x76f988daU, 0x983e5152U,
+    0xa831c66dU, 0xb00327c8U, 0xbf597fc7U, 0xc6e00bf3U, 0xd5a79147U,
+    0x06ca6351U, 0x14292967U, 0x27b70a85U, 0x2e1b2138U, 0x4d2c6dfcU,
+    0x53380d13U, 0x650a7354U, 0x766a0abbU, 0x81c2c92eU, 0x92722c85U,
+    0xa2bfe8a1U, 0xa81a664bU, 0xc24b8b70U, 0xc76c51a3U, 0xd192e819U,
+    0xd6990624U, 0xf40e3585U, 0x106aa070U, 0x19a4c116U, 0x1e376c08U,
+    0x2748774cU, 0x34b0bcb5U, 0x391c0cb3U, 0x4ed8aa4aU, 0x5b9cca4fU,
+    0x682e6ff3U, 0x748f82eeU, 0x78a5636fU, 0x84c87814U, 0x8cc70208U,
+    0x90befffaU, 0xa4506cebU, 0xbef9a3f7U, 0xc67178f2U
+  };  /* 32-bit fractional part of the cube root of the first 64 primes */
+
+#if defined(MAGICKCORE_SHA_EXTENSIONS)
+__attribute__((target("sha,ssse3,sse4.1")))
+static void TransformSignatureSHA(unsigned int *accumulator,
+  const unsigned char *message)
+{
+  __m128i
+    abef,
+    cdgh,
+    mask,
+    state0,
+    state1,
+    w[4],
+    work;
+
+  register ssize_t
+    i;
+
+  /*
+    Rearrange the accumulator into the ABEF/CDGH layout of sha256rnds2.
+  */
+  mask=_mm_set_epi64x(0x0c0d0e0f08090a0bULL,0x0405060700010203ULL);
+  work=_mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) accumulator),0xb1);
+  state1=_mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)
+    (accumulator+4)),0x1b);
+  state0=_mm_alignr_epi8(work,state1,8);
+  state1=_mm_blend_epi16(state1,work,0xf0);
+  abef=state0;
+  cdgh=state1;
+  for (i=0; i < 4; i++)
+    w[i]=_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)
+      (message+16*i)),mask);
+  for (i=0; i < 16; i++)
+  {
+    /*
+      Four rounds per step; the message schedule runs three steps ahead.
+    */
+    work=_mm_add_epi32(w[i & 0x03],_mm_loadu_si128((const __m128i *)
+      (SHA256Constants+4*i)));
+    state1=_mm_sha256rnds2_epu32(state1,state0,work);
+    if ((i >= 3) && (i < 15))
+      {
+        w[(i+1) & 0x03]=_mm_add_epi32(w[(i+1) & 0x03],
+          _mm_alignr_epi8(w[i & 0x03],w[(i-1) & 0x03],4));
+        w[(i+1) & 0x03]=_mm_sha256msg2_epu32(w[(i+1) & 0x03],w[i & 0x03]);
+      }
+    work=_mm_shuffle_epi32(work,0x0e);
+    state0=_mm_sha256rnds2_epu32(state0,state1,work);
+    if ((i >= 1) && (i < 13))
+      w[(i-1) & 0x03]=_mm_sha256msg1_epu32(w[(i-1) & 0x03],w[i & 0x03]);
+  }
+  state0=_mm_add_epi32(state0,abef);
+  state1=_mm_add_epi32(state1,cdgh);
+  work=_mm_shuffle_epi32(state0,0x1b);
+  state1=_mm_shuffle_epi32(state1,0xb1);
+  state0=_mm_blend_epi16(work,state1,0xf0);
+  state1=_mm_alignr_epi8(state1,work,8);
+  _mm_storeu_si128((__m128i *) accumulator,state0);
+  _mm_storeu_si128((__m128i *) (accumulator+4),state1);
+}
+#endif
+
 static inline unsigned int Ch(unsigned int x,unsigned int y,unsigned int z)
 {
   return((x & y) ^ (~x & z));
@@ -589,12 +1056,13 @@ static inline unsigned int Trunc32(unsigned int x)
   return((unsigned int) (x & 0xffffffffU));
 }
 
-static unsigned int RotateRight(unsigned int x,unsigned int n)
+static inline unsigned int RotateRight(unsigned int x,unsigned int n)
 {
   return(Trunc32((x >> n) | (x << (32-n))));
 }
 
-static void TransformSignature(SignatureInfo *signature_info)
+static void TransformSignature(SignatureInfo *signature_info,
+  const unsigned char *message)
 {
 #define Sigma0(x)  (RotateRight(x,7) ^ RotateRight(x,18) ^ Trunc32((x) >> 3))
 #define Sigma1(x)  (RotateRight(x,17) ^ RotateRight(x,19) ^ Trunc32((x) >> 10))
@@ -604,30 +1072,12 @@ static void TransformSignature(SignatureInfo *signature_info)
   register ssize_t
     i;
 
-  register unsigned char
+  register const unsigned char
     *p;
 
   ssize_t
     j;
 
-  static unsigned int
-    K[64] =
-    {
-      0x428a2f98U, 0x71374491U, 0xb5c0fbcfU, 0xe9b5dba5U, 0x3956c25bU,
-      0x59f111f1U, 0x923f82a4U, 0xab1c5ed5U, 0xd807aa98U, 0x12835b01U,
-      0x243185beU, 0x550c7dc3U, 0x72be5d74U, 0x80deb1feU, 0x9bdc06a7U,
-      0xc19bf174U, 0xe49b69c1U, 0xefbe4786U, 0x0fc19dc6U, 0x240ca1ccU,
-      0x2de92c6fU, 0x4a7484aaU, 0x5cb0a9dcU, 0x76f988daU, 0x983e5152U,
-      0xa831c66dU, 0xb00327c8U, 0xbf597fc7U, 0xc6e00bf3U, 0xd5a79147U,
-      0x06ca6351U, 0x14292967U, 0x27b70a85U, 0x2e1b2138U, 0x4d2c6dfcU,
-      0x53380d13U, 0x650a7354U, 0x766a0abbU, 0x81c2c92eU, 0x92722c85U,
-      0xa2bfe8a1U, 0xa81a664bU, 0xc24b8b70U, 0xc76c51a3U, 0xd192e819U,
-      0xd6990624U, 0xf40e3585U, 0x106aa070U, 0x19a4c116U, 0x1e376c08U,
-      0x2748774cU, 0x34b0bcb5U, 0x391c0cb3U, 0x4ed8aa4aU, 0x5b9cca4fU,
-      0x682e6ff3U, 0x748f82eeU, 0x78a5636fU, 0x84c87814U, 0x8cc70208U,
-      0x90befffaU, 0xa4506cebU, 0xbef9a3f7U, 0xc67178f2U
-    };  /* 32-bit fractional part of the cube root of the first 64 primes */
-
   unsigned int
     A,
     B,
@@ -637,52 +1087,24 @@ static void TransformSignature(SignatureInfo *signature_info)
     F,
     G,
     H,
-    shift,
-    T,
     T1,
     T2,
     W[64];
 
-  shift=32;
-  p=GetStringInfoDatum(signature_info->message);
-  if (signature_info->lsb_first == MagickFalse)
+#if defined(MAGICKCORE_SHA_EXTENSIONS)
+  if (signature_info->sha_extensions != MagickFalse)
     {
-      if (sizeof(unsigned int) <= 4)
-        for (i=0; i < 16; i++)
-        {
-          T=(*((unsigned int *) p));
-          p+=4;
-          W[i]=Trunc32(T);
-        }
-      else
-        for (i=0; i < 16; i+=2)
-        {
-          T=(*((unsigned int *) p));
-          p+=8;
-          W[i]=Trunc32(T >> shift);
-          W[i+1]=Trunc32(T);
-        }
+      TransformSignatureSHA(signature_info->accumulator,message);
+      return;
     }
-  else
-    if (sizeof(unsigned int) <= 4)
-      for (i=0; i < 16; i++)
-      {
-        T=(*((unsigned int *) p));
-        p+=4;
-        W[i]=((T << 24) & 0xff000000) | ((T << 8) & 0x00ff0000) |
-          ((T >> 8) & 0x0000ff00) | ((T >> 24) & 0x000000ff);
-      }
-    else
-      for (i=0; i < 16; i+=2)
-      {
-        T=(*((unsigned int *) p));
-        p+=8;
-        W[i]=((T << 24) & 0xff000000) | ((T << 8) & 0x00ff0000) |
-          ((T >> 8) & 0x0000ff00) | ((T >> 24) & 0x000000ff);
-        T>>=shift;
-        W[i+1]=((T << 24) & 0xff000000) | ((T << 8) & 0x00ff0000) |
-          ((T >> 8) & 0x0000ff00) | ((T >> 24) & 0x000000ff);
-      }
+#endif
+  p=message;
+  for (i=0; i < 16; i++)
+  {
+    W[i]=((unsigned int) p[0] << 24) | ((unsigned int) p[1] << 16) |
+      ((unsigned int) p[2] << 8) | (unsigned int) p[3];
+    p+=4;
+  }
   /*
     Copy accumulator to registers.
   */
@@ -698,7 +1120,7 @@ static void TransformSignature(SignatureInfo *signature_info)
     W[i]=Trunc32(Sigma1(W[i-2])+W[i-7]+Sigma0(W[i-15])+W[i-16]);
   for (j=0; j < 64; j++)
   {
-    T1=Trunc32(H+Suma1(E)+Ch(E,F,G)+K[j]+W[j]);
+    T1=Trunc32(H+Suma1(E)+Ch(E,F,G)+SHA256Constants[j]+W[j]);
     T2=Trunc32(Suma0(A)+Maj(A,B,C));
     H=G;
     G=F;
@@ -731,7 +1153,6 @@ static void TransformSignature(SignatureInfo *signature_info)
   F=0;
   G=0;
   H=0;
-  T=0;
   T1=0;
   T2=0;
   (void) ResetMagickMemory(W,0,sizeof(W));
@@ -764,30 +1185,33 @@ static void TransformSignature(SignatureInfo *signature_info)
 MagickExport void UpdateSignature(SignatureInfo *signature_info,
   const StringInfo *message)
 {
-  register size_t
-    i;
+  assert(signature_info != (SignatureInfo *) NULL);
+  assert(signature_info->signature == MagickSignature);
+  UpdateSignatureBlocks(signature_info,GetStringInfoDatum(message),
+    GetStringInfoLength(message));
+}
 
-  register unsigned char
+static void UpdateSignatureBlocks(SignatureInfo *signature_info,
+  const unsigned char *message,size_t n)
+{
+  register const unsigned char
     *p;
 
-  size_t
-    n;
+  register size_t
+    i;
 
   unsigned int
     length;
 
   /*
-    Update the Signature accumulator.
+    Update the Signature accumulator; whole blocks are transformed in place.
   */
-  assert(signature_info != (SignatureInfo *) NULL);
-  assert(signature_info->signature == MagickSignature);
-  n=GetStringInfoLength(message);
   length=Trunc32((unsigned int) (signature_info->low_order+(n << 3)));
   if (length < signature_info->low_order)
     signature_info->high_order++;
   signature_info->low_order=length;
   signature_info->high_order+=(unsigned int) (n >> 29);
-  p=GetStringInfoDatum(message);
+  p=message;
   if (signature_info->offset != 0)
     {
       i=GetStringInfoLength(signature_info->message)-signature_info->offset;
@@ -801,14 +1225,14 @@ MagickExport void UpdateSignature(SignatureInfo *signature_info,
       if (signature_info->offset !=
           GetStringInfoLength(signature_info->message))
         return;
-      TransformSignature(signature_info);
+      TransformSignature(signature_info,GetStringInfoDatum(
+        signature_info->message));
     }
-  while (n >= GetStringInfoLength(signature_info->message))
+  while (n >= SignatureBlocksize)
   {
-    SetStringInfoDatum(signature_info->message,p);
-    p+=GetStringInfoLength(signature_info->message);
-    n-=GetStringInfoLength(signature_info->message);
-    TransformSignature(signature_info);
+    TransformSignature(signature_info,p);
+    p+=SignatureBlocksize;
+    n-=SignatureBlocksize;
   }
   (void) CopyMagickMemory(GetStringInfoDatum(signature_info->message),p,n);
   signature_info->offset=n;
@@ -73,11 +73,23 @@ typedef struct _NodeInfo
   void
     *value;
 
+  ssize_t
+    *reference_count;
+
   struct _NodeInfo
     *left,
     *right;
 } NodeInfo;
 
+typedef struct _ShareInfo
+{
+  ssize_t
+    reference_count;
+
+  SemaphoreInfo
+    *semaphore;
+} ShareInfo;
+
 struct _SplayTreeInfo
 {
   NodeInfo
@@ -88,7 +100,9 @@ struct _SplayTreeInfo
 
   void
     *(*relinquish_key)(void *),
-    *(*relinquish_value)(void *);
+    *(*relinquish_value)(void *),
+    *(*clone_key)(void *),
+    *(*clone_value)(void *);
 
   MagickBooleanType
     balance;
@@ -103,6 +117,9 @@ struct _SplayTreeInfo
   MagickBooleanType
     debug;
 
+  ShareInfo
+    *share;
+
   SemaphoreInfo
     *semaphore;
 
@@ -117,7 +134,11 @@ static int
   IterateOverSplayTree(SplayTreeInfo *,int (*)(NodeInfo *,const void *),
     const void *);
 
+static MagickBooleanType
+  UnshareSplayTreeNode(SplayTreeInfo *,NodeInfo *);
+
 static void
+  RelinquishNodeKeyAndValue(SplayTreeInfo *,NodeInfo *),
   SplaySplayTree(SplayTreeInfo *,const void *);
 
 /*
@@ -168,14 +189,7 @@ MagickExport MagickBooleanType AddValueToSplayTree(SplayTreeInfo *splay_tree,
           ((splay_tree->root->key < key) ? -1 : 0);
       if (compare == 0)
         {
-          if ((splay_tree->relinquish_value != (void *(*)(void *)) NULL) &&
-              (splay_tree->root->value != (void *) NULL))
-            splay_tree->root->value=splay_tree->relinquish_value(
-              splay_tree->root->value);
-          if ((splay_tree->relinquish_key != (void *(*)(void *)) NULL) &&
-              (splay_tree->root->key != (void *) NULL))
-            splay_tree->root->key=splay_tree->relinquish_key(
-              splay_tree->root->key);
+          RelinquishNodeKeyAndValue(splay_tree,splay_tree->root);
           splay_tree->root->key=(void *) key;
           splay_tree->root->value=(void *) value;
           UnlockSemaphoreInfo(splay_tree->semaphore);
@@ -190,6 +204,7 @@ MagickExport MagickBooleanType AddValueToSplayTree(SplayTreeInfo *splay_tree,
     }
   node->key=(void *) key;
   node->value=(void *) value;
+  node->reference_count=(ssize_t *) NULL;
   if (splay_tree->root == (NodeInfo *) NULL)
     {
       node->left=(NodeInfo *) NULL;
@@ -538,14 +553,7 @@ MagickExport MagickBooleanType DeleteNodeByValueFromSplayTree(
           }
         left=splay_tree->root->left;
         right=splay_tree->root->right;
-        if ((splay_tree->relinquish_value != (void *(*)(void *)) NULL) &&
-            (splay_tree->root->value != (void *) NULL))
-          splay_tree->root->value=splay_tree->relinquish_value(
-            splay_tree->root->value);
-        if ((splay_tree->relinquish_key != (void *(*)(void *)) NULL) &&
-            (splay_tree->root->key != (void *) NULL))
-          splay_tree->root->key=splay_tree->relinquish_key(
-            splay_tree->root->key);
+        RelinquishNodeKeyAndValue(splay_tree,splay_tree->root);
         splay_tree->root=(NodeInfo *) RelinquishMagickMemory(splay_tree->root);
         splay_tree->nodes--;
         if (left == (NodeInfo *) NULL)
@@ -625,13 +633,7 @@ MagickExport MagickBooleanType DeleteNodeFromSplayTree(
     }
   left=splay_tree->root->left;
   right=splay_tree->root->right;
-  if ((splay_tree->relinquish_value != (void *(*)(void *)) NULL) &&
-      (splay_tree->root->value != (void *) NULL))
-    splay_tree->root->value=splay_tree->relinquish_value(
-      splay_tree->root->value);
-  if ((splay_tree->relinquish_key != (void *(*)(void *)) NULL) &&
-      (splay_tree->root->key != (void *) NULL))
-    splay_tree->root->key=splay_tree->relinquish_key(splay_tree->root->key);
+  RelinquishNodeKeyAndValue(splay_tree,splay_tree->root);
   splay_tree->root=(NodeInfo *) RelinquishMagickMemory(splay_tree->root);
   splay_tree->nodes--;
   if (left == (NodeInfo *) NULL)
@@ -685,13 +687,7 @@ MagickExport SplayTreeInfo *DestroySplayTree(SplayTreeInfo *splay_tree)
   LockSemaphoreInfo(splay_tree->semaphore);
   if (splay_tree->root != (NodeInfo *) NULL)
     {
-      if ((splay_tree->relinquish_value != (void *(*)(void *)) NULL) &&
-          (splay_tree->root->value != (void *) NULL))
-        splay_tree->root->value=splay_tree->relinquish_value(
-          splay_tree->root->value);
-      if ((splay_tree->relinquish_key != (void *(*)(void *)) NULL) &&
-          (splay_tree->root->key != (void *) NULL))
-        splay_tree->root->key=splay_tree->relinquish_key(splay_tree->root->key);
+      RelinquishNodeKeyAndValue(splay_tree,splay_tree->root);
       splay_tree->root->key=(void *) NULL;
       for (pend=splay_tree->root; pend != (NodeInfo *) NULL; )
       {
@@ -700,26 +696,13 @@ MagickExport SplayTreeInfo *DestroySplayTree(SplayTreeInfo *splay_tree)
         {
           if (active->left != (NodeInfo *) NULL)
             {
-              if ((splay_tree->relinquish_value != (void *(*)(void *)) NULL) &&
-                  (active->left->value != (void *) NULL))
-                active->left->value=splay_tree->relinquish_value(
-                  active->left->value);
-              if ((splay_tree->relinquish_key != (void *(*)(void *)) NULL) &&
-                  (active->left->key != (void *) NULL))
-                active->left->key=splay_tree->relinquish_key(active->left->key);
+              RelinquishNodeKeyAndValue(splay_tree,active->left);
               active->left->key=(void *) pend;
               pend=active->left;
             }
           if (active->right != (NodeInfo *) NULL)
             {
-              if ((splay_tree->relinquish_value != (void *(*)(void *)) NULL) &&
-                  (active->right->value != (void *) NULL))
-                active->right->value=splay_tree->relinquish_value(
-                  active->right->value);
-              if ((splay_tree->relinquish_key != (void *(*)(void *)) NULL) &&
-                  (active->right->key != (void *) NULL))
-                active->right->key=splay_tree->relinquish_key(
-                  active->right->key);
+              RelinquishNodeKeyAndValue(splay_tree,active->right);
               active->right->key=(void *) pend;
               pend=active->right;
             }
@@ -729,6 +712,23 @@ MagickExport SplayTreeInfo *DestroySplayTree(SplayTreeInfo *splay_tree)
         }
       }
     }
+  if (splay_tree->share != (ShareInfo *) NULL)
+    {
+      MagickBooleanType
+        destroy;
+
+      LockSemaphoreInfo(splay_tree->share->semaphore);
+      splay_tree->share->reference_count--;
+      destroy=splay_tree->share->reference_count == 0 ? MagickTrue :
+        MagickFalse;
+      UnlockSemaphoreInfo(splay_tree->share->semaphore);
+      if (destroy != MagickFalse)
+        {
+          DestroySemaphoreInfo(&splay_tree->share->semaphore);
+          splay_tree->share=(ShareInfo *) RelinquishMagickMemory(
+            splay_tree->share);
+        }
+    }
   splay_tree->signature=(~MagickSignature);
   UnlockSemaphoreInfo(splay_tree->semaphore);
   DestroySemaphoreInfo(&splay_tree->semaphore);
@@ -1106,16 +1106,59 @@ MagickExport SplayTreeInfo *NewSplayTree(
   splay_tree->compare=compare;
   splay_tree->relinquish_key=relinquish_key;
   splay_tree->relinquish_value=relinquish_value;
+  splay_tree->clone_key=(void *(*)(void *)) NULL;
+  splay_tree->clone_value=(void *(*)(void *)) NULL;
   splay_tree->balance=MagickFalse;
   splay_tree->key=(void *) NULL;
   splay_tree->next=(void *) NULL;
   splay_tree->nodes=0;
   splay_tree->debug=IsEventLogging();
+  splay_tree->share=(ShareInfo *) NULL;
   splay_tree->semaphore=AllocateSemaphoreInfo();
   splay_tree->signature=MagickSignature;
   return(splay_tree);
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%   R e l i n q u i s h N o d e K e y A n d V a l u e                         %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  RelinquishNodeKeyAndValue() relinquishes the key and value of a node.  They
+%  are left alone if the node still shares them with a node of another
+%  splay-tree.
+%
+%  The format of the RelinquishNodeKeyAndValue method is:
+%
+%      void RelinquishNodeKeyAndValue(SplayTreeInfo *splay_tree,
+%        NodeInfo *node)
+%
+%  A description of each parameter follows:
+%
+%    o splay_tree: the splay-tree info.
+%
+%    o node: the node.
+%
+*/
+static void RelinquishNodeKeyAndValue(SplayTreeInfo *splay_tree,
+  NodeInfo *node)
+{
+  if (UnshareSplayTreeNode(splay_tree,node) == MagickFalse)
+    return;
+  if ((splay_tree->relinquish_value != (void *(*)(void *)) NULL) &&
+      (node->value != (void *) NULL))
+    node->value=splay_tree->relinquish_value(node->value);
+  if ((splay_tree->relinquish_key != (void *(*)(void *)) NULL) &&
+      (node->key != (void *) NULL))
+    node->key=splay_tree->relinquish_key(node->key);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -1199,10 +1242,13 @@ MagickExport void *RemoveNodeByValueFromSplayTree(SplayTreeInfo *splay_tree,
           }
         left=splay_tree->root->left;
         right=splay_tree->root->right;
-        if ((splay_tree->relinquish_value != (void *(*)(void *)) NULL) &&
-            (splay_tree->root->value != (void *) NULL))
-          splay_tree->root->value=splay_tree->relinquish_value(
-            splay_tree->root->value);
+        if (UnshareSplayTreeNode(splay_tree,splay_tree->root) == MagickFalse)
+          key=splay_tree->clone_key(key);
+        else
+          if ((splay_tree->relinquish_value != (void *(*)(void *)) NULL) &&
+              (splay_tree->root->value != (void *) NULL))
+            splay_tree->root->value=splay_tree->relinquish_value(
+              splay_tree->root->value);
         splay_tree->root=(NodeInfo *) RelinquishMagickMemory(splay_tree->root);
         splay_tree->nodes--;
         if (left == (NodeInfo *) NULL)
@@ -1287,9 +1333,15 @@ MagickExport void *RemoveNodeFromSplayTree(SplayTreeInfo *splay_tree,
   left=splay_tree->root->left;
   right=splay_tree->root->right;
   value=splay_tree->root->value;
-  if ((splay_tree->relinquish_key != (void *(*)(void *)) NULL) &&
-      (splay_tree->root->key != (void *) NULL))
-    splay_tree->root->key=splay_tree->relinquish_key(splay_tree->root->key);
+  if (UnshareSplayTreeNode(splay_tree,splay_tree->root) == MagickFalse)
+    {
+      if (value != (void *) NULL)
+        value=splay_tree->clone_value(value);
+    }
+  else
+    if ((splay_tree->relinquish_key != (void *(*)(void *)) NULL) &&
+        (splay_tree->root->key != (void *) NULL))
+      splay_tree->root->key=splay_tree->relinquish_key(splay_tree->root->key);
   splay_tree->root=(NodeInfo *) RelinquishMagickMemory(splay_tree->root);
   splay_tree->nodes--;
   if (left == (NodeInfo *) NULL)
@@ -1348,13 +1400,7 @@ MagickExport void ResetSplayTree(SplayTreeInfo *splay_tree)
   LockSemaphoreInfo(splay_tree->semaphore);
   if (splay_tree->root != (NodeInfo *) NULL)
     {
-      if ((splay_tree->relinquish_value != (void *(*)(void *)) NULL) &&
-          (splay_tree->root->value != (void *) NULL))
-        splay_tree->root->value=splay_tree->relinquish_value(
-          splay_tree->root->value);
-      if ((splay_tree->relinquish_key != (void *(*)(void *)) NULL) &&
-          (splay_tree->root->key != (void *) NULL))
-        splay_tree->root->key=splay_tree->relinquish_key(splay_tree->root->key);
+      RelinquishNodeKeyAndValue(splay_tree,splay_tree->root);
       splay_tree->root->key=(void *) NULL;
       for (pend=splay_tree->root; pend != (NodeInfo *) NULL; )
       {
@@ -1363,26 +1409,13 @@ MagickExport void ResetSplayTree(SplayTreeInfo *splay_tree)
         {
           if (active->left != (NodeInfo *) NULL)
             {
-              if ((splay_tree->relinquish_value != (void *(*)(void *)) NULL) &&
-                  (active->left->value != (void *) NULL))
-                active->left->value=splay_tree->relinquish_value(
-                  active->left->value);
-              if ((splay_tree->relinquish_key != (void *(*)(void *)) NULL) &&
-                  (active->left->key != (void *) NULL))
-                active->left->key=splay_tree->relinquish_key(active->left->key);
+              RelinquishNodeKeyAndValue(splay_tree,active->left);
               active->left->key=(void *) pend;
               pend=active->left;
             }
           if (active->right != (NodeInfo *) NULL)
             {
-              if ((splay_tree->relinquish_value != (void *(*)(void *)) NULL) &&
-                  (active->right->value != (void *) NULL))
-                active->right->value=splay_tree->relinquish_value(
-                  active->right->value);
-              if ((splay_tree->relinquish_key != (void *(*)(void *)) NULL) &&
-                  (active->right->key != (void *) NULL))
-                active->right->key=splay_tree->relinquish_key(
-                  active->right->key);
+              RelinquishNodeKeyAndValue(splay_tree,active->right);
               active->right->key=(void *) pend;
               pend=active->right;
             }
@@ -1435,6 +1468,121 @@ MagickExport void ResetSplayTreeIterator(SplayTreeInfo *splay_tree)
   UnlockSemaphoreInfo(splay_tree->semaphore);
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%   S h a r e S p l a y T r e e                                               %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ShareSplayTree() returns a new splay-tree with the same keys and values as
+%  the splay-tree.  The nodes, and therefore the iterator, belong to each
+%  splay-tree alone, but the keys and values are shared between them and are
+%  relinquished only when the last node that refers to them goes away.  So a
+%  value returned by GetValueFromSplayTree() stays valid until that splay-tree
+%  replaces or deletes it, or is destroyed, no matter what happens to the
+%  splay-trees it was shared with.  Keys and values must not be modified in
+%  place.  RemoveNodeFromSplayTree() and RemoveNodeByValueFromSplayTree()
+%  return a copy made with clone_key() or clone_value() if the key or value is
+%  still shared.
+%
+%  The format of the ShareSplayTree method is:
+%
+%      SplayTreeInfo *ShareSplayTree(SplayTreeInfo *splay_tree,
+%        void *(*clone_key)(void *),void *(*clone_value)(void *))
+%
+%  A description of each parameter follows:
+%
+%    o splay_tree: the splay tree.
+%
+%    o clone_key: the key clone method, typically ConstantString(), called
+%      whenever a shared key is removed from the splay-tree.
+%
+%    o clone_value: the value clone method;  typically ConstantString(),
+%      called whenever a shared value is removed from the splay-tree.
+%
+*/
+MagickExport SplayTreeInfo *ShareSplayTree(SplayTreeInfo *splay_tree,
+  void *(*clone_key)(void *),void *(*clone_value)(void *))
+{
+  NodeInfo
+    **node,
+    **nodes,
+    *share_node;
+
+  register ssize_t
+    i;
+
+  SplayTreeInfo
+    *share_tree;
+
+  assert(splay_tree != (SplayTreeInfo *) NULL);
+  assert(splay_tree->signature == MagickSignature);
+  if (splay_tree->debug != MagickFalse)
+    (void) LogMagickEvent(TraceEvent,GetMagickModule(),"...");
+  share_tree=NewSplayTree(splay_tree->compare,splay_tree->relinquish_key,
+    splay_tree->relinquish_value);
+  LockSemaphoreInfo(splay_tree->semaphore);
+  if (splay_tree->root == (NodeInfo *) NULL)
+    {
+      UnlockSemaphoreInfo(splay_tree->semaphore);
+      return(share_tree);
+    }
+  nodes=(NodeInfo **) AcquireQuantumMemory((size_t) splay_tree->nodes,
+    sizeof(*nodes));
+  if (nodes == (NodeInfo **) NULL)
+    ThrowFatalException(ResourceLimitFatalError,"MemoryAllocationFailed");
+  node=nodes;
+  (void) IterateOverSplayTree(splay_tree,SplayTreeToNodeArray,
+    (const void *) &node);
+  if (splay_tree->share == (ShareInfo *) NULL)
+    {
+      splay_tree->share=(ShareInfo *) AcquireMagickMemory(
+        sizeof(*splay_tree->share));
+      if (splay_tree->share == (ShareInfo *) NULL)
+        ThrowFatalException(ResourceLimitFatalError,"MemoryAllocationFailed");
+      splay_tree->share->reference_count=1;
+      splay_tree->share->semaphore=AllocateSemaphoreInfo();
+    }
+  splay_tree->clone_key=clone_key;
+  splay_tree->clone_value=clone_value;
+  share_tree->clone_key=clone_key;
+  share_tree->clone_value=clone_value;
+  share_tree->share=splay_tree->share;
+  LockSemaphoreInfo(splay_tree->share->semaphore);
+  splay_tree->share->reference_count++;
+  for (i=0; i < (ssize_t) splay_tree->nodes; i++)
+  {
+    if (nodes[i]->reference_count == (ssize_t *) NULL)
+      {
+        nodes[i]->reference_count=(ssize_t *) AcquireMagickMemory(
+          sizeof(*nodes[i]->reference_count));
+        if (nodes[i]->reference_count == (ssize_t *) NULL)
+          ThrowFatalException(ResourceLimitFatalError,
+            "MemoryAllocationFailed");
+        *nodes[i]->reference_count=1;
+      }
+    (*nodes[i]->reference_count)++;
+    share_node=(NodeInfo *) AcquireMagickMemory(sizeof(*share_node));
+    if (share_node == (NodeInfo *) NULL)
+      ThrowFatalException(ResourceLimitFatalError,"MemoryAllocationFailed");
+    share_node->key=nodes[i]->key;
+    share_node->value=nodes[i]->value;
+    share_node->reference_count=nodes[i]->reference_count;
+    nodes[i]=share_node;
+  }
+  UnlockSemaphoreInfo(splay_tree->share->semaphore);
+  share_tree->root=LinkSplayTreeNodes(nodes,0,splay_tree->nodes-1);
+  share_tree->nodes=splay_tree->nodes;
+  UnlockSemaphoreInfo(splay_tree->semaphore);
+  nodes=(NodeInfo **) RelinquishMagickMemory(nodes);
+  return(share_tree);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -1588,3 +1736,48 @@ static void SplaySplayTree(SplayTreeInfo *splay_tree,const void *key)
     }
   splay_tree->key=(void *) key;
 }
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%   U n s h a r e S p l a y T r e e N o d e                                   %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  UnshareSplayTreeNode() drops the node's reference to a key and value it
+%  shares with nodes of other splay-trees.  It returns MagickTrue if the node
+%  was the last one to refer to them, in which case the caller now owns them.
+%
+%  The format of the UnshareSplayTreeNode method is:
+%
+%      MagickBooleanType UnshareSplayTreeNode(SplayTreeInfo *splay_tree,
+%        NodeInfo *node)
+%
+%  A description of each parameter follows:
+%
+%    o splay_tree: the splay-tree info.
+%
+%    o node: the node.
+%
+*/
+static MagickBooleanType UnshareSplayTreeNode(SplayTreeInfo *splay_tree,
+  NodeInfo *node)
+{
+  ssize_t
+    reference_count;
+
+  if (node->reference_count == (ssize_t *) NULL)
+    return(MagickTrue);
+  LockSemaphoreInfo(splay_tree->share->semaphore);
+  reference_count=(--(*node->reference_count));
+  UnlockSemaphoreInfo(splay_tree->share->semaphore);
+  if (reference_count == 0)
+    node->reference_count=(ssize_t *) RelinquishMagickMemory(
+      node->reference_count);
+  node->reference_count=(ssize_t *) NULL;
+  return(reference_count == 0 ? MagickTrue : MagickFalse);
+}
@@ -43,7 +43,8 @@ extern MagickExport SplayTreeInfo
   *CloneSplayTree(SplayTreeInfo *,void *(*)(void *),void *(*)(void *)),
   *DestroySplayTree(SplayTreeInfo *),
   *NewSplayTree(int (*)(const void *,const void *),void *(*)(void *),
-    void *(*)(void *));
+    void *(*)(void *)),
+  *ShareSplayTree(SplayTreeInfo *,void *(*)(void *),void *(*)(void *));
 
 extern MagickExport size_t
   GetNumberOfNodesInSplayTree(const SplayTreeInfo *);
@@ -24,6 +24,27 @@ extern "C" {
 
 #include <magick/locale_.h>
 
+static inline size_t HashLocaleString(const char *string)
+{
+  register const unsigned char
+    *p;
+
+  register size_t
+    hash;
+
+  /*
+    FNV-1a hash of the case-folded string, for tables searched with
+    LocaleCompare().
+  */
+  hash=2166136261UL;
+  for (p=(const unsigned char *) string; *p != '\0'; p++)
+  {
+    hash^=(size_t) (((*p >= 'A') && (*p <= 'Z')) ? *p+('a'-'A') : *p);
+    hash*=16777619UL;
+  }
+  return(hash);
+}
+
 static inline double SiPrefixToDoubleInterval(const char *string,
   const double interval)
 {
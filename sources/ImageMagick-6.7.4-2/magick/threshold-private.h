@@ -0,0 +1,46 @@
+/*
+  Copyright 1999-2012 ImageMagick Studio LLC, a non-profit organization
+  dedicated to making software imaging solutions freely available.
+  
+  You may not use this file except in compliance with the License.
+  obtain a copy of the License at
+  
+    http://www.imagemagick.org/script/license.php
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  MagickCore private image threshold methods.
+*/
+#ifndef _MAGICKCORE_THRESHOLD_PRIVATE_H
+#define _MAGICKCORE_THRESHOLD_PRIVATE_H
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+#include <magick/threshold.h>
+
+struct _ThresholdMap
+{
+  char
+    *map_id,
+    *description;
+
+  size_t
+    width,
+    height;
+
+  ssize_t
+    divisor,
+    *levels;
+};
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif
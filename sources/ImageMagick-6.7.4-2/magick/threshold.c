@@ -81,6 +81,7 @@
 #include "magick/string-private.h"
 #include "magick/thread-private.h"
 #include "magick/threshold.h"
+#include "magick/threshold-private.h"
 #include "magick/transform.h"
 #include "magick/xml-tree.h"
 
@@ -89,24 +90,6 @@
 */
 #define ThresholdsFilename  "thresholds.xml"
 
-/*
-  Typedef declarations.
-*/
-struct _ThresholdMap
-{
-  char
-    *map_id,
-    *description;
-
-  size_t
-    width,
-    height;
-
-  ssize_t
-    divisor,
-    *levels;
-};
-
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -41,6 +41,7 @@
 */
 #include "magick/studio.h"
 #include "magick/blob.h"
+#include "magick/blob-private.h"
 #include "magick/client.h"
 #include "magick/configure.h"
 #include "magick/draw.h"
@@ -50,6 +51,7 @@
 #include "magick/log.h"
 #include "magick/memory_.h"
 #include "magick/option.h"
+#include "magick/policy.h"
 #include "magick/semaphore.h"
 #include "magick/splay-tree.h"
 #include "magick/string_.h"
@@ -57,6 +59,8 @@
 #include "magick/type.h"
 #include "magick/token.h"
 #include "magick/utility.h"
+#include "magick/utility-private.h"
+#include "magick/version.h"
 #include "magick/xml-tree.h"
 #if defined(MAGICKCORE_FONTCONFIG_DELEGATE)
 # include "fontconfig/fontconfig.h"
@@ -98,6 +102,9 @@
   Define declarations.
 */
 #define MagickTypeFilename  "type.xml"
+#define TypeCacheFilename  "type.cache"
+#define TypeCacheMagick  "ImageMagickType"
+#define TypeCacheVersion  1UL
 
 /*
   Declare type map.
@@ -110,6 +117,47 @@ static const char
     "  <type stealth=\"True\" name=\"helvetica\" family=\"helvetica\"/>"
     "</typemap>";
 
+/*
+  Typedef declarations.
+*/
+#if defined(MAGICKCORE_FONTCONFIG_DELEGATE)
+typedef struct _TypeCacheHeader
+{
+  char
+    magick[16];
+
+  size_t
+    version,
+    library_version,
+    environment,
+    number_sources,
+    number_types,
+    length,
+    signature;
+} TypeCacheHeader;
+
+typedef struct _TypeCacheSource
+{
+  size_t
+    path;
+
+  MagickOffsetType
+    modify_time,
+    length;
+} TypeCacheSource;
+
+typedef struct _TypeCacheEntry
+{
+  size_t
+    name,
+    family,
+    glyphs,
+    style,
+    stretch,
+    weight;
+} TypeCacheEntry;
+#endif
+
 /*
   Static declarations.
 */
@@ -620,11 +668,383 @@ MagickExport char **GetTypeList(const char *pattern,size_t *number_fonts,
 */
 
 #if defined(MAGICKCORE_FONTCONFIG_DELEGATE)
+static void GetTypeCacheEnvironment(char *environment)
+{
+  char
+    *file,
+    *path,
+    *root;
+
+  /*
+    The font catalog depends on which FontConfig configuration was loaded.
+  */
+  file=GetEnvironmentValue("FONTCONFIG_FILE");
+  path=GetEnvironmentValue("FONTCONFIG_PATH");
+  root=GetEnvironmentValue("FONTCONFIG_SYSROOT");
+  (void) FormatLocaleString(environment,MaxTextExtent,"%d;%s;%s;%s",
+    FcGetVersion(),file != (char *) NULL ? file : "",path != (char *) NULL ?
+    path : "",root != (char *) NULL ? root : "");
+  if (root != (char *) NULL)
+    root=DestroyString(root);
+  if (path != (char *) NULL)
+    path=DestroyString(path);
+  if (file != (char *) NULL)
+    file=DestroyString(file);
+}
+
+static MagickBooleanType GetTypeCachePath(char *path)
+{
+  char
+    *home,
+    *value;
+
+  /*
+    The font catalog snapshot is opt-in: MAGICK_TYPE_CACHE (or the type-cache
+    policy) names the cache file, or "true" selects $HOME/.magick/type.cache.
+  */
+  value=GetEnvironmentValue("MAGICK_TYPE_CACHE");
+  if (value == (char *) NULL)
+    value=GetPolicyValue("type-cache");
+  if (value == (char *) NULL)
+    return(MagickFalse);
+  if ((*value == '\0') || (LocaleCompare(value,"false") == 0))
+    {
+      value=DestroyString(value);
+      return(MagickFalse);
+    }
+  if (IsMagickTrue(value) == MagickFalse)
+    {
+      (void) CopyMagickString(path,value,MaxTextExtent);
+      value=DestroyString(value);
+      return(MagickTrue);
+    }
+  value=DestroyString(value);
+  home=GetEnvironmentValue("HOME");
+  if (home == (char *) NULL)
+    home=GetEnvironmentValue("USERPROFILE");
+  if (home == (char *) NULL)
+    return(MagickFalse);
+  (void) FormatLocaleString(path,MaxTextExtent,"%s%s.magick%s%s",home,
+    DirectorySeparator,DirectorySeparator,TypeCacheFilename);
+  home=DestroyString(home);
+  return(MagickTrue);
+}
+
+static void GetTypeCacheSource(const char *path,TypeCacheSource *source)
+{
+  struct stat
+    attributes;
+
+  source->modify_time=(-1);
+  source->length=(-1);
+  if (GetPathAttributes(path,&attributes) == MagickFalse)
+    return;
+  source->modify_time=(MagickOffsetType) attributes.st_mtime;
+#if defined(__linux__)
+  source->modify_time=(MagickOffsetType) (1000000000*(MagickSizeType)
+    attributes.st_mtim.tv_sec+attributes.st_mtim.tv_nsec);
+#endif
+  source->length=(MagickOffsetType) attributes.st_size;
+}
+
+static MagickBooleanType LoadTypeCache(SplayTreeInfo *type_list,
+  const char *filename)
+{
+  char
+    environment[MaxTextExtent];
+
+  const TypeCacheEntry
+    *entries;
+
+  const TypeCacheHeader
+    *header;
+
+  const TypeCacheSource
+    *sources;
+
+  int
+    file;
+
+  MagickBooleanType
+    status;
+
+  register ssize_t
+    i;
+
+  size_t
+    length;
+
+  struct stat
+    attributes;
+
+  TypeCacheSource
+    source;
+
+  TypeInfo
+    *type_info;
+
+  unsigned char
+    *map;
+
+  /*
+    Map the font catalog and verify it still describes the FontConfig
+    configuration on disk.
+  */
+  file=open_utf8(filename,O_RDONLY | O_BINARY,0);
+  if (file == -1)
+    return(MagickFalse);
+  if ((fstat(file,&attributes) != 0) ||
+      (attributes.st_size < (MagickOffsetType) sizeof(*header)))
+    {
+      (void) close(file);
+      return(MagickFalse);
+    }
+  length=(size_t) attributes.st_size;
+  map=MapBlob(file,ReadMode,0,length);
+  (void) close(file);
+  if (map == (unsigned char *) NULL)
+    return(MagickFalse);
+  (void) LogMagickEvent(ConfigureEvent,GetMagickModule(),
+    "Loading type cache file \"%s\" ...",filename);
+  header=(const TypeCacheHeader *) map;
+  GetTypeCacheEnvironment(environment);
+  status=MagickFalse;
+  if ((memcmp(header->magick,TypeCacheMagick,sizeof(TypeCacheMagick)) == 0) &&
+      (header->version == TypeCacheVersion) &&
+      (header->library_version == MagickLibVersion) &&
+      (header->signature == MagickSignature) && (header->length == length) &&
+      (map[length-1] == '\0') &&
+      (header->number_sources < (length/sizeof(*sources))) &&
+      (header->number_types < (length/sizeof(*entries))) &&
+      ((sizeof(*header)+header->number_sources*sizeof(*sources)+
+        header->number_types*sizeof(*entries)) <= length) &&
+      (header->environment < length) &&
+      (strcmp((const char *) map+header->environment,environment) == 0))
+    status=MagickTrue;
+  sources=(const TypeCacheSource *) (map+sizeof(*header));
+  entries=(const TypeCacheEntry *) (map+sizeof(*header)+
+    header->number_sources*sizeof(*sources));
+  for (i=0; (status != MagickFalse) && (i < (ssize_t) header->number_sources);
+       i++)
+  {
+    if (sources[i].path >= length)
+      {
+        status=MagickFalse;
+        break;
+      }
+    GetTypeCacheSource((const char *) map+sources[i].path,&source);
+    if ((source.modify_time != sources[i].modify_time) ||
+        (source.length != sources[i].length))
+      status=MagickFalse;
+  }
+  for (i=0; (status != MagickFalse) && (i < (ssize_t) header->number_types);
+       i++)
+    if ((entries[i].name >= length) || (entries[i].family >= length) ||
+        (entries[i].glyphs >= length))
+      status=MagickFalse;
+  if (status == MagickFalse)
+    {
+      (void) UnmapBlob(map,length);
+      return(MagickFalse);
+    }
+  for (i=0; i < (ssize_t) header->number_types; i++)
+  {
+    type_info=(TypeInfo *) AcquireMagickMemory(sizeof(*type_info));
+    if (type_info == (TypeInfo *) NULL)
+      continue;
+    (void) ResetMagickMemory(type_info,0,sizeof(*type_info));
+    type_info->path=ConstantString("System Fonts");
+    type_info->signature=MagickSignature;
+    type_info->name=ConstantString((const char *) map+entries[i].name);
+    type_info->family=ConstantString((const char *) map+entries[i].family);
+    type_info->style=(StyleType) entries[i].style;
+    type_info->stretch=(StretchType) entries[i].stretch;
+    type_info->weight=entries[i].weight;
+    type_info->glyphs=ConstantString((const char *) map+entries[i].glyphs);
+    (void) AddValueToSplayTree(type_list,type_info->name,type_info);
+  }
+  (void) UnmapBlob(map,length);
+  return(MagickTrue);
+}
+
+static void SaveTypeCache(FcConfig *font_config,SplayTreeInfo *type_list,
+  const char *filename)
+{
+  char
+    directory[MaxTextExtent],
+    environment[MaxTextExtent],
+    path[MaxTextExtent];
+
+  const char
+    *source_path;
+
+  const TypeInfo
+    *p;
+
+  FcStrList
+    *list[3];
+
+  int
+    file;
+
+  LinkedListInfo
+    *paths;
+
+  register ssize_t
+    i;
+
+  size_t
+    length,
+    number_types,
+    offset;
+
+  ssize_t
+    count;
+
+  TypeCacheEntry
+    *entries;
+
+  TypeCacheHeader
+    *header;
+
+  TypeCacheSource
+    *sources;
+
+  unsigned char
+    *buffer;
+
+  /*
+    Record every FontConfig configuration file, font directory, and cache
+    directory so a later process can tell whether the catalog is stale.
+  */
+  paths=NewLinkedList(0);
+  list[0]=FcConfigGetConfigFiles(font_config);
+  list[1]=FcConfigGetFontDirs(font_config);
+  list[2]=FcConfigGetCacheDirs(font_config);
+  for (i=0; i < 3; i++)
+  {
+    FcChar8
+      *entry;
+
+    if (list[i] == (FcStrList *) NULL)
+      continue;
+    for (entry=FcStrListNext(list[i]); entry != (FcChar8 *) NULL;
+         entry=FcStrListNext(list[i]))
+      (void) AppendValueToLinkedList(paths,ConstantString((const char *)
+        entry));
+    FcStrListDone(list[i]);
+  }
+  GetTypeCacheEnvironment(environment);
+  length=sizeof(*header)+GetNumberOfElementsInLinkedList(paths)*
+    sizeof(*sources)+strlen(environment)+1;
+  ResetLinkedListIterator(paths);
+  source_path=(const char *) GetNextValueInLinkedList(paths);
+  while (source_path != (const char *) NULL)
+  {
+    length+=strlen(source_path)+1;
+    source_path=(const char *) GetNextValueInLinkedList(paths);
+  }
+  number_types=0;
+  ResetSplayTreeIterator(type_list);
+  p=(const TypeInfo *) GetNextValueInSplayTree(type_list);
+  while (p != (const TypeInfo *) NULL)
+  {
+    if (LocaleCompare(p->path,"System Fonts") == 0)
+      {
+        length+=sizeof(*entries)+strlen(p->name)+strlen(p->family)+
+          strlen(p->glyphs)+3;
+        number_types++;
+      }
+    p=(const TypeInfo *) GetNextValueInSplayTree(type_list);
+  }
+  buffer=(unsigned char *) AcquireQuantumMemory(length,sizeof(*buffer));
+  if (buffer == (unsigned char *) NULL)
+    {
+      paths=DestroyLinkedList(paths,RelinquishMagickMemory);
+      return;
+    }
+  (void) ResetMagickMemory(buffer,0,length);
+  header=(TypeCacheHeader *) buffer;
+  (void) CopyMagickString(header->magick,TypeCacheMagick,
+    sizeof(header->magick));
+  header->version=TypeCacheVersion;
+  header->library_version=MagickLibVersion;
+  header->number_sources=GetNumberOfElementsInLinkedList(paths);
+  header->number_types=number_types;
+  header->length=length;
+  header->signature=MagickSignature;
+  sources=(TypeCacheSource *) (buffer+sizeof(*header));
+  entries=(TypeCacheEntry *) (sources+header->number_sources);
+  offset=(size_t) ((unsigned char *) (entries+number_types)-buffer);
+  header->environment=offset;
+  (void) CopyMagickString((char *) buffer+offset,environment,length-offset);
+  offset+=strlen(environment)+1;
+  i=0;
+  ResetLinkedListIterator(paths);
+  source_path=(const char *) GetNextValueInLinkedList(paths);
+  while (source_path != (const char *) NULL)
+  {
+    GetTypeCacheSource(source_path,sources+i);
+    sources[i++].path=offset;
+    (void) CopyMagickString((char *) buffer+offset,source_path,length-offset);
+    offset+=strlen(source_path)+1;
+    source_path=(const char *) GetNextValueInLinkedList(paths);
+  }
+  paths=DestroyLinkedList(paths,RelinquishMagickMemory);
+  i=0;
+  ResetSplayTreeIterator(type_list);
+  p=(const TypeInfo *) GetNextValueInSplayTree(type_list);
+  while (p != (const TypeInfo *) NULL)
+  {
+    if (LocaleCompare(p->path,"System Fonts") == 0)
+      {
+        entries[i].style=(size_t) p->style;
+        entries[i].stretch=(size_t) p->stretch;
+        entries[i].weight=p->weight;
+        entries[i].name=offset;
+        (void) CopyMagickString((char *) buffer+offset,p->name,length-offset);
+        offset+=strlen(p->name)+1;
+        entries[i].family=offset;
+        (void) CopyMagickString((char *) buffer+offset,p->family,
+          length-offset);
+        offset+=strlen(p->family)+1;
+        entries[i].glyphs=offset;
+        (void) CopyMagickString((char *) buffer+offset,p->glyphs,
+          length-offset);
+        offset+=strlen(p->glyphs)+1;
+        i++;
+      }
+    p=(const TypeInfo *) GetNextValueInSplayTree(type_list);
+  }
+  /*
+    Write to a private file and rename it into place so concurrent readers
+    never see a partial catalog.
+  */
+  GetPathComponent(filename,HeadPath,directory);
+#if defined(MAGICKCORE_POSIX_SUPPORT)
+  (void) mkdir(directory,0700);
+#endif
+  (void) FormatLocaleString(path,MaxTextExtent,"%s.%.20g",filename,(double)
+    getpid());
+  file=open_utf8(path,O_WRONLY | O_CREAT | O_TRUNC | O_BINARY,S_MODE);
+  if (file == -1)
+    {
+      buffer=(unsigned char *) RelinquishMagickMemory(buffer);
+      return;
+    }
+  count=(ssize_t) write(file,buffer,length);
+  if ((close(file) != 0) || (count != (ssize_t) length) ||
+      (rename_utf8(path,filename) != 0))
+    (void) remove_utf8(path);
+  buffer=(unsigned char *) RelinquishMagickMemory(buffer);
+}
+
 MagickExport MagickBooleanType LoadFontConfigFonts(SplayTreeInfo *type_list,
   ExceptionInfo *exception)
 {
   char
     extension[MaxTextExtent],
+    filename[MaxTextExtent],
     name[MaxTextExtent];
 
   FcChar8
@@ -655,6 +1075,9 @@ MagickExport MagickBooleanType LoadFontConfigFonts(SplayTreeInfo *type_list,
   register ssize_t
     i;
 
+  MagickBooleanType
+    cache;
+
   TypeInfo
     *type_info;
 
@@ -662,6 +1085,10 @@ MagickExport MagickBooleanType LoadFontConfigFonts(SplayTreeInfo *type_list,
     Load system fonts.
   */
   (void) exception;
+  cache=GetTypeCachePath(filename);
+  if ((cache != MagickFalse) &&
+      (LoadTypeCache(type_list,filename) != MagickFalse))
+    return(MagickTrue);
   font_config=FcInitLoadConfigAndFonts();
   if (font_config == (FcConfig *) NULL)
     return(MagickFalse);
@@ -762,6 +1189,8 @@ MagickExport MagickBooleanType LoadFontConfigFonts(SplayTreeInfo *type_list,
     (void) AddValueToSplayTree(type_list,type_info->name,type_info);
   }
   FcFontSetDestroy(font_set);
+  if (cache != MagickFalse)
+    SaveTypeCache(font_config,type_list,filename);
   FcConfigDestroy(font_config);
   return(MagickTrue);
 }
@@ -1331,6 +1760,79 @@ static MagickBooleanType LoadTypeLists(const char *filename,
 #endif
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   T y p e C o m p o n e n t F o r k C h i l d                               %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  TypeComponentForkChild() releases the type component in the child process
+%  after a fork().
+%
+%  The format of the TypeComponentForkChild method is:
+%
+%      TypeComponentForkChild(void)
+%
+*/
+MagickExport void TypeComponentForkChild(void)
+{
+  UnlockSemaphoreInfo(type_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   T y p e C o m p o n e n t F o r k P a r e n t                             %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  TypeComponentForkParent() releases the type component in the parent process
+%  after a fork().
+%
+%  The format of the TypeComponentForkParent method is:
+%
+%      TypeComponentForkParent(void)
+%
+*/
+MagickExport void TypeComponentForkParent(void)
+{
+  UnlockSemaphoreInfo(type_semaphore);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   T y p e C o m p o n e n t F o r k P r e p a r e                           %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  TypeComponentForkPrepare() locks the type component before a fork().
+%
+%  The format of the TypeComponentForkPrepare method is:
+%
+%      TypeComponentForkPrepare(void)
+%
+*/
+MagickExport void TypeComponentForkPrepare(void)
+{
+  if (type_semaphore == (SemaphoreInfo *) NULL)
+    AcquireSemaphoreInfo(&type_semaphore);
+  LockSemaphoreInfo(type_semaphore);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -98,6 +98,9 @@ extern MagickExport const TypeInfo
   **GetTypeInfoList(const char *,size_t *,ExceptionInfo *);
 
 MagickExport void
+  TypeComponentForkChild(void),
+  TypeComponentForkParent(void),
+  TypeComponentForkPrepare(void),
   TypeComponentTerminus(void);
 
 #if defined(__cplusplus) || defined(c_plusplus)
@@ -84,7 +84,9 @@ struct _XMLTreeInfo
     *next,
     *sibling,
     *ordered,
-    *child;
+    *child,
+    *last,
+    *tail;
 
   MagickBooleanType
     debug;
@@ -998,14 +1000,21 @@ MagickExport XMLTreeInfo *InsertTagIntoXMLTree(XMLTreeInfo *xml_info,
     *node,
     *previous;
 
+  /*
+    The parent remembers its last child in document order, and the first tag
+    of each name remembers the last tag of that name, so appending a child, as
+    the parser always does, need not walk the existing children.
+  */
   child->ordered=(XMLTreeInfo *) NULL;
   child->sibling=(XMLTreeInfo *) NULL;
   child->next=(XMLTreeInfo *) NULL;
+  child->tail=(XMLTreeInfo *) NULL;
   child->offset=offset;
   child->parent=xml_info;
   if (xml_info->child == (XMLTreeInfo *) NULL)
     {
       xml_info->child=child;
+      xml_info->last=child;
       return(child);
     }
   head=xml_info->child;
@@ -1017,11 +1026,16 @@ MagickExport XMLTreeInfo *InsertTagIntoXMLTree(XMLTreeInfo *xml_info,
   else
     {
       node=head;
+      if ((xml_info->last != (XMLTreeInfo *) NULL) &&
+          (xml_info->last->offset <= offset))
+        node=xml_info->last;
       while ((node->ordered != (XMLTreeInfo *) NULL) &&
              (node->ordered->offset <= offset))
         node=node->ordered;
       child->ordered=node->ordered;
       node->ordered=child;
+      if (child->ordered == (XMLTreeInfo *) NULL)
+        xml_info->last=child;
     }
   previous=(XMLTreeInfo *) NULL;
   node=head;
@@ -1032,11 +1046,17 @@ MagickExport XMLTreeInfo *InsertTagIntoXMLTree(XMLTreeInfo *xml_info,
   }
   if ((node != (XMLTreeInfo *) NULL) && (node->offset <= offset))
     {
+      head=node;
+      if ((head->tail != (XMLTreeInfo *) NULL) &&
+          (head->tail->offset <= offset))
+        node=head->tail;
       while ((node->next != (XMLTreeInfo *) NULL) &&
              (node->next->offset <= offset))
         node=node->next;
       child->next=node->next;
       node->next=child;
+      if (child->next == (XMLTreeInfo *) NULL)
+        head->tail=child;
     }
   else
     {
@@ -1309,13 +1329,15 @@ static char *ParseEntities(char *xml,char **entities,int state)
       /*
         Normalize spaces for non-CDATA attributes.
       */
-      for (xml=p; *xml != '\0'; xml++)
+      for (xml=p; *xml != '\0'; )
       {
         i=(ssize_t) strspn(xml," ");
         if (i != 0)
           (void) CopyMagickMemory(xml,xml+i,strlen(xml+i)+1);
         while ((*xml != '\0') && (*xml != ' '))
           xml++;
+        if (*xml != '\0')
+          xml++;
       }
       xml--;
       if ((xml >= p) && (*xml == ' '))
@@ -2145,6 +2167,15 @@ MagickExport XMLTreeInfo *PruneTagFromXMLTree(XMLTreeInfo *xml_info)
     xml_info->next->sibling=xml_info->sibling;
   if (xml_info->parent != (XMLTreeInfo *) NULL)
     {
+      /*
+        Forget the append hints of the siblings; they may name this tag.
+      */
+      xml_info->parent->last=(XMLTreeInfo *) NULL;
+      for (node=xml_info->parent->child; node != (XMLTreeInfo *) NULL; )
+      {
+        node->tail=(XMLTreeInfo *) NULL;
+        node=node->ordered;
+      }
       node=xml_info->parent->child;
       if (node == xml_info)
         xml_info->parent->child=xml_info->ordered;
@@ -2174,6 +2205,7 @@ MagickExport XMLTreeInfo *PruneTagFromXMLTree(XMLTreeInfo *xml_info)
   xml_info->ordered=(XMLTreeInfo *) NULL;
   xml_info->sibling=(XMLTreeInfo *) NULL;
   xml_info->next=(XMLTreeInfo *) NULL;
+  xml_info->tail=(XMLTreeInfo *) NULL;
   return(xml_info);
 }
 
@@ -857,6 +857,256 @@ static size_t ValidateImageFormatsOnDisk(ImageInfo *image_info,
   return(test);
 }
 
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%   V a l i d a t e I m a g e P r o p e r t i e s                             %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ValidateImageProperties() validates the image options, artifacts, and
+%  properties that an image or image info shares with its clones.  It returns
+%  the number of validation tests that passed and failed.
+%
+%  The format of the ValidateImageProperties method is:
+%
+%      size_t ValidateImageProperties(ImageInfo *image_info,
+%        const char *reference_filename,const char *output_filename,
+%        size_t *fail,ExceptionInfo *exception)
+%
+%  A description of each parameter follows:
+%
+%    o image_info: the image info.
+%
+%    o reference_filename: the reference image filename.
+%
+%    o output_filename: the output image filename.
+%
+%    o fail: return the number of validation tests that pass.
+%
+%    o exception: return any errors or warnings in this structure.
+%
+*/
+
+static void ScribbleStrings(void)
+{
+  char
+    *strings[32];
+
+  register ssize_t
+    i;
+
+  /*
+    Reuse any string memory just freed so a dangling value no longer reads
+    back as the original.
+  */
+  for (i=0; i < 32; i++)
+    strings[i]=ConstantString("scribble");
+  for (i=0; i < 32; i++)
+    strings[i]=DestroyString(strings[i]);
+}
+
+static size_t ValidateImageProperties(ImageInfo *image_info,
+  const char *reference_filename,const char *output_filename,
+  size_t *fail,ExceptionInfo *exception)
+{
+#define ValidatePropertiesResult(status) \
+{ \
+  if ((status) == MagickFalse) \
+    { \
+      (void) FormatLocaleFile(stdout,"... fail @ %s/%s/%lu.\n", \
+        GetMagickModule()); \
+      (*fail)++; \
+    } \
+  else \
+    (void) FormatLocaleFile(stdout,"... pass.\n"); \
+}
+
+  char
+    key[MaxTextExtent],
+    *value;
+
+  const char
+    *artifact,
+    *option,
+    *property;
+
+  Image
+    *clone_image,
+    *reference_image;
+
+  ImageInfo
+    *clone_info,
+    *reference_info;
+
+  MagickBooleanType
+    status;
+
+  register ssize_t
+    i;
+
+  size_t
+    clone_keys,
+    reference_keys,
+    test;
+
+  (void) image_info;
+  (void) reference_filename;
+  (void) output_filename;
+  test=0;
+  (void) FormatLocaleFile(stdout,
+    "validate image options, artifacts, and properties:\n");
+  /*
+    A value must outlive a clone that shared it.
+  */
+  CatchException(exception);
+  (void) FormatLocaleFile(stdout,"  test %.20g: clone, set, destroy options",
+    (double) (test++));
+  reference_info=AcquireImageInfo();
+  (void) SetImageOption(reference_info,"validate:a","alpha");
+  option=GetImageOption(reference_info,"validate:a");
+  clone_info=CloneImageInfo(reference_info);
+  (void) SetImageOption(reference_info,"validate:b","beta");
+  clone_info=DestroyImageInfo(clone_info);
+  ScribbleStrings();
+  status=LocaleCompare(option,"alpha") == 0 ? MagickTrue : MagickFalse;
+  reference_info=DestroyImageInfo(reference_info);
+  ValidatePropertiesResult(status);
+  (void) FormatLocaleFile(stdout,"  test %.20g: clone, set, destroy artifacts",
+    (double) (test++));
+  reference_image=AcquireImage((ImageInfo *) NULL);
+  (void) SetImageArtifact(reference_image,"validate:a","alpha");
+  artifact=GetImageArtifact(reference_image,"validate:a");
+  clone_image=CloneImage(reference_image,0,0,MagickTrue,exception);
+  (void) SetImageArtifact(reference_image,"validate:b","beta");
+  clone_image=DestroyImage(clone_image);
+  ScribbleStrings();
+  status=LocaleCompare(artifact,"alpha") == 0 ? MagickTrue : MagickFalse;
+  reference_image=DestroyImage(reference_image);
+  ValidatePropertiesResult(status);
+  (void) FormatLocaleFile(stdout,
+    "  test %.20g: clone, set, destroy properties",(double) (test++));
+  reference_image=AcquireImage((ImageInfo *) NULL);
+  (void) SetImageProperty(reference_image,"validate:a","alpha");
+  property=GetImageProperty(reference_image,"validate:a");
+  clone_image=CloneImage(reference_image,0,0,MagickTrue,exception);
+  (void) SetImageProperty(reference_image,"validate:b","beta");
+  clone_image=DestroyImage(clone_image);
+  ScribbleStrings();
+  status=LocaleCompare(property,"alpha") == 0 ? MagickTrue : MagickFalse;
+  reference_image=DestroyImage(reference_image);
+  ValidatePropertiesResult(status);
+  /*
+    Removing a shared value hands the caller its own copy.
+  */
+  CatchException(exception);
+  (void) FormatLocaleFile(stdout,"  test %.20g: remove a shared artifact",
+    (double) (test++));
+  reference_image=AcquireImage((ImageInfo *) NULL);
+  (void) SetImageArtifact(reference_image,"validate:a","alpha");
+  clone_image=CloneImage(reference_image,0,0,MagickTrue,exception);
+  artifact=GetImageArtifact(clone_image,"validate:a");
+  value=RemoveImageArtifact(reference_image,"validate:a");
+  status=MagickFalse;
+  if (value != (char *) NULL)
+    {
+      status=LocaleCompare(value,"alpha") == 0 ? MagickTrue : MagickFalse;
+      value=DestroyString(value);
+    }
+  reference_image=DestroyImage(reference_image);
+  ScribbleStrings();
+  if (LocaleCompare(artifact,"alpha") != 0)
+    status=MagickFalse;
+  if (GetImageArtifact(clone_image,"validate:a") != artifact)
+    status=MagickFalse;
+  clone_image=DestroyImage(clone_image);
+  ValidatePropertiesResult(status);
+  /*
+    A clone iterates independently of the image it was cloned from.
+  */
+  CatchException(exception);
+  (void) FormatLocaleFile(stdout,"  test %.20g: interleave option iterators",
+    (double) (test++));
+  reference_info=AcquireImageInfo();
+  for (i=0; i < 10; i++)
+  {
+    (void) FormatLocaleString(key,MaxTextExtent,"validate:%.20g",(double) i);
+    (void) SetImageOption(reference_info,key,key);
+  }
+  ResetImageOptionIterator(reference_info);
+  for (i=0; i < 3; i++)
+    (void) GetNextImageOption(reference_info);
+  clone_info=CloneImageInfo(reference_info);
+  ResetImageOptionIterator(clone_info);
+  clone_keys=0;
+  while (GetNextImageOption(clone_info) != (char *) NULL)
+    clone_keys++;
+  reference_keys=0;
+  while (GetNextImageOption(reference_info) != (char *) NULL)
+    reference_keys++;
+  clone_info=DestroyImageInfo(clone_info);
+  reference_info=DestroyImageInfo(reference_info);
+  status=(clone_keys == 10) && (reference_keys == 7) ? MagickTrue :
+    MagickFalse;
+  ValidatePropertiesResult(status);
+  (void) FormatLocaleFile(stdout,"  test %.20g: interleave artifact iterators",
+    (double) (test++));
+  reference_image=AcquireImage((ImageInfo *) NULL);
+  for (i=0; i < 10; i++)
+  {
+    (void) FormatLocaleString(key,MaxTextExtent,"validate:%.20g",(double) i);
+    (void) SetImageArtifact(reference_image,key,key);
+  }
+  ResetImageArtifactIterator(reference_image);
+  for (i=0; i < 3; i++)
+    (void) GetNextImageArtifact(reference_image);
+  clone_image=CloneImage(reference_image,0,0,MagickTrue,exception);
+  ResetImageArtifactIterator(clone_image);
+  clone_keys=0;
+  while (GetNextImageArtifact(clone_image) != (char *) NULL)
+    clone_keys++;
+  reference_keys=0;
+  while (GetNextImageArtifact(reference_image) != (char *) NULL)
+    reference_keys++;
+  clone_image=DestroyImage(clone_image);
+  reference_image=DestroyImage(reference_image);
+  status=(clone_keys == 10) && (reference_keys == 7) ? MagickTrue :
+    MagickFalse;
+  ValidatePropertiesResult(status);
+  (void) FormatLocaleFile(stdout,
+    "  test %.20g: interleave property iterators",(double) (test++));
+  reference_image=AcquireImage((ImageInfo *) NULL);
+  for (i=0; i < 10; i++)
+  {
+    (void) FormatLocaleString(key,MaxTextExtent,"validate:%.20g",(double) i);
+    (void) SetImageProperty(reference_image,key,key);
+  }
+  ResetImagePropertyIterator(reference_image);
+  for (i=0; i < 3; i++)
+    (void) GetNextImageProperty(reference_image);
+  clone_image=CloneImage(reference_image,0,0,MagickTrue,exception);
+  ResetImagePropertyIterator(clone_image);
+  clone_keys=0;
+  while (GetNextImageProperty(clone_image) != (char *) NULL)
+    clone_keys++;
+  reference_keys=0;
+  while (GetNextImageProperty(reference_image) != (char *) NULL)
+    reference_keys++;
+  clone_image=DestroyImage(clone_image);
+  reference_image=DestroyImage(reference_image);
+  status=(clone_keys == 10) && (reference_keys == 7) ? MagickTrue :
+    MagickFalse;
+  ValidatePropertiesResult(status);
+  (void) FormatLocaleFile(stdout,
+    "  summary: %.20g subtests; %.20g passed; %.20g failed.\n",(double) test,
+    (double) (test-(*fail)),(double) *fail);
+  return(test);
+}
+
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %                                                                             %
@@ -1479,6 +1729,9 @@ int main(int argc,char **argv)
           if ((type & MontageValidate) != 0)
             tests+=ValidateMontageCommand(image_info,reference_filename,
               output_filename,&fail,exception);
+          if ((type & PropertiesValidate) != 0)
+            tests+=ValidateImageProperties(image_info,reference_filename,
+              output_filename,&fail,exception);
           if ((type & StreamValidate) != 0)
             tests+=ValidateStreamCommand(image_info,reference_filename,
               output_filename,&fail,exception);
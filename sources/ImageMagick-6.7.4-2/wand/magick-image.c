@@ -8586,7 +8586,8 @@ WandExport MagickBooleanType MagickReadImageFile(MagickWand *wand,FILE *file)
 %    o affinity: the affinity wand.
 %
 %    o method: choose from these dither methods: NoDitherMethod,
-%      RiemersmaDitherMethod, or FloydSteinbergDitherMethod.
+%      RiemersmaDitherMethod, FloydSteinbergDitherMethod, or
+%      OrderedDitherMethod.
 %
 */
 WandExport MagickBooleanType MagickRemapImage(MagickWand *wand,